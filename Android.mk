@@ -1,9 +1,33 @@
 LOCAL_PATH:= $(call my-dir)
-include $(CLEAR_VARS)
 
-LOCAL_SRC_FILES:= \
+gl2_cube_src_files := \
 	gl2_cube.cpp \
-  Matrix.cpp
+  Matrix.cpp \
+  GLStateCache.cpp \
+  GLError.cpp \
+  RenderGraph.cpp \
+  FrameClock.cpp \
+  ProgramCache.cpp \
+  ShaderVariants.cpp \
+  StageStats.cpp \
+  TextOverlay.cpp \
+  TraceEvents.cpp \
+  DamageTracker.cpp \
+  FrameState.cpp \
+  CommandBuffer.cpp \
+  VertexBatch.cpp \
+  InstanceBatch.cpp \
+  ResolutionScaler.cpp \
+  MeshFile.cpp \
+  MeshOptimizer.cpp \
+  MeshGenerator.cpp \
+  StartupProfiler.cpp \
+  GLTrace.cpp \
+  GLTraceFormat.cpp
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= $(gl2_cube_src_files)
 
 LOCAL_SHARED_LIBRARIES := \
     libcutils \
@@ -20,4 +44,160 @@ LOCAL_MODULE_TAGS := optional
 
 LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
 
+# VertexBatch transforms with NEON where the target has it.
+ifeq ($(ARCH_ARM_HAVE_NEON),true)
+LOCAL_ARM_NEON := true
+endif
+
+include $(BUILD_EXECUTABLE)
+
+# The same program built for the host and drawn by the software rasterizer, for
+# machines without a GPU. Renders offscreen; see SoftGL.h for its environment variables.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  $(gl2_cube_src_files) \
+  SoftRasterizer.cpp \
+  SoftGLES2.cpp \
+  SoftEGL.cpp \
+  HostEGL.cpp
+
+LOCAL_STATIC_LIBRARIES := \
+    libutils \
+    libcutils
+
+LOCAL_LDLIBS := -lpthread -lrt -lm
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl)
+
+LOCAL_MODULE:= gl2-cube-soft
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# The same program on the host against EGL and GLES2 entry points that only validate and
+# count calls, to measure the CPU cost of a frame without a driver; see NullGL.h.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  $(gl2_cube_src_files) \
+  NullGLES2.cpp \
+  NullEGL.cpp \
+  HostEGL.cpp
+
+LOCAL_STATIC_LIBRARIES := \
+    libutils \
+    libcutils
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl)
+
+LOCAL_MODULE:= gl2-cube-null
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# Re-issues a trace recorded with gl2-cube -t, timing every call; see GLTrace.h.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  GLTraceReplay.cpp \
+  GLTraceFormat.cpp
+
+LOCAL_SHARED_LIBRARIES := \
+    libcutils \
+    libEGL \
+    libGLESv2 \
+    libutils \
+    libui
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl-tests-includes)
+
+LOCAL_MODULE:= gl2-cube-replay
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
+
 include $(BUILD_EXECUTABLE)
+
+# The replayer on the host against the null backend, to profile the CPU cost of a
+# recorded frame away from the device.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  GLTraceReplay.cpp \
+  GLTraceFormat.cpp \
+  NullGLES2.cpp \
+  NullEGL.cpp \
+  HostEGL.cpp
+
+LOCAL_STATIC_LIBRARIES := \
+    libutils \
+    libcutils
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl)
+
+LOCAL_MODULE:= gl2-cube-replay-null
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# The replayer on the host against the software rasterizer, to look at a recorded frame;
+# see SoftGL.h for how to dump the surface.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  GLTraceReplay.cpp \
+  GLTraceFormat.cpp \
+  SoftRasterizer.cpp \
+  SoftGLES2.cpp \
+  SoftEGL.cpp \
+  HostEGL.cpp
+
+LOCAL_STATIC_LIBRARIES := \
+    libutils \
+    libcutils
+
+LOCAL_LDLIBS := -lpthread -lrt -lm
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl)
+
+LOCAL_MODULE:= gl2-cube-replay-soft
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -DGL_GLEXT_PROTOTYPES -DEGL_EGLEXT_PROTOTYPES
+
+include $(BUILD_HOST_EXECUTABLE)
+
+# Writes the cube as a mesh file for gl2-cube -M, optionally reordered for the vertex
+# caches, and checks it loads back unchanged; see MeshFile.h and MeshOptimizer.h.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+  MeshConvert.cpp \
+  MeshFile.cpp \
+  MeshOptimizer.cpp
+
+LOCAL_LDLIBS := -lm
+
+LOCAL_C_INCLUDES += $(call include-path-for, opengl)
+
+LOCAL_MODULE:= gl2-cube-meshconv
+
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
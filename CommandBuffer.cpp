@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CommandBuffer.h"
+#include "GLError.h"
+#include "TraceEvents.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "GLTrace.h"
+
+    /* Key fields, from the most significant bits down. */
+    static const int      targetShift  = 56;
+    static const int      layerShift   = 54;
+    static const int      programShift = 38;
+    static const int      textureShift = 24;
+    static const uint64_t programMask  = 0xFFFF;
+    static const uint64_t textureMask  = 0x3FFF;
+    static const uint64_t depthMask    = 0xFFFFFF;
+    static const uint64_t orderMask    = ((uint64_t)1 << layerShift) - 1;
+
+    enum { layerClear, layerMesh, layerCallback };
+
+    FrameArena::FrameArena(void)
+        : memory(NULL), capacity(0), used(0)
+    {
+    }
+
+    FrameArena::~FrameArena()
+    {
+        free(memory);
+    }
+
+    bool FrameArena::setup(size_t capacity)
+    {
+        free(memory);
+        memory = (unsigned char*)malloc(capacity);
+        this->capacity = memory != NULL ? capacity : 0;
+        used = 0;
+        return memory != NULL;
+    }
+
+    void* FrameArena::allocate(size_t size)
+    {
+        size = (size + 7) & ~(size_t)7;
+        if (size > capacity - used)
+        {
+            return NULL;
+        }
+        void* allocation = memory + used;
+        used += size;
+        return allocation;
+    }
+
+    CommandBuffer::CommandBuffer(GLStateCache* state)
+        : state(state), commands(NULL), maxCommands(0), commandCount(0), targetCount(0), callbackCount(0)
+    {
+        resetStats();
+    }
+
+    bool CommandBuffer::setup(size_t arenaBytes, unsigned int maxCommands)
+    {
+        free(commands);
+        commands = (DrawCommand**)malloc(maxCommands * sizeof(DrawCommand*));
+        this->maxCommands = commands != NULL ? maxCommands : 0;
+        return commands != NULL && arena.setup(arenaBytes);
+    }
+
+    void CommandBuffer::begin(void)
+    {
+        arena.reset();
+        commandCount  = 0;
+        targetCount   = 0;
+        callbackCount = 0;
+    }
+
+    const RenderTarget* CommandBuffer::addTarget(GLuint framebuffer, GLint x, GLint y, GLsizei width, GLsizei height,
+                                                 const GLint* scissor)
+    {
+        RenderTarget* target = targetCount < maxTargets ? (RenderTarget*)arena.allocate(sizeof(RenderTarget)) : NULL;
+        if (target == NULL)
+        {
+            dropped++;
+            return NULL;
+        }
+        target->index       = targetCount++;
+        target->framebuffer = framebuffer;
+        target->viewport[0] = x;
+        target->viewport[1] = y;
+        target->viewport[2] = width;
+        target->viewport[3] = height;
+        target->scissorTest = scissor != NULL;
+        if (scissor != NULL)
+        {
+            memcpy(target->scissor, scissor, sizeof(target->scissor));
+        }
+        return target;
+    }
+
+    DrawCommand* CommandBuffer::addCommand(const RenderTarget* target, DrawCommand::Type type, uint64_t key)
+    {
+        DrawCommand* command = NULL;
+        if (target != NULL && commandCount < maxCommands)
+        {
+            command = (DrawCommand*)arena.allocate(sizeof(DrawCommand));
+        }
+        if (command == NULL)
+        {
+            dropped++;
+            return NULL;
+        }
+        command->key    = (uint64_t)target->index << targetShift | key;
+        command->type   = type;
+        command->target = target;
+        commands[commandCount++] = command;
+        return command;
+    }
+
+    const GLfloat* CommandBuffer::copyMatrix(Matrix& matrix)
+    {
+        GLfloat* copy = (GLfloat*)arena.allocate(16 * sizeof(GLfloat));
+        if (copy != NULL)
+        {
+            memcpy(copy, matrix.getAsArray(), 16 * sizeof(GLfloat));
+        }
+        return copy;
+    }
+
+    void CommandBuffer::clear(const RenderTarget* target, GLbitfield mask,
+                              GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+    {
+        DrawCommand* command = addCommand(target, DrawCommand::CLEAR, (uint64_t)layerClear << layerShift);
+        if (command != NULL)
+        {
+            command->clearMask     = mask;
+            command->clearColor[0] = red;
+            command->clearColor[1] = green;
+            command->clearColor[2] = blue;
+            command->clearColor[3] = alpha;
+        }
+    }
+
+    void CommandBuffer::draw(const RenderTarget* target, ShaderVariant* variant, const DrawMesh* mesh,
+                             GLenum textureTarget, GLuint texture, Matrix& mvp, Matrix& modelView,
+                             Matrix& projection, unsigned int projectionGeneration, GLfloat textureMix)
+    {
+        /* Depth of the object's origin, from 0 at the near plane to the maximum at the far one. */
+        const GLfloat* transform = mvp.getAsArray();
+        float depth = transform[15] != 0.0f ? transform[14] / transform[15] : 1.0f;
+        depth = depth < -1.0f ? -1.0f : depth > 1.0f ? 1.0f : depth;
+        uint64_t key = (uint64_t)layerMesh << layerShift |
+                       ((uint64_t)variant->program & programMask) << programShift |
+                       ((uint64_t)texture & textureMask) << textureShift |
+                       (uint64_t)((depth + 1.0f) * 0.5f * depthMask);
+
+        DrawCommand* command = addCommand(target, DrawCommand::MESH, key);
+        if (command == NULL)
+        {
+            return;
+        }
+        command->variant              = variant;
+        command->mesh                 = mesh;
+        command->textureTarget        = textureTarget;
+        command->texture              = texture;
+        command->textureMix           = textureMix;
+        command->mvp                  = copyMatrix(mvp);
+        command->modelView            = copyMatrix(modelView);
+        command->projection           = projection.getAsArray();
+        command->projectionGeneration = projectionGeneration;
+        command->instanceCount        = 0;
+        command->instanceTransforms   = NULL;
+        if (command->mvp == NULL || command->modelView == NULL)
+        {
+            /* Out of arena for the uniforms, leave the command out. */
+            commandCount--;
+            dropped++;
+        }
+    }
+
+    GLfloat* CommandBuffer::drawInstances(const RenderTarget* target, ShaderVariant* variant, const DrawMesh* mesh,
+                                          int instanceCount, Matrix& mvp, Matrix& modelView,
+                                          Matrix& projection, unsigned int projectionGeneration)
+    {
+        unsigned int recorded = commandCount;
+        draw(target, variant, mesh, GL_TEXTURE_2D, 0, mvp, modelView, projection, projectionGeneration);
+        if (commandCount == recorded)
+        {
+            return NULL;
+        }
+        DrawCommand* command = commands[commandCount - 1];
+        GLfloat* transforms = (GLfloat*)arena.allocate(instanceCount * 12 * sizeof(GLfloat));
+        if (transforms == NULL)
+        {
+            commandCount--;
+            dropped++;
+            return NULL;
+        }
+        command->instanceCount      = instanceCount;
+        command->instanceTransforms = transforms;
+        return transforms;
+    }
+
+    void CommandBuffer::drawCallback(const RenderTarget* target, void (*callback)(void* userData), void* userData)
+    {
+        uint64_t key = (uint64_t)layerCallback << layerShift | (callbackCount & orderMask);
+        DrawCommand* command = addCommand(target, DrawCommand::CALLBACK, key);
+        if (command != NULL)
+        {
+            command->callback = callback;
+            command->userData = userData;
+            callbackCount++;
+        }
+    }
+
+    int CommandBuffer::compareCommands(const void* a, const void* b)
+    {
+        uint64_t keyA = (*(const DrawCommand* const*)a)->key;
+        uint64_t keyB = (*(const DrawCommand* const*)b)->key;
+        return keyA < keyB ? -1 : keyA > keyB ? 1 : 0;
+    }
+
+    void CommandBuffer::bindTarget(const RenderTarget* target)
+    {
+        state->bindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+        state->viewport(target->viewport[0], target->viewport[1], target->viewport[2], target->viewport[3]);
+        if (target->scissorTest)
+        {
+            state->enable(GL_SCISSOR_TEST);
+            state->scissor(target->scissor[0], target->scissor[1], target->scissor[2], target->scissor[3]);
+        }
+        else
+        {
+            state->disable(GL_SCISSOR_TEST);
+        }
+    }
+
+    /* Make a shader variant current and source the attributes it reads. */
+    void CommandBuffer::useVariant(ShaderVariant* variant, const VertexStreams* streams)
+    {
+        const VertexAttribStream* attributeStreams[ATTRIB_COUNT] =
+        {
+            &streams->position,
+            &streams->color,
+            &streams->texCoord,
+            &streams->instance,
+        };
+
+        state->useProgram(variant->program);
+        GL_CHECK("glUseProgram");
+
+        state->bindBuffer(GL_ARRAY_BUFFER, streams->buffer);
+
+        for (int attribute = 0; attribute < ATTRIB_COUNT; attribute++)
+        {
+            if (variant->usesAttribute(attribute))
+            {
+                const VertexAttribStream* stream = attributeStreams[attribute];
+                state->enableVertexAttribArray(attribute);
+                state->vertexAttribPointer(attribute, stream->size, stream->type, stream->normalized,
+                                           stream->stride, stream->pointer);
+            }
+            else
+            {
+                state->disableVertexAttribArray(attribute);
+            }
+        }
+        GL_CHECK("vertex attributes");
+    }
+
+    void CommandBuffer::drawMesh(const DrawCommand* command)
+    {
+        ShaderVariant* variant = command->variant;
+        useVariant(variant, command->mesh->streams);
+
+        /* Either the combined projection * modelView, built on the CPU instead of per vertex,
+         * or both matrices. */
+        if (variant->features & SHADER_MVP)
+        {
+            state->uniformMatrix4fv(variant->mvp, command->mvp);
+        }
+        else
+        {
+            state->uniformMatrix4fv(variant->modelview, command->modelView);
+            state->uniformMatrix4fv(variant->projection, command->projection, command->projectionGeneration);
+        }
+
+        if (command->texture != 0)
+        {
+            state->activeTexture(GL_TEXTURE0);
+            state->bindTexture(command->textureTarget, command->texture);
+        }
+        /* Only mixed variants have the uniform; the slot ignores the upload in the others. */
+        state->uniform1f(variant->textureMix, command->textureMix);
+
+        /* An instanced mesh's indices run copy by copy, so the first copies are a prefix. */
+        const DrawMesh* mesh = command->mesh;
+        GLsizei count = mesh->count;
+        GLsizei triangles = mesh->triangles;
+        if (command->instanceTransforms != NULL)
+        {
+            state->uniform4fv(variant->instanceTransforms, command->instanceCount * 3, command->instanceTransforms);
+            count = mesh->count / variant->instances * command->instanceCount;
+            triangles = mesh->triangles / variant->instances * command->instanceCount;
+        }
+
+        totalTriangles += triangles;
+
+        TRACE_EVENT("glDrawElements");
+        if (mesh->indices != NULL || mesh->indexBuffer != 0)
+        {
+            state->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer);
+            glDrawElements(mesh->mode, count, mesh->indexType, mesh->indices);
+        }
+        else
+        {
+            glDrawArrays(mesh->mode, 0, count);
+        }
+        GL_CHECK("glDrawElements");
+    }
+
+    void CommandBuffer::submit(void)
+    {
+        qsort(commands, commandCount, sizeof(commands[0]), compareCommands);
+
+        const RenderTarget* boundTarget = NULL;
+        for (unsigned int i = 0; i < commandCount; i++)
+        {
+            const DrawCommand* command = commands[i];
+            if (command->target != boundTarget)
+            {
+                bindTarget(command->target);
+                boundTarget = command->target;
+            }
+            switch (command->type)
+            {
+                case DrawCommand::CLEAR:
+                    state->clearColor(command->clearColor[0], command->clearColor[1],
+                                      command->clearColor[2], command->clearColor[3]);
+                    glClear(command->clearMask);
+                    break;
+                case DrawCommand::MESH:
+                    drawMesh(command);
+                    break;
+                case DrawCommand::CALLBACK:
+                    command->callback(command->userData);
+                    break;
+            }
+        }
+
+        frames++;
+        totalCommands   += commandCount;
+        totalArenaBytes += arena.bytesUsed();
+        peakArenaBytes   = arena.bytesUsed() > peakArenaBytes ? arena.bytesUsed() : peakArenaBytes;
+    }
+
+    void CommandBuffer::printStats(const char* label) const
+    {
+        if (frames == 0)
+        {
+            return;
+        }
+        fprintf(stderr, "Command buffer (%s): %.1f commands/frame, %.0f triangles/frame, arena %u bytes/frame, "
+                "peak %u of %u",
+                label, (double)totalCommands / frames, getTrianglesPerFrame(), (unsigned int)(totalArenaBytes / frames),
+                (unsigned int)peakArenaBytes, (unsigned int)arena.bytesTotal());
+        if (dropped != 0)
+        {
+            fprintf(stderr, ", %u commands dropped, out of room", dropped);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    void CommandBuffer::resetStats(void)
+    {
+        frames          = 0;
+        totalCommands   = 0;
+        totalTriangles  = 0;
+        totalArenaBytes = 0;
+        peakArenaBytes  = 0;
+        dropped         = 0;
+    }
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GLES2/gl2.h>
+
+#include "GLStateCache.h"
+#include "Matrix.h"
+#include "ShaderVariants.h"
+#include "VertexFormats.h"
+
+/**
+ * \file CommandBuffer.h
+ * \brief Draws recorded into a per-frame arena, sorted by the state they need, then issued.
+ */
+
+    /**
+     * \brief A linear allocator, emptied all at once.
+     *
+     * The memory is allocated by setup(), after which allocating is a pointer bump and
+     * reset() frees everything, so a frame's records cost no heap allocation.
+     */
+    class FrameArena
+    {
+    public:
+        FrameArena(void);
+        ~FrameArena();
+
+        /**
+         * \return false if the memory could not be allocated.
+         */
+        bool setup(size_t capacity);
+
+        /**
+         * \brief Allocate size bytes, 8 byte aligned.
+         * \return NULL if the arena is full.
+         */
+        void* allocate(size_t size);
+
+        void reset(void) { used = 0; }
+
+        size_t bytesUsed(void) const { return used; }
+        size_t bytesTotal(void) const { return capacity; }
+
+    private:
+        unsigned char*  memory;
+        size_t          capacity;
+        size_t          used;
+    };
+
+    /**
+     * \brief A mesh as drawn: its attribute streams and its indices, or none for glDrawArrays.
+     */
+    struct DrawMesh
+    {
+        const VertexStreams*    streams;
+        GLenum                  mode;
+        GLsizei                 count;
+        /** Triangles the indices draw, not counting the degenerate ones that join strips. */
+        GLsizei                 triangles;
+        GLenum                  indexType;
+        /** An offset into indexBuffer if it is not 0. */
+        const GLvoid*           indices;
+        GLuint                  indexBuffer;
+    };
+
+    /**
+     * \brief Where commands draw. Targets are drawn in the order they were added.
+     */
+    struct RenderTarget
+    {
+        int         index;
+        GLuint      framebuffer;
+        GLint       viewport[4];
+        bool        scissorTest;
+        GLint       scissor[4];
+    };
+
+    /**
+     * \brief One recorded command. Lives in the arena until the next frame begins.
+     */
+    struct DrawCommand
+    {
+        enum Type { CLEAR, MESH, CALLBACK };
+
+        uint64_t                key;
+        Type                    type;
+        const RenderTarget*     target;
+
+        /* CLEAR */
+        GLbitfield              clearMask;
+        GLclampf                clearColor[4];
+
+        /* MESH: uniform values are copies in the arena, projection is shared. Instanced
+         * meshes draw instanceCount copies, with three rows of instance transforms each. */
+        ShaderVariant*          variant;
+        const DrawMesh*         mesh;
+        GLsizei                 instanceCount;
+        const GLfloat*          instanceTransforms;
+        GLenum                  textureTarget;
+        GLuint                  texture;
+        GLfloat                 textureMix;
+        const GLfloat*          mvp;
+        const GLfloat*          modelView;
+        const GLfloat*          projection;
+        unsigned int            projectionGeneration;
+
+        /* CALLBACK */
+        void                  (*callback)(void* userData);
+        void*                   userData;
+    };
+
+    /**
+     * \brief Records a frame's draws and issues them sorted by a 64 bit state key.
+     *
+     * From the most significant bits down the key holds the target, a layer (clears, then
+     * meshes, then callbacks), the program, the texture and the depth of the mesh's origin,
+     * front to back. Sorting groups draws sharing a program and texture, so the state changes
+     * between them stay as few as the scene allows however many draws there are, and draws
+     * each target's opaque meshes front to back. Callbacks, for drawing that does not fit a
+     * mesh such as the text overlay, run after a target's meshes in the order recorded.
+     */
+    class CommandBuffer
+    {
+    public:
+        /**
+         * \param[in] state State cache the commands are issued through.
+         */
+        CommandBuffer(GLStateCache* state);
+
+        /**
+         * \brief Allocate the arena, and room to sort up to maxCommands commands per frame.
+         */
+        bool setup(size_t arenaBytes, unsigned int maxCommands);
+
+        /**
+         * \brief Forget the last frame's commands and start recording a new frame.
+         */
+        void begin(void);
+
+        /**
+         * \brief Add a target for the commands that follow.
+         * \param[in] scissor Box to clip the target's commands to, or NULL.
+         * \return NULL if the frame is out of memory or targets.
+         */
+        const RenderTarget* addTarget(GLuint framebuffer, GLint x, GLint y, GLsizei width, GLsizei height,
+                                      const GLint* scissor);
+
+        /**
+         * \brief Clear the target before anything is drawn to it.
+         */
+        void clear(const RenderTarget* target, GLbitfield mask,
+                   GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+
+        /**
+         * \brief Draw a mesh with a shader variant, its transform uploaded the way the variant
+         * expects it.
+         * \param[in] texture Texture for unit 0, 0 for none.
+         * \param[in] textureMix How much of the texel, against the vertex color, variants with
+         *                       both SHADER_VERTEX_COLOR and SHADER_TEXTURE draw.
+         */
+        void draw(const RenderTarget* target, ShaderVariant* variant, const DrawMesh* mesh,
+                  GLenum textureTarget, GLuint texture, Matrix& mvp, Matrix& modelView,
+                  Matrix& projection, unsigned int projectionGeneration, GLfloat textureMix = 1.0f);
+
+        /**
+         * \brief Draw the first instanceCount copies of a mesh made for a SHADER_INSTANCED
+         * variant, which holds variant->instances copies.
+         * \return The copies' transforms for the caller to fill in, the three rows of a 4x3 model
+         * matrix per copy; NULL if the frame is out of room and the draw was left out.
+         */
+        GLfloat* drawInstances(const RenderTarget* target, ShaderVariant* variant, const DrawMesh* mesh,
+                               int instanceCount, Matrix& mvp, Matrix& modelView,
+                               Matrix& projection, unsigned int projectionGeneration);
+
+        /**
+         * \brief Call a function after the target's meshes are drawn. It must change state
+         * through the state cache.
+         */
+        void drawCallback(const RenderTarget* target, void (*callback)(void* userData), void* userData);
+
+        /**
+         * \brief Sort the frame's commands and issue them.
+         */
+        void submit(void);
+
+        /**
+         * \brief Triangles drawn per frame since the statistics were reset, as counted by
+         * each DrawMesh.
+         */
+        double getTrianglesPerFrame(void) const { return frames != 0 ? (double)totalTriangles / frames : 0.0; }
+
+        /**
+         * \brief Print commands, triangles and arena use per frame to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        static const int maxTargets = 256;
+
+        DrawCommand* addCommand(const RenderTarget* target, DrawCommand::Type type, uint64_t key);
+        const GLfloat* copyMatrix(Matrix& matrix);
+        void bindTarget(const RenderTarget* target);
+        void useVariant(ShaderVariant* variant, const VertexStreams* streams);
+        void drawMesh(const DrawCommand* command);
+        static int compareCommands(const void* a, const void* b);
+
+        GLStateCache*   state;
+        FrameArena      arena;
+        DrawCommand**   commands;
+        unsigned int    maxCommands;
+        unsigned int    commandCount;
+        int             targetCount;
+        unsigned int    callbackCount;
+
+        unsigned int    frames;
+        unsigned int    totalCommands;
+        uint64_t        totalTriangles;
+        size_t          totalArenaBytes;
+        size_t          peakArenaBytes;
+        unsigned int    dropped;
+    };
+
+#endif /* COMMANDBUFFER_H */
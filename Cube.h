@@ -15,6 +15,8 @@
 
 #include <GLES2/gl2.h>
 
+#include "VertexFormats.h"
+
 /* These indices describe the cube triangle strips, separated by degenerate triangles where necessary. */
 static const GLubyte cubeIndices[] =
 {
@@ -28,123 +30,100 @@ static const GLubyte cubeIndices[] =
  * |   \   |6 - 7
  * |     \ || \ |
  * 0 ----- 14 - 5
+ *
+ * Every vertex is listed once as V(x, y, z,   r, g, b, a,   s, t) so the float tables and the
+ * packed table below are all expanded from the same data at compile time.
  */
+#define CUBE_VERTEX_LIST(V) \
+    /* Front. */ \
+    V(-0.5f, -0.5f,  0.5f,   0.0f, 0.0f, 0.0f, 1.0f,   0.0f, 0.0f) /*  0 */ \
+    V( 0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f, 1.0f,   1.0f, 0.0f) /*  1 */ \
+    V(-0.5f,  0.5f,  0.5f,   0.0f, 1.0f, 0.0f, 1.0f,   0.0f, 1.0f) /*  2 */ \
+    V( 0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 0.0f, 1.0f,   1.0f, 1.0f) /*  3 */ \
+    \
+    /* Right. */ \
+    V( 0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 0.0f) /*  4 */ \
+    V( 0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 0.0f) /*  5 */ \
+    V( 0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 0.0f, 1.0f,   0.0f, 1.0f) /*  6 */ \
+    V( 0.5f,  0.5f, -0.5f,   0.0f, 1.0f, 1.0f, 1.0f,   1.0f, 1.0f) /*  7 */ \
+    \
+    /* Back. */ \
+    V( 0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f, 1.0f,   0.0f, 0.0f) /*  8 */ \
+    V(-0.5f, -0.5f, -0.5f,   1.0f, 0.0f, 1.0f, 1.0f,   1.0f, 0.0f) /*  9 */ \
+    V( 0.5f,  0.5f, -0.5f,   0.0f, 1.0f, 1.0f, 1.0f,   0.0f, 1.0f) /* 10 */ \
+    V(-0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f, 1.0f,   1.0f, 1.0f) /* 11 */ \
+    \
+    /* Left. */ \
+    V(-0.5f, -0.5f, -0.5f,   1.0f, 0.0f, 1.0f, 1.0f,   0.0f, 0.0f) /* 12 */ \
+    V(-0.5f, -0.5f,  0.5f,   0.0f, 0.0f, 0.0f, 1.0f,   1.0f, 0.0f) /* 13 */ \
+    V(-0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f, 1.0f,   0.0f, 1.0f) /* 14 */ \
+    V(-0.5f,  0.5f,  0.5f,   0.0f, 1.0f, 0.0f, 1.0f,   1.0f, 1.0f) /* 15 */ \
+    \
+    /* Top. */ \
+    V(-0.5f,  0.5f,  0.5f,   0.0f, 1.0f, 0.0f, 1.0f,   0.0f, 0.0f) /* 16 */ \
+    V( 0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 0.0f, 1.0f,   1.0f, 0.0f) /* 17 */ \
+    V(-0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f, 1.0f,   0.0f, 1.0f) /* 18 */ \
+    V( 0.5f,  0.5f, -0.5f,   0.0f, 1.0f, 1.0f, 1.0f,   1.0f, 1.0f) /* 19 */ \
+    \
+    /* Bottom. */ \
+    V(-0.5f, -0.5f, -0.5f,   1.0f, 0.0f, 1.0f, 1.0f,   0.0f, 0.0f) /* 20 */ \
+    V( 0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 0.0f) /* 21 */ \
+    V(-0.5f, -0.5f,  0.5f,   0.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f) /* 22 */ \
+    V( 0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f, 1.0f,   1.0f, 1.0f) /* 23 */
+
+#define CUBE_POSITION(x, y, z, r, g, b, a, s, t)      x, y, z,
+#define CUBE_COLOR(x, y, z, r, g, b, a, s, t)         r, g, b, a,
+#define CUBE_TEXCOORD(x, y, z, r, g, b, a, s, t)      s, t,
+
 static const float cubeVertices[] =
 {
-    /* Front. */
-    -0.5f, -0.5f,  0.5f, /* 0 */
-     0.5f, -0.5f,  0.5f, /* 1 */
-    -0.5f,  0.5f,  0.5f, /* 2 */
-     0.5f,  0.5f,  0.5f, /* 3 */
-
-    /* Right. */
-     0.5f, -0.5f,  0.5f, /* 4 */
-     0.5f, -0.5f, -0.5f, /* 5 */
-     0.5f,  0.5f,  0.5f, /* 6 */
-     0.5f,  0.5f, -0.5f, /* 7 */
-
-    /* Back. */
-     0.5f, -0.5f, -0.5f, /* 8 */
-    -0.5f, -0.5f, -0.5f, /* 9 */
-     0.5f,  0.5f, -0.5f, /* 10 */
-    -0.5f,  0.5f, -0.5f, /* 11 */
-
-    /* Left. */
-    -0.5f, -0.5f, -0.5f, /* 12 */
-    -0.5f, -0.5f,  0.5f, /* 13 */
-    -0.5f,  0.5f, -0.5f, /* 14 */
-    -0.5f,  0.5f,  0.5f, /* 15 */
-
-    /* Top. */
-    -0.5f,  0.5f,  0.5f, /* 16 */
-     0.5f,  0.5f,  0.5f, /* 17 */
-    -0.5f,  0.5f, -0.5f, /* 18 */
-     0.5f,  0.5f, -0.5f, /* 19 */
-
-    /* Bottom. */
-    -0.5f, -0.5f, -0.5f, /* 20 */
-     0.5f, -0.5f, -0.5f, /* 21 */
-    -0.5f, -0.5f,  0.5f, /* 22 */
-     0.5f, -0.5f,  0.5f, /* 23 */
+    CUBE_VERTEX_LIST(CUBE_POSITION)
 };
 
 static const float cubeTextureCoordinates[] =
 {
-    /* Front. */
-    0.0f, 0.0f, /* 0 */
-    1.0f, 0.0f, /* 1 */
-    0.0f, 1.0f, /* 2 */
-    1.0f, 1.0f, /* 3 */
-
-    /* Right. */
-    0.0f, 0.0f, /* 4 */
-    1.0f, 0.0f, /* 5 */
-    0.0f, 1.0f, /* 6 */
-    1.0f, 1.0f, /* 7 */
-
-    /* Back. */
-    0.0f, 0.0f, /* 8 */
-    1.0f, 0.0f, /* 9 */
-    0.0f, 1.0f, /* 10 */
-    1.0f, 1.0f, /* 11 */
-
-    /* Left. */
-    0.0f, 0.0f, /* 12 */
-    1.0f, 0.0f, /* 13 */
-    0.0f, 1.0f, /* 14 */
-    1.0f, 1.0f, /* 15 */
-
-    /* Top. */
-    0.0f, 0.0f, /* 16 */
-    1.0f, 0.0f, /* 17 */
-    0.0f, 1.0f, /* 18 */
-    1.0f, 1.0f, /* 19 */
-
-    /* Bottom. */
-    0.0f, 0.0f, /* 20 */
-    1.0f, 0.0f, /* 21 */
-    0.0f, 1.0f, /* 22 */
-    1.0f, 1.0f, /* 23 */
-
+    CUBE_VERTEX_LIST(CUBE_TEXCOORD)
 };
 
 static const float cubeColors[] =
 {
-    /* Front. */
-    0.0f, 0.0f, 0.0f, 1.0f, /* 0 */
-    1.0f, 0.0f, 0.0f, 1.0f, /* 1 */
-    0.0f, 1.0f, 0.0f, 1.0f, /* 2 */
-    1.0f, 1.0f, 0.0f, 1.0f, /* 3 */
-
-    /* Right. */
-    1.0f, 0.0f, 0.0f, 1.0f, /* 4 */
-    0.0f, 0.0f, 1.0f, 1.0f, /* 5 */
-    1.0f, 1.0f, 0.0f, 1.0f, /* 6 */
-    0.0f, 1.0f, 1.0f, 1.0f, /* 7 */
-
-    /* Back. */
-    0.0f, 0.0f, 1.0f, 1.0f, /* 8 */
-    1.0f, 0.0f, 1.0f, 1.0f, /* 9 */
-    0.0f, 1.0f, 1.0f, 1.0f, /* 10 */
-    1.0f, 1.0f, 1.0f, 1.0f, /* 11 */
-
-    /* Left. */
-    1.0f, 0.0f, 1.0f, 1.0f, /* 12 */
-    0.0f, 0.0f, 0.0f, 1.0f, /* 13 */
-    1.0f, 1.0f, 1.0f, 1.0f, /* 14 */
-    0.0f, 1.0f, 0.0f, 1.0f, /* 15 */
-
-    /* Top. */
-    0.0f, 1.0f, 0.0f, 1.0f, /* 16 */
-    1.0f, 1.0f, 0.0f, 1.0f, /* 17 */
-    1.0f, 1.0f, 1.0f, 1.0f, /* 18 */
-    0.0f, 1.0f, 1.0f, 1.0f, /* 19 */
-
-    /* Bottom. */
-    1.0f, 0.0f, 1.0f, 1.0f, /* 20 */
-    0.0f, 0.0f, 1.0f, 1.0f, /* 21 */
-    0.0f, 0.0f, 0.0f, 1.0f, /* 22 */
-    1.0f, 0.0f, 0.0f, 1.0f, /* 23 */
+    CUBE_VERTEX_LIST(CUBE_COLOR)
+};
+
+/* Largest absolute coordinate in cubeVertices, used to quantize positions to normalized shorts. */
+#define CUBE_POSITION_SCALE 0.5f
+
+#define CUBE_PACKED(x, y, z, r, g, b, a, s, t)        PACKED_VERTEX(CUBE_POSITION_SCALE, x, y, z, r, g, b, a, s, t)
+
+static const PackedVertex cubePackedVertices[] =
+{
+    CUBE_VERTEX_LIST(CUBE_PACKED)
+};
+
+/* The cube as three separate float arrays. */
+static const VertexStreams cubeFloatStreams =
+{
+    { 3, GL_FLOAT, GL_FALSE, 0, cubeVertices },
+    { 4, GL_FLOAT, GL_FALSE, 0, cubeColors },
+    { 2, GL_FLOAT, GL_FALSE, 0, cubeTextureCoordinates },
+    1.0f,
+    (3 + 4 + 2) * sizeof(float),
+    "float",
+    { 0, 0, GL_FALSE, 0, NULL },
+    0,
+};
+
+/* The cube as interleaved PackedVertex data. */
+static const VertexStreams cubePackedStreams =
+{
+    { 3, GL_SHORT,         GL_TRUE,              sizeof(PackedVertex), &cubePackedVertices[0].position },
+    { 4, GL_UNSIGNED_BYTE, GL_TRUE,              sizeof(PackedVertex), &cubePackedVertices[0].color },
+    { 2, VERTEX_UV_TYPE,   VERTEX_UV_NORMALIZED, sizeof(PackedVertex), &cubePackedVertices[0].texCoord },
+    CUBE_POSITION_SCALE,
+    sizeof(PackedVertex),
+    "packed",
+    { 0, 0, GL_FALSE, 0, NULL },
+    0,
 };
 
 #endif /* CUBE_H */
\ No newline at end of file
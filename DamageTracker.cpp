@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DamageTracker.h"
+
+#include <cstdio>
+#include <cstring>
+
+    DamageTracker::DamageTracker(void)
+        : surfaceWidth(0), surfaceHeight(0), bytesPerPixel(0), age(0), historyFrames(0)
+    {
+        memset(&damage, 0, sizeof(damage));
+        resetStats();
+    }
+
+    void DamageTracker::setSurface(int width, int height, int bytesPerPixel)
+    {
+        surfaceWidth  = width;
+        surfaceHeight = height;
+        this->bytesPerPixel = bytesPerPixel;
+        historyFrames = 0;
+    }
+
+    void DamageTracker::beginFrame(int bufferAge)
+    {
+        age = bufferAge;
+        memset(&damage, 0, sizeof(damage));
+    }
+
+    DamageTracker::Rect DamageTracker::unite(const Rect& a, const Rect& b)
+    {
+        if (a.width <= 0 || a.height <= 0)
+        {
+            return b;
+        }
+        if (b.width <= 0 || b.height <= 0)
+        {
+            return a;
+        }
+        Rect result;
+        result.x      = a.x < b.x ? a.x : b.x;
+        result.y      = a.y < b.y ? a.y : b.y;
+        result.width  = (a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width) - result.x;
+        result.height = (a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height) - result.y;
+        return result;
+    }
+
+    void DamageTracker::addDamage(const Rect& rect)
+    {
+        Rect clipped;
+        clipped.x      = rect.x > 0 ? rect.x : 0;
+        clipped.y      = rect.y > 0 ? rect.y : 0;
+        clipped.width  = (rect.x + rect.width < surfaceWidth ? rect.x + rect.width : surfaceWidth) - clipped.x;
+        clipped.height = (rect.y + rect.height < surfaceHeight ? rect.y + rect.height : surfaceHeight) - clipped.y;
+        if (clipped.width > 0 && clipped.height > 0)
+        {
+            damage = unite(damage, clipped);
+        }
+    }
+
+    void DamageTracker::addFullDamage(void)
+    {
+        damage.x      = 0;
+        damage.y      = 0;
+        damage.width  = surfaceWidth;
+        damage.height = surfaceHeight;
+    }
+
+    DamageTracker::Rect DamageTracker::redrawRect(void) const
+    {
+        /* The buffer holds a frame we have no damage for, or nothing defined at all. */
+        if (age <= 0 || age - 1 > historyFrames)
+        {
+            Rect full = { 0, 0, surfaceWidth, surfaceHeight };
+            return full;
+        }
+        Rect redraw = damage;
+        for (int i = 0; i < age - 1; i++)
+        {
+            redraw = unite(redraw, history[i]);
+        }
+        return redraw;
+    }
+
+    void DamageTracker::endFrame(void)
+    {
+        Rect redraw = redrawRect();
+        if (redraw.width == surfaceWidth && redraw.height == surfaceHeight)
+        {
+            fullRedraws++;
+        }
+        redrawnPixels += (double)redraw.width * redraw.height;
+        surfacePixels += (double)surfaceWidth * surfaceHeight;
+        frames++;
+
+        memmove(&history[1], &history[0], (historyLength - 1) * sizeof(history[0]));
+        history[0] = damage;
+        historyFrames = historyFrames < historyLength ? historyFrames + 1 : historyLength;
+    }
+
+    void DamageTracker::printStats(const char* label) const
+    {
+        if (frames == 0 || surfacePixels == 0)
+        {
+            return;
+        }
+        fprintf(stderr, "Damage (%s): redrew %.1f%% of the surface, %u of %u frames in full, "
+                "%.2f of %.2f MB/frame color and depth written\n",
+                label,
+                100.0 * redrawnPixels / surfacePixels,
+                fullRedraws, frames,
+                redrawnPixels * bytesPerPixel / frames / 1e6,
+                surfacePixels * bytesPerPixel / frames / 1e6);
+    }
+
+    void DamageTracker::resetStats(void)
+    {
+        frames        = 0;
+        fullRedraws   = 0;
+        redrawnPixels = 0;
+        surfacePixels = 0;
+    }
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DAMAGETRACKER_H
+#define DAMAGETRACKER_H
+
+/**
+ * \file DamageTracker.h
+ * \brief The parts of the window each frame changes, and what a back buffer needs redrawn.
+ */
+
+    /**
+     * \brief Accumulates per-frame damage and resolves it against the back buffer's age.
+     *
+     * A frame's damage is the area where its contents differ from the frame before. A back
+     * buffer of age N (EGL_EXT_buffer_age) still holds the frame from N swaps ago, so only the
+     * damage of the last N frames, this one included, has to be redrawn into it. An age of 0
+     * means the contents are undefined and everything is redrawn, as is a buffer older than the
+     * history. Damage is kept as one bounding rectangle per frame, which is what a scissor
+     * box can clip to.
+     */
+    class DamageTracker
+    {
+    public:
+        /**
+         * \brief Frames of damage kept, the oldest back buffer that can be redrawn in part.
+         */
+        static const int historyLength = 4;
+
+        /**
+         * \brief A rectangle in window coordinates, origin in the bottom left corner as for
+         * glScissor. Empty if width or height is 0.
+         */
+        struct Rect
+        {
+            int x;
+            int y;
+            int width;
+            int height;
+        };
+
+        DamageTracker(void);
+
+        /**
+         * \brief Set the surface size, forgetting the damage history.
+         * \param[in] bytesPerPixel Color and depth bytes written per pixel redrawn, for statistics.
+         */
+        void setSurface(int width, int height, int bytesPerPixel);
+
+        /**
+         * \brief Start collecting the damage of a new frame.
+         * \param[in] bufferAge Age of the back buffer about to be drawn, 0 if unknown.
+         */
+        void beginFrame(int bufferAge);
+
+        /**
+         * \brief Add an area the frame changes, clipped to the surface.
+         */
+        void addDamage(const Rect& rect);
+
+        /**
+         * \brief Mark the whole surface as changed.
+         */
+        void addFullDamage(void);
+
+        /**
+         * \brief What has to be drawn into the back buffer for it to hold this frame.
+         */
+        Rect redrawRect(void) const;
+
+        /**
+         * \brief The damage of this frame, for presenting with swap-buffers-with-damage.
+         */
+        const Rect& frameDamage(void) const { return damage; }
+
+        /**
+         * \brief Finish the frame: keep its damage and count what redrawRect() redrew.
+         */
+        void endFrame(void);
+
+        /**
+         * \brief Print how much of the surface was redrawn to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        static Rect unite(const Rect& a, const Rect& b);
+
+        int             surfaceWidth;
+        int             surfaceHeight;
+        int             bytesPerPixel;
+        int             age;
+        Rect            damage;
+        /* history[0] is the damage of the previous frame, history[1] of the one before. */
+        Rect            history[historyLength];
+        int             historyFrames;
+
+        unsigned int    frames;
+        unsigned int    fullRedraws;
+        /* Pixels, in doubles so that long intervals at large sizes cannot overflow. */
+        double          redrawnPixels;
+        double          surfacePixels;
+    };
+
+#endif /* DAMAGETRACKER_H */
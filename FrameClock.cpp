@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameClock.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+
+    FrameClock::FrameClock(nsecs_t simulationStep)
+        : step(simulationStep), targetInterval(0), lastFrameStart(0), nextDeadline(0),
+          frameTime(0), latency(0), accumulator(0), steps(0)
+    {
+        resetStats();
+    }
+
+    void FrameClock::setTargetFrameRate(unsigned int framesPerSecond)
+    {
+        targetInterval = framesPerSecond ? seconds_to_nanoseconds(1) / framesPerSecond : 0;
+        nextDeadline = 0;
+    }
+
+    void FrameClock::beginFrame(void)
+    {
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+
+        /* The first frame only establishes the time base and simulates a single step; with
+         * no frame before it, it has no frame time to count. */
+        bool first = lastFrameStart == 0;
+        frameTime = first ? step : now - lastFrameStart;
+        lastFrameStart = now;
+
+        accumulator += frameTime;
+        steps = (int)(accumulator / step);
+        if (steps > maxStepsPerFrame)
+        {
+            /* Drop the time we cannot catch up on instead of running the simulation ever longer. */
+            steps = maxStepsPerFrame;
+            accumulator = step * maxStepsPerFrame;
+        }
+        accumulator -= step * steps;
+
+        if (first)
+        {
+            return;
+        }
+        if (frameStats.frames == 0 || frameTime < frameStats.minFrameTime)
+        {
+            frameStats.minFrameTime = frameTime;
+        }
+        if (frameTime > frameStats.maxFrameTime)
+        {
+            frameStats.maxFrameTime = frameTime;
+        }
+        frameStats.totalFrameTime += frameTime;
+        frameStats.frames++;
+    }
+
+    void FrameClock::framePresented(nsecs_t inputTime)
+    {
+        latency = systemTime(SYSTEM_TIME_MONOTONIC) - inputTime;
+        if (frameStats.presented == 0 || latency < frameStats.minLatency)
+        {
+            frameStats.minLatency = latency;
+        }
+        if (latency > frameStats.maxLatency)
+        {
+            frameStats.maxLatency = latency;
+        }
+        frameStats.totalLatency += latency;
+        frameStats.presented++;
+    }
+
+    void FrameClock::endFrame(void)
+    {
+        if (targetInterval == 0)
+        {
+            return;
+        }
+
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        nextDeadline = nextDeadline ? nextDeadline + targetInterval : now + targetInterval;
+
+        /* Fell more than a frame behind: restart pacing from now rather than racing to catch up. */
+        if (nextDeadline < now - targetInterval)
+        {
+            nextDeadline = now;
+            return;
+        }
+        if (nextDeadline <= now)
+        {
+            return;
+        }
+
+        struct timespec deadline;
+        deadline.tv_sec  = nextDeadline / seconds_to_nanoseconds(1);
+        deadline.tv_nsec = nextDeadline % seconds_to_nanoseconds(1);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+        {
+        }
+        frameStats.totalSleepTime += systemTime(SYSTEM_TIME_MONOTONIC) - now;
+    }
+
+    void FrameClock::printStats(const char* label) const
+    {
+        if (frameStats.frames == 0)
+        {
+            return;
+        }
+        nsecs_t average = frameStats.totalFrameTime / frameStats.frames;
+        fprintf(stderr, "Frame time (%s): min %.2f ms, avg %.2f ms (%.1f fps), max %.2f ms, slept %.2f ms/frame\n",
+                label,
+                frameStats.minFrameTime / 1e6,
+                average / 1e6,
+                average ? 1e9 / average : 0.0,
+                frameStats.maxFrameTime / 1e6,
+                frameStats.totalSleepTime / 1e6 / frameStats.frames);
+        if (frameStats.presented != 0)
+        {
+            fprintf(stderr, "Present latency (%s): min %.2f ms, avg %.2f ms, max %.2f ms\n",
+                    label,
+                    frameStats.minLatency / 1e6,
+                    frameStats.totalLatency / 1e6 / frameStats.presented,
+                    frameStats.maxLatency / 1e6);
+        }
+    }
+
+    void FrameClock::resetStats(void)
+    {
+        memset(&frameStats, 0, sizeof(frameStats));
+    }
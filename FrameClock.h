@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <utils/Timers.h>
+
+/**
+ * \file FrameClock.h
+ * \brief Monotonic frame timing, fixed timestep simulation and frame pacing.
+ */
+
+    /**
+     * \brief Drives the main loop from the monotonic clock.
+     *
+     * Each frame the loop calls beginFrame(), then steps the simulation once per
+     * stepsToSimulate() with a fixed timestep, renders with interpolation factor alpha()
+     * between the last two simulated states, and finally calls endFrame() which sleeps
+     * until the next frame is due when a target frame rate is set. framePresented(), called
+     * once the frame has been handed to the display, measures the latency from the time the
+     * frame sampled its input to presentation.
+     */
+    class FrameClock
+    {
+    public:
+        /**
+         * \brief Simulation steps are capped per frame so a long stall cannot snowball.
+         */
+        static const int maxStepsPerFrame = 8;
+
+        /**
+         * \brief Frame time statistics over an interval.
+         */
+        struct Stats
+        {
+            unsigned int    frames;
+            nsecs_t         minFrameTime;
+            nsecs_t         maxFrameTime;
+            nsecs_t         totalFrameTime;
+            /** Time spent sleeping for frame pacing. */
+            nsecs_t         totalSleepTime;
+            /** Frames that framePresented() was called for. */
+            unsigned int    presented;
+            nsecs_t         minLatency;
+            nsecs_t         maxLatency;
+            nsecs_t         totalLatency;
+        };
+
+        /**
+         * \param[in] simulationStep Length of one simulation step in nanoseconds.
+         */
+        FrameClock(nsecs_t simulationStep);
+
+        /**
+         * \brief Pace frames to a target rate.
+         * \param[in] framesPerSecond The target rate, 0 to run unthrottled.
+         */
+        void setTargetFrameRate(unsigned int framesPerSecond);
+
+        /**
+         * \brief Start a frame: sample the clock and add the elapsed time to the simulation budget.
+         */
+        void beginFrame(void);
+
+        /**
+         * \brief Number of fixed simulation steps to run this frame.
+         */
+        int stepsToSimulate(void) const { return steps; }
+
+        /**
+         * \brief Simulation step length in seconds.
+         */
+        float stepSeconds(void) const { return step / 1e9f; }
+
+        /**
+         * \brief How far between the previous and the current simulation state the frame is, in [0, 1).
+         */
+        float alpha(void) const { return (float)accumulator / (float)step; }
+
+        /**
+         * \brief Record that the frame begun last has been presented, as far as the caller can tell.
+         * \param[in] inputTime When the frame's state was sampled, on the monotonic clock.
+         */
+        void framePresented(nsecs_t inputTime);
+
+        /**
+         * \brief Finish a frame, sleeping until the next frame deadline if pacing is enabled.
+         */
+        void endFrame(void);
+
+        /**
+         * \brief Time between the last two beginFrame() calls.
+         */
+        nsecs_t lastFrameTime(void) const { return frameTime; }
+
+        /**
+         * \brief Latency recorded by the last framePresented().
+         */
+        nsecs_t lastLatency(void) const { return latency; }
+
+        const Stats& stats(void) const { return frameStats; }
+
+        /**
+         * \brief Print the frame time statistics to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        nsecs_t     step;
+        nsecs_t     targetInterval;
+        nsecs_t     lastFrameStart;
+        nsecs_t     nextDeadline;
+        nsecs_t     frameTime;
+        nsecs_t     latency;
+        nsecs_t     accumulator;
+        int         steps;
+        Stats       frameStats;
+    };
+
+#endif /* FRAMECLOCK_H */
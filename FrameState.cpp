@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameState.h"
+
+#include <cutils/atomic.h>
+#include <cutils/atomic-inline.h>
+
+    FrameStateBuffer::FrameStateBuffer(void)
+        : ready(1), back(0), front(2)
+    {
+    }
+
+    void FrameStateBuffer::publish(void)
+    {
+        /* Each exchange hands a slot both ways, so it must be both release and acquire on
+         * either side. Release, so the consumer sees the slot's contents before it sees the
+         * slot; and a full barrier after, so that the producer's writes into the slot it gets
+         * back cannot move before the exchange, while the consumer may still be reading it.
+         * acquire() pairs with this the other way round. */
+        int32_t previous;
+        do
+        {
+            previous = ready;
+        } while (android_atomic_release_cas(previous, back | fresh, &ready) != 0);
+        ANDROID_MEMBAR_FULL();
+        back = previous & ~fresh;
+    }
+
+    bool FrameStateBuffer::acquire(void)
+    {
+        if ((android_atomic_acquire_load(&ready) & fresh) == 0)
+        {
+            return false;
+        }
+        /* Only publish() changes ready meanwhile, and only to another fresh slot. The full
+         * barrier orders the reads of the old front slot before handing it back to the producer;
+         * the acquire makes the new slot's contents visible. */
+        int32_t previous;
+        ANDROID_MEMBAR_FULL();
+        do
+        {
+            previous = ready;
+        } while (android_atomic_acquire_cas(previous, front, &ready) != 0);
+        front = previous & ~fresh;
+        return true;
+    }
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMESTATE_H
+#define FRAMESTATE_H
+
+#include <stdint.h>
+#include <utils/Timers.h>
+
+#include "Matrix.h"
+#include "DamageTracker.h"
+
+/**
+ * \file FrameState.h
+ * \brief Everything the simulation prepares for rendering one frame, and its handoff.
+ */
+
+    /**
+     * \brief The transforms of one frame, ready to upload.
+     */
+    struct FrameState
+    {
+        /** When the simulation sampled the state, the frame's input time. */
+        nsecs_t             sampleTime;
+        Matrix              fboModelView;
+        Matrix              fboMvp;
+        Matrix              mainModelView;
+        Matrix              mainMvp;
+        /** Window area covered by the main cube. */
+        DamageTracker::Rect mainBounds;
+        /** The main cube's rotation about x, y and z, in degrees. */
+        float               angles[3];
+    };
+
+    /**
+     * \brief Hands frame states from one producer thread to one consumer thread, lock-free.
+     *
+     * Three slots: the producer fills its own, then publish() swaps it with the ready slot;
+     * acquire() swaps the ready slot, if a newer state was published, with the consumer's own.
+     * Neither side ever waits for the other or sees a slot being written, and the consumer
+     * always gets the newest state published, skipping any it was too slow for.
+     */
+    class FrameStateBuffer
+    {
+    public:
+        FrameStateBuffer(void);
+
+        /**
+         * \brief The slot the producer fills next.
+         */
+        FrameState* writeSlot(void) { return &slots[back]; }
+
+        /**
+         * \brief Make the filled slot the newest state.
+         */
+        void publish(void);
+
+        /**
+         * \brief Take the newest state, if one was published since the last call.
+         * \return false if there was none; readSlot() is then unchanged.
+         */
+        bool acquire(void);
+
+        /**
+         * \brief The state the consumer acquired last.
+         */
+        FrameState* readSlot(void) { return &slots[front]; }
+
+    private:
+        /* Set in ready when its slot holds a state the consumer has not taken yet. */
+        static const int32_t fresh = 4;
+
+        FrameState          slots[3];
+        /* Index of the slot in between the two threads, or'ed with fresh. */
+        volatile int32_t    ready;
+        int                 back;
+        int                 front;
+    };
+
+#endif /* FRAMESTATE_H */
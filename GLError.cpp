@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLError.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_ANDROID_OS
+#include "EGLUtils.h"
+
+using namespace android;
+
+#define eglErrorString(error) EGLUtils::strerror(error)
+#else
+/* EGLUtils is not available to host builds. */
+static const char* eglErrorString(EGLint error)
+{
+  switch (error)
+  {
+    case EGL_SUCCESS:             return "EGL_SUCCESS";
+    case EGL_NOT_INITIALIZED:     return "EGL_NOT_INITIALIZED";
+    case EGL_BAD_ACCESS:          return "EGL_BAD_ACCESS";
+    case EGL_BAD_ALLOC:           return "EGL_BAD_ALLOC";
+    case EGL_BAD_ATTRIBUTE:       return "EGL_BAD_ATTRIBUTE";
+    case EGL_BAD_CONFIG:          return "EGL_BAD_CONFIG";
+    case EGL_BAD_CONTEXT:         return "EGL_BAD_CONTEXT";
+    case EGL_BAD_CURRENT_SURFACE: return "EGL_BAD_CURRENT_SURFACE";
+    case EGL_BAD_DISPLAY:         return "EGL_BAD_DISPLAY";
+    case EGL_BAD_MATCH:           return "EGL_BAD_MATCH";
+    case EGL_BAD_NATIVE_PIXMAP:   return "EGL_BAD_NATIVE_PIXMAP";
+    case EGL_BAD_NATIVE_WINDOW:   return "EGL_BAD_NATIVE_WINDOW";
+    case EGL_BAD_PARAMETER:       return "EGL_BAD_PARAMETER";
+    case EGL_BAD_SURFACE:         return "EGL_BAD_SURFACE";
+    case EGL_CONTEXT_LOST:        return "EGL_CONTEXT_LOST";
+    default:                      return "UNKNOWN";
+  }
+}
+#endif
+#include "GLTrace.h"
+
+GLErrorCheckPolicy glErrorCheckPolicy = GL2_CUBE_ERROR_CHECK;
+
+static unsigned int sampleFrames = 60;
+static unsigned int errorCount = 0;
+
+void setGlErrorCheckPolicy(GLErrorCheckPolicy policy, unsigned int sampleInterval)
+{
+#if !GL2_CUBE_STRICT_ERROR_CHECK
+  if (policy == GL_ERROR_CHECK_STRICT)
+  {
+    fprintf(stderr, "Strict error checks are compiled out, checking once per frame.\n");
+    policy = GL_ERROR_CHECK_FRAME;
+  }
+#endif
+  glErrorCheckPolicy = policy;
+  sampleFrames = sampleInterval ? sampleInterval : 1;
+}
+
+bool parseGlErrorCheckPolicy(const char* text)
+{
+  if (strcmp(text, "off") == 0)
+  {
+    setGlErrorCheckPolicy(GL_ERROR_CHECK_OFF, sampleFrames);
+  }
+  else if (strcmp(text, "frame") == 0)
+  {
+    setGlErrorCheckPolicy(GL_ERROR_CHECK_FRAME, sampleFrames);
+  }
+  else if (strncmp(text, "sample", 6) == 0 && (text[6] == '\0' || text[6] == ':'))
+  {
+    unsigned int interval = text[6] == ':' ? (unsigned int)atoi(text + 7) : sampleFrames;
+    if (interval == 0)
+    {
+      return false;
+    }
+    setGlErrorCheckPolicy(GL_ERROR_CHECK_SAMPLED, interval);
+  }
+  else if (strcmp(text, "strict") == 0)
+  {
+    setGlErrorCheckPolicy(GL_ERROR_CHECK_STRICT, sampleFrames);
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+int checkGlError(const char* op)
+{
+  int count = 0;
+  for(GLint error = glGetError();
+      error;
+      error = glGetError())
+  {
+    fprintf(stderr, "after %s() glError (0x%x)\n", op, error);
+    count++;
+  }
+  errorCount += count;
+  return count;
+}
+
+int checkGlErrorAt(const char* op, const char* file, int line)
+{
+  int count = 0;
+  for(GLint error = glGetError();
+      error;
+      error = glGetError())
+  {
+    fprintf(stderr, "%s:%d: after %s() glError (0x%x)\n", file, line, op, error);
+    count++;
+  }
+  errorCount += count;
+  return count;
+}
+
+int checkEglError(const char* op, EGLBoolean returnVal)
+{
+  int count = 0;
+  if (returnVal != EGL_TRUE)
+  {
+    fprintf(stderr, "%s() returned %d\n", op, returnVal);
+    count++;
+  }
+
+  for(EGLint error = eglGetError();
+      error != EGL_SUCCESS;
+      error = eglGetError())
+  {
+    fprintf(stderr, "after %s() eglError %s (0x%x)\n",op,
+                                                      eglErrorString(error),
+                                                      error);
+    count++;
+  }
+  errorCount += count;
+  return count;
+}
+
+void checkFrameErrors(unsigned int frame)
+{
+  char op[32];
+
+  switch (glErrorCheckPolicy)
+  {
+    case GL_ERROR_CHECK_OFF:
+      return;
+    case GL_ERROR_CHECK_SAMPLED:
+      if (frame % sampleFrames != 0)
+      {
+        return;
+      }
+      break;
+    case GL_ERROR_CHECK_FRAME:
+    case GL_ERROR_CHECK_STRICT:
+      break;
+  }
+
+  snprintf(op, sizeof(op), "frame %u", frame);
+  checkGlError(op);
+  checkEglError(op);
+}
+
+unsigned int glErrorCount(void)
+{
+  return errorCount;
+}
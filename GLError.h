@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLERROR_H
+#define GLERROR_H
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+/**
+ * \file GLError.h
+ * \brief GL and EGL error checking with a selectable cost.
+ *
+ * glGetError can force a pipeline sync on some drivers, so how often it is called is a
+ * policy:
+ *  - off:      never check.
+ *  - frame:    check once at the end of every frame.
+ *  - sample:N: check at the end of every Nth frame.
+ *  - strict:   check after every GL_CHECK() call site, reporting file and line.
+ *
+ * The default policy is GL2_CUBE_ERROR_CHECK if defined, otherwise strict in debug builds
+ * and frame in release (NDEBUG) builds. GL_CHECK() compiles to nothing in release builds
+ * unless GL2_CUBE_STRICT_ERROR_CHECK is defined to 1, so there the strict policy degrades
+ * to frame.
+ */
+
+#ifndef GL2_CUBE_STRICT_ERROR_CHECK
+#ifdef NDEBUG
+#define GL2_CUBE_STRICT_ERROR_CHECK 0
+#else
+#define GL2_CUBE_STRICT_ERROR_CHECK 1
+#endif
+#endif
+
+    /**
+     * \brief How often GL and EGL errors are queried.
+     */
+    enum GLErrorCheckPolicy
+    {
+        GL_ERROR_CHECK_OFF,
+        GL_ERROR_CHECK_FRAME,
+        GL_ERROR_CHECK_SAMPLED,
+        GL_ERROR_CHECK_STRICT
+    };
+
+#ifndef GL2_CUBE_ERROR_CHECK
+#if GL2_CUBE_STRICT_ERROR_CHECK
+#define GL2_CUBE_ERROR_CHECK GL_ERROR_CHECK_STRICT
+#else
+#define GL2_CUBE_ERROR_CHECK GL_ERROR_CHECK_FRAME
+#endif
+#endif
+
+    /**
+     * \brief The active policy, read by GL_CHECK() at every call site.
+     */
+    extern GLErrorCheckPolicy glErrorCheckPolicy;
+
+    /**
+     * \brief Set the active policy.
+     * \param[in] policy The new policy.
+     * \param[in] sampleInterval Frames between checks for GL_ERROR_CHECK_SAMPLED.
+     */
+    void setGlErrorCheckPolicy(GLErrorCheckPolicy policy, unsigned int sampleInterval);
+
+    /**
+     * \brief Set the active policy from its command line name ("off", "frame", "sample:N", "strict").
+     * \return false if text does not name a policy.
+     */
+    bool parseGlErrorCheckPolicy(const char* text);
+
+    /**
+     * \brief Print all pending GL errors, regardless of the policy.
+     * \param[in] op Name of the operation the errors are attributed to.
+     * \return The number of errors found.
+     */
+    int checkGlError(const char* op);
+
+    /**
+     * \brief Print all pending GL errors with the call site, regardless of the policy.
+     */
+    int checkGlErrorAt(const char* op, const char* file, int line);
+
+    /**
+     * \brief Print a failed EGL return value and all pending EGL errors, regardless of the policy.
+     */
+    int checkEglError(const char* op, EGLBoolean returnVal = EGL_TRUE);
+
+    /**
+     * \brief Run the end of frame checks the policy asks for.
+     * \param[in] frame The number of the frame that just finished.
+     */
+    void checkFrameErrors(unsigned int frame);
+
+    /**
+     * \brief Total errors reported since startup.
+     */
+    unsigned int glErrorCount(void);
+
+#if GL2_CUBE_STRICT_ERROR_CHECK
+#define GL_CHECK(op)                                                    \
+    do                                                                  \
+    {                                                                   \
+        if (glErrorCheckPolicy == GL_ERROR_CHECK_STRICT)                \
+        {                                                               \
+            checkGlErrorAt(op, __FILE__, __LINE__);                     \
+        }                                                               \
+    } while (0)
+#else
+#define GL_CHECK(op) ((void)0)
+#endif
+
+#endif /* GLERROR_H */
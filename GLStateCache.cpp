@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLStateCache.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include "GLTrace.h"
+
+    static const GLuint unknownBinding = 0xFFFFFFFF;
+
+    static const char* const callNames[GL_STATE_CALL_COUNT] =
+    {
+        "glUseProgram",
+        "glEnable/glDisable",
+        "glEnable/DisableVertexAttribArray",
+        "glVertexAttribPointer",
+        "glBindBuffer",
+        "glActiveTexture",
+        "glBindTexture",
+        "glBindFramebuffer",
+        "glViewport",
+        "glScissor",
+        "glClearColor",
+        "glUniform*",
+    };
+
+    GLStateCache::GLStateCache(void)
+        : uniformEpoch(0)
+    {
+        invalidate();
+        resetStats();
+        /* A new context starts with every attribute array disabled. */
+        for (int i = 0; i < maxVertexAttribs; i++)
+        {
+            attribs[i].enabled = 0;
+        }
+    }
+
+    void GLStateCache::invalidate(void)
+    {
+        programValid = false;
+        program = 0;
+        memset(caps, -1, sizeof(caps));
+        memset(attribs, 0, sizeof(attribs));
+        for (int i = 0; i < maxVertexAttribs; i++)
+        {
+            attribs[i].enabled = -1;
+        }
+        arrayBufferValid = false;
+        elementArrayBufferValid = false;
+        activeTextureValid = false;
+        memset(textures, 0xFF, sizeof(textures));
+        framebufferValid = false;
+        framebuffer = 0;
+        viewportValid = false;
+        scissorValid = false;
+        clearColorValid = false;
+        /* Starts at 1 so a zeroed slot never matches. */
+        uniformEpoch++;
+        if (uniformEpoch == 0)
+        {
+            uniformEpoch = 1;
+        }
+    }
+
+    bool GLStateCache::filter(GLStateCall call, bool changed)
+    {
+        if (changed)
+        {
+            callStats[call].issued++;
+        }
+        else
+        {
+            callStats[call].skipped++;
+        }
+        return changed;
+    }
+
+    int GLStateCache::capIndex(GLenum cap)
+    {
+        switch (cap)
+        {
+            case GL_BLEND:          return capBlend;
+            case GL_CULL_FACE:      return capCullFace;
+            case GL_DEPTH_TEST:     return capDepthTest;
+            case GL_SCISSOR_TEST:   return capScissorTest;
+            default:                return -1;
+        }
+    }
+
+    int GLStateCache::textureTargetIndex(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_TEXTURE_2D:             return 0;
+            case GL_TEXTURE_EXTERNAL_OES:   return 1;
+            default:                        return -1;
+        }
+    }
+
+    void GLStateCache::useProgram(GLuint newProgram)
+    {
+        if (filter(GL_STATE_USE_PROGRAM, !programValid || program != newProgram))
+        {
+            glUseProgram(newProgram);
+            programValid = true;
+            program = newProgram;
+        }
+    }
+
+    void GLStateCache::enable(GLenum cap)
+    {
+        int index = capIndex(cap);
+        if (filter(GL_STATE_ENABLE, index == -1 || caps[index] != 1))
+        {
+            glEnable(cap);
+            if (index != -1)
+            {
+                caps[index] = 1;
+            }
+        }
+    }
+
+    void GLStateCache::disable(GLenum cap)
+    {
+        int index = capIndex(cap);
+        if (filter(GL_STATE_ENABLE, index == -1 || caps[index] != 0))
+        {
+            glDisable(cap);
+            if (index != -1)
+            {
+                caps[index] = 0;
+            }
+        }
+    }
+
+    void GLStateCache::enableVertexAttribArray(GLuint index)
+    {
+        bool tracked = index < (GLuint)maxVertexAttribs;
+        if (filter(GL_STATE_ENABLE_VERTEX_ATTRIB_ARRAY, !tracked || attribs[index].enabled != 1))
+        {
+            glEnableVertexAttribArray(index);
+            if (tracked)
+            {
+                attribs[index].enabled = 1;
+            }
+        }
+    }
+
+    void GLStateCache::disableVertexAttribArray(GLuint index)
+    {
+        /* Attribute arrays start disabled, so an untouched slot needs no call either; after
+         * invalidate() the state is unknown and the call goes through. */
+        bool tracked = index < (GLuint)maxVertexAttribs;
+        if (filter(GL_STATE_ENABLE_VERTEX_ATTRIB_ARRAY, !tracked || attribs[index].enabled != 0))
+        {
+            glDisableVertexAttribArray(index);
+            if (tracked)
+            {
+                attribs[index].enabled = 0;
+            }
+        }
+    }
+
+    void GLStateCache::vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                           GLsizei stride, const GLvoid* pointer)
+    {
+        /* The pointer is an offset into the bound array buffer, so that binding is part of the state. */
+        GLuint buffer = arrayBufferValid ? arrayBuffer : unknownBinding;
+        bool changed = true;
+
+        if (index < (GLuint)maxVertexAttribs && buffer != unknownBinding)
+        {
+            VertexAttrib& attrib = attribs[index];
+            changed = !attrib.valid || attrib.size != size || attrib.type != type ||
+                      attrib.normalized != normalized || attrib.stride != stride ||
+                      attrib.pointer != pointer || attrib.buffer != buffer;
+        }
+
+        if (filter(GL_STATE_VERTEX_ATTRIB_POINTER, changed))
+        {
+            glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+            if (index < (GLuint)maxVertexAttribs)
+            {
+                VertexAttrib& attrib = attribs[index];
+                attrib.valid = buffer != unknownBinding;
+                attrib.size = size;
+                attrib.type = type;
+                attrib.normalized = normalized;
+                attrib.stride = stride;
+                attrib.pointer = pointer;
+                attrib.buffer = buffer;
+            }
+        }
+    }
+
+    void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+    {
+        if (target == GL_ARRAY_BUFFER)
+        {
+            if (filter(GL_STATE_BIND_BUFFER, !arrayBufferValid || arrayBuffer != buffer))
+            {
+                glBindBuffer(target, buffer);
+                arrayBufferValid = true;
+                arrayBuffer = buffer;
+            }
+        }
+        else if (target == GL_ELEMENT_ARRAY_BUFFER)
+        {
+            if (filter(GL_STATE_BIND_BUFFER, !elementArrayBufferValid || elementArrayBuffer != buffer))
+            {
+                glBindBuffer(target, buffer);
+                elementArrayBufferValid = true;
+                elementArrayBuffer = buffer;
+            }
+        }
+        else
+        {
+            filter(GL_STATE_BIND_BUFFER, true);
+            glBindBuffer(target, buffer);
+        }
+    }
+
+    void GLStateCache::activeTexture(GLenum texture)
+    {
+        if (filter(GL_STATE_ACTIVE_TEXTURE, !activeTextureValid || activeTextureUnit != texture))
+        {
+            glActiveTexture(texture);
+            activeTextureValid = true;
+            activeTextureUnit = texture;
+        }
+    }
+
+    void GLStateCache::bindTexture(GLenum target, GLuint texture)
+    {
+        int targetIndex = textureTargetIndex(target);
+        int unit = activeTextureValid ? (int)(activeTextureUnit - GL_TEXTURE0) : -1;
+        bool tracked = targetIndex != -1 && unit >= 0 && unit < maxTextureUnits;
+
+        if (filter(GL_STATE_BIND_TEXTURE, !tracked || textures[unit][targetIndex] != texture))
+        {
+            glBindTexture(target, texture);
+            if (tracked)
+            {
+                textures[unit][targetIndex] = texture;
+            }
+        }
+    }
+
+    void GLStateCache::bindFramebuffer(GLenum target, GLuint newFramebuffer)
+    {
+        if (filter(GL_STATE_BIND_FRAMEBUFFER, !framebufferValid || framebuffer != newFramebuffer))
+        {
+            glBindFramebuffer(target, newFramebuffer);
+            framebufferValid = true;
+            framebuffer = newFramebuffer;
+        }
+    }
+
+    void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        GLint rect[4] = { x, y, width, height };
+        if (filter(GL_STATE_VIEWPORT, !viewportValid || memcmp(rect, viewportRect, sizeof(rect)) != 0))
+        {
+            glViewport(x, y, width, height);
+            viewportValid = true;
+            memcpy(viewportRect, rect, sizeof(rect));
+        }
+    }
+
+    void GLStateCache::scissor(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        GLint rect[4] = { x, y, width, height };
+        if (filter(GL_STATE_SCISSOR, !scissorValid || memcmp(rect, scissorRect, sizeof(rect)) != 0))
+        {
+            glScissor(x, y, width, height);
+            scissorValid = true;
+            memcpy(scissorRect, rect, sizeof(rect));
+        }
+    }
+
+    void GLStateCache::clearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+    {
+        GLclampf color[4] = { red, green, blue, alpha };
+        if (filter(GL_STATE_CLEAR_COLOR, !clearColorValid || memcmp(color, clearColorValue, sizeof(color)) != 0))
+        {
+            glClearColor(red, green, blue, alpha);
+            clearColorValid = true;
+            memcpy(clearColorValue, color, sizeof(color));
+        }
+    }
+
+    void GLStateCache::bindUniformSlot(UniformSlot& slot, GLuint program, const char* name)
+    {
+        slot = UniformSlot();
+        slot.program = program;
+        slot.location = glGetUniformLocation(program, name);
+    }
+
+    bool GLStateCache::selectSlot(const UniformSlot& slot)
+    {
+        if (slot.location == -1)
+        {
+            return false;
+        }
+        useProgram(slot.program);
+        return true;
+    }
+
+    bool GLStateCache::uniformChanged(UniformSlot& slot, const GLfloat* value, GLsizei size, unsigned int generation)
+    {
+        if (slot.epoch == uniformEpoch && slot.size == size)
+        {
+            if (generation != 0 ? generation == slot.generation :
+                                  memcmp(slot.value, value, size * sizeof(GLfloat)) == 0)
+            {
+                return false;
+            }
+        }
+        slot.epoch = uniformEpoch;
+        slot.generation = generation;
+        slot.size = size;
+        memcpy(slot.value, value, size * sizeof(GLfloat));
+        return true;
+    }
+
+    void GLStateCache::uniform1i(UniformSlot& slot, GLint value)
+    {
+        /* Stored bitwise in the float shadow; only equality matters. */
+        GLfloat bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if (selectSlot(slot) && filter(GL_STATE_UNIFORM, uniformChanged(slot, &bits, 1, 0)))
+        {
+            glUniform1i(slot.location, value);
+        }
+    }
+
+    void GLStateCache::uniform1f(UniformSlot& slot, GLfloat value)
+    {
+        if (selectSlot(slot) && filter(GL_STATE_UNIFORM, uniformChanged(slot, &value, 1, 0)))
+        {
+            glUniform1f(slot.location, value);
+        }
+    }
+
+    void GLStateCache::uniformMatrix4fv(UniformSlot& slot, const GLfloat* value, unsigned int generation)
+    {
+        if (selectSlot(slot) && filter(GL_STATE_UNIFORM, uniformChanged(slot, value, 16, generation)))
+        {
+            glUniformMatrix4fv(slot.location, 1, GL_FALSE, value);
+        }
+    }
+
+    void GLStateCache::uniform4fv(UniformSlot& slot, GLsizei count, const GLfloat* value)
+    {
+        if (selectSlot(slot) && filter(GL_STATE_UNIFORM, true))
+        {
+            glUniform4fv(slot.location, count, value);
+        }
+    }
+
+    void GLStateCache::endFrame(void)
+    {
+        lastFrameUniforms.issued  = callStats[GL_STATE_UNIFORM].issued  - frameStartUniforms.issued;
+        lastFrameUniforms.skipped = callStats[GL_STATE_UNIFORM].skipped - frameStartUniforms.skipped;
+        frameStartUniforms = callStats[GL_STATE_UNIFORM];
+        frames++;
+    }
+
+    unsigned int GLStateCache::totalIssued(void) const
+    {
+        unsigned int total = 0;
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++)
+        {
+            total += callStats[i].issued;
+        }
+        return total;
+    }
+
+    unsigned int GLStateCache::totalSkipped(void) const
+    {
+        unsigned int total = 0;
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++)
+        {
+            total += callStats[i].skipped;
+        }
+        return total;
+    }
+
+    void GLStateCache::printStats(const char* label) const
+    {
+        fprintf(stderr, "GL state cache (%s): %u issued, %u skipped\n", label, totalIssued(), totalSkipped());
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++)
+        {
+            if (callStats[i].issued || callStats[i].skipped)
+            {
+                fprintf(stderr, "  %-34s %8u issued %8u skipped\n", callNames[i],
+                        callStats[i].issued, callStats[i].skipped);
+            }
+        }
+        if (frames)
+        {
+            fprintf(stderr, "  uniform uploads per frame: %.1f issued %.1f skipped (last frame %u issued %u skipped)\n",
+                    callStats[GL_STATE_UNIFORM].issued / (float)frames,
+                    callStats[GL_STATE_UNIFORM].skipped / (float)frames,
+                    lastFrameUniforms.issued, lastFrameUniforms.skipped);
+        }
+    }
+
+    void GLStateCache::resetStats(void)
+    {
+        memset(callStats, 0, sizeof(callStats));
+        memset(&frameStartUniforms, 0, sizeof(frameStartUniforms));
+        memset(&lastFrameUniforms, 0, sizeof(lastFrameUniforms));
+        frames = 0;
+    }
@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+/**
+ * \file GLStateCache.h
+ * \brief Shadow copy of the GL state the application touches.
+ */
+
+    /**
+     * \brief The calls filtered by GLStateCache, used to index its statistics.
+     */
+    enum GLStateCall
+    {
+        GL_STATE_USE_PROGRAM,
+        GL_STATE_ENABLE,
+        GL_STATE_ENABLE_VERTEX_ATTRIB_ARRAY,
+        GL_STATE_VERTEX_ATTRIB_POINTER,
+        GL_STATE_BIND_BUFFER,
+        GL_STATE_ACTIVE_TEXTURE,
+        GL_STATE_BIND_TEXTURE,
+        GL_STATE_BIND_FRAMEBUFFER,
+        GL_STATE_VIEWPORT,
+        GL_STATE_SCISSOR,
+        GL_STATE_CLEAR_COLOR,
+        GL_STATE_UNIFORM,
+        GL_STATE_CALL_COUNT
+    };
+
+    /**
+     * \brief One uniform of one program, with the value last uploaded to it.
+     *
+     * Programs keep one slot per uniform they set (see ShaderVariant), so checking whether an
+     * upload is redundant is a compare against the slot rather than a lookup.
+     */
+    struct UniformSlot
+    {
+        GLuint          program;
+        GLint           location;
+        /** GLStateCache epoch the value was uploaded in, 0 if never; older values are stale. */
+        unsigned int    epoch;
+        /** Caller supplied version of the value, 0 if the value has to be compared. */
+        unsigned int    generation;
+        GLsizei         size;
+        GLfloat         value[16];
+
+        UniformSlot(void) : program(0), location(-1), epoch(0), generation(0), size(0) {}
+    };
+
+    /**
+     * \brief Wraps the GL state setters used by the application and drops calls that would not
+     * change anything.
+     *
+     * The cache assumes it sees every state change made on the context, so code that changes
+     * state behind its back must call invalidate() afterwards. Uniform values are shadowed in
+     * UniformSlots owned by the caller.
+     */
+    class GLStateCache
+    {
+    public:
+        /**
+         * \brief Maximum number of vertex attributes tracked.
+         */
+        static const int maxVertexAttribs = 8;
+
+        /**
+         * \brief Maximum number of texture units tracked.
+         */
+        static const int maxTextureUnits = 8;
+
+        /**
+         * \brief Issued and skipped call counts for one GLStateCall.
+         */
+        struct CallStats
+        {
+            unsigned int issued;
+            unsigned int skipped;
+        };
+
+        GLStateCache(void);
+
+        /**
+         * \brief Forget all shadowed state so the next call of every kind reaches GL.
+         */
+        void invalidate(void);
+
+        void useProgram(GLuint program);
+        void enable(GLenum cap);
+        void disable(GLenum cap);
+        void enableVertexAttribArray(GLuint index);
+        void disableVertexAttribArray(GLuint index);
+        void vertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                 GLsizei stride, const GLvoid* pointer);
+        void bindBuffer(GLenum target, GLuint buffer);
+        void activeTexture(GLenum texture);
+        void bindTexture(GLenum target, GLuint texture);
+        void bindFramebuffer(GLenum target, GLuint framebuffer);
+        void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+        void scissor(GLint x, GLint y, GLsizei width, GLsizei height);
+        void clearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+
+        /**
+         * \brief Look up a uniform of a program and reset its slot.
+         */
+        static void bindUniformSlot(UniformSlot& slot, GLuint program, const char* name);
+
+        /**
+         * \brief Uniform setters. The slot's program is made current first if it is not already;
+         * slots of uniforms the program lacks (location -1) are ignored.
+         */
+        void uniform1i(UniformSlot& slot, GLint value);
+        void uniform1f(UniformSlot& slot, GLfloat value);
+
+        /**
+         * \brief Set a mat4 uniform.
+         * \param[in] generation If non-zero, a version number of value: an upload with the same
+         * generation as the previous one is skipped without comparing the matrix.
+         */
+        void uniformMatrix4fv(UniformSlot& slot, const GLfloat* value, unsigned int generation = 0);
+
+        /**
+         * \brief Set count elements of a vec4 array uniform. Arrays are not shadowed, so every
+         * call is issued.
+         */
+        void uniform4fv(UniformSlot& slot, GLsizei count, const GLfloat* value);
+
+        /**
+         * \brief Mark the end of a frame for the per-frame uniform statistics.
+         */
+        void endFrame(void);
+
+        /**
+         * \brief The currently bound framebuffer, as last set through the cache.
+         */
+        GLuint boundFramebuffer(void) const { return framebuffer; }
+
+        /**
+         * \brief The currently used program, as last set through the cache.
+         */
+        GLuint currentProgram(void) const { return program; }
+
+        const CallStats& stats(GLStateCall call) const { return callStats[call]; }
+        unsigned int totalIssued(void) const;
+        unsigned int totalSkipped(void) const;
+
+        /**
+         * \brief Print the per-call issued/skipped counts to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        /**
+         * \brief Zero the statistics without touching the shadowed state.
+         */
+        void resetStats(void);
+
+    private:
+        enum { capBlend, capCullFace, capDepthTest, capScissorTest, capCount };
+
+        struct VertexAttrib
+        {
+            bool            valid;
+            /* 1 enabled, 0 disabled, -1 unknown, as caps. */
+            signed char     enabled;
+            GLint           size;
+            GLenum          type;
+            GLboolean       normalized;
+            GLsizei         stride;
+            const GLvoid*   pointer;
+            GLuint          buffer;
+        };
+
+        /* Record a call and return true if it has to be issued. */
+        bool filter(GLStateCall call, bool changed);
+        static int capIndex(GLenum cap);
+        static int textureTargetIndex(GLenum target);
+        /* Make the slot's program current; return false if the uniform does not exist. */
+        bool selectSlot(const UniformSlot& slot);
+        /* Return true if value differs from the slot's shadow copy, updating the copy. */
+        bool uniformChanged(UniformSlot& slot, const GLfloat* value, GLsizei size, unsigned int generation);
+
+        bool            programValid;
+        GLuint          program;
+        signed char     caps[capCount];
+        VertexAttrib    attribs[maxVertexAttribs];
+        bool            arrayBufferValid;
+        GLuint          arrayBuffer;
+        bool            elementArrayBufferValid;
+        GLuint          elementArrayBuffer;
+        bool            activeTextureValid;
+        GLenum          activeTextureUnit;
+        /* Bindings per unit for GL_TEXTURE_2D and GL_TEXTURE_EXTERNAL_OES, 0xFFFFFFFF if unknown. */
+        GLuint          textures[maxTextureUnits][2];
+        bool            framebufferValid;
+        GLuint          framebuffer;
+        bool            viewportValid;
+        GLint           viewportRect[4];
+        bool            scissorValid;
+        GLint           scissorRect[4];
+        bool            clearColorValid;
+        GLclampf        clearColorValue[4];
+        unsigned int    uniformEpoch;
+        CallStats       callStats[GL_STATE_CALL_COUNT];
+        /* Uniform uploads at the start of the current frame, in the last frame and frames counted. */
+        CallStats       frameStartUniforms;
+        CallStats       lastFrameUniforms;
+        unsigned int    frames;
+    };
+
+#endif /* GLSTATECACHE_H */
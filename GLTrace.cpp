@@ -0,0 +1,1320 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define GL_TRACE_IMPLEMENTATION
+#include "GLTrace.h"
+#include "GLTraceFormat.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cutils/atomic.h>
+#include <utils/Timers.h>
+
+bool glTraceRecording = false;
+
+#if !GL2_CUBE_TRACE
+
+bool startGlTrace(const char* path)
+{
+  fprintf(stderr, "GL trace: compiled out (GL2_CUBE_TRACE is 0), not recording %s\n", path);
+  return false;
+}
+
+void stopGlTrace(void)
+{
+}
+
+#else
+
+/* Bytes the ring holds; calls wait for the writer when it is full. */
+#define TRACE_RING_SIZE   (4 * 1024 * 1024)
+#define TRACE_MAX_HANDLES 64
+#define TRACE_MAX_ATTRIBS 16
+
+/*
+ * Single producer, single consumer byte ring. The GL thread copies records in and publishes
+ * them; the writer thread writes published bytes to the file and hands the space back. Both
+ * positions only grow and wrap modulo 2^32, the capacity is a power of two.
+ */
+class TraceRing
+{
+public:
+  TraceRing() : buffer(NULL), file(NULL), head(0), published(0), consumed(0), stopping(0),
+                bytes(0), stalls(0), writeFailed(false)
+  {
+  }
+
+  bool start(FILE* output)
+  {
+    buffer = (uint8_t*)malloc(TRACE_RING_SIZE);
+    if (buffer == NULL)
+    {
+      return false;
+    }
+    file = output;
+    head = 0;
+    published = consumed = stopping = 0;
+    bytes = stalls = 0;
+    writeFailed = false;
+    if (pthread_create(&thread, NULL, writerMain, this) != 0)
+    {
+      free(buffer);
+      buffer = NULL;
+      return false;
+    }
+    return true;
+  }
+
+  /* Copies size bytes in, waiting for the writer while the ring is full. */
+  void put(const void* data, size_t size)
+  {
+    const uint8_t* in = (const uint8_t*)data;
+    bool stalled = false;
+    while (size > 0)
+    {
+      uint32_t space = TRACE_RING_SIZE - (head - (uint32_t)android_atomic_acquire_load(&consumed));
+      if (space == 0)
+      {
+        /* Let the writer see what is here already and wait for it to make room. */
+        commit();
+        stalls += !stalled;
+        stalled = true;
+        sched_yield();
+        continue;
+      }
+      uint32_t offset = head & (TRACE_RING_SIZE - 1);
+      uint32_t length = TRACE_RING_SIZE - offset;
+      length = length < space ? length : space;
+      length = length < size ? length : (uint32_t)size;
+      memcpy(buffer + offset, in, length);
+      head += length;
+      in += length;
+      size -= length;
+      bytes += length;
+    }
+  }
+
+  /* Makes everything put so far visible to the writer. */
+  void commit(void)
+  {
+    android_atomic_release_store((int32_t)head, &published);
+  }
+
+  void stop(void)
+  {
+    commit();
+    android_atomic_release_store(1, &stopping);
+    pthread_join(thread, NULL);
+    free(buffer);
+    buffer = NULL;
+  }
+
+  uint64_t byteCount(void) const { return bytes; }
+  unsigned int stallCount(void) const { return stalls; }
+  bool failed(void) const { return writeFailed; }
+
+private:
+  static void* writerMain(void* arg)
+  {
+    ((TraceRing*)arg)->drain();
+    return NULL;
+  }
+
+  void drain(void)
+  {
+    uint32_t tail = 0;
+    for (;;)
+    {
+      bool done = android_atomic_acquire_load(&stopping) != 0;
+      uint32_t end = (uint32_t)android_atomic_acquire_load(&published);
+      if (tail == end)
+      {
+        if (done)
+        {
+          /* stop() published everything before it set stopping. */
+          break;
+        }
+        usleep(1000);
+        continue;
+      }
+      while (tail != end)
+      {
+        uint32_t offset = tail & (TRACE_RING_SIZE - 1);
+        uint32_t length = TRACE_RING_SIZE - offset;
+        length = length < end - tail ? length : end - tail;
+        if (!writeFailed && fwrite(buffer + offset, 1, length, file) != length)
+        {
+          /* Keep draining so the GL thread never blocks on a dead writer. */
+          writeFailed = true;
+        }
+        tail += length;
+      }
+      android_atomic_release_store((int32_t)tail, &consumed);
+    }
+  }
+
+  uint8_t*          buffer;
+  FILE*             file;
+  pthread_t         thread;
+  /* Producer side. */
+  uint32_t          head;
+  volatile int32_t  published;
+  /* Consumer side. */
+  volatile int32_t  consumed;
+  volatile int32_t  stopping;
+  uint64_t          bytes;
+  unsigned int      stalls;
+  bool              writeFailed;
+};
+
+/* What draws need to know to record the client arrays they read. */
+struct AttribState
+{
+  bool          enabled;
+  bool          client;
+  GLint         size;
+  GLenum        type;
+  GLsizei       stride;
+  const GLvoid* pointer;
+};
+
+static TraceRing    ring;
+static FILE*        traceFile;
+static nsecs_t      traceStart;
+static unsigned int traceCalls;
+static const void*  handles[TRACE_MAX_HANDLES];
+static unsigned int handleCount;
+static GLuint       arrayBuffer;
+static GLuint       elementArrayBuffer;
+static GLint        unpackAlignment = 4;
+static AttribState  attribs[TRACE_MAX_ATTRIBS];
+
+/* The number a handle is recorded as. */
+static uint32_t handleId(const void* handle)
+{
+  if (handle == NULL)
+  {
+    return 0;
+  }
+  for (unsigned int i = 0; i < handleCount; i++)
+  {
+    if (handles[i] == handle)
+    {
+      return i + 1;
+    }
+  }
+  if (handleCount == TRACE_MAX_HANDLES)
+  {
+    return 0;
+  }
+  handles[handleCount++] = handle;
+  return handleCount;
+}
+
+/*
+ * Builds one record: scalars are gathered on the stack and put into the ring in one go,
+ * blobs are put straight from the caller's memory. The record is committed when the
+ * builder goes away at the end of the statement that made it.
+ */
+class TraceRecord
+{
+public:
+  explicit TraceRecord(GLTraceCall call) : used(0)
+  {
+    scalars[used++] = (uint8_t)call;
+    traceCalls++;
+  }
+
+  ~TraceRecord()
+  {
+    flush();
+    ring.commit();
+  }
+
+  TraceRecord& u(uint32_t value)
+  {
+    return raw(&value, sizeof(value));
+  }
+
+  TraceRecord& f(GLfloat value)
+  {
+    return raw(&value, sizeof(value));
+  }
+
+  TraceRecord& q(uint64_t value)
+  {
+    return raw(&value, sizeof(value));
+  }
+
+  TraceRecord& h(const void* handle)
+  {
+    return u(handleId(handle));
+  }
+
+  TraceRecord& b(const void* data, uint32_t size)
+  {
+    u(data != NULL ? size : 0);
+    flush();
+    if (data != NULL && size > 0)
+    {
+      ring.put(data, size);
+    }
+    return *this;
+  }
+
+  /* A string with its NUL, or an empty blob for NULL. */
+  TraceRecord& s(const char* string)
+  {
+    return b(string, string != NULL ? strlen(string) + 1 : 0);
+  }
+
+  /* An EGL attribute list up to and including EGL_NONE. */
+  TraceRecord& attribList(const EGLint* list)
+  {
+    uint32_t count = 0;
+    while (list != NULL && list[count] != EGL_NONE)
+    {
+      count += 2;
+    }
+    return b(list, list != NULL ? (count + 1) * sizeof(EGLint) : 0);
+  }
+
+private:
+  TraceRecord& raw(const void* value, size_t size)
+  {
+    if (used + size > sizeof(scalars))
+    {
+      flush();
+    }
+    memcpy(scalars + used, value, size);
+    used += size;
+    return *this;
+  }
+
+  void flush(void)
+  {
+    ring.put(scalars, used);
+    used = 0;
+  }
+
+  uint8_t scalars[64];
+  size_t  used;
+};
+
+bool startGlTrace(const char* path)
+{
+  traceFile = fopen(path, "wb");
+  if (traceFile == NULL)
+  {
+    fprintf(stderr, "GL trace: could not create %s\n", path);
+    return false;
+  }
+  GLTraceFileHeader header = { GL_TRACE_MAGIC, GL_TRACE_VERSION, GLTRACE_CALL_COUNT, 0 };
+  if (fwrite(&header, sizeof(header), 1, traceFile) != 1 || !ring.start(traceFile))
+  {
+    fprintf(stderr, "GL trace: could not start recording to %s\n", path);
+    fclose(traceFile);
+    traceFile = NULL;
+    return false;
+  }
+  traceStart = systemTime(SYSTEM_TIME_MONOTONIC);
+  traceCalls = 0;
+  glTraceRecording = true;
+  fprintf(stderr, "GL trace: recording to %s\n", path);
+  return true;
+}
+
+void stopGlTrace(void)
+{
+  if (!glTraceRecording)
+  {
+    return;
+  }
+  glTraceRecording = false;
+  ring.stop();
+  bool failed = ring.failed() || fclose(traceFile) != 0;
+  traceFile = NULL;
+  fprintf(stderr, "GL trace: %u calls, %llu bytes, the ring was full %u times%s\n",
+          traceCalls, (unsigned long long)ring.byteCount(), ring.stallCount(),
+          failed ? "; writing the file FAILED" : "");
+}
+
+static int attribTypeSize(GLenum type)
+{
+  switch (type)
+  {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:   return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT_OES:  return 2;
+    default:                 return 4;
+  }
+}
+
+/* Records the enabled client arrays a draw of vertices 0 to maxIndex reads. */
+static void recordClientArrays(GLuint maxIndex)
+{
+  for (GLuint i = 0; i < TRACE_MAX_ATTRIBS; i++)
+  {
+    const AttribState& attrib = attribs[i];
+    if (!attrib.enabled || !attrib.client || attrib.pointer == NULL)
+    {
+      continue;
+    }
+    uint32_t elementSize = attribTypeSize(attrib.type) * attrib.size;
+    uint32_t stride = attrib.stride ? attrib.stride : elementSize;
+    TraceRecord(GLTRACE_glTraceClientArray).u(i).b(attrib.pointer, stride * maxIndex + elementSize);
+  }
+}
+
+/* EGL. */
+
+EGLDisplay traceEglGetDisplay(EGLNativeDisplayType display_id)
+{
+  EGLDisplay result = eglGetDisplay(display_id);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglGetDisplay).h((const void*)display_id).h(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor)
+{
+  EGLBoolean result = eglInitialize(dpy, major, minor);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglInitialize).h(dpy).u(major ? *major : 0).u(minor ? *minor : 0).u(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglTerminate(EGLDisplay dpy)
+{
+  EGLBoolean result = eglTerminate(dpy);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglTerminate).h(dpy).u(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs,
+                                EGLint config_size, EGLint* num_config)
+{
+  EGLBoolean result = eglChooseConfig(dpy, attrib_list, configs, config_size, num_config);
+  if (glTraceRecording)
+  {
+    bool chosen = result && configs != NULL && num_config != NULL && *num_config > 0;
+    TraceRecord(GLTRACE_eglChooseConfig).h(dpy).attribList(attrib_list).h(chosen ? configs[0] : NULL)
+                                        .u(num_config ? *num_config : 0).u(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglGetConfigAttrib(EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint* value)
+{
+  EGLBoolean result = eglGetConfigAttrib(dpy, config, attribute, value);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglGetConfigAttrib).h(dpy).h(config).u(attribute).u(result ? *value : 0).u(result);
+  }
+  return result;
+}
+
+/* Surfaces record their size, so the replayer can create one like them. */
+static void surfaceSize(EGLDisplay dpy, EGLSurface surface, EGLint* width, EGLint* height)
+{
+  *width = *height = 0;
+  if (surface != EGL_NO_SURFACE)
+  {
+    eglQuerySurface(dpy, surface, EGL_WIDTH, width);
+    eglQuerySurface(dpy, surface, EGL_HEIGHT, height);
+  }
+}
+
+EGLSurface traceEglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win,
+                                       const EGLint* attrib_list)
+{
+  EGLSurface result = eglCreateWindowSurface(dpy, config, win, attrib_list);
+  if (glTraceRecording)
+  {
+    EGLint width, height;
+    surfaceSize(dpy, result, &width, &height);
+    TraceRecord(GLTRACE_eglCreateWindowSurface).h(dpy).h(config).h((const void*)win).attribList(attrib_list)
+                                               .h(result).u(width).u(height);
+  }
+  return result;
+}
+
+EGLSurface traceEglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint* attrib_list)
+{
+  EGLSurface result = eglCreatePbufferSurface(dpy, config, attrib_list);
+  if (glTraceRecording)
+  {
+    EGLint width, height;
+    surfaceSize(dpy, result, &width, &height);
+    TraceRecord(GLTRACE_eglCreatePbufferSurface).h(dpy).h(config).attribList(attrib_list)
+                                                .h(result).u(width).u(height);
+  }
+  return result;
+}
+
+EGLContext traceEglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context,
+                                 const EGLint* attrib_list)
+{
+  EGLContext result = eglCreateContext(dpy, config, share_context, attrib_list);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglCreateContext).h(dpy).h(config).h(share_context).attribList(attrib_list).h(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+  EGLBoolean result = eglMakeCurrent(dpy, draw, read, ctx);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglMakeCurrent).h(dpy).h(draw).h(read).h(ctx).u(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint* value)
+{
+  EGLBoolean result = eglQuerySurface(dpy, surface, attribute, value);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglQuerySurface).h(dpy).h(surface).u(attribute).u(result ? *value : 0).u(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+  EGLBoolean result = eglSwapBuffers(dpy, surface);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglSwapBuffers).h(dpy).h(surface).u(result)
+                                       .q(systemTime(SYSTEM_TIME_MONOTONIC) - traceStart);
+  }
+  return result;
+}
+
+EGLBoolean traceEglSwapInterval(EGLDisplay dpy, EGLint interval)
+{
+  EGLBoolean result = eglSwapInterval(dpy, interval);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglSwapInterval).h(dpy).u(interval).u(result);
+  }
+  return result;
+}
+
+/* Extension functions are only reached through eglGetProcAddress, so the program is handed
+ * this wrapper in place of the driver's function. */
+typedef EGLBoolean (EGLAPIENTRYP SwapBuffersWithDamageProc)(EGLDisplay dpy, EGLSurface surface,
+                                                           const EGLint* rects, EGLint n_rects);
+static SwapBuffersWithDamageProc swapBuffersWithDamage;
+
+static EGLBoolean EGLAPIENTRY traceEglSwapBuffersWithDamage(EGLDisplay dpy, EGLSurface surface,
+                                                            const EGLint* rects, EGLint n_rects)
+{
+  EGLBoolean result = swapBuffersWithDamage(dpy, surface, rects, n_rects);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglSwapBuffersWithDamageKHR).h(dpy).h(surface)
+                                                    .b(rects, n_rects > 0 ? n_rects * 4 * sizeof(EGLint) : 0)
+                                                    .u(n_rects).u(result)
+                                                    .q(systemTime(SYSTEM_TIME_MONOTONIC) - traceStart);
+  }
+  return result;
+}
+
+__eglMustCastToProperFunctionPointerType traceEglGetProcAddress(const char* procname)
+{
+  __eglMustCastToProperFunctionPointerType result = eglGetProcAddress(procname);
+  if (result != NULL && (strcmp(procname, "eglSwapBuffersWithDamageKHR") == 0 ||
+                         strcmp(procname, "eglSwapBuffersWithDamageEXT") == 0))
+  {
+    swapBuffersWithDamage = (SwapBuffersWithDamageProc)result;
+    return (__eglMustCastToProperFunctionPointerType)traceEglSwapBuffersWithDamage;
+  }
+  return result;
+}
+
+EGLint traceEglGetError(void)
+{
+  EGLint result = eglGetError();
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglGetError).u(result);
+  }
+  return result;
+}
+
+#ifdef HAVE_ANDROID_OS
+EGLImageKHR traceEglCreateImageKHR(EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer,
+                                   const EGLint* attrib_list)
+{
+  EGLImageKHR result = eglCreateImageKHR(dpy, ctx, target, buffer, attrib_list);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglCreateImageKHR).h(dpy).h(ctx).u(target).h(buffer).attribList(attrib_list).h(result);
+  }
+  return result;
+}
+
+EGLBoolean traceEglDestroyImageKHR(EGLDisplay dpy, EGLImageKHR image)
+{
+  EGLBoolean result = eglDestroyImageKHR(dpy, image);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_eglDestroyImageKHR).h(dpy).h(image).u(result);
+  }
+  return result;
+}
+#endif
+
+/* GL. */
+
+void traceGlActiveTexture(GLenum texture)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glActiveTexture).u(texture);
+  }
+  glActiveTexture(texture);
+}
+
+void traceGlAttachShader(GLuint program, GLuint shader)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glAttachShader).u(program).u(shader);
+  }
+  glAttachShader(program, shader);
+}
+
+void traceGlBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBindAttribLocation).u(program).u(index).s(name);
+  }
+  glBindAttribLocation(program, index, name);
+}
+
+void traceGlBindBuffer(GLenum target, GLuint buffer)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBindBuffer).u(target).u(buffer);
+    if (target == GL_ARRAY_BUFFER)
+    {
+      arrayBuffer = buffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+      elementArrayBuffer = buffer;
+    }
+  }
+  glBindBuffer(target, buffer);
+}
+
+void traceGlBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBindFramebuffer).u(target).u(framebuffer);
+  }
+  glBindFramebuffer(target, framebuffer);
+}
+
+void traceGlBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBindRenderbuffer).u(target).u(renderbuffer);
+  }
+  glBindRenderbuffer(target, renderbuffer);
+}
+
+void traceGlBindTexture(GLenum target, GLuint texture)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBindTexture).u(target).u(texture);
+  }
+  glBindTexture(target, texture);
+}
+
+void traceGlBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBlendFunc).u(sfactor).u(dfactor);
+  }
+  glBlendFunc(sfactor, dfactor);
+}
+
+void traceGlBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBufferData).u(target).u(size).u(usage).b(data, size);
+  }
+  glBufferData(target, size, data, usage);
+}
+
+void traceGlBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glBufferSubData).u(target).u(offset).b(data, size);
+  }
+  glBufferSubData(target, offset, size, data);
+}
+
+GLenum traceGlCheckFramebufferStatus(GLenum target)
+{
+  GLenum result = glCheckFramebufferStatus(target);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glCheckFramebufferStatus).u(target).u(result);
+  }
+  return result;
+}
+
+void traceGlClear(GLbitfield mask)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glClear).u(mask);
+  }
+  glClear(mask);
+}
+
+void traceGlClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glClearColor).f(red).f(green).f(blue).f(alpha);
+  }
+  glClearColor(red, green, blue, alpha);
+}
+
+void traceGlClearDepthf(GLclampf depth)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glClearDepthf).f(depth);
+  }
+  glClearDepthf(depth);
+}
+
+void traceGlCompileShader(GLuint shader)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glCompileShader).u(shader);
+  }
+  glCompileShader(shader);
+}
+
+GLuint traceGlCreateProgram(void)
+{
+  GLuint result = glCreateProgram();
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glCreateProgram).u(result);
+  }
+  return result;
+}
+
+GLuint traceGlCreateShader(GLenum type)
+{
+  GLuint result = glCreateShader(type);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glCreateShader).u(type).u(result);
+  }
+  return result;
+}
+
+void traceGlCullFace(GLenum mode)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glCullFace).u(mode);
+  }
+  glCullFace(mode);
+}
+
+void traceGlDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDeleteBuffers).b(buffers, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+  glDeleteBuffers(n, buffers);
+}
+
+void traceGlDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDeleteFramebuffers).b(framebuffers, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+  glDeleteFramebuffers(n, framebuffers);
+}
+
+void traceGlDeleteProgram(GLuint program)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDeleteProgram).u(program);
+  }
+  glDeleteProgram(program);
+}
+
+void traceGlDeleteShader(GLuint shader)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDeleteShader).u(shader);
+  }
+  glDeleteShader(shader);
+}
+
+void traceGlDeleteTextures(GLsizei n, const GLuint* textures)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDeleteTextures).b(textures, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+  glDeleteTextures(n, textures);
+}
+
+void traceGlDepthFunc(GLenum func)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDepthFunc).u(func);
+  }
+  glDepthFunc(func);
+}
+
+void traceGlDepthMask(GLboolean flag)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDepthMask).u(flag);
+  }
+  glDepthMask(flag);
+}
+
+void traceGlDisable(GLenum cap)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDisable).u(cap);
+  }
+  glDisable(cap);
+}
+
+void traceGlDisableVertexAttribArray(GLuint index)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glDisableVertexAttribArray).u(index);
+    if (index < TRACE_MAX_ATTRIBS)
+    {
+      attribs[index].enabled = false;
+    }
+  }
+  glDisableVertexAttribArray(index);
+}
+
+void traceGlDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+  if (glTraceRecording)
+  {
+    if (count > 0)
+    {
+      recordClientArrays(first + count - 1);
+    }
+    TraceRecord(GLTRACE_glDrawArrays).u(mode).u(first).u(count);
+  }
+  glDrawArrays(mode, first, count);
+}
+
+/* Client indices are recorded with the draw and scanned for the client array range. */
+void traceGlDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+  if (glTraceRecording)
+  {
+    uint32_t indexSize = type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+    if (elementArrayBuffer == 0 && indices != NULL && count > 0)
+    {
+      GLuint maxIndex = 0;
+      for (GLsizei i = 0; i < count; i++)
+      {
+        GLuint index = indexSize == 1 ? ((const GLubyte*)indices)[i] :
+                       (indexSize == 2 ? ((const GLushort*)indices)[i] : ((const GLuint*)indices)[i]);
+        maxIndex = index > maxIndex ? index : maxIndex;
+      }
+      recordClientArrays(maxIndex);
+      TraceRecord(GLTRACE_glDrawElements).u(mode).u(count).u(type).u(0).b(indices, count * indexSize);
+    }
+    else
+    {
+      /* Indices in a buffer cannot be read back, so client arrays are not supported with them. */
+      TraceRecord(GLTRACE_glDrawElements).u(mode).u(count).u(type).u((uint32_t)(uintptr_t)indices).b(NULL, 0);
+    }
+  }
+  glDrawElements(mode, count, type, indices);
+}
+
+#ifdef HAVE_ANDROID_OS
+void traceGlEGLImageTargetTexture2DOES(GLenum target, GLeglImageOES image)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glEGLImageTargetTexture2DOES).u(target).h(image);
+  }
+  glEGLImageTargetTexture2DOES(target, image);
+}
+#endif
+
+void traceGlEnable(GLenum cap)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glEnable).u(cap);
+  }
+  glEnable(cap);
+}
+
+void traceGlEnableVertexAttribArray(GLuint index)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glEnableVertexAttribArray).u(index);
+    if (index < TRACE_MAX_ATTRIBS)
+    {
+      attribs[index].enabled = true;
+    }
+  }
+  glEnableVertexAttribArray(index);
+}
+
+void traceGlFinish(void)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord record(GLTRACE_glFinish);
+  }
+  glFinish();
+}
+
+void traceGlFlush(void)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord record(GLTRACE_glFlush);
+  }
+  glFlush();
+}
+
+void traceGlFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glFramebufferTexture2D).u(target).u(attachment).u(textarget).u(texture).u(level);
+  }
+  glFramebufferTexture2D(target, attachment, textarget, texture, level);
+}
+
+void traceGlFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget,
+                                    GLuint renderbuffer)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glFramebufferRenderbuffer).u(target).u(attachment).u(renderbuffertarget).u(renderbuffer);
+  }
+  glFramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+}
+
+void traceGlFrontFace(GLenum mode)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glFrontFace).u(mode);
+  }
+  glFrontFace(mode);
+}
+
+void traceGlGenBuffers(GLsizei n, GLuint* buffers)
+{
+  glGenBuffers(n, buffers);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGenBuffers).b(buffers, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+}
+
+void traceGlGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+  glGenFramebuffers(n, framebuffers);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGenFramebuffers).b(framebuffers, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+}
+
+void traceGlGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+  glGenRenderbuffers(n, renderbuffers);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGenRenderbuffers).b(renderbuffers, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+}
+
+void traceGlGenTextures(GLsizei n, GLuint* textures)
+{
+  glGenTextures(n, textures);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGenTextures).b(textures, n > 0 ? n * sizeof(GLuint) : 0);
+  }
+}
+
+int traceGlGetAttribLocation(GLuint program, const GLchar* name)
+{
+  int result = glGetAttribLocation(program, name);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetAttribLocation).u(program).s(name).u(result);
+  }
+  return result;
+}
+
+GLenum traceGlGetError(void)
+{
+  GLenum result = glGetError();
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetError).u(result);
+  }
+  return result;
+}
+
+void traceGlGetIntegerv(GLenum pname, GLint* params)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetIntegerv).u(pname);
+  }
+  glGetIntegerv(pname, params);
+}
+
+void traceGlGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat,
+                                GLvoid* binary)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetProgramBinaryOES).u(program).u(bufSize);
+  }
+  glGetProgramBinaryOES(program, bufSize, length, binaryFormat, binary);
+}
+
+void traceGlGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetProgramInfoLog).u(program).u(bufsize);
+  }
+  glGetProgramInfoLog(program, bufsize, length, infolog);
+}
+
+void traceGlGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetProgramiv).u(program).u(pname);
+  }
+  glGetProgramiv(program, pname, params);
+}
+
+void traceGlGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetShaderInfoLog).u(shader).u(bufsize);
+  }
+  glGetShaderInfoLog(shader, bufsize, length, infolog);
+}
+
+void traceGlGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetShaderiv).u(shader).u(pname);
+  }
+  glGetShaderiv(shader, pname, params);
+}
+
+const GLubyte* traceGlGetString(GLenum name)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetString).u(name);
+  }
+  return glGetString(name);
+}
+
+int traceGlGetUniformLocation(GLuint program, const GLchar* name)
+{
+  int result = glGetUniformLocation(program, name);
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glGetUniformLocation).u(program).s(name).u(result);
+  }
+  return result;
+}
+
+void traceGlLinkProgram(GLuint program)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glLinkProgram).u(program);
+  }
+  glLinkProgram(program);
+}
+
+void traceGlPixelStorei(GLenum pname, GLint param)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glPixelStorei).u(pname).u(param);
+    if (pname == GL_UNPACK_ALIGNMENT)
+    {
+      unpackAlignment = param;
+    }
+  }
+  glPixelStorei(pname, param);
+}
+
+void traceGlProgramBinaryOES(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLint length)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glProgramBinaryOES).u(program).u(binaryFormat).b(binary, length > 0 ? length : 0);
+  }
+  glProgramBinaryOES(program, binaryFormat, binary, length);
+}
+
+void traceGlReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glReadPixels).u(x).u(y).u(width).u(height).u(format).u(type);
+  }
+  glReadPixels(x, y, width, height, format, type, pixels);
+}
+
+void traceGlRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glRenderbufferStorage).u(target).u(internalformat).u(width).u(height);
+  }
+  glRenderbufferStorage(target, internalformat, width, height);
+}
+
+void traceGlScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glScissor).u(x).u(y).u(width).u(height);
+  }
+  glScissor(x, y, width, height);
+}
+
+/* Headers generated from the Khronos XML registry made the strings const. */
+#ifdef GL_GLES_PROTOTYPES
+typedef const GLchar* const* ShaderSourceStrings;
+#else
+typedef const GLchar** ShaderSourceStrings;
+#endif
+
+/* The strings are recorded joined into one. */
+void traceGlShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+  if (glTraceRecording)
+  {
+    size_t total = 0;
+    for (GLsizei i = 0; i < count; i++)
+    {
+      total += length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+    }
+    char* source = (char*)malloc(total + 1);
+    if (source != NULL)
+    {
+      size_t offset = 0;
+      for (GLsizei i = 0; i < count; i++)
+      {
+        size_t part = length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+        memcpy(source + offset, string[i], part);
+        offset += part;
+      }
+      source[total] = '\0';
+    }
+    TraceRecord(GLTRACE_glShaderSource).u(shader).s(source);
+    free(source);
+  }
+  glShaderSource(shader, count, (ShaderSourceStrings)string, length);
+}
+
+void traceGlTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                       GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glTexImage2D).u(target).u(level).u(internalformat).u(width).u(height).u(border)
+                                     .u(format).u(type)
+                                     .b(pixels, glTracePixelBytes(width, height, format, type, unpackAlignment));
+  }
+  glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+}
+
+void traceGlTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glTexParameteri).u(target).u(pname).u(param);
+  }
+  glTexParameteri(target, pname, param);
+}
+
+void traceGlTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                          GLsizei height, GLenum format, GLenum type, const GLvoid* pixels)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glTexSubImage2D).u(target).u(level).u(xoffset).u(yoffset).u(width).u(height)
+                                        .u(format).u(type)
+                                        .b(pixels, glTracePixelBytes(width, height, format, type, unpackAlignment));
+  }
+  glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+}
+
+void traceGlUniform1f(GLint location, GLfloat x)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glUniform1f).u(location).f(x);
+  }
+  glUniform1f(location, x);
+}
+
+void traceGlUniform1i(GLint location, GLint x)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glUniform1i).u(location).u(x);
+  }
+  glUniform1i(location, x);
+}
+
+void traceGlUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glUniform4fv).u(location).u(count).b(value, count > 0 ? count * 4 * sizeof(GLfloat) : 0);
+  }
+  glUniform4fv(location, count, value);
+}
+
+void traceGlUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glUniformMatrix4fv).u(location).u(count).u(transpose)
+                                           .b(value, count > 0 ? count * 16 * sizeof(GLfloat) : 0);
+  }
+  glUniformMatrix4fv(location, count, transpose, value);
+}
+
+void traceGlUseProgram(GLuint program)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glUseProgram).u(program);
+  }
+  glUseProgram(program);
+}
+
+/* Pointers into client memory are recorded as 0 and flagged; the data follows at each draw. */
+void traceGlVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                const GLvoid* ptr)
+{
+  if (glTraceRecording)
+  {
+    bool client = arrayBuffer == 0;
+    TraceRecord(GLTRACE_glVertexAttribPointer).u(index).u(size).u(type).u(normalized).u(stride)
+                                              .u(client ? 0 : (uint32_t)(uintptr_t)ptr).u(client);
+    if (index < TRACE_MAX_ATTRIBS)
+    {
+      AttribState& attrib = attribs[index];
+      attrib.client  = client;
+      attrib.size    = size;
+      attrib.type    = type;
+      attrib.stride  = stride;
+      attrib.pointer = ptr;
+    }
+  }
+  glVertexAttribPointer(index, size, type, normalized, stride, ptr);
+}
+
+void traceGlVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glVertexAttrib4f).u(index).f(x).f(y).f(z).f(w);
+  }
+  glVertexAttrib4f(index, x, y, z, w);
+}
+
+void traceGlViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  if (glTraceRecording)
+  {
+    TraceRecord(GLTRACE_glViewport).u(x).u(y).u(width).u(height);
+  }
+  glViewport(x, y, width, height);
+}
+
+#endif /* GL2_CUBE_TRACE */
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTRACE_H
+#define GLTRACE_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+/**
+ * \file GLTrace.h
+ * \brief Records the GL and EGL calls of the program to a binary trace file (see
+ * GLTraceFormat.h) that gl2-cube-replay re-issues.
+ *
+ * Included last by every source file that calls GL or EGL, it renames each call to a
+ * wrapper that records it while a trace is running and then makes it. Recording happens on
+ * the calling thread into a lock-free ring; a writer thread drains the ring to the file, so
+ * the only cost on the GL thread is encoding the call and copying the data it references.
+ * Calls must come from a single thread.
+ *
+ * Client arrays are recorded at each draw, as far as the draw reads them. Tracing is
+ * compiled in unless GL2_CUBE_TRACE is defined to 0; without a running trace each call
+ * costs one extra branch.
+ */
+
+#ifndef GL2_CUBE_TRACE
+#define GL2_CUBE_TRACE 1
+#endif
+
+    /**
+     * \brief Whether calls are being recorded.
+     */
+    extern bool glTraceRecording;
+
+    /**
+     * \brief Start recording to a new file. Must be called before the first GL or EGL call.
+     * \return false if the file could not be created or tracing is compiled out.
+     */
+    bool startGlTrace(const char* path);
+
+    /**
+     * \brief Stop recording, write out everything recorded and print the trace statistics.
+     */
+    void stopGlTrace(void);
+
+#if GL2_CUBE_TRACE
+
+    /* The wrappers, with the signatures of the calls they record. */
+    EGLDisplay traceEglGetDisplay(EGLNativeDisplayType display_id);
+    EGLBoolean traceEglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor);
+    EGLBoolean traceEglTerminate(EGLDisplay dpy);
+    EGLBoolean traceEglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs,
+                                    EGLint config_size, EGLint* num_config);
+    EGLBoolean traceEglGetConfigAttrib(EGLDisplay dpy, EGLConfig config, EGLint attribute, EGLint* value);
+    EGLSurface traceEglCreateWindowSurface(EGLDisplay dpy, EGLConfig config, EGLNativeWindowType win,
+                                           const EGLint* attrib_list);
+    EGLSurface traceEglCreatePbufferSurface(EGLDisplay dpy, EGLConfig config, const EGLint* attrib_list);
+    EGLContext traceEglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context,
+                                     const EGLint* attrib_list);
+    EGLBoolean traceEglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
+    EGLBoolean traceEglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint* value);
+    EGLBoolean traceEglSwapBuffers(EGLDisplay dpy, EGLSurface surface);
+    EGLBoolean traceEglSwapInterval(EGLDisplay dpy, EGLint interval);
+    /* Hands out a recording wrapper for eglSwapBuffersWithDamageKHR and EXT. */
+    __eglMustCastToProperFunctionPointerType traceEglGetProcAddress(const char* procname);
+    EGLint     traceEglGetError(void);
+#ifdef HAVE_ANDROID_OS
+    /* Only the device program uses EGLImages, the host backends do not provide them. */
+    EGLImageKHR traceEglCreateImageKHR(EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer,
+                                       const EGLint* attrib_list);
+    EGLBoolean traceEglDestroyImageKHR(EGLDisplay dpy, EGLImageKHR image);
+    void       traceGlEGLImageTargetTexture2DOES(GLenum target, GLeglImageOES image);
+#endif
+
+    void    traceGlActiveTexture(GLenum texture);
+    void    traceGlAttachShader(GLuint program, GLuint shader);
+    void    traceGlBindAttribLocation(GLuint program, GLuint index, const GLchar* name);
+    void    traceGlBindBuffer(GLenum target, GLuint buffer);
+    void    traceGlBindFramebuffer(GLenum target, GLuint framebuffer);
+    void    traceGlBindRenderbuffer(GLenum target, GLuint renderbuffer);
+    void    traceGlBindTexture(GLenum target, GLuint texture);
+    void    traceGlBlendFunc(GLenum sfactor, GLenum dfactor);
+    void    traceGlBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+    void    traceGlBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data);
+    GLenum  traceGlCheckFramebufferStatus(GLenum target);
+    void    traceGlClear(GLbitfield mask);
+    void    traceGlClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+    void    traceGlClearDepthf(GLclampf depth);
+    void    traceGlCompileShader(GLuint shader);
+    GLuint  traceGlCreateProgram(void);
+    GLuint  traceGlCreateShader(GLenum type);
+    void    traceGlCullFace(GLenum mode);
+    void    traceGlDeleteBuffers(GLsizei n, const GLuint* buffers);
+    void    traceGlDeleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+    void    traceGlDeleteProgram(GLuint program);
+    void    traceGlDeleteShader(GLuint shader);
+    void    traceGlDeleteTextures(GLsizei n, const GLuint* textures);
+    void    traceGlDepthFunc(GLenum func);
+    void    traceGlDepthMask(GLboolean flag);
+    void    traceGlDisable(GLenum cap);
+    void    traceGlDisableVertexAttribArray(GLuint index);
+    void    traceGlDrawArrays(GLenum mode, GLint first, GLsizei count);
+    void    traceGlDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+    void    traceGlEnable(GLenum cap);
+    void    traceGlEnableVertexAttribArray(GLuint index);
+    void    traceGlFinish(void);
+    void    traceGlFlush(void);
+    void    traceGlFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture,
+                                        GLint level);
+    void    traceGlFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget,
+                                           GLuint renderbuffer);
+    void    traceGlFrontFace(GLenum mode);
+    void    traceGlGenBuffers(GLsizei n, GLuint* buffers);
+    void    traceGlGenFramebuffers(GLsizei n, GLuint* framebuffers);
+    void    traceGlGenRenderbuffers(GLsizei n, GLuint* renderbuffers);
+    void    traceGlGenTextures(GLsizei n, GLuint* textures);
+    int     traceGlGetAttribLocation(GLuint program, const GLchar* name);
+    GLenum  traceGlGetError(void);
+    void    traceGlGetIntegerv(GLenum pname, GLint* params);
+    void    traceGlGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat,
+                                       GLvoid* binary);
+    void    traceGlGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei* length, GLchar* infolog);
+    void    traceGlGetProgramiv(GLuint program, GLenum pname, GLint* params);
+    void    traceGlGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* infolog);
+    void    traceGlGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+    const GLubyte* traceGlGetString(GLenum name);
+    int     traceGlGetUniformLocation(GLuint program, const GLchar* name);
+    void    traceGlLinkProgram(GLuint program);
+    void    traceGlPixelStorei(GLenum pname, GLint param);
+    void    traceGlProgramBinaryOES(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLint length);
+    void    traceGlReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+                              GLvoid* pixels);
+    void    traceGlRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
+    void    traceGlScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+    void    traceGlShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+    void    traceGlTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                              GLint border, GLenum format, GLenum type, const GLvoid* pixels);
+    void    traceGlTexParameteri(GLenum target, GLenum pname, GLint param);
+    void    traceGlTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                                 GLsizei height, GLenum format, GLenum type, const GLvoid* pixels);
+    void    traceGlUniform1f(GLint location, GLfloat x);
+    void    traceGlUniform1i(GLint location, GLint x);
+    void    traceGlUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+    void    traceGlUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+    void    traceGlUseProgram(GLuint program);
+    void    traceGlVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                       GLsizei stride, const GLvoid* ptr);
+    void    traceGlVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w);
+    void    traceGlViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#ifndef GL_TRACE_IMPLEMENTATION
+#define eglGetDisplay                 traceEglGetDisplay
+#define eglInitialize                 traceEglInitialize
+#define eglTerminate                  traceEglTerminate
+#define eglChooseConfig               traceEglChooseConfig
+#define eglGetConfigAttrib            traceEglGetConfigAttrib
+#define eglCreateWindowSurface        traceEglCreateWindowSurface
+#define eglCreatePbufferSurface       traceEglCreatePbufferSurface
+#define eglCreateContext              traceEglCreateContext
+#define eglMakeCurrent                traceEglMakeCurrent
+#define eglQuerySurface               traceEglQuerySurface
+#define eglSwapBuffers                traceEglSwapBuffers
+#define eglSwapInterval               traceEglSwapInterval
+#define eglGetProcAddress             traceEglGetProcAddress
+#define eglGetError                   traceEglGetError
+#ifdef HAVE_ANDROID_OS
+#define eglCreateImageKHR             traceEglCreateImageKHR
+#define eglDestroyImageKHR            traceEglDestroyImageKHR
+#define glEGLImageTargetTexture2DOES  traceGlEGLImageTargetTexture2DOES
+#endif
+
+#define glActiveTexture               traceGlActiveTexture
+#define glAttachShader                traceGlAttachShader
+#define glBindAttribLocation          traceGlBindAttribLocation
+#define glBindBuffer                  traceGlBindBuffer
+#define glBindFramebuffer             traceGlBindFramebuffer
+#define glBindRenderbuffer            traceGlBindRenderbuffer
+#define glBindTexture                 traceGlBindTexture
+#define glBlendFunc                   traceGlBlendFunc
+#define glBufferData                  traceGlBufferData
+#define glBufferSubData               traceGlBufferSubData
+#define glCheckFramebufferStatus      traceGlCheckFramebufferStatus
+#define glClear                       traceGlClear
+#define glClearColor                  traceGlClearColor
+#define glClearDepthf                 traceGlClearDepthf
+#define glCompileShader               traceGlCompileShader
+#define glCreateProgram               traceGlCreateProgram
+#define glCreateShader                traceGlCreateShader
+#define glCullFace                    traceGlCullFace
+#define glDeleteBuffers               traceGlDeleteBuffers
+#define glDeleteFramebuffers          traceGlDeleteFramebuffers
+#define glDeleteProgram               traceGlDeleteProgram
+#define glDeleteShader                traceGlDeleteShader
+#define glDeleteTextures              traceGlDeleteTextures
+#define glDepthFunc                   traceGlDepthFunc
+#define glDepthMask                   traceGlDepthMask
+#define glDisable                     traceGlDisable
+#define glDisableVertexAttribArray    traceGlDisableVertexAttribArray
+#define glDrawArrays                  traceGlDrawArrays
+#define glDrawElements                traceGlDrawElements
+#define glEnable                      traceGlEnable
+#define glEnableVertexAttribArray     traceGlEnableVertexAttribArray
+#define glFinish                      traceGlFinish
+#define glFlush                       traceGlFlush
+#define glFramebufferTexture2D        traceGlFramebufferTexture2D
+#define glFramebufferRenderbuffer     traceGlFramebufferRenderbuffer
+#define glFrontFace                   traceGlFrontFace
+#define glGenBuffers                  traceGlGenBuffers
+#define glGenFramebuffers             traceGlGenFramebuffers
+#define glGenRenderbuffers            traceGlGenRenderbuffers
+#define glGenTextures                 traceGlGenTextures
+#define glGetAttribLocation           traceGlGetAttribLocation
+#define glGetError                    traceGlGetError
+#define glGetIntegerv                 traceGlGetIntegerv
+#define glGetProgramBinaryOES         traceGlGetProgramBinaryOES
+#define glGetProgramInfoLog           traceGlGetProgramInfoLog
+#define glGetProgramiv                traceGlGetProgramiv
+#define glGetShaderInfoLog            traceGlGetShaderInfoLog
+#define glGetShaderiv                 traceGlGetShaderiv
+#define glGetString                   traceGlGetString
+#define glGetUniformLocation          traceGlGetUniformLocation
+#define glLinkProgram                 traceGlLinkProgram
+#define glPixelStorei                 traceGlPixelStorei
+#define glProgramBinaryOES            traceGlProgramBinaryOES
+#define glReadPixels                  traceGlReadPixels
+#define glRenderbufferStorage         traceGlRenderbufferStorage
+#define glScissor                     traceGlScissor
+#define glShaderSource                traceGlShaderSource
+#define glTexImage2D                  traceGlTexImage2D
+#define glTexParameteri               traceGlTexParameteri
+#define glTexSubImage2D               traceGlTexSubImage2D
+#define glUniform1f                   traceGlUniform1f
+#define glUniform1i                   traceGlUniform1i
+#define glUniform4fv                  traceGlUniform4fv
+#define glUniformMatrix4fv            traceGlUniformMatrix4fv
+#define glUseProgram                  traceGlUseProgram
+#define glVertexAttribPointer         traceGlVertexAttribPointer
+#define glVertexAttrib4f              traceGlVertexAttrib4f
+#define glViewport                    traceGlViewport
+#endif /* GL_TRACE_IMPLEMENTATION */
+
+#endif /* GL2_CUBE_TRACE */
+
+#endif /* GLTRACE_H */
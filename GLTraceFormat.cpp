@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLTraceFormat.h"
+
+#include <GLES2/gl2.h>
+
+const GLTraceCallInfo glTraceCalls[GLTRACE_CALL_COUNT] =
+{
+#define GLTRACE_CALL_INFO(name, signature) { #name, signature },
+  GLTRACE_CALLS(GLTRACE_CALL_INFO)
+#undef GLTRACE_CALL_INFO
+};
+
+uint32_t glTracePixelBytes(int width, int height, unsigned int format, unsigned int type, int alignment)
+{
+  int pixelSize = 0;
+  switch (type)
+  {
+    case GL_UNSIGNED_BYTE:
+      switch (format)
+      {
+        case GL_RGBA:            pixelSize = 4; break;
+        case GL_RGB:             pixelSize = 3; break;
+        case GL_LUMINANCE_ALPHA: pixelSize = 2; break;
+        case GL_LUMINANCE:
+        case GL_ALPHA:           pixelSize = 1; break;
+        default:                 break;
+      }
+      break;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      pixelSize = 2;
+      break;
+    default:
+      break;
+  }
+  if (pixelSize == 0 || width <= 0 || height <= 0)
+  {
+    return 0;
+  }
+
+  /* Every row but the last is padded to the alignment. */
+  uint32_t rowBytes = width * pixelSize;
+  uint32_t alignedRowBytes = (rowBytes + alignment - 1) & ~(alignment - 1);
+  return alignedRowBytes * (height - 1) + rowBytes;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTRACEFORMAT_H
+#define GLTRACEFORMAT_H
+
+#include <stdint.h>
+
+/**
+ * \file GLTraceFormat.h
+ * \brief The binary GL call trace file, shared by the recorder and the replayer.
+ *
+ * A trace is a GLTraceFileHeader followed by one record per call: the call's number as one
+ * byte, then its arguments and results in the order its signature gives, little endian and
+ * unaligned:
+ *  - u: 32 bit integer, enum, name, location or boolean.
+ *  - f: 32 bit float.
+ *  - q: 64 bit integer.
+ *  - h: EGL handle, numbered 1, 2, ... in the order the recorder first saw them, 0 for none.
+ *  - b: 32 bit byte count, then that many bytes: pixels, uniform values, client arrays,
+ *       client indices, strings (with their terminating NUL) and attribute lists.
+ *
+ * Records carry no length, the signature says how to read them, so the call numbers and
+ * signatures of a version never change; new calls are added at the end.
+ */
+
+#define GL_TRACE_MAGIC   0x54324C47 /* "GL2T" */
+#define GL_TRACE_VERSION 1
+
+    /**
+     * \brief Start of a trace file.
+     */
+    struct GLTraceFileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        /** Number of calls in the GLTRACE_CALLS table of the recorder. */
+        uint32_t callCount;
+        uint32_t reserved;
+    };
+
+/**
+ * \brief Every recorded call with its signature, arguments first and then results.
+ *
+ * glTraceClientArray is not a GL call: it carries the client array an enabled attribute
+ * reads from, as much of it as the following draw uses, to be pointed at on replay.
+ * eglSwapBuffers records the monotonic time since the trace started in nanoseconds, as does
+ * eglSwapBuffersWithDamageKHR, which also stands for its EXT twin.
+ */
+#define GLTRACE_CALLS(X)                                                            \
+    X(eglGetDisplay,                "hh")                                           \
+    X(eglInitialize,                "huuu")                                         \
+    X(eglTerminate,                 "hu")                                           \
+    X(eglChooseConfig,              "hbhuu")                                        \
+    X(eglGetConfigAttrib,           "hhuuu")                                        \
+    X(eglCreateWindowSurface,       "hhhbhuu")                                      \
+    X(eglCreatePbufferSurface,      "hhbhuu")                                       \
+    X(eglCreateContext,             "hhhbh")                                        \
+    X(eglMakeCurrent,               "hhhhu")                                        \
+    X(eglQuerySurface,              "hhuuu")                                        \
+    X(eglSwapBuffers,               "hhuq")                                         \
+    X(eglGetError,                  "u")                                            \
+    X(eglCreateImageKHR,            "hhuhbh")                                       \
+    X(eglDestroyImageKHR,           "hhu")                                          \
+    X(glActiveTexture,              "u")                                            \
+    X(glAttachShader,               "uu")                                           \
+    X(glBindAttribLocation,         "uub")                                          \
+    X(glBindBuffer,                 "uu")                                           \
+    X(glBindFramebuffer,            "uu")                                           \
+    X(glBindTexture,                "uu")                                           \
+    X(glBlendFunc,                  "uu")                                           \
+    X(glBufferData,                 "uuub")                                         \
+    X(glBufferSubData,              "uub")                                          \
+    X(glCheckFramebufferStatus,     "uu")                                           \
+    X(glClear,                      "u")                                            \
+    X(glClearColor,                 "ffff")                                         \
+    X(glClearDepthf,                "f")                                            \
+    X(glCompileShader,              "u")                                            \
+    X(glCreateProgram,              "u")                                            \
+    X(glCreateShader,               "uu")                                           \
+    X(glCullFace,                   "u")                                            \
+    X(glDeleteBuffers,              "b")                                            \
+    X(glDeleteFramebuffers,         "b")                                            \
+    X(glDeleteProgram,              "u")                                            \
+    X(glDeleteShader,               "u")                                            \
+    X(glDeleteTextures,             "b")                                            \
+    X(glDepthFunc,                  "u")                                            \
+    X(glDepthMask,                  "u")                                            \
+    X(glDisable,                    "u")                                            \
+    X(glDisableVertexAttribArray,   "u")                                            \
+    X(glDrawArrays,                 "uuu")                                          \
+    X(glDrawElements,               "uuuub")                                        \
+    X(glEGLImageTargetTexture2DOES, "uh")                                           \
+    X(glEnable,                     "u")                                            \
+    X(glEnableVertexAttribArray,    "u")                                            \
+    X(glFinish,                     "")                                             \
+    X(glFlush,                      "")                                             \
+    X(glFramebufferTexture2D,       "uuuuu")                                        \
+    X(glFrontFace,                  "u")                                            \
+    X(glGenBuffers,                 "b")                                            \
+    X(glGenFramebuffers,            "b")                                            \
+    X(glGenTextures,                "b")                                            \
+    X(glGetAttribLocation,          "ubu")                                          \
+    X(glGetError,                   "u")                                            \
+    X(glGetIntegerv,                "u")                                            \
+    X(glGetProgramBinaryOES,        "uu")                                           \
+    X(glGetProgramInfoLog,          "uu")                                           \
+    X(glGetProgramiv,               "uu")                                           \
+    X(glGetShaderInfoLog,           "uu")                                           \
+    X(glGetShaderiv,                "uu")                                           \
+    X(glGetString,                  "u")                                            \
+    X(glGetUniformLocation,         "ubu")                                          \
+    X(glLinkProgram,                "u")                                            \
+    X(glPixelStorei,                "uu")                                           \
+    X(glProgramBinaryOES,           "uub")                                          \
+    X(glReadPixels,                 "uuuuuu")                                       \
+    X(glScissor,                    "uuuu")                                         \
+    X(glShaderSource,               "ub")                                           \
+    X(glTexImage2D,                 "uuuuuuuub")                                    \
+    X(glTexParameteri,              "uuu")                                          \
+    X(glTexSubImage2D,              "uuuuuuuub")                                    \
+    X(glUniform1f,                  "uf")                                           \
+    X(glUniform1i,                  "uu")                                           \
+    X(glUniformMatrix4fv,           "uuub")                                         \
+    X(glUseProgram,                 "u")                                            \
+    X(glVertexAttribPointer,        "uuuuuuu")                                      \
+    X(glVertexAttrib4f,             "uffff")                                        \
+    X(glViewport,                   "uuuu")                                         \
+    X(glTraceClientArray,           "ub")                                           \
+    X(eglSwapInterval,              "huu")                                          \
+    X(eglSwapBuffersWithDamageKHR,  "hhbuuq")                                       \
+    X(glUniform4fv,                 "uub")                                          \
+    X(glGenRenderbuffers,           "b")                                            \
+    X(glBindRenderbuffer,           "uu")                                           \
+    X(glRenderbufferStorage,        "uuuu")                                         \
+    X(glFramebufferRenderbuffer,    "uuuu")
+
+    /**
+     * \brief Number of each call in a trace.
+     */
+    enum GLTraceCall
+    {
+#define GLTRACE_CALL_ENUM(name, signature) GLTRACE_##name,
+        GLTRACE_CALLS(GLTRACE_CALL_ENUM)
+#undef GLTRACE_CALL_ENUM
+        GLTRACE_CALL_COUNT
+    };
+
+    /**
+     * \brief Name and signature of a call.
+     */
+    struct GLTraceCallInfo
+    {
+        const char* name;
+        const char* signature;
+    };
+
+    /**
+     * \brief Name and signature of every call, indexed by GLTraceCall.
+     */
+    extern const GLTraceCallInfo glTraceCalls[GLTRACE_CALL_COUNT];
+
+    /**
+     * \brief Bytes of client memory a pixel transfer of width x height reads or writes.
+     * \param[in] alignment The GL_UNPACK_ALIGNMENT or GL_PACK_ALIGNMENT in effect.
+     * \return 0 if format and type are not a valid combination.
+     */
+    uint32_t glTracePixelBytes(int width, int height, unsigned int format, unsigned int type, int alignment);
+
+#endif /* GLTRACEFORMAT_H */
@@ -0,0 +1,915 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * gl2-cube-replay: re-issues a trace recorded with gl2-cube -t against the EGL and GLES2
+ * the program is linked with, timing every call. Built for the device, and for the host
+ * against the null and software backends.
+ *
+ * The replayer sets up its own display, surface and context and skips the recorded EGL
+ * calls except the swaps and the swap interval. Object names and uniform locations are
+ * translated from the recorded ones to the ones the backend returns. EGLImages cannot be
+ * recreated, textures that were bound to one are left undefined.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <utils/Timers.h>
+#ifdef HAVE_ANDROID_OS
+#include <ui/FramebufferNativeWindow.h>
+#include "EGLUtils.h"
+
+using namespace android;
+#endif
+
+#include "GLTraceFormat.h"
+
+#define MAX_ARGS        12
+#define MAX_NAMES       4096
+#define MAX_ATTRIBS     16
+#define MAX_LOCATIONS   256
+
+/* One decoded argument; which member is valid depends on its signature letter. */
+struct Arg
+{
+  uint32_t        u;
+  GLfloat         f;
+  uint64_t        q;
+  const uint8_t*  data;
+  uint32_t        size;
+};
+
+/* A growable, malloc aligned copy of a blob, for data the backend reads as words. */
+struct Scratch
+{
+  void*     data;
+  uint32_t  capacity;
+};
+
+struct CallTiming
+{
+  unsigned int  count;
+  nsecs_t       total;
+  nsecs_t       max;
+};
+
+/* The recorded client array pointer of an attribute; set when its data arrives. */
+struct ClientAttrib
+{
+  GLint     size;
+  GLenum    type;
+  GLboolean normalized;
+  GLsizei   stride;
+  Scratch   data;
+};
+
+struct LocationMap
+{
+  GLuint  program;
+  GLint   recorded;
+  GLint   replayed;
+};
+
+static bool         verbose = false;
+
+/* Recorded object names to replayed ones, 0 where not seen yet. */
+static GLuint       textures[MAX_NAMES];
+static GLuint       buffers[MAX_NAMES];
+static GLuint       framebuffers[MAX_NAMES];
+static GLuint       renderbuffers[MAX_NAMES];
+/* Shaders and programs share a namespace. */
+static GLuint       programObjects[MAX_NAMES];
+
+static LocationMap  locations[MAX_LOCATIONS];
+static unsigned int locationCount;
+static GLuint       currentProgram;
+
+static ClientAttrib clientAttribs[MAX_ATTRIBS];
+static Scratch      blobScratch;
+
+static CallTiming   timings[GLTRACE_CALL_COUNT];
+
+static EGLDisplay   dpy = EGL_NO_DISPLAY;
+static EGLSurface   surface = EGL_NO_SURFACE;
+static EGLContext   context = EGL_NO_CONTEXT;
+static EGLint       surfaceWidth;
+static EGLint       surfaceHeight;
+
+static nsecs_t      frameCallTime;
+
+/* Adds the time of a call that was issued to its totals and the frame's. */
+static void account(GLTraceCall call, nsecs_t elapsed)
+{
+  CallTiming& timing = timings[call];
+  timing.count++;
+  timing.total += elapsed;
+  timing.max = elapsed > timing.max ? elapsed : timing.max;
+  frameCallTime += elapsed;
+}
+
+/* Issues statement as call, timed. */
+#define ISSUE(call, statement)                                          \
+  do                                                                    \
+  {                                                                     \
+    nsecs_t issueStart = systemTime(SYSTEM_TIME_MONOTONIC);             \
+    statement;                                                          \
+    account(call, systemTime(SYSTEM_TIME_MONOTONIC) - issueStart);      \
+  } while (0)
+
+static GLuint mapName(const GLuint* table, uint32_t recorded)
+{
+  return recorded < MAX_NAMES && table[recorded] != 0 ? table[recorded] : recorded;
+}
+
+static void setName(GLuint* table, uint32_t recorded, GLuint replayed)
+{
+  if (recorded < MAX_NAMES)
+  {
+    table[recorded] = replayed;
+  }
+}
+
+static GLint mapLocation(uint32_t recorded)
+{
+  if ((GLint)recorded < 0)
+  {
+    return -1;
+  }
+  for (unsigned int i = 0; i < locationCount; i++)
+  {
+    if (locations[i].program == currentProgram && locations[i].recorded == (GLint)recorded)
+    {
+      return locations[i].replayed;
+    }
+  }
+  return recorded;
+}
+
+static void setLocation(GLuint program, GLint recorded, GLint replayed)
+{
+  unsigned int i;
+  for (i = 0; i < locationCount; i++)
+  {
+    if (locations[i].program == program && locations[i].recorded == recorded)
+    {
+      break;
+    }
+  }
+  if (i == MAX_LOCATIONS)
+  {
+    return;
+  }
+  locationCount += i == locationCount;
+  locations[i].program  = program;
+  locations[i].recorded = recorded;
+  locations[i].replayed = replayed;
+}
+
+/* Grows scratch to at least size bytes; returns NULL if that fails. */
+static void* reserve(Scratch& scratch, uint32_t size)
+{
+  if (size > scratch.capacity)
+  {
+    free(scratch.data);
+    scratch.data = malloc(size);
+    scratch.capacity = scratch.data != NULL ? size : 0;
+  }
+  return scratch.data;
+}
+
+/* The blob of arg, copied to aligned memory; NULL if it is empty. */
+static const void* alignedBlob(const Arg& arg, Scratch& scratch)
+{
+  if (arg.size == 0 || reserve(scratch, arg.size) == NULL)
+  {
+    return NULL;
+  }
+  memcpy(scratch.data, arg.data, arg.size);
+  return scratch.data;
+}
+
+static void warnOnce(bool* warned, const char* message)
+{
+  if (!*warned)
+  {
+    fprintf(stderr, "%s\n", message);
+    *warned = true;
+  }
+}
+
+static bool createSurface(void)
+{
+  EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+  EGLint majorVersion, minorVersion;
+  EGLConfig config;
+
+  dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &majorVersion, &minorVersion))
+  {
+    fprintf(stderr, "Could not initialize EGL (0x%x)\n", eglGetError());
+    return false;
+  }
+
+#ifdef HAVE_ANDROID_OS
+  EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+                             EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                             EGL_NONE };
+  EGLNativeWindowType window = android_createDisplaySurfaceEx("fb4");
+  if (EGLUtils::selectConfigForNativeWindow(dpy, configAttribs, window, &config))
+  {
+    fprintf(stderr, "EGLUtils::selectConfigForNativeWindow failed\n");
+    return false;
+  }
+  surface = eglCreateWindowSurface(dpy, config, window, NULL);
+#else
+  /* The surface is as large as the recorded one unless -s says otherwise. */
+  EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                             EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                             EGL_NONE };
+  EGLint numConfigs = 0;
+  if (!eglChooseConfig(dpy, configAttribs, &config, 1, &numConfigs) || numConfigs == 0)
+  {
+    fprintf(stderr, "eglChooseConfig found no configuration.\n");
+    return false;
+  }
+  EGLint pbufferAttribs[] = { EGL_WIDTH,  surfaceWidth  > 0 ? surfaceWidth  : 800,
+                              EGL_HEIGHT, surfaceHeight > 0 ? surfaceHeight : 480,
+                              EGL_NONE };
+  surface = eglCreatePbufferSurface(dpy, config, pbufferAttribs);
+#endif
+  if (surface == EGL_NO_SURFACE)
+  {
+    fprintf(stderr, "Could not create a surface (0x%x)\n", eglGetError());
+    return false;
+  }
+
+  context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, surface, surface, context))
+  {
+    fprintf(stderr, "Could not create a context (0x%x)\n", eglGetError());
+    return false;
+  }
+
+  eglQuerySurface(dpy, surface, EGL_WIDTH, &surfaceWidth);
+  eglQuerySurface(dpy, surface, EGL_HEIGHT, &surfaceHeight);
+  fprintf(stderr, "Replaying to a %d x %d surface\n", surfaceWidth, surfaceHeight);
+  return true;
+}
+
+static void printCall(GLTraceCall call, const Arg* args)
+{
+  const char* signature = glTraceCalls[call].signature;
+  fprintf(stderr, "%s(", glTraceCalls[call].name);
+  for (int i = 0; signature[i] != '\0'; i++)
+  {
+    const char* separator = i ? ", " : "";
+    switch (signature[i])
+    {
+      case 'u': fprintf(stderr, "%s0x%x", separator, args[i].u); break;
+      case 'f': fprintf(stderr, "%s%g", separator, args[i].f); break;
+      case 'q': fprintf(stderr, "%s%llu", separator, (unsigned long long)args[i].q); break;
+      case 'h': fprintf(stderr, "%s#%u", separator, args[i].u); break;
+      case 'b': fprintf(stderr, "%s[%u bytes]", separator, args[i].size); break;
+    }
+  }
+  fprintf(stderr, ")\n");
+}
+
+/* Decodes the arguments of a record at data, returning its end or NULL if it is cut short. */
+static const uint8_t* decodeArgs(GLTraceCall call, const uint8_t* data, const uint8_t* end, Arg* args)
+{
+  const char* signature = glTraceCalls[call].signature;
+  for (int i = 0; signature[i] != '\0'; i++)
+  {
+    Arg& arg = args[i];
+    size_t size = signature[i] == 'q' ? 8 : 4;
+    if ((size_t)(end - data) < size)
+    {
+      return NULL;
+    }
+    switch (signature[i])
+    {
+      case 'f': memcpy(&arg.f, data, 4); break;
+      case 'q': memcpy(&arg.q, data, 8); break;
+      default:  memcpy(&arg.u, data, 4); break;
+    }
+    data += size;
+    if (signature[i] == 'b')
+    {
+      if ((size_t)(end - data) < arg.u)
+      {
+        return NULL;
+      }
+      arg.data = data;
+      arg.size = arg.u;
+      data += arg.size;
+    }
+  }
+  return data;
+}
+
+/* Replays one call; returns false if the replay cannot go on. */
+static bool replayCall(GLTraceCall call, const Arg* a)
+{
+  static bool warnedImage = false;
+  static GLint intResult[16];
+  static GLchar infoLog[1024];
+  static Scratch binaryScratch;
+
+  switch (call)
+  {
+    case GLTRACE_eglCreateWindowSurface:
+    case GLTRACE_eglCreatePbufferSurface:
+      if (surfaceWidth == 0 || surfaceHeight == 0)
+      {
+        int width = call == GLTRACE_eglCreateWindowSurface ? 5 : 4;
+        surfaceWidth  = a[width].u;
+        surfaceHeight = a[width + 1].u;
+      }
+      break;
+    case GLTRACE_eglMakeCurrent:
+      if (a[3].u != 0 && context == EGL_NO_CONTEXT && !createSurface())
+      {
+        return false;
+      }
+      break;
+    case GLTRACE_eglSwapBuffers:
+      ISSUE(call, eglSwapBuffers(dpy, surface));
+      break;
+    case GLTRACE_eglSwapBuffersWithDamageKHR:
+      /* Presenting everything is always correct, and the replay surface may lack the extension. */
+      ISSUE(call, eglSwapBuffers(dpy, surface));
+      break;
+    case GLTRACE_eglSwapInterval:
+      ISSUE(call, eglSwapInterval(dpy, a[1].u));
+      break;
+    case GLTRACE_eglGetError:
+      ISSUE(call, eglGetError());
+      break;
+    case GLTRACE_eglCreateImageKHR:
+    case GLTRACE_glEGLImageTargetTexture2DOES:
+      warnOnce(&warnedImage, "Skipping EGLImage calls, textures bound to an EGLImage are left undefined.");
+      break;
+    case GLTRACE_eglGetDisplay:
+    case GLTRACE_eglInitialize:
+    case GLTRACE_eglTerminate:
+    case GLTRACE_eglChooseConfig:
+    case GLTRACE_eglGetConfigAttrib:
+    case GLTRACE_eglCreateContext:
+    case GLTRACE_eglQuerySurface:
+    case GLTRACE_eglDestroyImageKHR:
+      /* The replayer has its own display, surface and context. */
+      break;
+
+    case GLTRACE_glActiveTexture:
+      ISSUE(call, glActiveTexture(a[0].u));
+      break;
+    case GLTRACE_glAttachShader:
+      ISSUE(call, glAttachShader(mapName(programObjects, a[0].u), mapName(programObjects, a[1].u)));
+      break;
+    case GLTRACE_glBindAttribLocation:
+      ISSUE(call, glBindAttribLocation(mapName(programObjects, a[0].u), a[1].u, (const GLchar*)a[2].data));
+      break;
+    case GLTRACE_glBindBuffer:
+      ISSUE(call, glBindBuffer(a[0].u, mapName(buffers, a[1].u)));
+      break;
+    case GLTRACE_glBindFramebuffer:
+      ISSUE(call, glBindFramebuffer(a[0].u, mapName(framebuffers, a[1].u)));
+      break;
+    case GLTRACE_glBindRenderbuffer:
+      ISSUE(call, glBindRenderbuffer(a[0].u, mapName(renderbuffers, a[1].u)));
+      break;
+    case GLTRACE_glBindTexture:
+      ISSUE(call, glBindTexture(a[0].u, mapName(textures, a[1].u)));
+      break;
+    case GLTRACE_glBlendFunc:
+      ISSUE(call, glBlendFunc(a[0].u, a[1].u));
+      break;
+    case GLTRACE_glBufferData:
+    {
+      const void* data = alignedBlob(a[3], blobScratch);
+      ISSUE(call, glBufferData(a[0].u, a[1].u, data, a[2].u));
+      break;
+    }
+    case GLTRACE_glBufferSubData:
+    {
+      const void* data = alignedBlob(a[2], blobScratch);
+      ISSUE(call, glBufferSubData(a[0].u, a[1].u, a[2].size, data));
+      break;
+    }
+    case GLTRACE_glCheckFramebufferStatus:
+      ISSUE(call, glCheckFramebufferStatus(a[0].u));
+      break;
+    case GLTRACE_glClear:
+      ISSUE(call, glClear(a[0].u));
+      break;
+    case GLTRACE_glClearColor:
+      ISSUE(call, glClearColor(a[0].f, a[1].f, a[2].f, a[3].f));
+      break;
+    case GLTRACE_glClearDepthf:
+      ISSUE(call, glClearDepthf(a[0].f));
+      break;
+    case GLTRACE_glCompileShader:
+      ISSUE(call, glCompileShader(mapName(programObjects, a[0].u)));
+      break;
+    case GLTRACE_glCreateProgram:
+    {
+      GLuint program = 0;
+      ISSUE(call, program = glCreateProgram());
+      setName(programObjects, a[0].u, program);
+      break;
+    }
+    case GLTRACE_glCreateShader:
+    {
+      GLuint shader = 0;
+      ISSUE(call, shader = glCreateShader(a[0].u));
+      setName(programObjects, a[1].u, shader);
+      break;
+    }
+    case GLTRACE_glCullFace:
+      ISSUE(call, glCullFace(a[0].u));
+      break;
+    case GLTRACE_glDeleteBuffers:
+    case GLTRACE_glDeleteFramebuffers:
+    case GLTRACE_glDeleteTextures:
+    {
+      GLuint* table = call == GLTRACE_glDeleteBuffers ? buffers :
+                      (call == GLTRACE_glDeleteFramebuffers ? framebuffers : textures);
+      GLsizei n = a[0].size / sizeof(GLuint);
+      GLuint* names = (GLuint*)alignedBlob(a[0], blobScratch);
+      for (GLsizei i = 0; i < n; i++)
+      {
+        GLuint recorded = names[i];
+        names[i] = mapName(table, recorded);
+        setName(table, recorded, 0);
+      }
+      if (call == GLTRACE_glDeleteBuffers)
+      {
+        ISSUE(call, glDeleteBuffers(n, names));
+      }
+      else if (call == GLTRACE_glDeleteFramebuffers)
+      {
+        ISSUE(call, glDeleteFramebuffers(n, names));
+      }
+      else
+      {
+        ISSUE(call, glDeleteTextures(n, names));
+      }
+      break;
+    }
+    case GLTRACE_glDeleteProgram:
+      ISSUE(call, glDeleteProgram(mapName(programObjects, a[0].u)));
+      break;
+    case GLTRACE_glDeleteShader:
+      ISSUE(call, glDeleteShader(mapName(programObjects, a[0].u)));
+      break;
+    case GLTRACE_glDepthFunc:
+      ISSUE(call, glDepthFunc(a[0].u));
+      break;
+    case GLTRACE_glDepthMask:
+      ISSUE(call, glDepthMask(a[0].u));
+      break;
+    case GLTRACE_glDisable:
+      ISSUE(call, glDisable(a[0].u));
+      break;
+    case GLTRACE_glDisableVertexAttribArray:
+      ISSUE(call, glDisableVertexAttribArray(a[0].u));
+      break;
+    case GLTRACE_glDrawArrays:
+      ISSUE(call, glDrawArrays(a[0].u, a[1].u, a[2].u));
+      break;
+    case GLTRACE_glDrawElements:
+    {
+      const GLvoid* indices = a[4].size ? alignedBlob(a[4], blobScratch) : (const GLvoid*)(uintptr_t)a[3].u;
+      ISSUE(call, glDrawElements(a[0].u, a[1].u, a[2].u, indices));
+      break;
+    }
+    case GLTRACE_glEnable:
+      ISSUE(call, glEnable(a[0].u));
+      break;
+    case GLTRACE_glEnableVertexAttribArray:
+      ISSUE(call, glEnableVertexAttribArray(a[0].u));
+      break;
+    case GLTRACE_glFinish:
+      ISSUE(call, glFinish());
+      break;
+    case GLTRACE_glFlush:
+      ISSUE(call, glFlush());
+      break;
+    case GLTRACE_glFramebufferTexture2D:
+      ISSUE(call, glFramebufferTexture2D(a[0].u, a[1].u, a[2].u, mapName(textures, a[3].u), a[4].u));
+      break;
+    case GLTRACE_glFramebufferRenderbuffer:
+      ISSUE(call, glFramebufferRenderbuffer(a[0].u, a[1].u, a[2].u, mapName(renderbuffers, a[3].u)));
+      break;
+    case GLTRACE_glFrontFace:
+      ISSUE(call, glFrontFace(a[0].u));
+      break;
+    case GLTRACE_glGenBuffers:
+    case GLTRACE_glGenFramebuffers:
+    case GLTRACE_glGenRenderbuffers:
+    case GLTRACE_glGenTextures:
+    {
+      GLuint* table = call == GLTRACE_glGenBuffers ? buffers :
+                      call == GLTRACE_glGenFramebuffers ? framebuffers :
+                      (call == GLTRACE_glGenRenderbuffers ? renderbuffers : textures);
+      GLsizei n = a[0].size / sizeof(GLuint);
+      const GLuint* recorded = (const GLuint*)alignedBlob(a[0], blobScratch);
+      GLuint names[64];
+      for (GLsizei first = 0; first < n; first += 64)
+      {
+        GLsizei count = n - first < 64 ? n - first : 64;
+        if (call == GLTRACE_glGenBuffers)
+        {
+          ISSUE(call, glGenBuffers(count, names));
+        }
+        else if (call == GLTRACE_glGenFramebuffers)
+        {
+          ISSUE(call, glGenFramebuffers(count, names));
+        }
+        else if (call == GLTRACE_glGenRenderbuffers)
+        {
+          ISSUE(call, glGenRenderbuffers(count, names));
+        }
+        else
+        {
+          ISSUE(call, glGenTextures(count, names));
+        }
+        for (GLsizei i = 0; i < count; i++)
+        {
+          setName(table, recorded[first + i], names[i]);
+        }
+      }
+      break;
+    }
+    case GLTRACE_glGetAttribLocation:
+      ISSUE(call, glGetAttribLocation(mapName(programObjects, a[0].u), (const GLchar*)a[1].data));
+      break;
+    case GLTRACE_glGetError:
+      ISSUE(call, glGetError());
+      break;
+    case GLTRACE_glGetIntegerv:
+      ISSUE(call, glGetIntegerv(a[0].u, intResult));
+      break;
+    case GLTRACE_glGetProgramBinaryOES:
+    {
+      GLsizei length;
+      GLenum format;
+      void* binary = reserve(binaryScratch, a[1].u);
+      ISSUE(call, glGetProgramBinaryOES(mapName(programObjects, a[0].u), binaryScratch.capacity, &length,
+                                        &format, binary));
+      break;
+    }
+    case GLTRACE_glGetProgramInfoLog:
+      ISSUE(call, glGetProgramInfoLog(mapName(programObjects, a[0].u), sizeof(infoLog), NULL, infoLog));
+      break;
+    case GLTRACE_glGetProgramiv:
+      ISSUE(call, glGetProgramiv(mapName(programObjects, a[0].u), a[1].u, intResult));
+      break;
+    case GLTRACE_glGetShaderInfoLog:
+      ISSUE(call, glGetShaderInfoLog(mapName(programObjects, a[0].u), sizeof(infoLog), NULL, infoLog));
+      break;
+    case GLTRACE_glGetShaderiv:
+      ISSUE(call, glGetShaderiv(mapName(programObjects, a[0].u), a[1].u, intResult));
+      break;
+    case GLTRACE_glGetString:
+      ISSUE(call, glGetString(a[0].u));
+      break;
+    case GLTRACE_glGetUniformLocation:
+    {
+      GLint location = -1;
+      ISSUE(call, location = glGetUniformLocation(mapName(programObjects, a[0].u), (const GLchar*)a[1].data));
+      setLocation(a[0].u, a[2].u, location);
+      break;
+    }
+    case GLTRACE_glLinkProgram:
+      ISSUE(call, glLinkProgram(mapName(programObjects, a[0].u)));
+      break;
+    case GLTRACE_glPixelStorei:
+      ISSUE(call, glPixelStorei(a[0].u, a[1].u));
+      break;
+    case GLTRACE_glProgramBinaryOES:
+    {
+      const void* binary = alignedBlob(a[2], blobScratch);
+      GLuint program = mapName(programObjects, a[0].u);
+      GLint linked = GL_FALSE;
+      ISSUE(call, glProgramBinaryOES(program, a[1].u, binary, a[2].size));
+      glGetProgramiv(program, GL_LINK_STATUS, &linked);
+      if (!linked)
+      {
+        /* The program goes unlinked unless the trace compiled it from source afterwards. */
+        fprintf(stderr, "Program %u: the recorded program binary was rejected; record with -c \"\" "
+                "to replay on a different backend.\n", a[0].u);
+      }
+      break;
+    }
+    case GLTRACE_glReadPixels:
+    {
+      void* pixels = reserve(blobScratch, glTracePixelBytes(a[2].u, a[3].u, a[4].u, a[5].u, 4));
+      if (pixels != NULL)
+      {
+        ISSUE(call, glReadPixels(a[0].u, a[1].u, a[2].u, a[3].u, a[4].u, a[5].u, pixels));
+      }
+      break;
+    }
+    case GLTRACE_glRenderbufferStorage:
+      ISSUE(call, glRenderbufferStorage(a[0].u, a[1].u, a[2].u, a[3].u));
+      break;
+    case GLTRACE_glScissor:
+      ISSUE(call, glScissor(a[0].u, a[1].u, a[2].u, a[3].u));
+      break;
+    case GLTRACE_glShaderSource:
+    {
+      const GLchar* source = (const GLchar*)a[1].data;
+      ISSUE(call, glShaderSource(mapName(programObjects, a[0].u), 1, &source, NULL));
+      break;
+    }
+    case GLTRACE_glTexImage2D:
+    {
+      const void* pixels = alignedBlob(a[8], blobScratch);
+      ISSUE(call, glTexImage2D(a[0].u, a[1].u, a[2].u, a[3].u, a[4].u, a[5].u, a[6].u, a[7].u, pixels));
+      break;
+    }
+    case GLTRACE_glTexParameteri:
+      ISSUE(call, glTexParameteri(a[0].u, a[1].u, a[2].u));
+      break;
+    case GLTRACE_glTexSubImage2D:
+    {
+      const void* pixels = alignedBlob(a[8], blobScratch);
+      ISSUE(call, glTexSubImage2D(a[0].u, a[1].u, a[2].u, a[3].u, a[4].u, a[5].u, a[6].u, a[7].u, pixels));
+      break;
+    }
+    case GLTRACE_glUniform1f:
+    {
+      GLint location = mapLocation(a[0].u);
+      ISSUE(call, glUniform1f(location, a[1].f));
+      break;
+    }
+    case GLTRACE_glUniform1i:
+    {
+      GLint location = mapLocation(a[0].u);
+      ISSUE(call, glUniform1i(location, a[1].u));
+      break;
+    }
+    case GLTRACE_glUniform4fv:
+    {
+      GLint location = mapLocation(a[0].u);
+      const GLfloat* value = (const GLfloat*)alignedBlob(a[2], blobScratch);
+      ISSUE(call, glUniform4fv(location, a[1].u, value));
+      break;
+    }
+    case GLTRACE_glUniformMatrix4fv:
+    {
+      GLint location = mapLocation(a[0].u);
+      const GLfloat* value = (const GLfloat*)alignedBlob(a[3], blobScratch);
+      ISSUE(call, glUniformMatrix4fv(location, a[1].u, a[2].u, value));
+      break;
+    }
+    case GLTRACE_glUseProgram:
+      currentProgram = a[0].u;
+      ISSUE(call, glUseProgram(mapName(programObjects, a[0].u)));
+      break;
+    case GLTRACE_glVertexAttribPointer:
+      if (a[6].u && a[0].u < MAX_ATTRIBS)
+      {
+        /* Pointed at the data of the next glTraceClientArray of the attribute. */
+        ClientAttrib& attrib = clientAttribs[a[0].u];
+        attrib.size       = a[1].u;
+        attrib.type       = a[2].u;
+        attrib.normalized = a[3].u;
+        attrib.stride     = a[4].u;
+      }
+      else
+      {
+        ISSUE(call, glVertexAttribPointer(a[0].u, a[1].u, a[2].u, a[3].u, a[4].u,
+                                          (const GLvoid*)(uintptr_t)a[5].u));
+      }
+      break;
+    case GLTRACE_glVertexAttrib4f:
+      ISSUE(call, glVertexAttrib4f(a[0].u, a[1].f, a[2].f, a[3].f, a[4].f));
+      break;
+    case GLTRACE_glViewport:
+      ISSUE(call, glViewport(a[0].u, a[1].u, a[2].u, a[3].u));
+      break;
+    case GLTRACE_glTraceClientArray:
+      if (a[0].u < MAX_ATTRIBS)
+      {
+        /* Client arrays are recorded at every draw, so the pointer is set again each time. */
+        ClientAttrib& attrib = clientAttribs[a[0].u];
+        const void* data = alignedBlob(a[1], attrib.data);
+        ISSUE(GLTRACE_glVertexAttribPointer,
+              glVertexAttribPointer(a[0].u, attrib.size, attrib.type, attrib.normalized, attrib.stride, data));
+      }
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+static void printTimings(unsigned int frames, nsecs_t minFrame, nsecs_t maxFrame, nsecs_t totalFrame,
+                         nsecs_t minCalls, nsecs_t maxCalls, nsecs_t totalCalls, nsecs_t recordedSpan)
+{
+  int order[GLTRACE_CALL_COUNT];
+  int count = 0;
+  for (int i = 0; i < GLTRACE_CALL_COUNT; i++)
+  {
+    if (timings[i].count == 0)
+    {
+      continue;
+    }
+    int j = count++;
+    for (; j > 0 && timings[order[j - 1]].total < timings[i].total; j--)
+    {
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+  }
+
+  fprintf(stderr, "%-30s %9s %11s %9s %9s\n", "call", "count", "total ms", "avg us", "max us");
+  for (int i = 0; i < count; i++)
+  {
+    const CallTiming& timing = timings[order[i]];
+    fprintf(stderr, "%-30s %9u %11.3f %9.2f %9.2f\n", glTraceCalls[order[i]].name, timing.count,
+            timing.total / 1000000.0, timing.total / 1000.0 / timing.count, timing.max / 1000.0);
+  }
+
+  if (frames == 0)
+  {
+    return;
+  }
+  fprintf(stderr, "%u frames: frame %.3f/%.3f/%.3f ms min/avg/max, in GL and EGL calls %.3f/%.3f/%.3f ms\n",
+          frames, minFrame / 1000000.0, totalFrame / 1000000.0 / frames, maxFrame / 1000000.0,
+          minCalls / 1000000.0, totalCalls / 1000000.0 / frames, maxCalls / 1000000.0);
+  if (frames > 1)
+  {
+    fprintf(stderr, "recorded: %.3f ms per frame\n", recordedSpan / 1000000.0 / (frames - 1));
+  }
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [options] <trace>\n", name);
+  fprintf(stderr, "  -v                               print every call as it is replayed\n");
+#ifndef HAVE_ANDROID_OS
+  fprintf(stderr, "  -s <width>x<height>              size of the offscreen surface (default: as recorded)\n");
+#endif
+}
+
+int main(int argc, char** argv)
+{
+  const char* path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-v") == 0)
+    {
+      verbose = true;
+    }
+#ifndef HAVE_ANDROID_OS
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc &&
+             sscanf(argv[++i], "%dx%d", &surfaceWidth, &surfaceHeight) == 2)
+    {
+    }
+#endif
+    else if (argv[i][0] != '-' && path == NULL)
+    {
+      path = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (path == NULL)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  /* The whole trace is read up front so that reading does not show up in the timings. */
+  FILE* file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Could not open %s\n", path);
+    return 1;
+  }
+  fseek(file, 0, SEEK_END);
+  long fileSize = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  uint8_t* trace = fileSize > 0 ? (uint8_t*)malloc(fileSize) : NULL;
+  if (trace == NULL || fread(trace, 1, fileSize, file) != (size_t)fileSize)
+  {
+    fprintf(stderr, "Could not read %s\n", path);
+    fclose(file);
+    return 1;
+  }
+  fclose(file);
+
+  GLTraceFileHeader header;
+  if ((size_t)fileSize < sizeof(header))
+  {
+    fprintf(stderr, "%s is not a GL trace\n", path);
+    return 1;
+  }
+  memcpy(&header, trace, sizeof(header));
+  if (header.magic != GL_TRACE_MAGIC || header.version != GL_TRACE_VERSION)
+  {
+    fprintf(stderr, "%s is not a version %d GL trace\n", path, GL_TRACE_VERSION);
+    return 1;
+  }
+
+  const uint8_t* data = trace + sizeof(header);
+  const uint8_t* end  = trace + fileSize;
+  unsigned int records = 0;
+  unsigned int frames = 0;
+  nsecs_t frameStart = 0;
+  nsecs_t minFrame = 0, maxFrame = 0, totalFrame = 0;
+  nsecs_t minCalls = 0, maxCalls = 0, totalCalls = 0;
+  nsecs_t firstSwap = 0, lastSwap = 0;
+  Arg args[MAX_ARGS];
+
+  while (data < end)
+  {
+    GLTraceCall call = (GLTraceCall)*data;
+    if (call >= GLTRACE_CALL_COUNT)
+    {
+      fprintf(stderr, "Unknown call %d in record %u, stopping.\n", call, records);
+      break;
+    }
+    const uint8_t* next = decodeArgs(call, data + 1, end, args);
+    if (next == NULL)
+    {
+      fprintf(stderr, "Record %u (%s) is cut short, stopping.\n", records, glTraceCalls[call].name);
+      break;
+    }
+    data = next;
+    records++;
+
+    if (verbose)
+    {
+      printCall(call, args);
+    }
+    if (!replayCall(call, args))
+    {
+      return 1;
+    }
+
+    if (call == GLTRACE_eglSwapBuffers || call == GLTRACE_eglSwapBuffersWithDamageKHR)
+    {
+      nsecs_t swapTime = call == GLTRACE_eglSwapBuffers ? args[3].q : args[5].q;
+      nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+      if (frameStart != 0)
+      {
+        nsecs_t frame = now - frameStart;
+        minFrame = frames == 0 || frame < minFrame ? frame : minFrame;
+        maxFrame = frame > maxFrame ? frame : maxFrame;
+        totalFrame += frame;
+        minCalls = frames == 0 || frameCallTime < minCalls ? frameCallTime : minCalls;
+        maxCalls = frameCallTime > maxCalls ? frameCallTime : maxCalls;
+        totalCalls += frameCallTime;
+        frames++;
+        lastSwap = swapTime;
+      }
+      else
+      {
+        /* Everything up to the first swap is setup. */
+        firstSwap = swapTime;
+      }
+      frameStart = now;
+      frameCallTime = 0;
+    }
+  }
+
+  fprintf(stderr, "Replayed %u calls from %s\n", records, path);
+  printTimings(frames, minFrame, maxFrame, totalFrame, minCalls, maxCalls, totalCalls, lastSwap - firstSwap);
+
+  if (dpy != EGL_NO_DISPLAY)
+  {
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglTerminate(dpy);
+  }
+  free(trace);
+  return 0;
+}
@@ -0,0 +1,693 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HostEGL.h"
+
+#include <string.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#define COUNT(name) hosteglCount(HOSTEGL_CALL_##name)
+
+/* The only display, config and context; handles are the addresses of these. */
+struct DisplayObject
+{
+  bool initialized;
+};
+
+struct ConfigObject
+{
+  EGLint id;
+};
+
+struct ContextObject
+{
+  bool created;
+};
+
+struct SurfaceObject
+{
+  bool          used;
+  EGLint        width;
+  EGLint        height;
+  unsigned int  swaps;
+};
+
+static DisplayObject  display;
+static ConfigObject   config = { 1 };
+static ContextObject  context;
+static SurfaceObject  surfaces[HOSTEGL_MAX_SURFACES];
+static EGLint         error = EGL_SUCCESS;
+static SurfaceObject* drawSurface;
+static SurfaceObject* readSurface;
+static bool           contextCurrent;
+
+/* Attributes of the config, see eglGetConfigAttrib. */
+static const EGLint configAttributes[] =
+{
+  EGL_BUFFER_SIZE,            32,
+  EGL_RED_SIZE,               8,
+  EGL_GREEN_SIZE,             8,
+  EGL_BLUE_SIZE,              8,
+  EGL_ALPHA_SIZE,             8,
+  EGL_DEPTH_SIZE,             24,
+  EGL_STENCIL_SIZE,           0,
+  EGL_CONFIG_ID,              1,
+  EGL_LEVEL,                  0,
+  EGL_MAX_PBUFFER_WIDTH,      HOSTEGL_MAX_PBUFFER_SIZE,
+  EGL_MAX_PBUFFER_HEIGHT,     HOSTEGL_MAX_PBUFFER_SIZE,
+  EGL_MAX_PBUFFER_PIXELS,     HOSTEGL_MAX_PBUFFER_SIZE * HOSTEGL_MAX_PBUFFER_SIZE,
+  EGL_NATIVE_RENDERABLE,      EGL_FALSE,
+  EGL_NATIVE_VISUAL_ID,       0,
+  EGL_NATIVE_VISUAL_TYPE,     EGL_NONE,
+  EGL_SAMPLES,                0,
+  EGL_SAMPLE_BUFFERS,         0,
+  EGL_SURFACE_TYPE,           EGL_PBUFFER_BIT,
+  EGL_TRANSPARENT_TYPE,       EGL_NONE,
+  EGL_TRANSPARENT_RED_VALUE,  0,
+  EGL_TRANSPARENT_GREEN_VALUE, 0,
+  EGL_TRANSPARENT_BLUE_VALUE, 0,
+  EGL_BIND_TO_TEXTURE_RGB,    EGL_FALSE,
+  EGL_BIND_TO_TEXTURE_RGBA,   EGL_FALSE,
+  EGL_MIN_SWAP_INTERVAL,      0,
+  EGL_MAX_SWAP_INTERVAL,      1,
+  EGL_LUMINANCE_SIZE,         0,
+  EGL_ALPHA_MASK_SIZE,        0,
+  EGL_COLOR_BUFFER_TYPE,      EGL_RGB_BUFFER,
+  EGL_RENDERABLE_TYPE,        EGL_OPENGL_ES_BIT | EGL_OPENGL_ES2_BIT,
+  EGL_CONFORMANT,             0,
+  EGL_NONE
+};
+
+static EGLBoolean fail(EGLint code)
+{
+  error = code;
+  return EGL_FALSE;
+}
+
+static bool validDisplay(EGLDisplay dpy)
+{
+  if (dpy != (EGLDisplay)&display)
+  {
+    error = EGL_BAD_DISPLAY;
+    return false;
+  }
+  if (!display.initialized)
+  {
+    error = EGL_NOT_INITIALIZED;
+    return false;
+  }
+  return true;
+}
+
+static SurfaceObject* surfaceObject(EGLSurface surface)
+{
+  for (int i = 0; i < HOSTEGL_MAX_SURFACES; i++)
+  {
+    if (surface == (EGLSurface)&surfaces[i] && surfaces[i].used)
+    {
+      return &surfaces[i];
+    }
+  }
+  return NULL;
+}
+
+static int surfaceIndex(const SurfaceObject* surface)
+{
+  return surface - surfaces;
+}
+
+static bool hasExtension(const char* name)
+{
+  size_t length = strlen(name);
+  for (const char* found = strstr(hosteglExtensions, name); found != NULL; found = strstr(found + length, name))
+  {
+    if ((found == hosteglExtensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+EGLint eglGetError(void)
+{
+  COUNT(eglGetError);
+  EGLint result = error;
+  error = EGL_SUCCESS;
+  return result;
+}
+
+EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id)
+{
+  COUNT(eglGetDisplay);
+  if (display_id != EGL_DEFAULT_DISPLAY)
+  {
+    return EGL_NO_DISPLAY;
+  }
+  return (EGLDisplay)&display;
+}
+
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint* major, EGLint* minor)
+{
+  COUNT(eglInitialize);
+  if (dpy != (EGLDisplay)&display)
+  {
+    return fail(EGL_BAD_DISPLAY);
+  }
+  if (!display.initialized)
+  {
+    hosteglInitialize();
+    display.initialized = true;
+  }
+  if (major != NULL)
+  {
+    *major = 1;
+  }
+  if (minor != NULL)
+  {
+    *minor = 4;
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
+
+EGLBoolean eglTerminate(EGLDisplay dpy)
+{
+  COUNT(eglTerminate);
+  if (dpy != (EGLDisplay)&display)
+  {
+    return fail(EGL_BAD_DISPLAY);
+  }
+  if (display.initialized)
+  {
+    hosteglTerminate();
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    for (int i = 0; i < HOSTEGL_MAX_SURFACES; i++)
+    {
+      if (surfaces[i].used)
+      {
+        hosteglDestroySurface(i);
+        surfaces[i].used = false;
+      }
+    }
+    if (context.created)
+    {
+      hosteglDestroyContext();
+      context.created = false;
+    }
+    display.initialized = false;
+  }
+  return EGL_TRUE;
+}
+
+const char* eglQueryString(EGLDisplay dpy, EGLint name)
+{
+  COUNT(eglQueryString);
+  if (!validDisplay(dpy))
+  {
+    return NULL;
+  }
+  switch (name)
+  {
+    case EGL_VENDOR:      return "gl2-cube";
+    case EGL_VERSION:     return hosteglVersion;
+    case EGL_EXTENSIONS:  return hosteglExtensions;
+    case EGL_CLIENT_APIS: return "OpenGL_ES";
+    default:
+      error = EGL_BAD_PARAMETER;
+      return NULL;
+  }
+}
+
+EGLBoolean eglGetConfigs(EGLDisplay dpy, EGLConfig* configs, EGLint config_size, EGLint* num_config)
+{
+  COUNT(eglGetConfigs);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  if (num_config == NULL)
+  {
+    return fail(EGL_BAD_PARAMETER);
+  }
+  *num_config = 1;
+  if (configs != NULL)
+  {
+    *num_config = config_size > 0 ? 1 : 0;
+    if (config_size > 0)
+    {
+      configs[0] = (EGLConfig)&config;
+    }
+  }
+  return EGL_TRUE;
+}
+
+static bool configAttribute(EGLint attribute, EGLint* value)
+{
+  if (attribute == EGL_CONFIG_CAVEAT)
+  {
+    /* Up to the backend, so it is not in the table. */
+    *value = hosteglConfigCaveat;
+    return true;
+  }
+  for (int i = 0; configAttributes[i] != EGL_NONE; i += 2)
+  {
+    if (configAttributes[i] == attribute)
+    {
+      *value = configAttributes[i + 1];
+      return true;
+    }
+  }
+  return false;
+}
+
+/* The one config matches unless a size asks for more bits than it has or a surface or
+ * renderable type bit it lacks is requested. */
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint* attrib_list, EGLConfig* configs,
+                           EGLint config_size, EGLint* num_config)
+{
+  COUNT(eglChooseConfig);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  if (num_config == NULL)
+  {
+    return fail(EGL_BAD_PARAMETER);
+  }
+
+  bool matches = true;
+  for (int i = 0; attrib_list != NULL && attrib_list[i] != EGL_NONE; i += 2)
+  {
+    EGLint value;
+    EGLint requested = attrib_list[i + 1];
+    if (!configAttribute(attrib_list[i], &value) || requested == EGL_DONT_CARE)
+    {
+      continue;
+    }
+    switch (attrib_list[i])
+    {
+      case EGL_SURFACE_TYPE:
+      case EGL_RENDERABLE_TYPE:
+        matches = matches && (requested & ~value) == 0;
+        break;
+      case EGL_BUFFER_SIZE:
+      case EGL_RED_SIZE:
+      case EGL_GREEN_SIZE:
+      case EGL_BLUE_SIZE:
+      case EGL_ALPHA_SIZE:
+      case EGL_DEPTH_SIZE:
+      case EGL_STENCIL_SIZE:
+      case EGL_SAMPLES:
+      case EGL_SAMPLE_BUFFERS:
+        matches = matches && requested <= value;
+        break;
+      case EGL_CONFIG_ID:
+        matches = matches && requested == value;
+        break;
+      default:
+        break;
+    }
+  }
+
+  *num_config = matches ? 1 : 0;
+  if (configs != NULL)
+  {
+    *num_config = matches && config_size > 0 ? 1 : 0;
+    if (*num_config)
+    {
+      configs[0] = (EGLConfig)&config;
+    }
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean eglGetConfigAttrib(EGLDisplay dpy, EGLConfig cfg, EGLint attribute, EGLint* value)
+{
+  COUNT(eglGetConfigAttrib);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  if (cfg != (EGLConfig)&config)
+  {
+    return fail(EGL_BAD_CONFIG);
+  }
+  if (!configAttribute(attribute, value))
+  {
+    return fail(EGL_BAD_ATTRIBUTE);
+  }
+  return EGL_TRUE;
+}
+
+/* There is no window system on the host, only pbuffers can be rendered to. */
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig cfg, EGLNativeWindowType win, const EGLint* attrib_list)
+{
+  COUNT(eglCreateWindowSurface);
+  if (validDisplay(dpy))
+  {
+    error = cfg == (EGLConfig)&config ? EGL_BAD_MATCH : EGL_BAD_CONFIG;
+  }
+  return EGL_NO_SURFACE;
+}
+
+EGLSurface eglCreatePbufferSurface(EGLDisplay dpy, EGLConfig cfg, const EGLint* attrib_list)
+{
+  COUNT(eglCreatePbufferSurface);
+  if (!validDisplay(dpy))
+  {
+    return EGL_NO_SURFACE;
+  }
+  if (cfg != (EGLConfig)&config)
+  {
+    error = EGL_BAD_CONFIG;
+    return EGL_NO_SURFACE;
+  }
+
+  EGLint width = 0;
+  EGLint height = 0;
+  for (int i = 0; attrib_list != NULL && attrib_list[i] != EGL_NONE; i += 2)
+  {
+    switch (attrib_list[i])
+    {
+      case EGL_WIDTH:           width = attrib_list[i + 1]; break;
+      case EGL_HEIGHT:          height = attrib_list[i + 1]; break;
+      case EGL_LARGEST_PBUFFER:
+      case EGL_TEXTURE_FORMAT:
+      case EGL_TEXTURE_TARGET:
+      case EGL_MIPMAP_TEXTURE:  break;
+      default:
+        error = EGL_BAD_ATTRIBUTE;
+        return EGL_NO_SURFACE;
+    }
+  }
+  if (width < 0 || height < 0 || width > HOSTEGL_MAX_PBUFFER_SIZE || height > HOSTEGL_MAX_PBUFFER_SIZE)
+  {
+    error = EGL_BAD_PARAMETER;
+    return EGL_NO_SURFACE;
+  }
+
+  SurfaceObject* surface = NULL;
+  for (int i = 0; i < HOSTEGL_MAX_SURFACES && surface == NULL; i++)
+  {
+    surface = surfaces[i].used ? NULL : &surfaces[i];
+  }
+  if (surface == NULL)
+  {
+    error = EGL_BAD_ALLOC;
+    return EGL_NO_SURFACE;
+  }
+
+  if (!hosteglCreateSurface(surfaceIndex(surface), width, height))
+  {
+    error = EGL_BAD_ALLOC;
+    return EGL_NO_SURFACE;
+  }
+  surface->width  = width;
+  surface->height = height;
+  surface->swaps  = 0;
+  surface->used = true;
+  return (EGLSurface)surface;
+}
+
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface)
+{
+  COUNT(eglDestroySurface);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  SurfaceObject* object = surfaceObject(surface);
+  if (object == NULL)
+  {
+    return fail(EGL_BAD_SURFACE);
+  }
+  if (object == drawSurface || object == readSurface)
+  {
+    /* Still current; a real implementation defers this, keep it simple and refuse. */
+    return fail(EGL_BAD_ACCESS);
+  }
+  hosteglDestroySurface(surfaceIndex(object));
+  object->used = false;
+  return EGL_TRUE;
+}
+
+EGLBoolean eglQuerySurface(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint* value)
+{
+  COUNT(eglQuerySurface);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  SurfaceObject* object = surfaceObject(surface);
+  if (object == NULL)
+  {
+    return fail(EGL_BAD_SURFACE);
+  }
+  switch (attribute)
+  {
+    case EGL_WIDTH:           *value = object->width; break;
+    case EGL_HEIGHT:          *value = object->height; break;
+    case EGL_CONFIG_ID:       *value = config.id; break;
+    case EGL_RENDER_BUFFER:   *value = EGL_BACK_BUFFER; break;
+    case EGL_SWAP_BEHAVIOR:   *value = EGL_BUFFER_PRESERVED; break;
+    case EGL_BUFFER_AGE_EXT:
+      if (!hasExtension("EGL_EXT_buffer_age"))
+      {
+        return fail(EGL_BAD_ATTRIBUTE);
+      }
+      /* There is a single buffer, which holds the previous frame once there has been one. */
+      *value = object->swaps ? 1 : 0;
+      break;
+    default:
+      return fail(EGL_BAD_ATTRIBUTE);
+  }
+  return EGL_TRUE;
+}
+
+EGLBoolean eglBindAPI(EGLenum api)
+{
+  COUNT(eglBindAPI);
+  return api == EGL_OPENGL_ES_API ? EGL_TRUE : fail(EGL_BAD_PARAMETER);
+}
+
+EGLenum eglQueryAPI(void)
+{
+  COUNT(eglQueryAPI);
+  return EGL_OPENGL_ES_API;
+}
+
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig cfg, EGLContext share_context, const EGLint* attrib_list)
+{
+  COUNT(eglCreateContext);
+  if (!validDisplay(dpy))
+  {
+    return EGL_NO_CONTEXT;
+  }
+  if (cfg != (EGLConfig)&config)
+  {
+    error = EGL_BAD_CONFIG;
+    return EGL_NO_CONTEXT;
+  }
+  for (int i = 0; attrib_list != NULL && attrib_list[i] != EGL_NONE; i += 2)
+  {
+    if (attrib_list[i] != EGL_CONTEXT_CLIENT_VERSION || attrib_list[i + 1] != 2)
+    {
+      error = EGL_BAD_ATTRIBUTE;
+      return EGL_NO_CONTEXT;
+    }
+  }
+  if (context.created || share_context != EGL_NO_CONTEXT)
+  {
+    /* A single context, so nothing to share with either. */
+    error = EGL_BAD_ALLOC;
+    return EGL_NO_CONTEXT;
+  }
+  if (!hosteglCreateContext())
+  {
+    error = EGL_BAD_ALLOC;
+    return EGL_NO_CONTEXT;
+  }
+  context.created = true;
+  return (EGLContext)&context;
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx)
+{
+  COUNT(eglDestroyContext);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  if (ctx != (EGLContext)&context || !context.created)
+  {
+    return fail(EGL_BAD_CONTEXT);
+  }
+  if (contextCurrent)
+  {
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+  hosteglDestroyContext();
+  context.created = false;
+  return EGL_TRUE;
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+  COUNT(eglMakeCurrent);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  if (ctx == EGL_NO_CONTEXT)
+  {
+    if (draw != EGL_NO_SURFACE || read != EGL_NO_SURFACE)
+    {
+      return fail(EGL_BAD_MATCH);
+    }
+    hosteglMakeCurrent(-1, 0, 0);
+    drawSurface = readSurface = NULL;
+    contextCurrent = false;
+    return EGL_TRUE;
+  }
+  if (ctx != (EGLContext)&context || !context.created)
+  {
+    return fail(EGL_BAD_CONTEXT);
+  }
+
+  SurfaceObject* drawObject = surfaceObject(draw);
+  SurfaceObject* readObject = surfaceObject(read);
+  if (drawObject == NULL || readObject == NULL)
+  {
+    return fail(EGL_BAD_SURFACE);
+  }
+  if (drawObject != readObject)
+  {
+    /* GL reads from the surface it draws to. */
+    return fail(EGL_BAD_MATCH);
+  }
+  drawSurface = drawObject;
+  readSurface = readObject;
+  contextCurrent = true;
+  hosteglMakeCurrent(surfaceIndex(drawObject), drawObject->width, drawObject->height);
+  return EGL_TRUE;
+}
+
+EGLContext eglGetCurrentContext(void)
+{
+  COUNT(eglGetCurrentContext);
+  return contextCurrent ? (EGLContext)&context : EGL_NO_CONTEXT;
+}
+
+EGLSurface eglGetCurrentSurface(EGLint readdraw)
+{
+  COUNT(eglGetCurrentSurface);
+  SurfaceObject* surface = readdraw == EGL_READ ? readSurface : drawSurface;
+  return surface ? (EGLSurface)surface : EGL_NO_SURFACE;
+}
+
+EGLDisplay eglGetCurrentDisplay(void)
+{
+  COUNT(eglGetCurrentDisplay);
+  return contextCurrent ? (EGLDisplay)&display : EGL_NO_DISPLAY;
+}
+
+EGLBoolean eglSwapInterval(EGLDisplay dpy, EGLint interval)
+{
+  COUNT(eglSwapInterval);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  /* Nothing is presented, so there is nothing to wait for either. */
+  return EGL_TRUE;
+}
+
+/* Rendering is synchronous and the surface is never shown, so what a swap does beyond counting
+ * it is up to the backend. */
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+  COUNT(eglSwapBuffers);
+  if (!validDisplay(dpy))
+  {
+    return EGL_FALSE;
+  }
+  SurfaceObject* object = surfaceObject(surface);
+  if (object == NULL)
+  {
+    return fail(EGL_BAD_SURFACE);
+  }
+  if (object != drawSurface)
+  {
+    return fail(EGL_BAD_SURFACE);
+  }
+
+  object->swaps++;
+  hosteglSwapBuffers(surfaceIndex(object), object->swaps);
+  return EGL_TRUE;
+}
+
+/* The whole surface is kept anyway, so the damage changes nothing. */
+EGLBoolean eglSwapBuffersWithDamageKHR(EGLDisplay dpy, EGLSurface surface, const EGLint* rects, EGLint n_rects)
+{
+  if (n_rects < 0 || (n_rects > 0 && rects == NULL))
+  {
+    return fail(EGL_BAD_PARAMETER);
+  }
+  return eglSwapBuffers(dpy, surface);
+}
+
+EGLBoolean eglWaitGL(void)
+{
+  COUNT(eglWaitGL);
+  return EGL_TRUE;
+}
+
+EGLBoolean eglWaitClient(void)
+{
+  COUNT(eglWaitClient);
+  return EGL_TRUE;
+}
+
+EGLBoolean eglWaitNative(EGLint engine)
+{
+  COUNT(eglWaitNative);
+  return EGL_TRUE;
+}
+
+EGLBoolean eglReleaseThread(void)
+{
+  COUNT(eglReleaseThread);
+  if (display.initialized && contextCurrent)
+  {
+    eglMakeCurrent((EGLDisplay)&display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  }
+  return EGL_TRUE;
+}
+
+/* Every entry point is exported directly, only the extension functions are looked up here. */
+__eglMustCastToProperFunctionPointerType eglGetProcAddress(const char* procname)
+{
+  COUNT(eglGetProcAddress);
+  if (strcmp(procname, "eglSwapBuffersWithDamageKHR") == 0 && hasExtension("EGL_KHR_swap_buffers_with_damage"))
+  {
+    return (__eglMustCastToProperFunctionPointerType)eglSwapBuffersWithDamageKHR;
+  }
+  return NULL;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef HOSTEGL_H
+#define HOSTEGL_H
+
+#include <EGL/egl.h>
+
+/**
+ * \file HostEGL.h
+ * \brief The EGL entry points shared by the host backends (gl2-cube-soft and gl2-cube-null).
+ *
+ * HostEGL.cpp implements one display, one config, one context and pbuffer surfaces, with the
+ * argument checks and errors of a real implementation. What differs between backends is left
+ * to the hooks below, which each backend's EGL file defines: the storage behind a surface,
+ * making it the default framebuffer, what a swap does, and the statistics reported.
+ * EGL_EXT_buffer_age and EGL_KHR_swap_buffers_with_damage are supported when the backend
+ * lists them in hosteglExtensions.
+ */
+
+#define HOSTEGL_MAX_SURFACES      8
+#define HOSTEGL_MAX_PBUFFER_SIZE  4096
+
+/**
+ * \brief Every EGL entry point, for backends that count calls.
+ */
+#define HOSTEGL_CALLS(X) \
+    X(eglGetError) X(eglGetDisplay) X(eglInitialize) X(eglTerminate) X(eglQueryString) \
+    X(eglGetConfigs) X(eglChooseConfig) X(eglGetConfigAttrib) X(eglCreateWindowSurface) \
+    X(eglCreatePbufferSurface) X(eglDestroySurface) X(eglQuerySurface) X(eglBindAPI) \
+    X(eglQueryAPI) X(eglCreateContext) X(eglDestroyContext) X(eglMakeCurrent) \
+    X(eglGetCurrentContext) X(eglGetCurrentSurface) X(eglGetCurrentDisplay) X(eglSwapInterval) \
+    X(eglSwapBuffers) X(eglWaitGL) X(eglWaitClient) X(eglWaitNative) X(eglReleaseThread) \
+    X(eglGetProcAddress)
+
+    /**
+     * \brief Index of each EGL entry point.
+     */
+    enum HostEGLCall
+    {
+#define HOSTEGL_CALL_ENUM(name) HOSTEGL_CALL_##name,
+        HOSTEGL_CALLS(HOSTEGL_CALL_ENUM)
+#undef HOSTEGL_CALL_ENUM
+        HOSTEGL_CALL_COUNT
+    };
+
+    /**
+     * \brief EGL_VERSION string of the backend.
+     */
+    extern const char hosteglVersion[];
+
+    /**
+     * \brief EGL_EXTENSIONS string of the backend.
+     */
+    extern const char hosteglExtensions[];
+
+    /**
+     * \brief EGL_CONFIG_CAVEAT of the config.
+     */
+    extern const EGLint hosteglConfigCaveat;
+
+    /**
+     * \brief Called on entry to every EGL entry point.
+     */
+    void hosteglCount(HostEGLCall call);
+
+    /**
+     * \brief Read the backend's settings from the environment, on the first eglInitialize.
+     */
+    void hosteglInitialize(void);
+
+    /**
+     * \brief Report what is left to report, before eglTerminate releases everything.
+     */
+    void hosteglTerminate(void);
+
+    /**
+     * \brief Create the GL context state.
+     */
+    bool hosteglCreateContext(void);
+
+    /**
+     * \brief Free all GL objects.
+     */
+    void hosteglDestroyContext(void);
+
+    /**
+     * \brief Allocate the storage of a new surface.
+     * \param[in] surface Index of the surface, below HOSTEGL_MAX_SURFACES.
+     * \return False if it could not be allocated.
+     */
+    bool hosteglCreateSurface(int surface, EGLint width, EGLint height);
+
+    /**
+     * \brief Free the storage of a surface.
+     */
+    void hosteglDestroySurface(int surface);
+
+    /**
+     * \brief Make a surface the default framebuffer.
+     * \param[in] surface Index of the surface, -1 to release it.
+     */
+    void hosteglMakeCurrent(int surface, EGLint width, EGLint height);
+
+    /**
+     * \brief Present the current surface.
+     * \param[in] swaps Swaps of the surface so far, including this one.
+     */
+    void hosteglSwapBuffers(int surface, unsigned int swaps);
+
+#endif /* HOSTEGL_H */
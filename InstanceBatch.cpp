@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InstanceBatch.h"
+#include "TraceEvents.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+    InstanceBatch::InstanceBatch(void)
+        : objects(NULL), objectCount(0), instances(1), vertices(NULL), indices(NULL)
+    {
+        memset(&streams, 0, sizeof(streams));
+        memset(&mesh, 0, sizeof(mesh));
+        resetStats();
+    }
+
+    InstanceBatch::~InstanceBatch()
+    {
+        free(vertices);
+        free(indices);
+    }
+
+    bool InstanceBatch::setup(const GLfloat* positions, const GLfloat* colors, int vertexCount,
+                              const GLubyte* strip, int stripLength,
+                              const BatchObject* objects, int objectCount, int instances)
+    {
+        /* Instance indices are bytes, vertex indices 16 bits. */
+        if (instances < 1 || instances > 256 || instances * vertexCount > 65536 || objectCount <= 0)
+        {
+            fprintf(stderr, "Cannot draw %d copies of %d vertices at a time.\n", instances, vertexCount);
+            return false;
+        }
+        this->objects     = objects;
+        this->objectCount = objectCount;
+        this->instances   = instances;
+
+        GLubyte* triangles = (GLubyte*)malloc(stripLength * 3);
+        int triangleIndices = triangles != NULL ? stripToTriangles(strip, stripLength, triangles) : 0;
+        vertices = (InstanceVertex*)malloc(instances * vertexCount * sizeof(InstanceVertex));
+        indices  = (GLushort*)malloc(instances * triangleIndices * sizeof(GLushort));
+        if (triangles == NULL || vertices == NULL || indices == NULL)
+        {
+            fprintf(stderr, "Could not allocate %d copies of a mesh.\n", instances);
+            free(triangles);
+            return false;
+        }
+
+        for (int instance = 0; instance < instances; instance++)
+        {
+            for (int i = 0; i < vertexCount; i++)
+            {
+                InstanceVertex& vertex = vertices[instance * vertexCount + i];
+                memcpy(vertex.position, &positions[i * 3], sizeof(vertex.position));
+                for (int component = 0; component < 4; component++)
+                {
+                    vertex.color[component] = VERTEX_UNORM8(colors[i * 4 + component]);
+                }
+                vertex.instance = (GLubyte)instance;
+                memset(vertex.padding, 0, sizeof(vertex.padding));
+            }
+            for (int i = 0; i < triangleIndices; i++)
+            {
+                indices[instance * triangleIndices + i] = (GLushort)(instance * vertexCount + triangles[i]);
+            }
+        }
+        free(triangles);
+
+        streams.position.size       = 3;
+        streams.position.type       = GL_FLOAT;
+        streams.position.normalized = GL_FALSE;
+        streams.position.stride     = sizeof(InstanceVertex);
+        streams.position.pointer    = vertices[0].position;
+        streams.color.size          = 4;
+        streams.color.type          = GL_UNSIGNED_BYTE;
+        streams.color.normalized    = GL_TRUE;
+        streams.color.stride        = sizeof(InstanceVertex);
+        streams.color.pointer       = vertices[0].color;
+        streams.instance.size       = 1;
+        streams.instance.type       = GL_UNSIGNED_BYTE;
+        streams.instance.normalized = GL_FALSE;
+        streams.instance.stride     = sizeof(InstanceVertex);
+        streams.instance.pointer    = &vertices[0].instance;
+        streams.positionScale       = 1.0f;
+        streams.bytesPerVertex      = sizeof(InstanceVertex);
+        streams.name                = "instanced float";
+
+        mesh.streams   = &streams;
+        mesh.mode      = GL_TRIANGLES;
+        mesh.count     = instances * triangleIndices;
+        mesh.triangles = instances * triangleIndices / 3;
+        mesh.indexType = GL_UNSIGNED_SHORT;
+        mesh.indices   = indices;
+
+        fprintf(stderr, "Instancing: %d objects, %d per draw in %d draws, %d bytes of vertices\n",
+                objectCount, instances, getDrawCount(), (int)(instances * vertexCount * sizeof(InstanceVertex)));
+        return true;
+    }
+
+    void InstanceBatch::record(CommandBuffer* commands, const RenderTarget* target, ShaderVariant* variant,
+                               Matrix& projection, unsigned int projectionGeneration, const float angles[3])
+    {
+        TRACE_EVENT("instanceTransforms");
+        nsecs_t begin = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (int first = 0; first < objectCount; first += instances)
+        {
+            int count = objectCount - first < instances ? objectCount - first : instances;
+            /* The model matrices are in the rows, so the view is all the matrices hold. */
+            GLfloat* rows = commands->drawInstances(target, variant, &mesh, count, projection,
+                                                    Matrix::identityMatrix, projection, projectionGeneration);
+            if (rows == NULL)
+            {
+                break;
+            }
+            for (int object = 0; object < count; object++, rows += 12)
+            {
+                GLfloat model[16];
+                batchObjectModel(objects[first + object], angles, model);
+                for (int row = 0; row < 3; row++)
+                {
+                    rows[row * 4 + 0] = model[row];
+                    rows[row * 4 + 1] = model[4 + row];
+                    rows[row * 4 + 2] = model[8 + row];
+                    rows[row * 4 + 3] = model[12 + row];
+                }
+            }
+            totalDraws++;
+        }
+        frames++;
+        totalTime += systemTime(SYSTEM_TIME_MONOTONIC) - begin;
+    }
+
+    void InstanceBatch::printStats(const char* label) const
+    {
+        if (frames == 0)
+        {
+            return;
+        }
+        fprintf(stderr, "Instancing (%s): %d objects in %.1f draws/frame of up to %d, "
+                "transforms written in %.3f ms/frame\n",
+                label, objectCount, (double)totalDraws / frames, instances, totalTime / 1e6 / frames);
+    }
+
+    void InstanceBatch::resetStats(void)
+    {
+        frames     = 0;
+        totalTime  = 0;
+        totalDraws = 0;
+    }
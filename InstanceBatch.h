@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include <GLES2/gl2.h>
+#include <utils/Timers.h>
+
+#include "CommandBuffer.h"
+#include "Matrix.h"
+#include "ShaderVariants.h"
+#include "VertexBatch.h"
+#include "VertexFormats.h"
+
+/**
+ * \file InstanceBatch.h
+ * \brief Many copies of a mesh drawn with their transforms in a uniform array.
+ */
+
+    /**
+     * \brief A vertex of the replicated mesh: the mesh's own, and which copy it belongs to.
+     */
+    struct InstanceVertex
+    {
+        GLfloat     position[3];
+        GLubyte     color[4];
+        GLubyte     instance;
+        GLubyte     padding[3];
+    };
+
+    /**
+     * \brief Draws a mesh many times over with a SHADER_INSTANCED variant, without instancing
+     * support in GL.
+     *
+     * The mesh is stored once per copy a draw can hold, each copy's vertices carrying its
+     * index. Every frame the objects' model matrices are written as 4x3 transforms straight
+     * into the command buffer, as many per draw as the variant has room for, so one
+     * glDrawElements and one glUniform4fv draw that many objects and the vertices never
+     * change after setup.
+     */
+    class InstanceBatch
+    {
+    public:
+        InstanceBatch(void);
+        ~InstanceBatch();
+
+        /**
+         * \brief Build the replicated mesh.
+         * \param[in] positions x, y, z of each vertex of the mesh.
+         * \param[in] colors r, g, b, a of each vertex of the mesh, in [0, 1].
+         * \param[in] strip Triangle strip indices of the mesh, with degenerate triangles
+         *                  between its strips.
+         * \param[in] objects The copies to draw; the array must stay valid.
+         * \param[in] instances Copies per draw, ShaderVariant::instances of the variant used.
+         * \return false if memory could not be had.
+         */
+        bool setup(const GLfloat* positions, const GLfloat* colors, int vertexCount,
+                   const GLubyte* strip, int stripLength,
+                   const BatchObject* objects, int objectCount, int instances);
+
+        /**
+         * \brief Record this frame's draws.
+         * \param[in] angles Rotation about x, y and z in degrees, before each object's phase.
+         */
+        void record(CommandBuffer* commands, const RenderTarget* target, ShaderVariant* variant,
+                    Matrix& projection, unsigned int projectionGeneration, const float angles[3]);
+
+        /**
+         * \brief Number of draws the batch takes.
+         */
+        int getDrawCount(void) const { return (objectCount + instances - 1) / instances; }
+
+        /**
+         * \brief Print the draws per frame and the time spent writing transforms to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        const BatchObject*  objects;
+        int                 objectCount;
+        int                 instances;
+
+        InstanceVertex*     vertices;
+        GLushort*           indices;
+        VertexStreams       streams;
+        DrawMesh            mesh;
+
+        unsigned int        frames;
+        nsecs_t             totalTime;
+        unsigned int        totalDraws;
+    };
+
+#endif /* INSTANCEBATCH_H */
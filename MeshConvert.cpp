@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * gl2-cube-meshconv: writes the cube of Cube.h as a mesh file for gl2-cube -M, see
+ * MeshFile.h. The packed vertices are written interleaved as they are, or with -f the float
+ * tables one after the other. With -o the triangles and vertices are first reordered for the
+ * vertex caches, see MeshOptimizer.h. The file is then loaded back and compared with what
+ * was written, and with -o checked to still draw the cube's triangles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Cube.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+#define CUBE_VERTEX_COUNT   (sizeof(cubeVertices) / (3 * sizeof(float)))
+#define CUBE_INDEX_COUNT    (sizeof(cubeIndices) / sizeof(GLubyte))
+
+static void setStream(MeshFileStream* stream, uint32_t offset, uint16_t stride, uint8_t size,
+                      uint32_t type, GLboolean normalized)
+{
+  stream->offset     = offset;
+  stream->stride     = stride;
+  stream->size       = size;
+  stream->normalized = normalized;
+  stream->type       = type;
+}
+
+/* Vertex tables one after the other, each starting on a MESH_FILE_ALIGNMENT boundary.
+ * Returns the data, which the caller frees. */
+static GLubyte* layoutTables(const void* const* tables, const int* elementBytes, int tableCount,
+                             int vertexCount, uint32_t* offsets, uint32_t* totalBytes)
+{
+  uint32_t total = 0;
+  for (int i = 0; i < tableCount; i++)
+  {
+    offsets[i] = total;
+    total = (total + vertexCount * elementBytes[i] + MESH_FILE_ALIGNMENT - 1) & ~(uint32_t)(MESH_FILE_ALIGNMENT - 1);
+  }
+  GLubyte* data = (GLubyte*)calloc(1, total);
+  if (data == NULL)
+  {
+    return NULL;
+  }
+  for (int i = 0; i < tableCount; i++)
+  {
+    memcpy(data + offsets[i], tables[i], vertexCount * elementBytes[i]);
+  }
+  *totalBytes = total;
+  return data;
+}
+
+/* The triangles a list or strip draws, through remap if not NULL, each rotated to start at
+ * its lowest index and sorted, so that meshes drawing the same triangles compare equal. */
+static int compareTriangles(const void* a, const void* b)
+{
+  return memcmp(a, b, 3 * sizeof(GLushort));
+}
+
+static int canonicalTriangles(GLenum mode, const GLushort* indices, int indexCount, const GLushort* remap,
+                              GLushort* triangles)
+{
+  int count = 0;
+  int step  = mode == GL_TRIANGLE_STRIP ? 1 : 3;
+  for (int i = 0; i + 2 < indexCount; i += step)
+  {
+    int odd = mode == GL_TRIANGLE_STRIP ? (i & 1) : 0;
+    GLushort triangle[3] = { indices[i + odd], indices[i + 1 - odd], indices[i + 2] };
+    if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+    {
+      continue;
+    }
+    int first = 0;
+    for (int corner = 0; corner < 3; corner++)
+    {
+      if (remap != NULL)
+      {
+        triangle[corner] = remap[triangle[corner]];
+      }
+    }
+    for (int corner = 1; corner < 3; corner++)
+    {
+      first = triangle[corner] < triangle[first] ? corner : first;
+    }
+    for (int corner = 0; corner < 3; corner++)
+    {
+      triangles[count * 3 + corner] = triangle[(first + corner) % 3];
+    }
+    count++;
+  }
+  qsort(triangles, count, 3 * sizeof(GLushort), compareTriangles);
+  return count;
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [-f] [-o] <file>\n", name);
+  fprintf(stderr, "  -f   write the float tables instead of the packed vertices\n");
+  fprintf(stderr, "  -o   reorder triangles and vertices for the vertex caches, and pick strip or list\n");
+}
+
+int main(int argc, char** argv)
+{
+  const char* path = NULL;
+  bool floatStreams = false;
+  bool optimize = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-f") == 0)
+    {
+      floatStreams = true;
+    }
+    else if (strcmp(argv[i], "-o") == 0)
+    {
+      optimize = true;
+    }
+    else if (argv[i][0] != '-' && path == NULL)
+    {
+      path = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (path == NULL)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  /* The packed vertices are one table, the float ones three. */
+  const void* tables[3]       = { cubePackedVertices, NULL, NULL };
+  int         elementBytes[3] = { sizeof(PackedVertex), 0, 0 };
+  int         tableCount      = 1;
+  if (floatStreams)
+  {
+    tables[0] = cubeVertices;
+    tables[1] = cubeColors;
+    tables[2] = cubeTextureCoordinates;
+    elementBytes[0] = 3 * sizeof(float);
+    elementBytes[1] = 4 * sizeof(float);
+    elementBytes[2] = 2 * sizeof(float);
+    tableCount = 3;
+  }
+
+  GLushort cubeStrip[CUBE_INDEX_COUNT];
+  for (unsigned int i = 0; i < CUBE_INDEX_COUNT; i++)
+  {
+    cubeStrip[i] = cubeIndices[i];
+  }
+  GLenum          mode        = GL_TRIANGLE_STRIP;
+  const GLushort* indices     = cubeStrip;
+  int             indexCount  = CUBE_INDEX_COUNT;
+  int             vertexCount = CUBE_VERTEX_COUNT;
+
+  MeshOptimizer optimizer;
+  void* reordered[3] = { NULL, NULL, NULL };
+  if (optimize)
+  {
+    if (!optimizer.optimize(mode, indices, indexCount, vertexCount))
+    {
+      return 1;
+    }
+    optimizer.printStats("cube");
+    mode        = optimizer.getMode();
+    indices     = optimizer.getIndices();
+    indexCount  = optimizer.getIndexCount();
+    vertexCount = optimizer.getVertexCount();
+    for (int i = 0; i < tableCount; i++)
+    {
+      reordered[i] = malloc(vertexCount * elementBytes[i]);
+      if (reordered[i] == NULL)
+      {
+        fprintf(stderr, "Could not allocate the vertices.\n");
+        return 1;
+      }
+      optimizer.remapVertices(tables[i], elementBytes[i], reordered[i]);
+      tables[i] = reordered[i];
+    }
+  }
+
+  MeshFileHeader layout;
+  memset(&layout, 0, sizeof(layout));
+  layout.vertexCount = vertexCount;
+  layout.indexCount  = indexCount;
+  layout.indexType   = vertexCount <= 256 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
+  layout.mode        = mode;
+  for (int axis = 0; axis < 3; axis++)
+  {
+    layout.boundsMin[axis] = cubeVertices[axis];
+    layout.boundsMax[axis] = cubeVertices[axis];
+  }
+  for (unsigned int i = 1; i < CUBE_VERTEX_COUNT; i++)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      float value = cubeVertices[i * 3 + axis];
+      layout.boundsMin[axis] = value < layout.boundsMin[axis] ? value : layout.boundsMin[axis];
+      layout.boundsMax[axis] = value > layout.boundsMax[axis] ? value : layout.boundsMax[axis];
+    }
+  }
+
+  uint32_t offsets[3];
+  GLubyte* vertices = layoutTables(tables, elementBytes, tableCount, vertexCount, offsets, &layout.vertexBytes);
+  void* indexData = malloc(indexCount * sizeof(GLushort));
+  if (vertices == NULL || indexData == NULL)
+  {
+    fprintf(stderr, "Could not allocate the vertices.\n");
+    return 1;
+  }
+  if (floatStreams)
+  {
+    setStream(&layout.streams[0], offsets[0], elementBytes[0], 3, GL_FLOAT, GL_FALSE);
+    setStream(&layout.streams[1], offsets[1], elementBytes[1], 4, GL_FLOAT, GL_FALSE);
+    setStream(&layout.streams[2], offsets[2], elementBytes[2], 2, GL_FLOAT, GL_FALSE);
+    layout.positionScale = 1.0f;
+  }
+  else
+  {
+    setStream(&layout.streams[0], offsetof(PackedVertex, position), sizeof(PackedVertex), 3,
+              GL_SHORT, GL_TRUE);
+    setStream(&layout.streams[1], offsetof(PackedVertex, color), sizeof(PackedVertex), 4,
+              GL_UNSIGNED_BYTE, GL_TRUE);
+    setStream(&layout.streams[2], offsetof(PackedVertex, texCoord), sizeof(PackedVertex), 2,
+              VERTEX_UV_TYPE, VERTEX_UV_NORMALIZED);
+    layout.positionScale = CUBE_POSITION_SCALE;
+  }
+  for (int i = 0; i < indexCount; i++)
+  {
+    if (layout.indexType == GL_UNSIGNED_BYTE)
+    {
+      ((GLubyte*)indexData)[i] = (GLubyte)indices[i];
+    }
+    else
+    {
+      ((GLushort*)indexData)[i] = indices[i];
+    }
+  }
+
+  bool written = MeshFile::write(path, layout, vertices, indexData);
+
+  /* What gl2-cube -M would draw must be exactly what was written. */
+  MeshFile mesh;
+  bool verified = written && mesh.load(path);
+  if (verified)
+  {
+    const MeshFileHeader& header = mesh.getHeader();
+    verified = header.vertexBytes == layout.vertexBytes &&
+               memcmp(mesh.getVertices(), vertices, layout.vertexBytes) == 0 &&
+               memcmp(mesh.getIndices(), indexData, header.indexBytes) == 0 &&
+               memcmp(header.streams, layout.streams, sizeof(layout.streams)) == 0 &&
+               mesh.getMesh()->count == indexCount;
+    if (!verified)
+    {
+      fprintf(stderr, "Mesh %s does not match what was written.\n", path);
+    }
+  }
+  /* And reordering must not have lost, added or turned around a triangle. */
+  if (verified && optimize)
+  {
+    GLushort cubeTriangles[3 * CUBE_INDEX_COUNT];
+    GLushort optimizedTriangles[3 * CUBE_INDEX_COUNT];
+    int count = canonicalTriangles(GL_TRIANGLE_STRIP, cubeStrip, CUBE_INDEX_COUNT, optimizer.getRemap(),
+                                   cubeTriangles);
+    verified = canonicalTriangles(mode, indices, indexCount, NULL, optimizedTriangles) == count &&
+               memcmp(cubeTriangles, optimizedTriangles, count * 3 * sizeof(GLushort)) == 0;
+    if (!verified)
+    {
+      fprintf(stderr, "Mesh %s does not draw the cube's triangles.\n", path);
+    }
+  }
+  free(vertices);
+  free(indexData);
+  for (int i = 0; i < 3; i++)
+  {
+    free(reordered[i]);
+  }
+  if (!verified)
+  {
+    return 1;
+  }
+
+  fprintf(stderr, "Wrote %s: %s vertices, %s, %u bytes\n", path, floatStreams ? "float" : "packed",
+          mode == GL_TRIANGLE_STRIP ? "strip" : "list", mesh.getHeader().fileSize);
+  return 0;
+}
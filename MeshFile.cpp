@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshFile.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+    /* Bytes of one component of an attribute, 0 if the type cannot be an attribute. */
+    static uint32_t componentBytes(uint32_t type)
+    {
+        switch (type)
+        {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT_OES:
+            return 2;
+        case GL_FIXED:
+        case GL_FLOAT:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    static uint32_t alignOffset(uint32_t offset)
+    {
+        return (offset + MESH_FILE_ALIGNMENT - 1) & ~(uint32_t)(MESH_FILE_ALIGNMENT - 1);
+    }
+
+    /* Whether [offset, offset + size) lies within a block of blockSize bytes. */
+    static bool inside(uint64_t offset, uint64_t size, uint64_t blockSize)
+    {
+        return offset <= blockSize && size <= blockSize - offset;
+    }
+
+    static bool writeBlock(FILE* file, const void* data, size_t size)
+    {
+        return size == 0 || fwrite(data, size, 1, file) == 1;
+    }
+
+    MeshFile::MeshFile(void)
+        : path(NULL), mapping(NULL), mappingSize(0), triangleCount(0)
+    {
+        memset(&header, 0, sizeof(header));
+        memset(&streams, 0, sizeof(streams));
+        memset(&mesh, 0, sizeof(mesh));
+    }
+
+    MeshFile::~MeshFile()
+    {
+        unmap();
+    }
+
+    bool MeshFile::load(const char* path)
+    {
+        unmap();
+        this->path = path;
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Could not open mesh %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(MeshFileHeader))
+        {
+            fprintf(stderr, "Mesh %s is too short for a header.\n", path);
+            close(fd);
+            return false;
+        }
+        void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+        {
+            fprintf(stderr, "Could not map mesh %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        mapping     = (GLubyte*)data;
+        mappingSize = info.st_size;
+
+        memcpy(&header, mapping, sizeof(header));
+        if (!check())
+        {
+            unmap();
+            return false;
+        }
+        setStreams(mapping + header.vertexOffset, mapping + header.indexOffset);
+
+        fprintf(stderr, "Mesh %s: %u vertices in %u bytes, %u indices, mapped\n",
+                path, header.vertexCount, header.vertexBytes, header.indexCount);
+        return true;
+    }
+
+    /* Everything drawing the mesh reads must lie within the file, since the file is handed
+     * to GL as it is. */
+    bool MeshFile::check(void)
+    {
+        const char* problem = NULL;
+        uint32_t indexSize = header.indexType == GL_UNSIGNED_BYTE ? 1 : (header.indexType == GL_UNSIGNED_SHORT ? 2 : 0);
+
+        if (header.magic != MESH_FILE_MAGIC)
+        {
+            problem = "is not a mesh file";
+        }
+        else if (header.version != MESH_FILE_VERSION || header.headerSize != sizeof(MeshFileHeader))
+        {
+            problem = "is a version this build cannot read";
+        }
+        else if (header.fileSize != mappingSize)
+        {
+            problem = "is truncated";
+        }
+        else if (header.vertexOffset % MESH_FILE_ALIGNMENT != 0 || header.indexOffset % MESH_FILE_ALIGNMENT != 0 ||
+                 header.vertexOffset < header.headerSize || header.indexOffset < header.headerSize ||
+                 !inside(header.vertexOffset, header.vertexBytes, mappingSize) ||
+                 !inside(header.indexOffset, header.indexBytes, mappingSize))
+        {
+            problem = "has its blocks out of place";
+        }
+        else if (indexSize == 0 || (uint64_t)header.indexCount * indexSize != header.indexBytes)
+        {
+            problem = "has bad indices";
+        }
+        else if (header.vertexCount == 0 || header.streams[0].size == 0 || header.positionScale <= 0.0f)
+        {
+            problem = "has no positions";
+        }
+
+        for (int i = 0; problem == NULL && i < 3; i++)
+        {
+            const MeshFileStream& stream = header.streams[i];
+            if (stream.size == 0)
+            {
+                continue;
+            }
+            uint32_t bytes  = componentBytes(stream.type);
+            uint32_t stride = stream.stride != 0 ? stream.stride : stream.size * bytes;
+            if (bytes == 0 || stream.size > 4 || stream.offset % bytes != 0 || stride % bytes != 0 ||
+                !inside(stream.offset, (uint64_t)(header.vertexCount - 1) * stride + stream.size * bytes,
+                        header.vertexBytes))
+            {
+                problem = "has a bad vertex stream";
+            }
+        }
+
+        /* The only pass over the data: an index past the vertices would read outside them.
+         * Triangles are counted on the way, degenerate ones left out. */
+        triangleCount = 0;
+        if (problem == NULL)
+        {
+            const GLubyte* indices = mapping + header.indexOffset;
+            uint32_t a = 0, b = 0;
+            for (uint32_t i = 0; i < header.indexCount; i++)
+            {
+                uint32_t index = indexSize == 1 ? indices[i] : ((const GLushort*)indices)[i];
+                if (index >= header.vertexCount)
+                {
+                    problem = "has an index past its vertices";
+                    break;
+                }
+                bool ends = header.mode == GL_TRIANGLE_STRIP ? i >= 2 : i % 3 == 2;
+                if (ends && a != b && b != index && a != index)
+                {
+                    triangleCount++;
+                }
+                a = b;
+                b = index;
+            }
+        }
+
+        if (problem != NULL)
+        {
+            fprintf(stderr, "Mesh %s %s.\n", path, problem);
+            return false;
+        }
+        return true;
+    }
+
+    const void* MeshFile::getVertices(void) const
+    {
+        return mapping != NULL ? mapping + header.vertexOffset : NULL;
+    }
+
+    const void* MeshFile::getIndices(void) const
+    {
+        return mapping != NULL ? mapping + header.indexOffset : NULL;
+    }
+
+    void MeshFile::setStreams(const GLubyte* vertices, const GLubyte* indices)
+    {
+        VertexAttribStream* attributeStreams[3] = { &streams.position, &streams.color, &streams.texCoord };
+
+        memset(&streams, 0, sizeof(streams));
+        for (int i = 0; i < 3; i++)
+        {
+            const MeshFileStream& stream = header.streams[i];
+            if (stream.size != 0)
+            {
+                attributeStreams[i]->size       = stream.size;
+                attributeStreams[i]->type       = stream.type;
+                attributeStreams[i]->normalized = stream.normalized ? GL_TRUE : GL_FALSE;
+                attributeStreams[i]->stride     = stream.stride;
+                attributeStreams[i]->pointer    = vertices + stream.offset;
+            }
+        }
+        streams.positionScale  = header.positionScale;
+        streams.bytesPerVertex = header.vertexBytes / header.vertexCount;
+        streams.name           = "mesh file";
+
+        mesh.streams   = &streams;
+        mesh.mode      = header.mode;
+        mesh.count     = header.indexCount;
+        mesh.triangles = triangleCount;
+        mesh.indexType = header.indexType;
+        mesh.indices   = indices;
+    }
+
+    void MeshFile::useBuffers(GLuint vertexBuffer, GLuint indexBuffer)
+    {
+        /* Offsets into the buffers from here on. */
+        setStreams(NULL, NULL);
+        streams.buffer   = vertexBuffer;
+        mesh.indexBuffer = indexBuffer;
+        unmap();
+    }
+
+    void MeshFile::unmap(void)
+    {
+        if (mapping != NULL)
+        {
+            munmap(mapping, mappingSize);
+            mapping     = NULL;
+            mappingSize = 0;
+        }
+    }
+
+    bool MeshFile::write(const char* path, const MeshFileHeader& layout, const void* vertices, const void* indices)
+    {
+        static const GLubyte padding[MESH_FILE_ALIGNMENT] = { 0 };
+
+        MeshFileHeader header = layout;
+        header.magic        = MESH_FILE_MAGIC;
+        header.version      = MESH_FILE_VERSION;
+        header.headerSize   = sizeof(MeshFileHeader);
+        header.vertexOffset = alignOffset(sizeof(MeshFileHeader));
+        header.indexBytes   = header.indexCount * (header.indexType == GL_UNSIGNED_SHORT ? 2 : 1);
+        header.indexOffset  = alignOffset(header.vertexOffset + header.vertexBytes);
+        header.fileSize     = header.indexOffset + header.indexBytes;
+
+        FILE* file = fopen(path, "wb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Could not create mesh %s: %s\n", path, strerror(errno));
+            return false;
+        }
+        bool written =
+            writeBlock(file, &header, sizeof(header)) &&
+            writeBlock(file, padding, header.vertexOffset - sizeof(header)) &&
+            writeBlock(file, vertices, header.vertexBytes) &&
+            writeBlock(file, padding, header.indexOffset - header.vertexOffset - header.vertexBytes) &&
+            writeBlock(file, indices, header.indexBytes);
+        if (fclose(file) != 0 || !written)
+        {
+            fprintf(stderr, "Could not write mesh %s.\n", path);
+            return false;
+        }
+        return true;
+    }
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GLES2/gl2.h>
+
+#include "CommandBuffer.h"
+#include "VertexFormats.h"
+
+/**
+ * \file MeshFile.h
+ * \brief A binary mesh format laid out to be drawn from where it is mapped.
+ *
+ * A file is a MeshFileHeader, the vertex data and the indices, each starting on a
+ * MESH_FILE_ALIGNMENT boundary. The vertex data holds the attribute streams exactly as
+ * glVertexAttribPointer takes them, interleaved or one after the other, so the blocks can be
+ * passed to glBufferData or used as client arrays straight from the mapping. Everything is
+ * little endian, like every target gl2-cube builds for. Files are written by
+ * gl2-cube-meshconv.
+ */
+
+#define MESH_FILE_MAGIC     0x48534D47u     /* "GMSH" */
+#define MESH_FILE_VERSION   1
+#define MESH_FILE_ALIGNMENT 16
+
+    /**
+     * \brief Where one attribute is in the vertex data. size is 0 if the mesh does not have it.
+     */
+    struct MeshFileStream
+    {
+        /** From the start of the vertex data. */
+        uint32_t    offset;
+        uint16_t    stride;
+        uint8_t     size;
+        uint8_t     normalized;
+        uint32_t    type;
+    };
+
+    /**
+     * \brief Start of a mesh file.
+     */
+    struct MeshFileHeader
+    {
+        uint32_t        magic;
+        uint16_t        version;
+        uint16_t        headerSize;
+        uint32_t        fileSize;
+
+        uint32_t        vertexCount;
+        /** From the start of the file, as are the indices. */
+        uint32_t        vertexOffset;
+        uint32_t        vertexBytes;
+        uint32_t        indexOffset;
+        uint32_t        indexBytes;
+        uint32_t        indexCount;
+        /** GL_UNSIGNED_BYTE or GL_UNSIGNED_SHORT. */
+        uint32_t        indexType;
+        /** Primitive the indices draw, such as GL_TRIANGLE_STRIP. */
+        uint32_t        mode;
+
+        /** Factor positions are scaled by to get object space coordinates. */
+        float           positionScale;
+        /** Object space bounding box. */
+        float           boundsMin[3];
+        float           boundsMax[3];
+
+        /** Position, color and texture coordinates. */
+        MeshFileStream  streams[3];
+    };
+
+    /**
+     * \brief A mesh file mapped into memory.
+     *
+     * load() maps the file read only and checks that everything the header points at lies
+     * within it; nothing is copied or converted. The mesh can be drawn from the mapping as
+     * client arrays, or the mapped blocks handed to glBufferData and the buffers to
+     * useBuffers(), after which the mesh draws from them and the file is unmapped.
+     */
+    class MeshFile
+    {
+    public:
+        MeshFile(void);
+        ~MeshFile();
+
+        /**
+         * \brief Map and check a mesh file.
+         * \return false, with the reason printed to stderr, if it cannot be used.
+         */
+        bool load(const char* path);
+
+        const MeshFileHeader&   getHeader(void) const { return header; }
+
+        /**
+         * \brief The vertex data and the indices in the mapping, header.vertexBytes and
+         * header.indexBytes long. NULL once the file is unmapped.
+         */
+        const void*             getVertices(void) const;
+        const void*             getIndices(void) const;
+
+        /**
+         * \brief How to draw the mesh: from the mapping, or from the buffers once
+         * useBuffers() has been called.
+         */
+        const VertexStreams*    getStreams(void) const { return &streams; }
+        const DrawMesh*         getMesh(void) const { return &mesh; }
+
+        /**
+         * \brief Draw from buffer objects holding the vertex data and the indices from now on,
+         * and unmap the file.
+         */
+        void useBuffers(GLuint vertexBuffer, GLuint indexBuffer);
+
+        /**
+         * \brief Write a mesh file.
+         * \param[in] layout The vertex and index counts, vertexBytes, indexType, mode, scale,
+         *                   bounds and streams; the rest of the header is filled in.
+         * \return false, with the reason printed to stderr, if it could not be written.
+         */
+        static bool write(const char* path, const MeshFileHeader& layout,
+                          const void* vertices, const void* indices);
+
+    private:
+        /* Also counts the triangles, on its pass over the indices. */
+        bool check(void);
+        void setStreams(const GLubyte* vertices, const GLubyte* indices);
+        void unmap(void);
+
+        const char*     path;
+        GLubyte*        mapping;
+        size_t          mappingSize;
+        /* A copy, so that it outlives the mapping. */
+        MeshFileHeader  header;
+        GLsizei         triangleCount;
+        VertexStreams   streams;
+        DrawMesh        mesh;
+    };
+
+#endif /* MESHFILE_H */
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshGenerator.h"
+#include "Mathematics.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+    static const char* const shapeNames[MESH_SHAPE_COUNT] = { "grid", "cube", "sphere" };
+
+    static void setVertex(GeneratedVertex* vertex, float x, float y, float z, float s, float t)
+    {
+        vertex->position[0] = x;
+        vertex->position[1] = y;
+        vertex->position[2] = z;
+        vertex->color[0]    = VERTEX_UNORM8(x + 0.5f);
+        vertex->color[1]    = VERTEX_UNORM8(y + 0.5f);
+        vertex->color[2]    = VERTEX_UNORM8(z + 0.5f);
+        vertex->color[3]    = 255;
+        vertex->texCoord[0] = s;
+        vertex->texCoord[1] = t;
+    }
+
+    MeshGenerator::MeshGenerator(void)
+        : shape(MESH_SHAPE_GRID), vertices(NULL), vertexCount(0), indices(NULL), indexCount(0), triangleCount(0)
+    {
+        memset(&streams, 0, sizeof(streams));
+        memset(&mesh, 0, sizeof(mesh));
+    }
+
+    MeshGenerator::~MeshGenerator()
+    {
+        release();
+    }
+
+    void MeshGenerator::release(void)
+    {
+        free(vertices);
+        free(indices);
+        vertices      = NULL;
+        indices       = NULL;
+        vertexCount   = 0;
+        indexCount    = 0;
+        triangleCount = 0;
+    }
+
+    MeshShape MeshGenerator::findShape(const char* name)
+    {
+        for (int i = 0; i < MESH_SHAPE_COUNT; i++)
+        {
+            if (strcmp(name, shapeNames[i]) == 0)
+            {
+                return (MeshShape)i;
+            }
+        }
+        return MESH_SHAPE_COUNT;
+    }
+
+    const char* MeshGenerator::getShapeName(MeshShape shape)
+    {
+        return shape < MESH_SHAPE_COUNT ? shapeNames[shape] : "unknown";
+    }
+
+    bool MeshGenerator::generate(MeshShape shape, int triangles, bool optimize)
+    {
+        release();
+        this->shape = shape;
+
+        /* Subdivisions for about the triangles asked for: a grid of n x n quads has 2n^2
+         * triangles, a cube 6 of them, and a sphere of r rings and 2r segments 4r^2 - 4r, its
+         * pole rings being fans. */
+        int subdivisions = 0;
+        int vertexTotal  = 0;
+        int triangleTotal = 0;
+        switch (shape)
+        {
+            case MESH_SHAPE_GRID:
+                subdivisions  = (int)(sqrtf(triangles / 2.0f) + 0.5f);
+                subdivisions  = subdivisions > 1 ? subdivisions : 1;
+                vertexTotal   = (subdivisions + 1) * (subdivisions + 1);
+                triangleTotal = 2 * subdivisions * subdivisions;
+                break;
+            case MESH_SHAPE_CUBE:
+                subdivisions  = (int)(sqrtf(triangles / 12.0f) + 0.5f);
+                subdivisions  = subdivisions > 1 ? subdivisions : 1;
+                vertexTotal   = 6 * (subdivisions + 1) * (subdivisions + 1);
+                triangleTotal = 12 * subdivisions * subdivisions;
+                break;
+            case MESH_SHAPE_SPHERE:
+                subdivisions  = (int)((1.0f + sqrtf(1.0f + triangles)) / 2.0f + 0.5f);
+                subdivisions  = subdivisions > 2 ? subdivisions : 2;
+                vertexTotal   = (subdivisions + 1) * (2 * subdivisions + 1);
+                triangleTotal = 2 * subdivisions * (2 * subdivisions - 2);
+                break;
+            default:
+                fprintf(stderr, "Unknown mesh shape %d.\n", shape);
+                return false;
+        }
+        if (vertexTotal > 65535)
+        {
+            fprintf(stderr, "A %s of %d triangles needs %d vertices, more than 16 bit indices reach.\n",
+                    getShapeName(shape), triangleTotal, vertexTotal);
+            return false;
+        }
+
+        vertices = (GeneratedVertex*)malloc(vertexTotal * sizeof(GeneratedVertex));
+        indices  = (GLushort*)malloc(triangleTotal * 3 * sizeof(GLushort));
+        if (vertices == NULL || indices == NULL)
+        {
+            fprintf(stderr, "Could not allocate a %s of %d vertices.\n", getShapeName(shape), vertexTotal);
+            release();
+            return false;
+        }
+
+        if (shape == MESH_SHAPE_GRID)
+        {
+            static const float origin[3] = { -0.5f, -0.5f, 0.0f };
+            static const float across[3] = { 1.0f, 0.0f, 0.0f };
+            static const float up[3]     = { 0.0f, 1.0f, 0.0f };
+            addGrid(origin, across, up, subdivisions, subdivisions);
+        }
+        else if (shape == MESH_SHAPE_CUBE)
+        {
+            /* Each face from its bottom left corner seen from outside, across and up it. */
+            static const float faces[6][3][3] =
+            {
+                { { -0.5f, -0.5f,  0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },   /* Front. */
+                { {  0.5f, -0.5f,  0.5f }, {  0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f,  0.0f } },   /* Right. */
+                { {  0.5f, -0.5f, -0.5f }, { -1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },   /* Back. */
+                { { -0.5f, -0.5f, -0.5f }, {  0.0f, 0.0f,  1.0f }, { 0.0f, 1.0f,  0.0f } },   /* Left. */
+                { { -0.5f,  0.5f,  0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f, -1.0f } },   /* Top. */
+                { { -0.5f, -0.5f, -0.5f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f,  1.0f } },   /* Bottom. */
+            };
+            for (int face = 0; face < 6; face++)
+            {
+                addGrid(faces[face][0], faces[face][1], faces[face][2], subdivisions, subdivisions);
+            }
+        }
+        else
+        {
+            addSphere(subdivisions);
+        }
+        triangleCount = indexCount / 3;
+        mesh.mode = GL_TRIANGLES;
+
+        if (optimize)
+        {
+            MeshOptimizer optimizer;
+            GeneratedVertex* reordered = (GeneratedVertex*)malloc(vertexCount * sizeof(GeneratedVertex));
+            if (reordered == NULL || !optimizer.optimize(GL_TRIANGLES, indices, indexCount, vertexCount))
+            {
+                fprintf(stderr, "Could not optimize the %s.\n", getShapeName(shape));
+                free(reordered);
+                release();
+                return false;
+            }
+            optimizer.remapVertices(vertices, sizeof(GeneratedVertex), reordered);
+            free(vertices);
+            vertices    = reordered;
+            vertexCount = optimizer.getVertexCount();
+            /* A strip is only picked when it is shorter than the list. */
+            indexCount  = optimizer.getIndexCount();
+            memcpy(indices, optimizer.getIndices(), indexCount * sizeof(GLushort));
+            mesh.mode   = optimizer.getMode();
+            optimizer.printStats(getShapeName(shape));
+        }
+
+        setStreams((const GLubyte*)vertices, indices);
+        fprintf(stderr, "Generated %s: %d triangles, %d vertices, %d bytes of vertices and %d of indices\n",
+                getShapeName(shape), triangleCount, vertexCount,
+                (int)(vertexCount * sizeof(GeneratedVertex)), (int)(indexCount * sizeof(GLushort)));
+        return true;
+    }
+
+    /* A grid of columns x rows quads from origin, across and up being its edges, each quad
+     * two triangles turning from across to up. */
+    void MeshGenerator::addGrid(const float origin[3], const float across[3], const float up[3], int columns, int rows)
+    {
+        int first = vertexCount;
+        for (int row = 0; row <= rows; row++)
+        {
+            float t = (float)row / rows;
+            for (int column = 0; column <= columns; column++)
+            {
+                float s = (float)column / columns;
+                setVertex(&vertices[vertexCount++],
+                          origin[0] + across[0] * s + up[0] * t,
+                          origin[1] + across[1] * s + up[1] * t,
+                          origin[2] + across[2] * s + up[2] * t, s, t);
+            }
+        }
+        for (int row = 0; row < rows; row++)
+        {
+            for (int column = 0; column < columns; column++)
+            {
+                GLushort a = (GLushort)(first + row * (columns + 1) + column);
+                GLushort b = (GLushort)(a + 1);
+                GLushort c = (GLushort)(a + columns + 1);
+                GLushort d = (GLushort)(c + 1);
+                indices[indexCount++] = a;
+                indices[indexCount++] = b;
+                indices[indexCount++] = c;
+                indices[indexCount++] = b;
+                indices[indexCount++] = d;
+                indices[indexCount++] = c;
+            }
+        }
+    }
+
+    /* Rings from the bottom pole up, segments around the y axis from +z towards +x. Every
+     * ring has its own copy of the pole and of the seam for their texture coordinates; the
+     * quads touching a pole are single triangles. */
+    void MeshGenerator::addSphere(int rings)
+    {
+        int segments = 2 * rings;
+        for (int ring = 0; ring <= rings; ring++)
+        {
+            float t = (float)ring / rings;
+            float radius = 0.5f * sinf(M_PI * t);
+            float y = -0.5f * cosf(M_PI * t);
+            for (int segment = 0; segment <= segments; segment++)
+            {
+                float s = (float)segment / segments;
+                setVertex(&vertices[vertexCount++],
+                          radius * sinf(2.0f * M_PI * s), y, radius * cosf(2.0f * M_PI * s), s, t);
+            }
+        }
+        for (int ring = 0; ring < rings; ring++)
+        {
+            for (int segment = 0; segment < segments; segment++)
+            {
+                GLushort a = (GLushort)(ring * (segments + 1) + segment);
+                GLushort b = (GLushort)(a + 1);
+                GLushort c = (GLushort)(a + segments + 1);
+                GLushort d = (GLushort)(c + 1);
+                if (ring > 0)
+                {
+                    indices[indexCount++] = a;
+                    indices[indexCount++] = b;
+                    indices[indexCount++] = c;
+                }
+                if (ring < rings - 1)
+                {
+                    indices[indexCount++] = b;
+                    indices[indexCount++] = d;
+                    indices[indexCount++] = c;
+                }
+            }
+        }
+    }
+
+    void MeshGenerator::setStreams(const GLubyte* base, const GLvoid* indexPointer)
+    {
+        streams.position.size       = 3;
+        streams.position.type       = GL_FLOAT;
+        streams.position.normalized = GL_FALSE;
+        streams.position.stride     = sizeof(GeneratedVertex);
+        streams.position.pointer    = base + offsetof(GeneratedVertex, position);
+        streams.color.size          = 4;
+        streams.color.type          = GL_UNSIGNED_BYTE;
+        streams.color.normalized    = GL_TRUE;
+        streams.color.stride        = sizeof(GeneratedVertex);
+        streams.color.pointer       = base + offsetof(GeneratedVertex, color);
+        streams.texCoord.size       = 2;
+        streams.texCoord.type       = GL_FLOAT;
+        streams.texCoord.normalized = GL_FALSE;
+        streams.texCoord.stride     = sizeof(GeneratedVertex);
+        streams.texCoord.pointer    = base + offsetof(GeneratedVertex, texCoord);
+        streams.positionScale       = 1.0f;
+        streams.bytesPerVertex      = sizeof(GeneratedVertex);
+        streams.name                = shapeNames[shape];
+
+        mesh.streams   = &streams;
+        mesh.count     = indexCount;
+        mesh.triangles = triangleCount;
+        mesh.indexType = GL_UNSIGNED_SHORT;
+        mesh.indices   = indexPointer;
+    }
+
+    void MeshGenerator::useBuffers(GLuint vertexBuffer, GLuint indexBuffer)
+    {
+        /* Offsets into the buffers from here on. */
+        setStreams(NULL, NULL);
+        streams.buffer   = vertexBuffer;
+        mesh.indexBuffer = indexBuffer;
+    }
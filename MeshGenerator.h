@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESHGENERATOR_H
+#define MESHGENERATOR_H
+
+#include <GLES2/gl2.h>
+
+#include "CommandBuffer.h"
+#include "VertexFormats.h"
+
+/**
+ * \file MeshGenerator.h
+ * \brief Meshes of any size, for measuring how vertex and index throughput scales.
+ */
+
+    /**
+     * \brief A vertex with every attribute the shaders read: position, color and texture
+     * coordinates, 24 bytes.
+     */
+    struct GeneratedVertex
+    {
+        GLfloat     position[3];
+        GLubyte     color[4];
+        GLfloat     texCoord[2];
+    };
+
+    enum MeshShape
+    {
+        /** A square in the xy plane, facing +z. */
+        MESH_SHAPE_GRID,
+        /** A cube with every face a grid. */
+        MESH_SHAPE_CUBE,
+        /** A sphere of latitude rings and longitude segments. */
+        MESH_SHAPE_SPHERE,
+        MESH_SHAPE_COUNT
+    };
+
+    /**
+     * \brief Builds grids, subdivided cubes and spheres of about a requested number of
+     * triangles.
+     *
+     * Meshes fit the same box as the cube of Cube.h, from -0.5 to 0.5 on each axis, and
+     * wind counterclockwise seen from outside. Colors follow the position, red along x,
+     * green along y and blue along z, and texture coordinates cover each grid, each face of
+     * the cube and the sphere once. Indices are 16 bits, GL ES 2.0 not having 32 bit ones,
+     * which limits meshes to 65535 vertices, a little over 125000 triangles.
+     */
+    class MeshGenerator
+    {
+    public:
+        MeshGenerator(void);
+        ~MeshGenerator();
+
+        /**
+         * \brief The shape called name on the command line, or MESH_SHAPE_COUNT.
+         */
+        static MeshShape findShape(const char* name);
+        static const char* getShapeName(MeshShape shape);
+
+        /**
+         * \brief Build a mesh of the shape as near the number of triangles as it comes.
+         * \param[in] optimize Reorder it for the vertex caches with MeshOptimizer; otherwise
+         *                     it is built row by row.
+         * \return false, with the reason printed to stderr, if it would need more vertices
+         *         than 16 bit indices reach or memory could not be had.
+         */
+        bool generate(MeshShape shape, int triangles, bool optimize);
+
+        const GeneratedVertex*  getVertices(void) const { return vertices; }
+        int                     getVertexCount(void) const { return vertexCount; }
+        const GLushort*         getIndices(void) const { return indices; }
+        int                     getIndexCount(void) const { return mesh.count; }
+        int                     getTriangleCount(void) const { return triangleCount; }
+
+        /**
+         * \brief How to draw the mesh: from the arrays above, or from the buffers once
+         * useBuffers() has been called.
+         */
+        const VertexStreams*    getStreams(void) const { return &streams; }
+        const DrawMesh*         getMesh(void) const { return &mesh; }
+
+        /**
+         * \brief Draw from buffer objects holding getVertices() and getIndices() from now on.
+         */
+        void useBuffers(GLuint vertexBuffer, GLuint indexBuffer);
+
+    private:
+        void release(void);
+        void addGrid(const float origin[3], const float across[3], const float up[3], int columns, int rows);
+        void addSphere(int rings);
+        void setStreams(const GLubyte* base, const GLvoid* indexPointer);
+
+        MeshShape           shape;
+        GeneratedVertex*    vertices;
+        int                 vertexCount;
+        GLushort*           indices;
+        int                 indexCount;
+        int                 triangleCount;
+        VertexStreams       streams;
+        DrawMesh            mesh;
+    };
+
+#endif /* MESHGENERATOR_H */
@@ -0,0 +1,457 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+    /* The LRU cache the triangle order is scored against, and how vertices are scored: by
+     * their place in it, the three of the last triangle a little less so that the next
+     * triangle does not only turn around them, and by how few triangles still need them so
+     * that lone triangles are not left behind. The weights are Forsyth's. */
+    static const int   scoredCacheSize   = 32;
+    static const float cacheDecayPower   = 1.5f;
+    static const float lastTriangleScore = 0.75f;
+    static const float valenceBoostScale = 2.0f;
+    static const float valenceBoostPower = 0.5f;
+
+    static float vertexScore(int cachePosition, int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                score = lastTriangleScore;
+            }
+            else
+            {
+                float scaled = 1.0f - (float)(cachePosition - 3) / (scoredCacheSize - 3);
+                score = powf(scaled, cacheDecayPower);
+            }
+        }
+        return score + valenceBoostScale * powf((float)remainingTriangles, -valenceBoostPower);
+    }
+
+    /* Whether a triangle runs from one vertex to the other along one of its edges. */
+    static bool hasEdge(const GLushort* triangle, GLushort from, GLushort to)
+    {
+        return (triangle[0] == from && triangle[1] == to) ||
+               (triangle[1] == from && triangle[2] == to) ||
+               (triangle[2] == from && triangle[0] == to);
+    }
+
+    /* The triangles of a list or strip, of the same winding, without degenerate ones. */
+    static int collectTriangles(GLenum mode, const GLushort* indices, int indexCount, int vertexCount,
+                                GLushort* triangles)
+    {
+        int count = 0;
+        int step  = mode == GL_TRIANGLE_STRIP ? 1 : 3;
+        for (int i = 0; i + 2 < indexCount; i += step)
+        {
+            int odd = mode == GL_TRIANGLE_STRIP ? (i & 1) : 0;
+            GLushort a = indices[i + odd], b = indices[i + 1 - odd], c = indices[i + 2];
+            if (a != b && b != c && a != c && a < vertexCount && b < vertexCount && c < vertexCount)
+            {
+                triangles[count++] = a;
+                triangles[count++] = b;
+                triangles[count++] = c;
+            }
+        }
+        return count;
+    }
+
+    MeshOptimizer::MeshOptimizer(void)
+        : inputMode(GL_TRIANGLES), mode(GL_TRIANGLES), vertexCount(0), usedVertices(0),
+          triangles(NULL), triangleIndices(0), strip(NULL), stripLength(0), remap(NULL)
+    {
+        memset(&before, 0, sizeof(before));
+        memset(&after, 0, sizeof(after));
+    }
+
+    MeshOptimizer::~MeshOptimizer()
+    {
+        release();
+    }
+
+    void MeshOptimizer::release(void)
+    {
+        free(triangles);
+        free(strip);
+        free(remap);
+        triangles       = NULL;
+        strip           = NULL;
+        remap           = NULL;
+        triangleIndices = 0;
+        stripLength     = 0;
+        usedVertices    = 0;
+    }
+
+    bool MeshOptimizer::optimize(GLenum mode, const GLushort* indices, int indexCount, int vertexCount)
+    {
+        release();
+        if ((mode != GL_TRIANGLES && mode != GL_TRIANGLE_STRIP) || vertexCount <= 0 || vertexCount > 65535)
+        {
+            fprintf(stderr, "Cannot optimize mode 0x%x meshes of %d vertices.\n", mode, vertexCount);
+            return false;
+        }
+        this->inputMode   = mode;
+        this->vertexCount = vertexCount;
+        before = measure(mode, indices, indexCount, vertexCount, VERTEX_CACHE_FIFO_SIZE);
+
+        /* A strip of n indices has at most n - 2 triangles, each of which may need a join of
+         * three indices when stripped again. */
+        int maxTriangleIndices = mode == GL_TRIANGLE_STRIP ? 3 * (indexCount > 2 ? indexCount - 2 : 0) : indexCount;
+        GLushort* list = (GLushort*)malloc((maxTriangleIndices + 1) * sizeof(GLushort));
+        triangles      = (GLushort*)malloc((maxTriangleIndices + 1) * sizeof(GLushort));
+        strip          = (GLushort*)malloc((2 * maxTriangleIndices + 1) * sizeof(GLushort));
+        remap          = (GLushort*)malloc(vertexCount * sizeof(GLushort));
+        if (list == NULL || triangles == NULL || strip == NULL || remap == NULL)
+        {
+            fprintf(stderr, "Could not allocate a mesh of %d indices to optimize.\n", indexCount);
+            free(list);
+            release();
+            return false;
+        }
+
+        int listIndices = collectTriangles(mode, indices, indexCount, vertexCount, list);
+        bool ordered = orderTriangles(list, listIndices);
+        free(list);
+        if (!ordered)
+        {
+            release();
+            return false;
+        }
+        orderVertices();
+        buildStrip();
+
+        /* Strips save index bandwidth, but not if their joins cost transforms. */
+        VertexCacheStats listStats  = measure(GL_TRIANGLES, triangles, triangleIndices, usedVertices, VERTEX_CACHE_FIFO_SIZE);
+        VertexCacheStats stripStats = measure(GL_TRIANGLE_STRIP, strip, stripLength, usedVertices, VERTEX_CACHE_FIFO_SIZE);
+        if (stripLength < triangleIndices && stripStats.transforms <= listStats.transforms)
+        {
+            this->mode = GL_TRIANGLE_STRIP;
+            after = stripStats;
+        }
+        else
+        {
+            this->mode = GL_TRIANGLES;
+            after = listStats;
+        }
+        return true;
+    }
+
+    /* Forsyth's greedy ordering: emit the best scoring triangle, move its vertices to the
+     * front of the modelled cache, rescore the vertices in the cache and the triangles still
+     * using them, and go on with the best of those. Only when none of them is left is every
+     * triangle looked at. */
+    bool MeshOptimizer::orderTriangles(const GLushort* list, int indexCount)
+    {
+        int triangleCount = indexCount / 3;
+        triangleIndices   = 0;
+
+        int*   adjacencyStart = (int*)calloc(vertexCount + 1, sizeof(int));
+        int*   remaining      = (int*)calloc(vertexCount, sizeof(int));
+        int*   adjacency      = (int*)malloc((indexCount + 1) * sizeof(int));
+        int*   cachePosition  = (int*)malloc(vertexCount * sizeof(int));
+        float* scores         = (float*)malloc(vertexCount * sizeof(float));
+        float* triangleScores = (float*)malloc((triangleCount + 1) * sizeof(float));
+        bool*  emitted        = (bool*)calloc(triangleCount + 1, sizeof(bool));
+        bool   allocated = adjacencyStart != NULL && remaining != NULL && adjacency != NULL &&
+                           cachePosition != NULL && scores != NULL && triangleScores != NULL && emitted != NULL;
+
+        if (allocated)
+        {
+            /* Each vertex's triangles, those still to be emitted first. */
+            for (int i = 0; i < indexCount; i++)
+            {
+                adjacencyStart[list[i] + 1]++;
+            }
+            for (int v = 0; v < vertexCount; v++)
+            {
+                adjacencyStart[v + 1] += adjacencyStart[v];
+            }
+            for (int i = 0; i < indexCount; i++)
+            {
+                GLushort v = list[i];
+                adjacency[adjacencyStart[v] + remaining[v]++] = i / 3;
+            }
+            for (int v = 0; v < vertexCount; v++)
+            {
+                cachePosition[v] = -1;
+                scores[v] = vertexScore(-1, remaining[v]);
+            }
+
+            int best = -1;
+            float bestScore = -1.0f;
+            for (int t = 0; t < triangleCount; t++)
+            {
+                const GLushort* triangle = &list[t * 3];
+                triangleScores[t] = scores[triangle[0]] + scores[triangle[1]] + scores[triangle[2]];
+                if (triangleScores[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+
+            int cache[scoredCacheSize + 3];
+            int cacheCount = 0;
+            for (int count = 0; count < triangleCount; count++)
+            {
+                if (best < 0)
+                {
+                    bestScore = -1.0f;
+                    for (int t = 0; t < triangleCount; t++)
+                    {
+                        if (!emitted[t] && triangleScores[t] > bestScore)
+                        {
+                            best = t;
+                            bestScore = triangleScores[t];
+                        }
+                    }
+                }
+
+                const GLushort* triangle = &list[best * 3];
+                emitted[best] = true;
+                memcpy(&triangles[triangleIndices], triangle, 3 * sizeof(GLushort));
+                triangleIndices += 3;
+
+                /* Out of its vertices' lists of triangles still to be emitted. */
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    GLushort v = triangle[corner];
+                    int* triangleList = &adjacency[adjacencyStart[v]];
+                    for (int i = 0; i < remaining[v]; i++)
+                    {
+                        if (triangleList[i] == best)
+                        {
+                            triangleList[i] = triangleList[--remaining[v]];
+                            break;
+                        }
+                    }
+                }
+
+                int newCache[scoredCacheSize + 3];
+                int newCount = 0;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    newCache[newCount++] = triangle[corner];
+                }
+                for (int i = 0; i < cacheCount; i++)
+                {
+                    if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                    {
+                        newCache[newCount++] = cache[i];
+                    }
+                }
+                for (int i = 0; i < newCount; i++)
+                {
+                    int v = newCache[i];
+                    cachePosition[v] = i < scoredCacheSize ? i : -1;
+                    scores[v] = vertexScore(cachePosition[v], remaining[v]);
+                }
+
+                best = -1;
+                bestScore = -1.0f;
+                for (int i = 0; i < newCount; i++)
+                {
+                    int v = newCache[i];
+                    for (int j = 0; j < remaining[v]; j++)
+                    {
+                        int t = adjacency[adjacencyStart[v] + j];
+                        const GLushort* neighbour = &list[t * 3];
+                        triangleScores[t] = scores[neighbour[0]] + scores[neighbour[1]] + scores[neighbour[2]];
+                        if (triangleScores[t] > bestScore)
+                        {
+                            best = t;
+                            bestScore = triangleScores[t];
+                        }
+                    }
+                }
+
+                cacheCount = newCount < scoredCacheSize ? newCount : scoredCacheSize;
+                memcpy(cache, newCache, cacheCount * sizeof(int));
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Could not allocate the adjacency of %d triangles.\n", triangleCount);
+        }
+
+        free(adjacencyStart);
+        free(remaining);
+        free(adjacency);
+        free(cachePosition);
+        free(scores);
+        free(triangleScores);
+        free(emitted);
+        return allocated;
+    }
+
+    /* Number vertices in the order the triangles first use them. */
+    void MeshOptimizer::orderVertices(void)
+    {
+        for (int v = 0; v < vertexCount; v++)
+        {
+            remap[v] = MESH_UNUSED_VERTEX;
+        }
+        usedVertices = 0;
+        for (int i = 0; i < triangleIndices; i++)
+        {
+            GLushort& index = triangles[i];
+            if (remap[index] == MESH_UNUSED_VERTEX)
+            {
+                remap[index] = (GLushort)usedVertices++;
+            }
+            index = remap[index];
+        }
+    }
+
+    /* Strip the triangles in their order. A triangle continues the strip if it is the one
+     * the strip's last two indices and one more would make; otherwise the strip is joined to
+     * it with degenerate triangles, repeating the last index and the triangle's first, and
+     * once more if needed for the triangle to start at an even place and keep its winding.
+     * A new strip starts on the edge it shares with the next triangle, if any. */
+    void MeshOptimizer::buildStrip(void)
+    {
+        int count = triangleIndices / 3;
+        stripLength = 0;
+        for (int t = 0; t < count; t++)
+        {
+            const GLushort* triangle = &triangles[t * 3];
+
+            if (stripLength >= 2)
+            {
+                bool even = (stripLength & 1) == 0;
+                GLushort first  = strip[stripLength - (even ? 2 : 1)];
+                GLushort second = strip[stripLength - (even ? 1 : 2)];
+                int corner = 0;
+                while (corner < 3 && !(triangle[corner] == first && triangle[(corner + 1) % 3] == second))
+                {
+                    corner++;
+                }
+                if (corner < 3)
+                {
+                    strip[stripLength++] = triangle[(corner + 2) % 3];
+                    continue;
+                }
+            }
+
+            int start = 0;
+            if (t + 1 < count)
+            {
+                const GLushort* next = &triangles[(t + 1) * 3];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (hasEdge(next, triangle[(corner + 2) % 3], triangle[(corner + 1) % 3]))
+                    {
+                        start = corner;
+                        break;
+                    }
+                }
+            }
+            GLushort a = triangle[start], b = triangle[(start + 1) % 3], c = triangle[(start + 2) % 3];
+            if (stripLength > 0)
+            {
+                GLushort last = strip[stripLength - 1];
+                strip[stripLength++] = last;
+                strip[stripLength++] = a;
+                if (stripLength & 1)
+                {
+                    strip[stripLength++] = a;
+                }
+            }
+            strip[stripLength++] = a;
+            strip[stripLength++] = b;
+            strip[stripLength++] = c;
+        }
+    }
+
+    void MeshOptimizer::remapVertices(const void* vertices, int stride, void* out) const
+    {
+        const GLubyte* source = (const GLubyte*)vertices;
+        GLubyte* destination  = (GLubyte*)out;
+        for (int v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] != MESH_UNUSED_VERTEX)
+            {
+                memcpy(destination + remap[v] * stride, source + v * stride, stride);
+            }
+        }
+    }
+
+    VertexCacheStats MeshOptimizer::measure(GLenum mode, const GLushort* indices, int indexCount,
+                                            int vertexCount, int cacheSize)
+    {
+        VertexCacheStats stats;
+        memset(&stats, 0, sizeof(stats));
+        stats.indices = indexCount;
+
+        /* The miss that put each vertex in the cache, 0 if it was never transformed. It is
+         * still cached if fewer than cacheSize misses came after it. */
+        int* transformedAt = (int*)calloc(vertexCount > 0 ? vertexCount : 1, sizeof(int));
+        if (transformedAt == NULL)
+        {
+            return stats;
+        }
+        for (int i = 0; i < indexCount; i++)
+        {
+            GLushort v = indices[i];
+            if (v >= vertexCount)
+            {
+                continue;
+            }
+            if (transformedAt[v] == 0)
+            {
+                stats.vertices++;
+            }
+            if (transformedAt[v] == 0 || stats.transforms - transformedAt[v] >= cacheSize)
+            {
+                transformedAt[v] = ++stats.transforms;
+            }
+        }
+        free(transformedAt);
+
+        int step = mode == GL_TRIANGLE_STRIP ? 1 : 3;
+        for (int i = 0; i + 2 < indexCount; i += step)
+        {
+            if (indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2])
+            {
+                stats.triangles++;
+            }
+        }
+        stats.acmr = stats.triangles > 0 ? (float)stats.transforms / stats.triangles : 0.0f;
+        stats.atvr = stats.vertices > 0 ? (float)stats.transforms / stats.vertices : 0.0f;
+        return stats;
+    }
+
+    void MeshOptimizer::printStats(const char* label) const
+    {
+        fprintf(stderr, "Mesh optimization (%s): %d triangles, %d of %d vertices used, %d entry FIFO cache\n",
+                label, after.triangles, usedVertices, vertexCount, VERTEX_CACHE_FIFO_SIZE);
+        fprintf(stderr, "  before: %-6s %6d indices, ACMR %.3f, ATVR %.3f\n",
+                inputMode == GL_TRIANGLE_STRIP ? "strip" : "list", before.indices, before.acmr, before.atvr);
+        fprintf(stderr, "  after:  %-6s %6d indices, ACMR %.3f, ATVR %.3f\n",
+                mode == GL_TRIANGLE_STRIP ? "strip" : "list", after.indices, after.acmr, after.atvr);
+    }
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <GLES2/gl2.h>
+
+/**
+ * \file MeshOptimizer.h
+ * \brief Reorders a mesh's triangles and vertices for the GPU's vertex caches.
+ */
+
+/**
+ * \brief Entries of the post-transform cache the statistics are measured with. Mobile GPUs
+ * keep somewhere between 8 and 32 transformed vertices, mostly first in first out.
+ */
+#define VERTEX_CACHE_FIFO_SIZE  16
+
+/**
+ * \brief Marks a vertex no triangle uses in MeshOptimizer::getRemap().
+ */
+#define MESH_UNUSED_VERTEX      0xFFFF
+
+    /**
+     * \brief How often an index buffer makes the GPU transform a vertex.
+     */
+    struct VertexCacheStats
+    {
+        int     indices;
+        int     triangles;
+        /** Distinct vertices the triangles use. */
+        int     vertices;
+        /** Indices that missed the cache. */
+        int     transforms;
+        /** Average cache miss ratio, transforms per triangle: 0.5 at best for large meshes, 3 at worst. */
+        float   acmr;
+        /** Average transform to vertex ratio, transforms per vertex used: 1 at best. */
+        float   atvr;
+    };
+
+    /**
+     * \brief Optimizes the order of a mesh's indices and vertices.
+     *
+     * optimize() takes a triangle list or a strip with degenerate triangles between its
+     * strips and:
+     * - orders the triangles so that their vertices are reused while still in the
+     *   post-transform cache, scoring vertices by their place in a modelled LRU cache and by
+     *   how many triangles still need them (Tom Forsyth's linear-speed vertex cache
+     *   optimization);
+     * - numbers the vertices in the order the triangles first use them, so vertex fetches
+     *   walk memory forwards, and drops vertices no triangle uses;
+     * - strips the ordered triangles, keeping their order, and picks the strip if it takes
+     *   fewer indices than the list without transforming more vertices.
+     *
+     * The statistics of the mesh as given and as optimized are measured by running the
+     * indices through a FIFO cache of VERTEX_CACHE_FIFO_SIZE entries.
+     */
+    class MeshOptimizer
+    {
+    public:
+        MeshOptimizer(void);
+        ~MeshOptimizer();
+
+        /**
+         * \param[in] mode GL_TRIANGLES or GL_TRIANGLE_STRIP.
+         * \param[in] vertexCount Number of vertices the indices refer to, at most 65535.
+         * \return false if mode is not supported or memory could not be had.
+         */
+        bool optimize(GLenum mode, const GLushort* indices, int indexCount, int vertexCount);
+
+        /**
+         * \brief The optimized indices, referring to the renumbered vertices.
+         */
+        GLenum              getMode(void) const { return mode; }
+        const GLushort*     getIndices(void) const { return mode == GL_TRIANGLE_STRIP ? strip : triangles; }
+        int                 getIndexCount(void) const { return mode == GL_TRIANGLE_STRIP ? stripLength : triangleIndices; }
+
+        /**
+         * \brief The new number of every vertex given, or MESH_UNUSED_VERTEX.
+         */
+        const GLushort*     getRemap(void) const { return remap; }
+        /**
+         * \brief Number of vertices the optimized mesh keeps.
+         */
+        int                 getVertexCount(void) const { return usedVertices; }
+
+        /**
+         * \brief Reorder one vertex stream to the new numbering.
+         * \param[in] vertices The stream, vertexCount elements of stride bytes.
+         * \param[out] out Room for getVertexCount() elements of stride bytes.
+         */
+        void remapVertices(const void* vertices, int stride, void* out) const;
+
+        const VertexCacheStats& getBefore(void) const { return before; }
+        const VertexCacheStats& getAfter(void) const { return after; }
+
+        /**
+         * \brief Print the statistics before and after to stderr.
+         * \param[in] label A label for the report, such as the mesh's name.
+         */
+        void printStats(const char* label) const;
+
+        /**
+         * \brief Run indices through a FIFO post-transform cache.
+         */
+        static VertexCacheStats measure(GLenum mode, const GLushort* indices, int indexCount,
+                                        int vertexCount, int cacheSize);
+
+    private:
+        void release(void);
+        bool orderTriangles(const GLushort* list, int indexCount);
+        void orderVertices(void);
+        void buildStrip(void);
+
+        GLenum              inputMode;
+        GLenum              mode;
+        int                 vertexCount;
+        int                 usedVertices;
+        GLushort*           triangles;
+        int                 triangleIndices;
+        GLushort*           strip;
+        int                 stripLength;
+        GLushort*           remap;
+
+        VertexCacheStats    before;
+        VertexCacheStats    after;
+    };
+
+#endif /* MESHOPTIMIZER_H */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NullGL.h"
+#include "HostEGL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The EGL entry points are in HostEGL.cpp; these are the null backend's hooks. */
+
+const char   hosteglVersion[]    = "1.4 nullgl";
+const char   hosteglExtensions[] = "";
+const EGLint hosteglConfigCaveat = EGL_NONE;
+
+static unsigned int statsInterval = 600;
+/* The swap that ended the last frame, to label what eglTerminate reports. */
+static unsigned int lastSwap;
+
+void hosteglCount(HostEGLCall call)
+{
+  /* NULLGL_CALLS starts with HOSTEGL_CALLS, so the indices are the same. */
+  nullglCount((NullGLCall)call);
+}
+
+void hosteglInitialize(void)
+{
+  const char* interval;
+  if ((interval = getenv("NULLGL_STATS")) != NULL)
+  {
+    statsInterval = atoi(interval) > 0 ? atoi(interval) : 0;
+  }
+}
+
+void hosteglTerminate(void)
+{
+  /* The frames since the last report, so a run shorter than NULLGL_STATS swaps reports too. */
+  if (statsInterval != 0)
+  {
+    char label[64];
+    snprintf(label, sizeof(label), "swap %u", lastSwap);
+    nullglPrintStats(label);
+  }
+}
+
+bool hosteglCreateContext(void)
+{
+  return nullglCreateContext();
+}
+
+void hosteglDestroyContext(void)
+{
+  nullglDestroyContext();
+}
+
+/* Nothing is rendered, so a surface is only its size. */
+bool hosteglCreateSurface(int surface, EGLint width, EGLint height)
+{
+  return true;
+}
+
+void hosteglDestroySurface(int surface)
+{
+}
+
+void hosteglMakeCurrent(int surface, EGLint width, EGLint height)
+{
+  nullglMakeCurrent(surface >= 0, width, height);
+}
+
+/* Nothing is shown, so a swap only ends the frame's statistics and reports them every
+ * NULLGL_STATS swaps, and at eglTerminate. */
+void hosteglSwapBuffers(int surface, unsigned int swaps)
+{
+  lastSwap = swaps;
+  nullglEndFrame();
+  if (statsInterval != 0 && swaps % statsInterval == 0)
+  {
+    char label[64];
+    snprintf(label, sizeof(label), "swap %u", swaps);
+    nullglPrintStats(label);
+  }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NULLGL_H
+#define NULLGL_H
+
+#include "HostEGL.h"
+
+/**
+ * \file NullGL.h
+ * \brief EGL and GLES2 entry points that validate their arguments and count calls but
+ * render nothing (the gl2-cube-null host executable).
+ *
+ * With no driver underneath, the time between two eglSwapBuffers calls is the CPU cost of
+ * the application's frame. Every NULLGL_STATS swaps (default 600, 0 for never) the average
+ * thread and process CPU time per frame since the first swap, and the calls per frame of each
+ * entry point, are printed to stderr; the frames after the last report are printed by
+ * eglTerminate.
+ *
+ * Errors are recorded for glGetError and eglGetError as a real implementation would. Shaders
+ * are not compiled, but their preprocessor conditionals are evaluated and their attribute and
+ * uniform declarations collected, so locations, active uniforms and the type of each uniform
+ * call are checked as on a device.
+ */
+
+/**
+ * \brief Every entry point the backend implements, for the per-call counters. The EGL ones come
+ * first and in the order of HOSTEGL_CALLS, so a HostEGLCall is also a NullGLCall.
+ */
+#define NULLGL_CALLS(X) \
+    HOSTEGL_CALLS(X) \
+    X(glActiveTexture) X(glAttachShader) X(glBindAttribLocation) X(glBindBuffer) \
+    X(glBindFramebuffer) X(glBindTexture) X(glBlendFunc) X(glBufferData) X(glBufferSubData) \
+    X(glCheckFramebufferStatus) X(glClear) X(glClearColor) X(glClearDepthf) X(glCompileShader) \
+    X(glCreateProgram) X(glCreateShader) X(glCullFace) X(glDeleteBuffers) \
+    X(glDeleteFramebuffers) X(glDeleteProgram) X(glDeleteShader) X(glDeleteTextures) \
+    X(glDepthFunc) X(glDepthMask) X(glDetachShader) X(glDisable) X(glDisableVertexAttribArray) \
+    X(glDrawArrays) X(glDrawElements) X(glEnable) X(glEnableVertexAttribArray) X(glFinish) \
+    X(glFlush) X(glFramebufferTexture2D) X(glFrontFace) X(glGenBuffers) X(glGenFramebuffers) \
+    X(glGenTextures) X(glGetAttribLocation) X(glGetError) X(glGetIntegerv) \
+    X(glGetProgramInfoLog) X(glGetProgramiv) X(glGetShaderInfoLog) X(glGetShaderiv) \
+    X(glGetString) X(glGetUniformLocation) X(glIsEnabled) X(glLinkProgram) X(glPixelStorei) \
+    X(glReadPixels) X(glScissor) X(glShaderSource) X(glTexImage2D) X(glTexParameterf) \
+    X(glTexParameteri) X(glTexSubImage2D) X(glUniform1f) X(glUniform1i) X(glUniform4fv) \
+    X(glUniformMatrix4fv) X(glUseProgram) X(glVertexAttrib4f) X(glVertexAttribPointer) X(glViewport) \
+    X(glGetProgramBinaryOES) X(glProgramBinaryOES) X(glGenRenderbuffers) X(glBindRenderbuffer) \
+    X(glRenderbufferStorage) X(glFramebufferRenderbuffer)
+
+    /**
+     * \brief Index of each entry point in the call counters.
+     */
+    enum NullGLCall
+    {
+#define NULLGL_CALL_ENUM(name) NULLGL_CALL_##name,
+        NULLGL_CALLS(NULLGL_CALL_ENUM)
+#undef NULLGL_CALL_ENUM
+        NULLGL_CALL_COUNT
+    };
+
+    /**
+     * \brief Count one call of an entry point.
+     */
+    void nullglCount(NullGLCall call);
+
+    /**
+     * \brief Create the GL context state.
+     */
+    bool nullglCreateContext(void);
+
+    /**
+     * \brief Free all GL objects.
+     */
+    void nullglDestroyContext(void);
+
+    /**
+     * \brief Make a surface of the given size the default framebuffer.
+     * \param[in] current False to release the surface.
+     */
+    void nullglMakeCurrent(bool current, int width, int height);
+
+    /**
+     * \brief Close the statistics of the frame eglSwapBuffers just ended.
+     */
+    void nullglEndFrame(void);
+
+    /**
+     * \brief Print the per frame CPU time and call counts since the last report to stderr
+     * and reset them.
+     */
+    void nullglPrintStats(const char* label);
+
+#endif /* NULLGL_H */
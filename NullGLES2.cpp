@@ -0,0 +1,2287 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "NullGL.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <utils/Timers.h>
+
+#define NULLGL_MAX_TEXTURES      256
+#define NULLGL_MAX_BUFFERS       256
+#define NULLGL_MAX_SHADERS       128
+#define NULLGL_MAX_PROGRAMS      64
+#define NULLGL_MAX_FRAMEBUFFERS  32
+#define NULLGL_MAX_RENDERBUFFERS 32
+#define NULLGL_MAX_ATTRIBS       8
+#define NULLGL_MAX_TEXTURE_UNITS 8
+#define NULLGL_MAX_TEXTURE_SIZE  4096
+#define NULLGL_MAX_VARIABLES     16
+#define NULLGL_MAX_NAME          64
+#define NULLGL_MAX_DEFINES       16
+#define NULLGL_MAX_NESTING       8
+#define NULLGL_MAX_LOG           256
+
+#define COUNT(name) nullglCount(NULLGL_CALL_##name)
+
+/* An attribute or uniform a shader declares. */
+struct Variable
+{
+  char    name[NULLGL_MAX_NAME];
+  GLenum  type;
+  GLint   size;
+  GLint   location;
+  /* Referenced after its declaration, as a compiler would keep it. */
+  bool    active;
+};
+
+struct TextureObject
+{
+  bool    used;
+  GLsizei width;
+  GLsizei height;
+};
+
+struct BufferObject
+{
+  bool        used;
+  GLsizeiptr  size;
+};
+
+struct ShaderObject
+{
+  bool      used;
+  GLenum    type;
+  GLint     sourceLength;
+  char*     source;
+  bool      compiled;
+  Variable  attributes[NULLGL_MAX_VARIABLES];
+  int       attributeCount;
+  Variable  uniforms[NULLGL_MAX_VARIABLES];
+  int       uniformCount;
+  char      infoLog[NULLGL_MAX_LOG];
+};
+
+struct AttribBinding
+{
+  char  name[NULLGL_MAX_NAME];
+  GLint index;
+};
+
+struct ProgramObject
+{
+  bool          used;
+  GLuint        shaders[2];
+  bool          linked;
+  AttribBinding bindings[NULLGL_MAX_ATTRIBS];
+  int           bindingCount;
+  Variable      attributes[NULLGL_MAX_VARIABLES];
+  int           attributeCount;
+  Variable      uniforms[2 * NULLGL_MAX_VARIABLES];
+  int           uniformCount;
+  char          infoLog[NULLGL_MAX_LOG];
+};
+
+struct FramebufferObject
+{
+  bool    used;
+  GLuint  colorTexture;
+  GLuint  depthRenderbuffer;
+};
+
+struct RenderbufferObject
+{
+  bool    used;
+  GLenum  format;
+  GLsizei width;
+  GLsizei height;
+};
+
+struct VertexAttrib
+{
+  bool          enabled;
+  GLuint        buffer;
+  const GLvoid* pointer;
+};
+
+struct ContextState
+{
+  GLenum            error;
+  TextureObject     textures[NULLGL_MAX_TEXTURES];
+  BufferObject      buffers[NULLGL_MAX_BUFFERS];
+  ShaderObject      shaders[NULLGL_MAX_SHADERS];
+  ProgramObject     programs[NULLGL_MAX_PROGRAMS];
+  FramebufferObject framebuffers[NULLGL_MAX_FRAMEBUFFERS];
+  RenderbufferObject renderbuffers[NULLGL_MAX_RENDERBUFFERS];
+  VertexAttrib      attribs[NULLGL_MAX_ATTRIBS];
+
+  GLuint            program;
+  GLuint            arrayBuffer;
+  GLuint            elementArrayBuffer;
+  GLuint            framebuffer;
+  GLuint            renderbuffer;
+  GLuint            activeTexture;
+  /* Bindings per unit for GL_TEXTURE_2D and GL_TEXTURE_EXTERNAL_OES. */
+  GLuint            boundTextures[NULLGL_MAX_TEXTURE_UNITS][2];
+  GLint             unpackAlignment;
+  GLint             packAlignment;
+  GLint             viewport[4];
+  GLint             scissor[4];
+  bool              blend;
+  bool              cullFace;
+  bool              depthTest;
+  bool              scissorTest;
+  bool              hasSurface;
+};
+
+/* What the application asked for between two swaps. */
+struct FrameStats
+{
+  unsigned int  calls[NULLGL_CALL_COUNT];
+  unsigned int  frames;
+  unsigned int  draws;
+  unsigned int  vertices;
+  nsecs_t       threadTime;
+  nsecs_t       maxThreadTime;
+  nsecs_t       processTime;
+  nsecs_t       wallTime;
+};
+
+static const char* const callNames[NULLGL_CALL_COUNT] =
+{
+#define NULLGL_CALL_NAME(name) #name,
+  NULLGL_CALLS(NULLGL_CALL_NAME)
+#undef NULLGL_CALL_NAME
+};
+
+static ContextState context;
+static FrameStats   stats;
+static bool         frameStarted;
+static nsecs_t      frameThreadStart;
+static nsecs_t      frameProcessStart;
+static nsecs_t      frameWallStart;
+
+static void setError(GLenum error)
+{
+  if (context.error == GL_NO_ERROR)
+  {
+    context.error = error;
+  }
+}
+
+void nullglCount(NullGLCall call)
+{
+  stats.calls[call]++;
+}
+
+static void resetContext(void)
+{
+  memset(&context, 0, sizeof(context));
+  context.activeTexture   = GL_TEXTURE0;
+  context.unpackAlignment = 4;
+  context.packAlignment   = 4;
+}
+
+bool nullglCreateContext(void)
+{
+  resetContext();
+  return true;
+}
+
+void nullglDestroyContext(void)
+{
+  for (int i = 0; i < NULLGL_MAX_SHADERS; i++)
+  {
+    free(context.shaders[i].source);
+  }
+  resetContext();
+}
+
+void nullglMakeCurrent(bool current, int width, int height)
+{
+  context.hasSurface = current;
+  if (current && context.viewport[2] == 0 && context.viewport[3] == 0)
+  {
+    /* Like every EGL implementation, size the viewport and scissor to the first surface. */
+    context.viewport[2] = context.scissor[2] = width;
+    context.viewport[3] = context.scissor[3] = height;
+  }
+}
+
+/* Frames are measured from one swap to the next, so start up is not part of the first one. */
+void nullglEndFrame(void)
+{
+  nsecs_t thread = systemTime(SYSTEM_TIME_THREAD);
+  nsecs_t process = systemTime(SYSTEM_TIME_PROCESS);
+  nsecs_t wall = systemTime(SYSTEM_TIME_MONOTONIC);
+
+  if (!frameStarted)
+  {
+    memset(&stats, 0, sizeof(stats));
+    frameStarted = true;
+  }
+  else
+  {
+    nsecs_t threadTime = thread - frameThreadStart;
+    stats.frames++;
+    stats.threadTime += threadTime;
+    stats.maxThreadTime = threadTime > stats.maxThreadTime ? threadTime : stats.maxThreadTime;
+    stats.processTime += process - frameProcessStart;
+    stats.wallTime += wall - frameWallStart;
+  }
+  frameThreadStart = thread;
+  frameProcessStart = process;
+  frameWallStart = wall;
+}
+
+void nullglPrintStats(const char* label)
+{
+  if (stats.frames == 0)
+  {
+    return;
+  }
+
+  double frames = stats.frames;
+  unsigned int total = 0;
+  int order[NULLGL_CALL_COUNT];
+  int used = 0;
+  for (int i = 0; i < NULLGL_CALL_COUNT; i++)
+  {
+    total += stats.calls[i];
+    if (stats.calls[i] == 0)
+    {
+      continue;
+    }
+    /* Most frequent first. */
+    int j = used++;
+    for (; j > 0 && stats.calls[order[j - 1]] < stats.calls[i]; j--)
+    {
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+  }
+
+  fprintf(stderr, "nullgl (%s): %u frames, CPU %.3f ms/frame thread (max %.3f), %.3f process, "
+          "%.3f ms wall; %.1f calls, %.1f draws, %.0f vertices per frame\n",
+          label, stats.frames, stats.threadTime / frames / 1e6, stats.maxThreadTime / 1e6,
+          stats.processTime / frames / 1e6, stats.wallTime / frames / 1e6,
+          total / frames, stats.draws / frames, stats.vertices / frames);
+  for (int i = 0; i < used; i++)
+  {
+    fprintf(stderr, "nullgl:   %-28s %8.2f\n", callNames[order[i]], stats.calls[order[i]] / frames);
+  }
+  memset(&stats, 0, sizeof(stats));
+}
+
+/* Object names are indices into the object tables, 0 is never handed out. */
+#define OBJECT(table, name) \
+  ((name) > 0 && (name) < sizeof(context.table) / sizeof(context.table[0]) && context.table[name].used ? \
+   &context.table[name] : NULL)
+
+#define GEN_OBJECTS(table, n, names)                                             \
+  do {                                                                           \
+    GLuint next = 1;                                                             \
+    for (GLsizei i = 0; i < (n); i++)                                            \
+    {                                                                            \
+      while (next < sizeof(context.table) / sizeof(context.table[0]) &&          \
+             context.table[next].used)                                           \
+      {                                                                          \
+        next++;                                                                  \
+      }                                                                          \
+      if (next == sizeof(context.table) / sizeof(context.table[0]))              \
+      {                                                                          \
+        setError(GL_OUT_OF_MEMORY);                                              \
+        (names)[i] = 0;                                                          \
+        continue;                                                                \
+      }                                                                          \
+      memset(&context.table[next], 0, sizeof(context.table[next]));              \
+      context.table[next].used = true;                                           \
+      (names)[i] = next;                                                         \
+    }                                                                            \
+  } while (0)
+
+static int textureTargetIndex(GLenum target)
+{
+  switch (target)
+  {
+    case GL_TEXTURE_2D:           return 0;
+    case GL_TEXTURE_EXTERNAL_OES: return 1;
+    default:                      return -1;
+  }
+}
+
+/* The texture bound to target on the active unit. */
+static TextureObject* boundTexture(GLenum target)
+{
+  int index = textureTargetIndex(target);
+  if (index < 0)
+  {
+    setError(GL_INVALID_ENUM);
+    return NULL;
+  }
+  TextureObject* texture = OBJECT(textures, context.boundTextures[context.activeTexture - GL_TEXTURE0][index]);
+  if (texture == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+  }
+  return texture;
+}
+
+/* Whether the bound framebuffer can be drawn to. */
+static bool framebufferComplete(void)
+{
+  if (context.framebuffer == 0)
+  {
+    return context.hasSurface;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  TextureObject* texture = framebuffer ? OBJECT(textures, framebuffer->colorTexture) : NULL;
+  if (texture == NULL || texture->width == 0 || texture->height == 0)
+  {
+    return false;
+  }
+  /* Attachments must all be the same size. */
+  RenderbufferObject* depth = OBJECT(renderbuffers, framebuffer->depthRenderbuffer);
+  return framebuffer->depthRenderbuffer == 0 ||
+         (depth != NULL && depth->width == texture->width && depth->height == texture->height);
+}
+
+/* Depth bits of the bound framebuffer. */
+static GLint depthBits(void)
+{
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (context.framebuffer == 0)
+  {
+    return 24;
+  }
+  return framebuffer != NULL && OBJECT(renderbuffers, framebuffer->depthRenderbuffer) != NULL ? 16 : 0;
+}
+
+/* State. */
+
+GLenum glGetError(void)
+{
+  COUNT(glGetError);
+  GLenum error = context.error;
+  context.error = GL_NO_ERROR;
+  return error;
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+  COUNT(glGetString);
+  switch (name)
+  {
+    case GL_VENDOR:                   return (const GLubyte*)"gl2-cube";
+    case GL_RENDERER:                 return (const GLubyte*)"nullgl";
+    case GL_VERSION:                  return (const GLubyte*)"OpenGL ES 2.0 nullgl";
+    case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"OpenGL ES GLSL ES 1.00";
+    case GL_EXTENSIONS:               return (const GLubyte*)"GL_OES_vertex_half_float GL_OES_EGL_image_external";
+    default:
+      setError(GL_INVALID_ENUM);
+      return NULL;
+  }
+}
+
+void glGetIntegerv(GLenum name, GLint* params)
+{
+  COUNT(glGetIntegerv);
+  switch (name)
+  {
+    case GL_MAX_VERTEX_ATTRIBS:                 *params = NULLGL_MAX_ATTRIBS; break;
+    case GL_MAX_TEXTURE_SIZE:                   *params = NULLGL_MAX_TEXTURE_SIZE; break;
+    case GL_MAX_TEXTURE_IMAGE_UNITS:
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:   *params = NULLGL_MAX_TEXTURE_UNITS; break;
+    case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS:     *params = 0; break;
+    case GL_MAX_VERTEX_UNIFORM_VECTORS:         *params = 128; break;
+    case GL_MAX_FRAGMENT_UNIFORM_VECTORS:       *params = 16; break;
+    case GL_MAX_VARYING_VECTORS:                *params = 8; break;
+    case GL_MAX_RENDERBUFFER_SIZE:              *params = NULLGL_MAX_TEXTURE_SIZE; break;
+    case GL_MAX_VIEWPORT_DIMS:                  params[0] = params[1] = NULLGL_MAX_TEXTURE_SIZE; break;
+    case GL_NUM_COMPRESSED_TEXTURE_FORMATS:
+    case GL_NUM_SHADER_BINARY_FORMATS:
+    case GL_NUM_PROGRAM_BINARY_FORMATS_OES:     *params = 0; break;
+    case GL_RED_BITS:
+    case GL_GREEN_BITS:
+    case GL_BLUE_BITS:
+    case GL_ALPHA_BITS:                         *params = 8; break;
+    case GL_DEPTH_BITS:                         *params = depthBits(); break;
+    case GL_STENCIL_BITS:                       *params = 0; break;
+    case GL_VIEWPORT:                           memcpy(params, context.viewport, 4 * sizeof(GLint)); break;
+    case GL_SCISSOR_BOX:                        memcpy(params, context.scissor, 4 * sizeof(GLint)); break;
+    case GL_CURRENT_PROGRAM:                    *params = context.program; break;
+    case GL_ARRAY_BUFFER_BINDING:               *params = context.arrayBuffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER_BINDING:       *params = context.elementArrayBuffer; break;
+    case GL_FRAMEBUFFER_BINDING:                *params = context.framebuffer; break;
+    case GL_ACTIVE_TEXTURE:                     *params = context.activeTexture; break;
+    case GL_TEXTURE_BINDING_2D:
+      *params = context.boundTextures[context.activeTexture - GL_TEXTURE0][0];
+      break;
+    case GL_UNPACK_ALIGNMENT:                   *params = context.unpackAlignment; break;
+    case GL_PACK_ALIGNMENT:                     *params = context.packAlignment; break;
+    default:
+      setError(GL_INVALID_ENUM);
+      break;
+  }
+}
+
+static bool* capability(GLenum cap)
+{
+  switch (cap)
+  {
+    case GL_BLEND:        return &context.blend;
+    case GL_CULL_FACE:    return &context.cullFace;
+    case GL_DEPTH_TEST:   return &context.depthTest;
+    case GL_SCISSOR_TEST: return &context.scissorTest;
+    default:              return NULL;
+  }
+}
+
+void glEnable(GLenum cap)
+{
+  COUNT(glEnable);
+  bool* value = capability(cap);
+  if (value != NULL)
+  {
+    *value = true;
+  }
+  else if (cap != GL_DITHER)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glDisable(GLenum cap)
+{
+  COUNT(glDisable);
+  bool* value = capability(cap);
+  if (value != NULL)
+  {
+    *value = false;
+  }
+  else if (cap != GL_DITHER)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+GLboolean glIsEnabled(GLenum cap)
+{
+  COUNT(glIsEnabled);
+  bool* value = capability(cap);
+  if (value == NULL)
+  {
+    setError(GL_INVALID_ENUM);
+    return GL_FALSE;
+  }
+  return *value ? GL_TRUE : GL_FALSE;
+}
+
+void glCullFace(GLenum mode)
+{
+  COUNT(glCullFace);
+  if (mode != GL_FRONT && mode != GL_BACK && mode != GL_FRONT_AND_BACK)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glFrontFace(GLenum mode)
+{
+  COUNT(glFrontFace);
+  if (mode != GL_CW && mode != GL_CCW)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glDepthFunc(GLenum func)
+{
+  COUNT(glDepthFunc);
+  if (func < GL_NEVER || func > GL_ALWAYS)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glDepthMask(GLboolean flag)
+{
+  COUNT(glDepthMask);
+}
+
+static bool validBlendFactor(GLenum factor, bool source)
+{
+  switch (factor)
+  {
+    case GL_ZERO:
+    case GL_ONE:
+    case GL_SRC_COLOR:
+    case GL_ONE_MINUS_SRC_COLOR:
+    case GL_DST_COLOR:
+    case GL_ONE_MINUS_DST_COLOR:
+    case GL_SRC_ALPHA:
+    case GL_ONE_MINUS_SRC_ALPHA:
+    case GL_DST_ALPHA:
+    case GL_ONE_MINUS_DST_ALPHA:
+    case GL_CONSTANT_COLOR:
+    case GL_ONE_MINUS_CONSTANT_COLOR:
+    case GL_CONSTANT_ALPHA:
+    case GL_ONE_MINUS_CONSTANT_ALPHA:
+      return true;
+    case GL_SRC_ALPHA_SATURATE:
+      return source;
+    default:
+      return false;
+  }
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+  COUNT(glBlendFunc);
+  if (!validBlendFactor(sfactor, true) || !validBlendFactor(dfactor, false))
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  COUNT(glViewport);
+  if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.viewport[0] = x;
+  context.viewport[1] = y;
+  context.viewport[2] = width < NULLGL_MAX_TEXTURE_SIZE ? width : NULLGL_MAX_TEXTURE_SIZE;
+  context.viewport[3] = height < NULLGL_MAX_TEXTURE_SIZE ? height : NULLGL_MAX_TEXTURE_SIZE;
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  COUNT(glScissor);
+  if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.scissor[0] = x;
+  context.scissor[1] = y;
+  context.scissor[2] = width;
+  context.scissor[3] = height;
+}
+
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+  COUNT(glClearColor);
+}
+
+void glClearDepthf(GLclampf depth)
+{
+  COUNT(glClearDepthf);
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+  COUNT(glPixelStorei);
+  if (param != 1 && param != 2 && param != 4 && param != 8)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  switch (pname)
+  {
+    case GL_UNPACK_ALIGNMENT: context.unpackAlignment = param; break;
+    case GL_PACK_ALIGNMENT:   context.packAlignment = param; break;
+    default:                  setError(GL_INVALID_ENUM); break;
+  }
+}
+
+void glFlush(void)
+{
+  COUNT(glFlush);
+}
+
+void glFinish(void)
+{
+  COUNT(glFinish);
+}
+
+void glClear(GLbitfield mask)
+{
+  COUNT(glClear);
+  if (mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT))
+  {
+    setError(GL_INVALID_VALUE);
+  }
+  else if (!framebufferComplete())
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+  }
+}
+
+/* Nothing is rendered, so the pixels read are left as they are. */
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+  COUNT(glReadPixels);
+  if (format != GL_RGBA || type != GL_UNSIGNED_BYTE)
+  {
+    setError(GL_INVALID_OPERATION);
+  }
+  else if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+  }
+  else if (!framebufferComplete())
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+  }
+}
+
+/* Buffers. */
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+  COUNT(glGenBuffers);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GEN_OBJECTS(buffers, n, buffers);
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+  COUNT(glDeleteBuffers);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  for (GLsizei i = 0; i < n; i++)
+  {
+    BufferObject* buffer = OBJECT(buffers, buffers[i]);
+    if (buffer == NULL)
+    {
+      continue;
+    }
+    buffer->used = false;
+    if (context.arrayBuffer == buffers[i])
+    {
+      context.arrayBuffer = 0;
+    }
+    if (context.elementArrayBuffer == buffers[i])
+    {
+      context.elementArrayBuffer = 0;
+    }
+    for (int j = 0; j < NULLGL_MAX_ATTRIBS; j++)
+    {
+      if (context.attribs[j].buffer == buffers[i])
+      {
+        context.attribs[j].buffer = 0;
+      }
+    }
+  }
+}
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+  COUNT(glBindBuffer);
+  if (target != GL_ARRAY_BUFFER && target != GL_ELEMENT_ARRAY_BUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (buffer != 0 && OBJECT(buffers, buffer) == NULL)
+  {
+    /* Names not from glGenBuffers are valid in ES 2.0; create the object on first bind. */
+    if (buffer >= NULLGL_MAX_BUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.buffers[buffer], 0, sizeof(context.buffers[buffer]));
+    context.buffers[buffer].used = true;
+  }
+  if (target == GL_ARRAY_BUFFER)
+  {
+    context.arrayBuffer = buffer;
+  }
+  else
+  {
+    context.elementArrayBuffer = buffer;
+  }
+}
+
+static BufferObject* boundBuffer(GLenum target)
+{
+  GLuint name;
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:         name = context.arrayBuffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER: name = context.elementArrayBuffer; break;
+    default:
+      setError(GL_INVALID_ENUM);
+      return NULL;
+  }
+  BufferObject* buffer = OBJECT(buffers, name);
+  if (buffer == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+  }
+  return buffer;
+}
+
+/* Only the size is kept, to check updates and index reads against. */
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+  COUNT(glBufferData);
+  if (size < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (usage != GL_STREAM_DRAW && usage != GL_STATIC_DRAW && usage != GL_DYNAMIC_DRAW)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  BufferObject* buffer = boundBuffer(target);
+  if (buffer != NULL)
+  {
+    buffer->size = size;
+  }
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+  COUNT(glBufferSubData);
+  BufferObject* buffer = boundBuffer(target);
+  if (buffer != NULL && (offset < 0 || size < 0 || offset + size > buffer->size))
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+/* Textures. */
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+  COUNT(glGenTextures);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GEN_OBJECTS(textures, n, textures);
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+  COUNT(glDeleteTextures);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  for (GLsizei i = 0; i < n; i++)
+  {
+    TextureObject* texture = OBJECT(textures, textures[i]);
+    if (texture == NULL)
+    {
+      continue;
+    }
+    texture->used = false;
+    for (int unit = 0; unit < NULLGL_MAX_TEXTURE_UNITS; unit++)
+    {
+      for (int j = 0; j < 2; j++)
+      {
+        if (context.boundTextures[unit][j] == textures[i])
+        {
+          context.boundTextures[unit][j] = 0;
+        }
+      }
+    }
+  }
+}
+
+void glActiveTexture(GLenum texture)
+{
+  COUNT(glActiveTexture);
+  if (texture < GL_TEXTURE0 || texture >= GL_TEXTURE0 + NULLGL_MAX_TEXTURE_UNITS)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  context.activeTexture = texture;
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+  COUNT(glBindTexture);
+  int index = textureTargetIndex(target);
+  if (index < 0)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texture != 0 && OBJECT(textures, texture) == NULL)
+  {
+    if (texture >= NULLGL_MAX_TEXTURES)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.textures[texture], 0, sizeof(context.textures[texture]));
+    context.textures[texture].used = true;
+  }
+  context.boundTextures[context.activeTexture - GL_TEXTURE0][index] = texture;
+}
+
+static bool validTexParameter(GLenum pname, GLint param)
+{
+  switch (pname)
+  {
+    case GL_TEXTURE_MIN_FILTER:
+      return param == GL_NEAREST || param == GL_LINEAR ||
+             param == GL_NEAREST_MIPMAP_NEAREST || param == GL_LINEAR_MIPMAP_NEAREST ||
+             param == GL_NEAREST_MIPMAP_LINEAR || param == GL_LINEAR_MIPMAP_LINEAR;
+    case GL_TEXTURE_MAG_FILTER:
+      return param == GL_NEAREST || param == GL_LINEAR;
+    case GL_TEXTURE_WRAP_S:
+    case GL_TEXTURE_WRAP_T:
+      return param == GL_REPEAT || param == GL_CLAMP_TO_EDGE || param == GL_MIRRORED_REPEAT;
+    default:
+      return false;
+  }
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+  COUNT(glTexParameteri);
+  if (boundTexture(target) != NULL && !validTexParameter(pname, param))
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+  COUNT(glTexParameterf);
+  if (boundTexture(target) != NULL && !validTexParameter(pname, (GLint)param))
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+/* Whether format and type are a valid ES 2.0 client pixel format. */
+static bool validPixelFormat(GLenum format, GLenum type)
+{
+  switch (type)
+  {
+    case GL_UNSIGNED_BYTE:
+      return format == GL_RGBA || format == GL_RGB || format == GL_LUMINANCE_ALPHA ||
+             format == GL_LUMINANCE || format == GL_ALPHA;
+    case GL_UNSIGNED_SHORT_5_6_5:   return format == GL_RGB;
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1: return format == GL_RGBA;
+    default:                        return false;
+  }
+}
+
+/* The texel data is not looked at, only the level 0 size is kept. */
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                  GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+  COUNT(glTexImage2D);
+  if (target != GL_TEXTURE_2D)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (level < 0 || width < 0 || height < 0 || border != 0 ||
+      width > NULLGL_MAX_TEXTURE_SIZE || height > NULLGL_MAX_TEXTURE_SIZE)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if ((GLenum)internalformat != format || !validPixelFormat(format, type))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  TextureObject* texture = boundTexture(target);
+  if (texture != NULL && level == 0)
+  {
+    texture->width  = width;
+    texture->height = height;
+  }
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+                     GLenum format, GLenum type, const GLvoid* pixels)
+{
+  COUNT(glTexSubImage2D);
+  if (target != GL_TEXTURE_2D)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (!validPixelFormat(format, type))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  TextureObject* texture = boundTexture(target);
+  if (texture == NULL || level > 0)
+  {
+    return;
+  }
+  if (level < 0 || xoffset < 0 || yoffset < 0 || width < 0 || height < 0 ||
+      xoffset + width > texture->width || yoffset + height > texture->height)
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+/* Framebuffers. */
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+  COUNT(glGenFramebuffers);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GEN_OBJECTS(framebuffers, n, framebuffers);
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+  COUNT(glDeleteFramebuffers);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  for (GLsizei i = 0; i < n; i++)
+  {
+    FramebufferObject* framebuffer = OBJECT(framebuffers, framebuffers[i]);
+    if (framebuffer != NULL)
+    {
+      framebuffer->used = false;
+      if (context.framebuffer == framebuffers[i])
+      {
+        context.framebuffer = 0;
+      }
+    }
+  }
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+  COUNT(glBindFramebuffer);
+  if (target != GL_FRAMEBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (framebuffer != 0 && OBJECT(framebuffers, framebuffer) == NULL)
+  {
+    if (framebuffer >= NULLGL_MAX_FRAMEBUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.framebuffers[framebuffer], 0, sizeof(context.framebuffers[framebuffer]));
+    context.framebuffers[framebuffer].used = true;
+  }
+  context.framebuffer = framebuffer;
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+  COUNT(glFramebufferTexture2D);
+  if (target != GL_FRAMEBUFFER || textarget != GL_TEXTURE_2D ||
+      (attachment != GL_COLOR_ATTACHMENT0 && attachment != GL_DEPTH_ATTACHMENT &&
+       attachment != GL_STENCIL_ATTACHMENT))
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer == NULL || (texture != 0 && OBJECT(textures, texture) == NULL))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (level != 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (attachment == GL_COLOR_ATTACHMENT0)
+  {
+    framebuffer->colorTexture = texture;
+  }
+}
+
+GLenum glCheckFramebufferStatus(GLenum target)
+{
+  COUNT(glCheckFramebufferStatus);
+  if (target != GL_FRAMEBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return 0;
+  }
+  if (context.framebuffer == 0 || framebufferComplete())
+  {
+    return GL_FRAMEBUFFER_COMPLETE;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer->colorTexture == 0)
+  {
+    return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+  }
+  TextureObject* texture = OBJECT(textures, framebuffer->colorTexture);
+  RenderbufferObject* depth = OBJECT(renderbuffers, framebuffer->depthRenderbuffer);
+  if (texture != NULL && texture->width > 0 && depth != NULL &&
+      (depth->width != texture->width || depth->height != texture->height))
+  {
+    return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
+  }
+  return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+}
+
+/* Renderbuffers, only as depth attachments. */
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+  COUNT(glGenRenderbuffers);
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GEN_OBJECTS(renderbuffers, n, renderbuffers);
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+  COUNT(glBindRenderbuffer);
+  if (target != GL_RENDERBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (renderbuffer != 0 && OBJECT(renderbuffers, renderbuffer) == NULL)
+  {
+    if (renderbuffer >= NULLGL_MAX_RENDERBUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.renderbuffers[renderbuffer], 0, sizeof(context.renderbuffers[renderbuffer]));
+    context.renderbuffers[renderbuffer].used = true;
+  }
+  context.renderbuffer = renderbuffer;
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+  COUNT(glRenderbufferStorage);
+  if (target != GL_RENDERBUFFER ||
+      (internalformat != GL_DEPTH_COMPONENT16 && internalformat != GL_RGBA4 &&
+       internalformat != GL_RGB5_A1 && internalformat != GL_RGB565 && internalformat != GL_STENCIL_INDEX8))
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (width < 0 || height < 0 || width > NULLGL_MAX_TEXTURE_SIZE || height > NULLGL_MAX_TEXTURE_SIZE)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  RenderbufferObject* renderbuffer = OBJECT(renderbuffers, context.renderbuffer);
+  if (renderbuffer == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  renderbuffer->format = internalformat;
+  renderbuffer->width  = width;
+  renderbuffer->height = height;
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+  COUNT(glFramebufferRenderbuffer);
+  if (target != GL_FRAMEBUFFER || renderbuffertarget != GL_RENDERBUFFER ||
+      (attachment != GL_COLOR_ATTACHMENT0 && attachment != GL_DEPTH_ATTACHMENT &&
+       attachment != GL_STENCIL_ATTACHMENT))
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer == NULL || (renderbuffer != 0 && OBJECT(renderbuffers, renderbuffer) == NULL))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (attachment == GL_DEPTH_ATTACHMENT)
+  {
+    framebuffer->depthRenderbuffer = renderbuffer;
+  }
+}
+
+/* Shaders and programs. */
+
+GLuint glCreateShader(GLenum type)
+{
+  COUNT(glCreateShader);
+  if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER)
+  {
+    setError(GL_INVALID_ENUM);
+    return 0;
+  }
+  GLuint name;
+  GEN_OBJECTS(shaders, 1, &name);
+  if (name != 0)
+  {
+    context.shaders[name].type = type;
+  }
+  return name;
+}
+
+void glDeleteShader(GLuint shader)
+{
+  COUNT(glDeleteShader);
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object != NULL)
+  {
+    /* Programs copy what they need at link time, so this can free at once. */
+    free(object->source);
+    memset(object, 0, sizeof(*object));
+  }
+  else if (shader != 0)
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+/* Headers generated from the Khronos XML registry made the strings const. */
+#ifdef GL_GLES_PROTOTYPES
+typedef const GLchar* const* ShaderSourceStrings;
+#else
+typedef const GLchar** ShaderSourceStrings;
+#endif
+
+void glShaderSource(GLuint shader, GLsizei count, ShaderSourceStrings string, const GLint* length)
+{
+  COUNT(glShaderSource);
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL || count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  size_t total = 0;
+  for (GLsizei i = 0; i < count; i++)
+  {
+    total += length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+  }
+  char* source = (char*)malloc(total + 1);
+  if (source == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  size_t offset = 0;
+  for (GLsizei i = 0; i < count; i++)
+  {
+    size_t part = length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+    memcpy(source + offset, string[i], part);
+    offset += part;
+  }
+  source[total] = '\0';
+
+  free(object->source);
+  object->source = source;
+  object->sourceLength = total;
+}
+
+/*
+ * GLSL is not compiled, but enough of it is understood to tell the application the truth
+ * about its interface: the preprocessor conditionals are evaluated, and the attribute and
+ * uniform declarations left are collected, active if their name is used again after them.
+ */
+
+static bool isIdentifierChar(char c)
+{
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+static const char* skipSpaces(const char* p, const char* end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+  {
+    p++;
+  }
+  return p;
+}
+
+/* Skips whitespace including line ends. */
+static const char* skipBlank(const char* p, const char* end)
+{
+  while (p < end && isspace((unsigned char)*p))
+  {
+    p++;
+  }
+  return p;
+}
+
+/* Copies the identifier at p into name, returning the end of it or NULL if there is none. */
+static const char* readIdentifier(const char* p, const char* end, char* name)
+{
+  const char* start = p;
+  while (p < end && isIdentifierChar(*p))
+  {
+    p++;
+  }
+  if (p == start || isdigit((unsigned char)*start) || p - start >= NULLGL_MAX_NAME)
+  {
+    return NULL;
+  }
+  memcpy(name, start, p - start);
+  name[p - start] = '\0';
+  return p;
+}
+
+struct Preprocessor
+{
+  char  defines[NULLGL_MAX_DEFINES][NULLGL_MAX_NAME];
+  int   defineCount;
+  /* Per open conditional: whether its current branch is kept and whether one was. */
+  bool  active[NULLGL_MAX_NESTING + 1];
+  bool  taken[NULLGL_MAX_NESTING + 1];
+  int   depth;
+};
+
+static bool isDefined(const Preprocessor& pp, const char* name)
+{
+  for (int i = 0; i < pp.defineCount; i++)
+  {
+    if (strcmp(pp.defines[i], name) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Evaluates terms of the form [!]defined(NAME), [!]defined NAME, 0 or 1 joined by && and ||. */
+static bool evaluateCondition(const Preprocessor& pp, const char* p, const char* end, bool* result)
+{
+  bool any = false;
+  bool all = true;
+  for (;;)
+  {
+    p = skipSpaces(p, end);
+    bool negate = false;
+    while (p < end && *p == '!')
+    {
+      negate = !negate;
+      p = skipSpaces(p + 1, end);
+    }
+
+    bool value;
+    char name[NULLGL_MAX_NAME];
+    if (p < end && (*p == '0' || *p == '1'))
+    {
+      value = *p++ == '1';
+    }
+    else if (end - p > 7 && strncmp(p, "defined", 7) == 0 && !isIdentifierChar(p[7]))
+    {
+      p = skipSpaces(p + 7, end);
+      bool parenthesized = p < end && *p == '(';
+      p = skipSpaces(p + parenthesized, end);
+      if ((p = readIdentifier(p, end, name)) == NULL)
+      {
+        return false;
+      }
+      p = skipSpaces(p, end);
+      if (parenthesized && (p == end || *p++ != ')'))
+      {
+        return false;
+      }
+      value = isDefined(pp, name);
+    }
+    else
+    {
+      return false;
+    }
+    all = all && (value != negate);
+
+    p = skipSpaces(p, end);
+    if (p == end)
+    {
+      *result = any || all;
+      return true;
+    }
+    if (end - p < 2 || p[0] != p[1] || (p[0] != '&' && p[0] != '|'))
+    {
+      return false;
+    }
+    if (p[0] == '|')
+    {
+      any = any || all;
+      all = true;
+    }
+    p += 2;
+  }
+}
+
+/*
+ * Runs the directives of the source, writing the lines that survive them to out (which has
+ * room for the whole source) with comments removed. Returns false with a message in log if a
+ * directive cannot be handled.
+ */
+static bool preprocess(const char* source, char* out, char* log)
+{
+  Preprocessor pp;
+  pp.defineCount = 0;
+  pp.depth = 0;
+  pp.active[0] = true;
+  pp.taken[0] = true;
+
+  char* o = out;
+  bool inComment = false;
+  for (const char* line = source; *line != '\0';)
+  {
+    const char* end = strchr(line, '\n');
+    end = end ? end : line + strlen(line);
+    const char* p = skipSpaces(line, end);
+
+    if (!inComment && p < end && *p == '#')
+    {
+      char directive[NULLGL_MAX_NAME] = "";
+      char name[NULLGL_MAX_NAME];
+      p = skipSpaces(p + 1, end);
+      if (p < end && (p = readIdentifier(p, end, directive)) == NULL)
+      {
+        snprintf(log, NULLGL_MAX_LOG, "ERROR: bad preprocessor directive\n");
+        return false;
+      }
+      p = skipSpaces(p ? p : end, end);
+      const char* comment = strstr(p, "//");
+      const char* argumentEnd = comment && comment < end ? comment : end;
+      bool parentActive = pp.active[pp.depth];
+      bool value;
+
+      if (strcmp(directive, "ifdef") == 0 || strcmp(directive, "ifndef") == 0 || strcmp(directive, "if") == 0)
+      {
+        if (pp.depth == NULLGL_MAX_NESTING)
+        {
+          snprintf(log, NULLGL_MAX_LOG, "ERROR: conditionals nested too deeply\n");
+          return false;
+        }
+        if (directive[2] == '\0')
+        {
+          if (!evaluateCondition(pp, p, argumentEnd, &value))
+          {
+            snprintf(log, NULLGL_MAX_LOG, "ERROR: unsupported #if expression\n");
+            return false;
+          }
+        }
+        else
+        {
+          if (readIdentifier(p, argumentEnd, name) == NULL)
+          {
+            snprintf(log, NULLGL_MAX_LOG, "ERROR: #%s without a name\n", directive);
+            return false;
+          }
+          value = isDefined(pp, name) == (directive[2] == 'd');
+        }
+        pp.depth++;
+        pp.active[pp.depth] = parentActive && value;
+        pp.taken[pp.depth] = value;
+      }
+      else if (strcmp(directive, "elif") == 0 || strcmp(directive, "else") == 0)
+      {
+        if (pp.depth == 0)
+        {
+          snprintf(log, NULLGL_MAX_LOG, "ERROR: #%s without #if\n", directive);
+          return false;
+        }
+        value = true;
+        if (directive[2] == 'i' && !evaluateCondition(pp, p, argumentEnd, &value))
+        {
+          snprintf(log, NULLGL_MAX_LOG, "ERROR: unsupported #elif expression\n");
+          return false;
+        }
+        value = value && !pp.taken[pp.depth];
+        pp.active[pp.depth] = pp.active[pp.depth - 1] && value;
+        pp.taken[pp.depth] = pp.taken[pp.depth] || value;
+      }
+      else if (strcmp(directive, "endif") == 0)
+      {
+        if (pp.depth == 0)
+        {
+          snprintf(log, NULLGL_MAX_LOG, "ERROR: #endif without #if\n");
+          return false;
+        }
+        pp.depth--;
+      }
+      else if (pp.active[pp.depth] && strcmp(directive, "define") == 0)
+      {
+        if (readIdentifier(p, argumentEnd, name) == NULL)
+        {
+          snprintf(log, NULLGL_MAX_LOG, "ERROR: #define without a name\n");
+          return false;
+        }
+        if (!isDefined(pp, name))
+        {
+          if (pp.defineCount == NULLGL_MAX_DEFINES)
+          {
+            snprintf(log, NULLGL_MAX_LOG, "ERROR: too many macros\n");
+            return false;
+          }
+          strcpy(pp.defines[pp.defineCount++], name);
+        }
+      }
+      else if (pp.active[pp.depth] && strcmp(directive, "undef") == 0)
+      {
+        for (int i = 0; readIdentifier(p, argumentEnd, name) != NULL && i < pp.defineCount; i++)
+        {
+          if (strcmp(pp.defines[i], name) == 0)
+          {
+            strcpy(pp.defines[i], pp.defines[--pp.defineCount]);
+          }
+        }
+      }
+      /* #version, #extension, #pragma and #line do not change the interface. */
+    }
+    else if (pp.active[pp.depth])
+    {
+      for (p = line; p < end; p++)
+      {
+        if (inComment)
+        {
+          if (p[0] == '*' && p + 1 < end && p[1] == '/')
+          {
+            inComment = false;
+            p++;
+          }
+        }
+        else if (p[0] == '/' && p + 1 < end && p[1] == '/')
+        {
+          break;
+        }
+        else if (p[0] == '/' && p + 1 < end && p[1] == '*')
+        {
+          inComment = true;
+          *o++ = ' ';
+          p++;
+        }
+        else
+        {
+          *o++ = *p;
+        }
+      }
+      *o++ = '\n';
+    }
+
+    line = *end ? end + 1 : end;
+  }
+  *o = '\0';
+
+  if (pp.depth != 0)
+  {
+    snprintf(log, NULLGL_MAX_LOG, "ERROR: unterminated #if\n");
+    return false;
+  }
+  return true;
+}
+
+/* The GL type of a GLSL type name, 0 if it cannot be an attribute or uniform. */
+static GLenum glslType(const char* name)
+{
+  static const struct { const char* name; GLenum type; } types[] =
+  {
+    { "float", GL_FLOAT },       { "vec2", GL_FLOAT_VEC2 },   { "vec3", GL_FLOAT_VEC3 },
+    { "vec4", GL_FLOAT_VEC4 },   { "int", GL_INT },           { "ivec2", GL_INT_VEC2 },
+    { "ivec3", GL_INT_VEC3 },    { "ivec4", GL_INT_VEC4 },    { "bool", GL_BOOL },
+    { "bvec2", GL_BOOL_VEC2 },   { "bvec3", GL_BOOL_VEC3 },   { "bvec4", GL_BOOL_VEC4 },
+    { "mat2", GL_FLOAT_MAT2 },   { "mat3", GL_FLOAT_MAT3 },   { "mat4", GL_FLOAT_MAT4 },
+    { "sampler2D", GL_SAMPLER_2D }, { "samplerCube", GL_SAMPLER_CUBE },
+    { "samplerExternalOES", GL_SAMPLER_EXTERNAL_OES }
+  };
+  for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+  {
+    if (strcmp(name, types[i].name) == 0)
+    {
+      return types[i].type;
+    }
+  }
+  return 0;
+}
+
+/* Whether the identifier name occurs in text after position from. */
+static bool usedAfter(const char* text, const char* from, const char* name)
+{
+  size_t length = strlen(name);
+  for (const char* p = strstr(from, name); p != NULL; p = strstr(p + 1, name))
+  {
+    if ((p == text || !isIdentifierChar(p[-1])) && !isIdentifierChar(p[length]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Collects the attribute and uniform declarations of preprocessed source. */
+static bool scanDeclarations(ShaderObject* shader, const char* text)
+{
+  bool hasMain = false;
+  const char* end = text + strlen(text);
+  for (const char* p = text; p < end;)
+  {
+    char word[NULLGL_MAX_NAME];
+    if (!isIdentifierChar(*p) || (p > text && isIdentifierChar(p[-1])))
+    {
+      p++;
+      continue;
+    }
+    const char* next = readIdentifier(p, end, word);
+    if (next == NULL)
+    {
+      while (p < end && isIdentifierChar(*p))
+      {
+        p++;
+      }
+      continue;
+    }
+    p = next;
+    hasMain = hasMain || strcmp(word, "main") == 0;
+
+    bool uniform = strcmp(word, "uniform") == 0;
+    if (!uniform && strcmp(word, "attribute") != 0)
+    {
+      continue;
+    }
+    if (!uniform && shader->type != GL_VERTEX_SHADER)
+    {
+      snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: attribute in a fragment shader\n");
+      return false;
+    }
+
+    char typeName[NULLGL_MAX_NAME];
+    while ((p = readIdentifier(skipBlank(p, end), end, typeName)) != NULL &&
+           (strcmp(typeName, "lowp") == 0 || strcmp(typeName, "mediump") == 0 || strcmp(typeName, "highp") == 0))
+    {
+    }
+    GLenum type = p ? glslType(typeName) : 0;
+    if (type == 0)
+    {
+      snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: unsupported %s type\n", word);
+      return false;
+    }
+
+    /* One or more declarators, "name" or "name[size]", up to the semicolon. */
+    for (;;)
+    {
+      Variable variable;
+      memset(&variable, 0, sizeof(variable));
+      variable.type = type;
+      variable.size = 1;
+      variable.location = -1;
+      if ((p = readIdentifier(skipBlank(p, end), end, variable.name)) == NULL)
+      {
+        snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: %s without a name\n", word);
+        return false;
+      }
+      p = skipBlank(p, end);
+      if (p < end && *p == '[')
+      {
+        variable.size = (GLint)strtol(p + 1, (char**)&p, 10);
+        p = skipBlank(p, end);
+        if (variable.size <= 0 || p == end || *p++ != ']' || !uniform)
+        {
+          snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: bad array size for %s\n", variable.name);
+          return false;
+        }
+        p = skipBlank(p, end);
+      }
+      variable.active = usedAfter(text, p, variable.name);
+
+      int& count = uniform ? shader->uniformCount : shader->attributeCount;
+      if (count == NULLGL_MAX_VARIABLES)
+      {
+        snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: too many %ss\n", word);
+        return false;
+      }
+      (uniform ? shader->uniforms : shader->attributes)[count++] = variable;
+
+      if (p < end && *p == ',')
+      {
+        p++;
+        continue;
+      }
+      if (p == end || *p != ';')
+      {
+        snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: expected ; after %s\n", variable.name);
+        return false;
+      }
+      break;
+    }
+  }
+
+  if (!hasMain)
+  {
+    snprintf(shader->infoLog, NULLGL_MAX_LOG, "ERROR: no main()\n");
+    return false;
+  }
+  return true;
+}
+
+void glCompileShader(GLuint shader)
+{
+  COUNT(glCompileShader);
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  object->compiled = false;
+  object->attributeCount = 0;
+  object->uniformCount = 0;
+  object->infoLog[0] = '\0';
+  if (object->source == NULL)
+  {
+    snprintf(object->infoLog, NULLGL_MAX_LOG, "ERROR: no source\n");
+    return;
+  }
+  char* text = (char*)malloc(object->sourceLength + 2);
+  if (text == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  object->compiled = preprocess(object->source, text, object->infoLog) && scanDeclarations(object, text);
+  free(text);
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+  COUNT(glGetShaderiv);
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  switch (pname)
+  {
+    case GL_SHADER_TYPE:          *params = object->type; break;
+    case GL_COMPILE_STATUS:       *params = object->compiled; break;
+    case GL_DELETE_STATUS:        *params = GL_FALSE; break;
+    case GL_INFO_LOG_LENGTH:      *params = object->infoLog[0] ? strlen(object->infoLog) + 1 : 0; break;
+    case GL_SHADER_SOURCE_LENGTH: *params = object->source ? object->sourceLength + 1 : 0; break;
+    default:                      setError(GL_INVALID_ENUM); break;
+  }
+}
+
+static void copyInfoLog(const char* log, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  GLsizei written = 0;
+  if (bufsize > 0)
+  {
+    written = (GLsizei)strlen(log) < bufsize - 1 ? (GLsizei)strlen(log) : bufsize - 1;
+    memcpy(infolog, log, written);
+    infolog[written] = '\0';
+  }
+  if (length != NULL)
+  {
+    *length = written;
+  }
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  COUNT(glGetShaderInfoLog);
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL || bufsize < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  copyInfoLog(object->infoLog, bufsize, length, infolog);
+}
+
+GLuint glCreateProgram(void)
+{
+  COUNT(glCreateProgram);
+  GLuint name;
+  GEN_OBJECTS(programs, 1, &name);
+  return name;
+}
+
+void glDeleteProgram(GLuint program)
+{
+  COUNT(glDeleteProgram);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object != NULL)
+  {
+    memset(object, 0, sizeof(*object));
+    if (context.program == program)
+    {
+      context.program = 0;
+    }
+  }
+  else if (program != 0)
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+void glAttachShader(GLuint program, GLuint shader)
+{
+  COUNT(glAttachShader);
+  ProgramObject* programObject = OBJECT(programs, program);
+  ShaderObject* shaderObject = OBJECT(shaders, shader);
+  if (programObject == NULL || shaderObject == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GLuint& slot = programObject->shaders[shaderObject->type == GL_VERTEX_SHADER ? 0 : 1];
+  if (slot != 0)
+  {
+    /* Already attached, or another shader of the same type is. */
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  slot = shader;
+}
+
+void glDetachShader(GLuint program, GLuint shader)
+{
+  COUNT(glDetachShader);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || OBJECT(shaders, shader) == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  for (int i = 0; i < 2; i++)
+  {
+    if (object->shaders[i] == shader)
+    {
+      object->shaders[i] = 0;
+      return;
+    }
+  }
+  setError(GL_INVALID_OPERATION);
+}
+
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+  COUNT(glBindAttribLocation);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || index >= NULLGL_MAX_ATTRIBS || strlen(name) >= NULLGL_MAX_NAME)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (strncmp(name, "gl_", 3) == 0)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  /* Takes effect at the next link. */
+  int i = 0;
+  while (i < object->bindingCount && strcmp(object->bindings[i].name, name) != 0)
+  {
+    i++;
+  }
+  if (i == NULLGL_MAX_ATTRIBS)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  strcpy(object->bindings[i].name, name);
+  object->bindings[i].index = index;
+  object->bindingCount += i == object->bindingCount;
+}
+
+/* Assigns attribute locations, bound ones first, and merges the uniforms of both stages. */
+static bool linkInterface(ProgramObject* program, const ShaderObject* vertexShader, const ShaderObject* fragmentShader)
+{
+  bool used[NULLGL_MAX_ATTRIBS] = { false };
+  program->attributeCount = 0;
+  for (int i = 0; i < vertexShader->attributeCount; i++)
+  {
+    if (!vertexShader->attributes[i].active)
+    {
+      continue;
+    }
+    Variable& attribute = program->attributes[program->attributeCount++];
+    attribute = vertexShader->attributes[i];
+    for (int j = 0; j < program->bindingCount; j++)
+    {
+      if (strcmp(program->bindings[j].name, attribute.name) == 0)
+      {
+        attribute.location = program->bindings[j].index;
+      }
+    }
+    if (attribute.location >= 0)
+    {
+      if (used[attribute.location])
+      {
+        snprintf(program->infoLog, NULLGL_MAX_LOG, "ERROR: location %d bound twice\n", attribute.location);
+        return false;
+      }
+      used[attribute.location] = true;
+    }
+  }
+  for (int i = 0, next = 0; i < program->attributeCount; i++)
+  {
+    if (program->attributes[i].location < 0)
+    {
+      while (next < NULLGL_MAX_ATTRIBS && used[next])
+      {
+        next++;
+      }
+      if (next == NULLGL_MAX_ATTRIBS)
+      {
+        snprintf(program->infoLog, NULLGL_MAX_LOG, "ERROR: too many attributes\n");
+        return false;
+      }
+      program->attributes[i].location = next;
+      used[next] = true;
+    }
+  }
+
+  program->uniformCount = 0;
+  GLint location = 0;
+  const ShaderObject* stages[2] = { vertexShader, fragmentShader };
+  for (int stage = 0; stage < 2; stage++)
+  {
+    for (int i = 0; i < stages[stage]->uniformCount; i++)
+    {
+      const Variable& uniform = stages[stage]->uniforms[i];
+      Variable* merged = NULL;
+      for (int j = 0; j < program->uniformCount && merged == NULL; j++)
+      {
+        merged = strcmp(program->uniforms[j].name, uniform.name) == 0 ? &program->uniforms[j] : NULL;
+      }
+      if (merged != NULL)
+      {
+        if (merged->type != uniform.type || merged->size != uniform.size)
+        {
+          snprintf(program->infoLog, NULLGL_MAX_LOG, "ERROR: %s declared differently in each stage\n",
+                   uniform.name);
+          return false;
+        }
+        merged->active = merged->active || uniform.active;
+        continue;
+      }
+      program->uniforms[program->uniformCount++] = uniform;
+    }
+  }
+  for (int i = 0; i < program->uniformCount; i++)
+  {
+    if (program->uniforms[i].active)
+    {
+      program->uniforms[i].location = location;
+      location += program->uniforms[i].size;
+    }
+  }
+  return true;
+}
+
+void glLinkProgram(GLuint program)
+{
+  COUNT(glLinkProgram);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  ShaderObject* vertexShader = OBJECT(shaders, object->shaders[0]);
+  ShaderObject* fragmentShader = OBJECT(shaders, object->shaders[1]);
+  object->linked = false;
+  object->infoLog[0] = '\0';
+  if (vertexShader == NULL || fragmentShader == NULL || !vertexShader->compiled || !fragmentShader->compiled)
+  {
+    snprintf(object->infoLog, NULLGL_MAX_LOG, "ERROR: a compiled vertex and fragment shader must be attached\n");
+    return;
+  }
+  object->linked = linkInterface(object, vertexShader, fragmentShader);
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+  COUNT(glGetProgramiv);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  GLint count = 0;
+  switch (pname)
+  {
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:            *params = object->linked; break;
+    case GL_DELETE_STATUS:              *params = GL_FALSE; break;
+    case GL_INFO_LOG_LENGTH:            *params = object->infoLog[0] ? strlen(object->infoLog) + 1 : 0; break;
+    case GL_ATTACHED_SHADERS:           *params = (object->shaders[0] != 0) + (object->shaders[1] != 0); break;
+    case GL_ACTIVE_ATTRIBUTES:          *params = object->linked ? object->attributeCount : 0; break;
+    case GL_ACTIVE_UNIFORMS:
+      for (int i = 0; object->linked && i < object->uniformCount; i++)
+      {
+        count += object->uniforms[i].active;
+      }
+      *params = count;
+      break;
+    case GL_PROGRAM_BINARY_LENGTH_OES:  *params = 0; break;
+    default:                            setError(GL_INVALID_ENUM); break;
+  }
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  COUNT(glGetProgramInfoLog);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || bufsize < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  copyInfoLog(object->infoLog, bufsize, length, infolog);
+}
+
+/* No binary formats are reported, so there is nothing to save or load. */
+void glGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, GLvoid* binary)
+{
+  COUNT(glGetProgramBinaryOES);
+  if (length != NULL)
+  {
+    *length = 0;
+  }
+  setError(GL_INVALID_OPERATION);
+}
+
+void glProgramBinaryOES(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLint length)
+{
+  COUNT(glProgramBinaryOES);
+  setError(GL_INVALID_ENUM);
+}
+
+void glUseProgram(GLuint program)
+{
+  COUNT(glUseProgram);
+  ProgramObject* object = OBJECT(programs, program);
+  if (program != 0 && (object == NULL || !object->linked))
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return;
+  }
+  context.program = program;
+}
+
+int glGetAttribLocation(GLuint program, const GLchar* name)
+{
+  COUNT(glGetAttribLocation);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || !object->linked)
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return -1;
+  }
+  for (int i = 0; i < object->attributeCount; i++)
+  {
+    if (strcmp(object->attributes[i].name, name) == 0)
+    {
+      return object->attributes[i].location;
+    }
+  }
+  return -1;
+}
+
+/* Accepts "name", and "name[i]" for elements of arrays. */
+int glGetUniformLocation(GLuint program, const GLchar* name)
+{
+  COUNT(glGetUniformLocation);
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || !object->linked)
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return -1;
+  }
+
+  const char* bracket = strchr(name, '[');
+  size_t length = bracket ? (size_t)(bracket - name) : strlen(name);
+  GLint element = bracket ? atoi(bracket + 1) : 0;
+  for (int i = 0; i < object->uniformCount; i++)
+  {
+    const Variable& uniform = object->uniforms[i];
+    if (uniform.active && strncmp(uniform.name, name, length) == 0 && uniform.name[length] == '\0')
+    {
+      return element >= 0 && element < uniform.size ? uniform.location + element : -1;
+    }
+  }
+  return -1;
+}
+
+/*
+ * The active uniform of the current program whose storage location falls in, if count
+ * elements from there can be set with a call taking one of types. Records the error the
+ * call gets and returns NULL otherwise, as it also does without error for location -1.
+ */
+static const Variable* currentUniform(GLint location, GLsizei count, const GLenum* types, int typeCount)
+{
+  if (count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return NULL;
+  }
+  ProgramObject* object = OBJECT(programs, context.program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+    return NULL;
+  }
+  if (location == -1)
+  {
+    return NULL;
+  }
+  for (int i = 0; i < object->uniformCount; i++)
+  {
+    const Variable& uniform = object->uniforms[i];
+    if (!uniform.active || location < uniform.location || location >= uniform.location + uniform.size)
+    {
+      continue;
+    }
+    for (int j = 0; j < typeCount; j++)
+    {
+      if (uniform.type == types[j] && (count <= 1 || uniform.size > 1))
+      {
+        return &uniform;
+      }
+    }
+    break;
+  }
+  setError(GL_INVALID_OPERATION);
+  return NULL;
+}
+
+void glUniform1i(GLint location, GLint x)
+{
+  COUNT(glUniform1i);
+  static const GLenum types[] = { GL_INT, GL_BOOL, GL_SAMPLER_2D, GL_SAMPLER_CUBE, GL_SAMPLER_EXTERNAL_OES };
+  const Variable* uniform = currentUniform(location, 1, types, sizeof(types) / sizeof(types[0]));
+  if (uniform != NULL && uniform->type != GL_INT && uniform->type != GL_BOOL &&
+      (x < 0 || x >= NULLGL_MAX_TEXTURE_UNITS))
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+void glUniform1f(GLint location, GLfloat x)
+{
+  COUNT(glUniform1f);
+  static const GLenum types[] = { GL_FLOAT, GL_BOOL };
+  currentUniform(location, 1, types, sizeof(types) / sizeof(types[0]));
+}
+
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+  COUNT(glUniform4fv);
+  static const GLenum types[] = { GL_FLOAT_VEC4, GL_BOOL_VEC4 };
+  currentUniform(location, count, types, sizeof(types) / sizeof(types[0]));
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+  COUNT(glUniformMatrix4fv);
+  static const GLenum types[] = { GL_FLOAT_MAT4 };
+  if (transpose != GL_FALSE)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  currentUniform(location, count, types, 1);
+}
+
+/* Vertex attributes. */
+
+void glEnableVertexAttribArray(GLuint index)
+{
+  COUNT(glEnableVertexAttribArray);
+  if (index >= NULLGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.attribs[index].enabled = true;
+}
+
+void glDisableVertexAttribArray(GLuint index)
+{
+  COUNT(glDisableVertexAttribArray);
+  if (index >= NULLGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.attribs[index].enabled = false;
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const GLvoid* ptr)
+{
+  COUNT(glVertexAttribPointer);
+  if (index >= NULLGL_MAX_ATTRIBS || size < 1 || size > 4 || stride < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  switch (type)
+  {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT_OES:
+    case GL_FIXED:
+    case GL_FLOAT:
+      break;
+    default:
+      setError(GL_INVALID_ENUM);
+      return;
+  }
+  context.attribs[index].pointer = ptr;
+  context.attribs[index].buffer = context.arrayBuffer;
+}
+
+void glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  COUNT(glVertexAttrib4f);
+  if (index >= NULLGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+  }
+}
+
+/* Drawing. */
+
+/*
+ * The checks every draw makes. Besides the errors ES 2.0 defines, an enabled array the
+ * program reads with neither a buffer nor a pointer is reported as GL_INVALID_OPERATION,
+ * where a real driver would read from address 0.
+ */
+static bool validDraw(GLenum mode, GLsizei count)
+{
+  if (mode > GL_TRIANGLE_FAN)
+  {
+    setError(GL_INVALID_ENUM);
+    return false;
+  }
+  if (count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return false;
+  }
+  if (!framebufferComplete())
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+    return false;
+  }
+  ProgramObject* program = OBJECT(programs, context.program);
+  if (program == NULL)
+  {
+    /* Undefined results but not an error. */
+    return false;
+  }
+  for (int i = 0; i < program->attributeCount; i++)
+  {
+    const VertexAttrib& attrib = context.attribs[program->attributes[i].location];
+    if (attrib.enabled && attrib.buffer == 0 && attrib.pointer == NULL)
+    {
+      setError(GL_INVALID_OPERATION);
+      return false;
+    }
+  }
+  return true;
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+  COUNT(glDrawArrays);
+  if (first < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (validDraw(mode, count))
+  {
+    stats.draws++;
+    stats.vertices += count;
+  }
+}
+
+/* Index reads past the end of the element array buffer, or from no buffer and a NULL
+ * pointer, are GL_INVALID_OPERATION rather than a crash. */
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+  COUNT(glDrawElements);
+  if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (!validDraw(mode, count))
+  {
+    return;
+  }
+  BufferObject* buffer = OBJECT(buffers, context.elementArrayBuffer);
+  size_t end = (size_t)indices + count * (type == GL_UNSIGNED_BYTE ? 1 : 2);
+  if (buffer != NULL ? end > (size_t)buffer->size : indices == NULL && count > 0)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  stats.draws++;
+  stats.vertices += count;
+}
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProgramCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <GLES2/gl2ext.h>
+
+#include <utils/Timers.h>
+
+#include "GLTrace.h"
+
+/* Layout of a cache file: the header followed by binaryLength bytes of program binary. */
+struct ProgramBinaryHeader
+{
+    char        magic[4];
+    uint32_t    version;
+    uint64_t    key;
+    uint32_t    binaryFormat;
+    uint32_t    binaryLength;
+};
+
+static const char programBinaryMagic[4] = { 'G', 'L', '2', 'P' };
+static const uint32_t programBinaryVersion = 1;
+
+/* Upper bound on a binary we are willing to read back. */
+static const uint32_t maxProgramBinaryLength = 4 * 1024 * 1024;
+
+GLuint loadShader(GLenum shaderType, const char* pSource) {
+    GLuint shader = glCreateShader(shaderType);
+    if (shader) {
+        glShaderSource(shader, 1, &pSource, NULL);
+        glCompileShader(shader);
+        GLint compiled = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            GLint infoLen = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
+            if (infoLen) {
+                char* buf = (char*) malloc(infoLen);
+                if (buf) {
+                    glGetShaderInfoLog(shader, infoLen, NULL, buf);
+                    fprintf(stderr, "Could not compile shader %d:\n%s\n",
+                            shaderType, buf);
+                    free(buf);
+                }
+            } else {
+                fprintf(stderr, "Guessing at GL_INFO_LOG_LENGTH size\n");
+                char* buf = (char*) malloc(0x1000);
+                if (buf) {
+                    glGetShaderInfoLog(shader, 0x1000, NULL, buf);
+                    fprintf(stderr, "Could not compile shader %d:\n%s\n",
+                            shaderType, buf);
+                    free(buf);
+                }
+            }
+            glDeleteShader(shader);
+            shader = 0;
+        }
+    }
+    return shader;
+}
+
+GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+                    const char* const* attributeNames) {
+    GLuint vertexShader = loadShader(GL_VERTEX_SHADER, vertexSource);
+    if (!vertexShader) {
+        fprintf(stderr, "vertexShader load error.\n");
+        return 0;
+    }
+
+    GLuint pixelShader = loadShader(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!pixelShader) {
+        fprintf(stderr, "pixelShader load error.\n");
+        glDeleteShader(vertexShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (program) {
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, pixelShader);
+        for (GLuint i = 0; attributeNames && attributeNames[i]; i++) {
+            glBindAttribLocation(program, i, attributeNames[i]);
+        }
+        glLinkProgram(program);
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE) {
+            GLint bufLength = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &bufLength);
+            if (bufLength) {
+                char* buf = (char*) malloc(bufLength);
+                if (buf) {
+                    glGetProgramInfoLog(program, bufLength, NULL, buf);
+                    fprintf(stderr, "Could not link program:\n%s\n", buf);
+                    free(buf);
+                }
+            }
+            glDeleteProgram(program);
+            program = 0;
+        }
+    } else {
+        fprintf(stderr, "glCreateProgram error.\n");
+    }
+
+    /* The program keeps the shaders alive as long as it needs them. */
+    glDeleteShader(vertexShader);
+    glDeleteShader(pixelShader);
+    return program;
+}
+
+/* 64-bit FNV-1a, continued from hash. The terminating zero is included so that
+ * consecutive strings cannot run into each other. */
+static uint64_t hashString(uint64_t hash, const char* text)
+{
+    if (text == NULL) {
+        text = "";
+    }
+    do {
+        hash ^= (unsigned char)*text;
+        hash *= 1099511628211ULL;
+    } while (*text++);
+    return hash;
+}
+
+ProgramCache::ProgramCache(const char* path)
+    : supported(-1), hits(0), misses(0), hitTime(0), missTime(0)
+{
+    directory[0] = '\0';
+    if (path) {
+        strncpy(directory, path, sizeof(directory) - 1);
+        directory[sizeof(directory) - 1] = '\0';
+    }
+}
+
+void ProgramCache::setDirectory(const char* path)
+{
+    directory[0] = '\0';
+    if (path) {
+        strncpy(directory, path, sizeof(directory) - 1);
+        directory[sizeof(directory) - 1] = '\0';
+    }
+    /* Re-evaluated on next use, the new directory may need creating. */
+    supported = -1;
+}
+
+bool ProgramCache::binariesSupported(void)
+{
+    if (supported != -1) {
+        return supported == 1;
+    }
+    supported = 0;
+
+    if (directory[0] == '\0') {
+        return false;
+    }
+
+    const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+    if (extensions == NULL || strstr(extensions, "GL_OES_get_program_binary") == NULL) {
+        fprintf(stderr, "Program cache: GL_OES_get_program_binary not supported.\n");
+        return false;
+    }
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    if (formats <= 0) {
+        fprintf(stderr, "Program cache: no program binary formats.\n");
+        return false;
+    }
+
+    if (mkdir(directory, 0770) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Program cache: could not create %s, %s\n", directory, strerror(errno));
+        return false;
+    }
+
+    supported = 1;
+    return true;
+}
+
+uint64_t ProgramCache::programKey(const char* vertexSource, const char* fragmentSource,
+                                  const char* const* attributeNames) const
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hashString(hash, vertexSource);
+    hash = hashString(hash, fragmentSource);
+    for (int i = 0; attributeNames && attributeNames[i]; i++) {
+        hash = hashString(hash, attributeNames[i]);
+    }
+    hash = hashString(hash, (const char*) glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char*) glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char*) glGetString(GL_VERSION));
+    return hash;
+}
+
+void ProgramCache::binaryPath(uint64_t key, char* path, size_t size) const
+{
+    snprintf(path, size, "%s/%016llx.bin", directory, (unsigned long long)key);
+}
+
+GLuint ProgramCache::loadBinary(uint64_t key)
+{
+    char path[320];
+    binaryPath(key, path, sizeof(path));
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+
+    ProgramBinaryHeader header;
+    void* binary = NULL;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, programBinaryMagic, sizeof(header.magic)) == 0 &&
+                 header.version == programBinaryVersion &&
+                 header.key == key &&
+                 header.binaryLength > 0 &&
+                 header.binaryLength <= maxProgramBinaryLength;
+    if (valid) {
+        binary = malloc(header.binaryLength);
+        valid = binary != NULL && fread(binary, header.binaryLength, 1, file) == 1;
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinaryOES(program, header.binaryFormat, binary, header.binaryLength);
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    free(binary);
+
+    if (program == 0) {
+        fprintf(stderr, "Program cache: discarding unusable binary %s\n", path);
+        unlink(path);
+    }
+    return program;
+}
+
+void ProgramCache::storeBinary(uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0 || (uint32_t)length > maxProgramBinaryLength) {
+        return;
+    }
+
+    void* binary = malloc(length);
+    if (binary == NULL) {
+        return;
+    }
+
+    ProgramBinaryHeader header;
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinaryOES(program, length, &written, &format, binary);
+    if (written <= 0) {
+        free(binary);
+        return;
+    }
+    memcpy(header.magic, programBinaryMagic, sizeof(header.magic));
+    header.version = programBinaryVersion;
+    header.key = key;
+    header.binaryFormat = format;
+    header.binaryLength = written;
+
+    /* Write to a temporary name and rename it so a reader never sees a partial file. */
+    char path[320];
+    char temporaryPath[330];
+    binaryPath(key, path, sizeof(path));
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+
+    FILE* file = fopen(temporaryPath, "wb");
+    if (file != NULL) {
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(binary, written, 1, file) == 1;
+        ok = fclose(file) == 0 && ok;
+        if (!ok || rename(temporaryPath, path) != 0) {
+            fprintf(stderr, "Program cache: could not write %s\n", path);
+            unlink(temporaryPath);
+        }
+    }
+    free(binary);
+}
+
+GLuint ProgramCache::getProgram(const char* vertexSource, const char* fragmentSource,
+                                const char* const* attributeNames)
+{
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    bool useBinaries = binariesSupported();
+    uint64_t key = 0;
+
+    if (useBinaries) {
+        key = programKey(vertexSource, fragmentSource, attributeNames);
+        GLuint program = loadBinary(key);
+        if (program) {
+            hits++;
+            hitTime += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+            return program;
+        }
+    }
+
+    GLuint program = buildProgram(vertexSource, fragmentSource, attributeNames);
+    if (program && useBinaries) {
+        storeBinary(key, program);
+    }
+    misses++;
+    missTime += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    return program;
+}
+
+void ProgramCache::printStats(void) const
+{
+    fprintf(stderr, "Program cache: %u loaded from binary in %.2f ms, %u built from source in %.2f ms\n",
+            hits, hitTime / 1e6, misses, missTime / 1e6);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <GLES2/gl2.h>
+
+/**
+ * \file ProgramCache.h
+ * \brief Shader compilation and an on-disk cache of linked program binaries.
+ */
+
+    /**
+     * \brief Compile a shader.
+     * \param[in] shaderType GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+     * \param[in] pSource The shader source.
+     * \return The shader object, or 0 if it did not compile (the info log is printed).
+     */
+    GLuint loadShader(GLenum shaderType, const char* pSource);
+
+    /**
+     * \brief Compile and link a program from source.
+     * \param[in] attributeNames NULL terminated attribute names bound to locations 0, 1, ... before
+     * linking, or NULL to let the linker assign locations.
+     * \return The linked program, or 0 on failure.
+     */
+    GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+                        const char* const* attributeNames = NULL);
+
+    /**
+     * \brief Stores linked programs through GL_OES_get_program_binary and reloads them on later runs.
+     *
+     * Entries are keyed by a hash of both shader sources, the attribute bindings and the GL_VENDOR, GL_RENDERER and
+     * GL_VERSION strings, so a driver update or a shader change misses the cache. A binary the
+     * driver refuses is deleted and the program is rebuilt from source, which is also the path
+     * taken when the extension or the cache directory is unavailable.
+     */
+    class ProgramCache
+    {
+    public:
+        /**
+         * \param[in] path Directory binaries are stored in, see setDirectory().
+         */
+        ProgramCache(const char* path);
+
+        /**
+         * \brief Set the directory binaries are stored in; NULL or "" disables the disk cache.
+         * The directory is created if it does not exist.
+         */
+        void setDirectory(const char* path);
+
+        /**
+         * \brief Return a linked program for the given sources, from the cache if possible.
+         * \param[in] attributeNames Attribute location bindings, see buildProgram().
+         * \return The program, or 0 if it could neither be loaded nor built.
+         */
+        GLuint getProgram(const char* vertexSource, const char* fragmentSource,
+                          const char* const* attributeNames = NULL);
+
+        /**
+         * \brief Print hit/miss counts and time spent on each path to stderr.
+         */
+        void printStats(void) const;
+
+    private:
+        /* Check for the extension and a usable binary format the first time it is needed. */
+        bool binariesSupported(void);
+        uint64_t programKey(const char* vertexSource, const char* fragmentSource,
+                            const char* const* attributeNames) const;
+        void binaryPath(uint64_t key, char* path, size_t size) const;
+        GLuint loadBinary(uint64_t key);
+        void storeBinary(uint64_t key, GLuint program);
+
+        char            directory[256];
+        int             supported;
+        unsigned int    hits;
+        unsigned int    misses;
+        int64_t         hitTime;
+        int64_t         missTime;
+    };
+
+#endif /* PROGRAMCACHE_H */
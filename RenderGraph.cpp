@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RenderGraph.h"
+
+#include <cstdio>
+#include <cstring>
+
+    /* Visit states used while scheduling. */
+    enum { unvisited, visiting, visited };
+
+    RenderGraph::RenderGraph(void)
+        : resourceCount(0), passCount(0), scheduleCount(0)
+    {
+    }
+
+    int RenderGraph::addResource(const char* name, bool presented)
+    {
+        if (resourceCount == maxResources)
+        {
+            fprintf(stderr, "RenderGraph: too many resources, dropping \"%s\"\n", name);
+            return -1;
+        }
+        resources[resourceCount].name = name;
+        resources[resourceCount].presented = presented;
+        return resourceCount++;
+    }
+
+    int RenderGraph::addPass(const char* name, PassFunction function, void* userData)
+    {
+        if (passCount == maxPasses)
+        {
+            fprintf(stderr, "RenderGraph: too many passes, dropping \"%s\"\n", name);
+            return -1;
+        }
+        Pass& pass = passes[passCount];
+        memset(&pass, 0, sizeof(pass));
+        pass.name = name;
+        pass.function = function;
+        pass.userData = userData;
+        return passCount++;
+    }
+
+    bool RenderGraph::addRead(int pass, int resource)
+    {
+        if (pass < 0 || resource < 0 || passes[pass].readCount == maxPassResources)
+        {
+            return false;
+        }
+        passes[pass].reads[passes[pass].readCount++] = resource;
+        return true;
+    }
+
+    bool RenderGraph::addWrite(int pass, int resource)
+    {
+        if (pass < 0 || resource < 0 || passes[pass].writeCount == maxPassResources)
+        {
+            return false;
+        }
+        passes[pass].writes[passes[pass].writeCount++] = resource;
+        return true;
+    }
+
+    bool RenderGraph::writesTo(const Pass& pass, int resource) const
+    {
+        for (int i = 0; i < pass.writeCount; i++)
+        {
+            if (pass.writes[i] == resource)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RenderGraph::schedulePass(int index, unsigned char* state)
+    {
+        if (state[index] == visited)
+        {
+            return true;
+        }
+        if (state[index] == visiting)
+        {
+            fprintf(stderr, "RenderGraph: cycle through pass \"%s\"\n", passes[index].name);
+            return false;
+        }
+        state[index] = visiting;
+
+        /* Every earlier declared writer of an input runs first. A pass reading and writing the
+         * same resource (e.g. blending onto it) depends on the earlier writers only. */
+        const Pass& pass = passes[index];
+        for (int r = 0; r < pass.readCount; r++)
+        {
+            for (int p = 0; p < passCount; p++)
+            {
+                if (p != index && passes[p].live && writesTo(passes[p], pass.reads[r]) &&
+                    (p < index || !writesTo(pass, pass.reads[r])))
+                {
+                    if (!schedulePass(p, state))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        /* Passes writing the same output keep their declaration order. */
+        for (int w = 0; w < pass.writeCount; w++)
+        {
+            for (int p = 0; p < index; p++)
+            {
+                if (passes[p].live && writesTo(passes[p], pass.writes[w]))
+                {
+                    if (!schedulePass(p, state))
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        state[index] = visited;
+        schedule[scheduleCount++] = index;
+        return true;
+    }
+
+    bool RenderGraph::compile(void)
+    {
+        bool needed[maxResources];
+        unsigned char state[maxPasses];
+
+        for (int r = 0; r < resourceCount; r++)
+        {
+            needed[r] = resources[r].presented;
+        }
+        for (int p = 0; p < passCount; p++)
+        {
+            passes[p].live = false;
+        }
+
+        /* Propagate liveness backwards from the presented resources until nothing changes. */
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (int p = 0; p < passCount; p++)
+            {
+                Pass& pass = passes[p];
+                if (pass.live)
+                {
+                    continue;
+                }
+                for (int w = 0; w < pass.writeCount && !pass.live; w++)
+                {
+                    pass.live = needed[pass.writes[w]];
+                }
+                if (pass.live)
+                {
+                    for (int r = 0; r < pass.readCount; r++)
+                    {
+                        needed[pass.reads[r]] = true;
+                    }
+                    changed = true;
+                }
+            }
+        }
+
+        memset(state, unvisited, sizeof(state));
+        scheduleCount = 0;
+        for (int p = 0; p < passCount; p++)
+        {
+            if (passes[p].live && !schedulePass(p, state))
+            {
+                scheduleCount = 0;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void RenderGraph::execute(void)
+    {
+        for (int i = 0; i < scheduleCount; i++)
+        {
+            const Pass& pass = passes[schedule[i]];
+            pass.function(pass.userData);
+        }
+    }
+
+    void RenderGraph::printSchedule(void) const
+    {
+        fprintf(stderr, "Render graph: %d of %d passes scheduled\n", scheduleCount, passCount);
+        for (int i = 0; i < scheduleCount; i++)
+        {
+            const Pass& pass = passes[schedule[i]];
+            fprintf(stderr, "  %d: %s (", i, pass.name);
+            for (int r = 0; r < pass.readCount; r++)
+            {
+                fprintf(stderr, "%s%s", r ? ", " : "", resources[pass.reads[r]].name);
+            }
+            fprintf(stderr, " -> ");
+            for (int w = 0; w < pass.writeCount; w++)
+            {
+                fprintf(stderr, "%s%s", w ? ", " : "", resources[pass.writes[w]].name);
+            }
+            fprintf(stderr, ")\n");
+        }
+        for (int p = 0; p < passCount; p++)
+        {
+            if (!passes[p].live)
+            {
+                fprintf(stderr, "  culled: %s\n", passes[p].name);
+            }
+        }
+    }
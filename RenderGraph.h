@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+/**
+ * \file RenderGraph.h
+ * \brief A static graph of render passes and the resources they read and write.
+ */
+
+    /**
+     * \brief Schedules render passes from their declared inputs and outputs.
+     *
+     * Resources are named handles (textures, render targets, the window surface); a resource
+     * marked as presented is an output of the whole frame. compile() keeps only the passes
+     * whose writes reach a presented resource, directly or through passes that read them, and
+     * orders them so every pass runs after the passes producing its inputs. Passes whose outputs
+     * are never consumed are culled and never executed.
+     */
+    class RenderGraph
+    {
+    public:
+        /**
+         * \brief A pass body.
+         * \param[in] userData The pointer given to addPass().
+         */
+        typedef void (*PassFunction)(void* userData);
+
+        static const int maxPasses = 16;
+        static const int maxResources = 16;
+        static const int maxPassResources = 4;
+
+        RenderGraph(void);
+
+        /**
+         * \brief Declare a resource.
+         * \param[in] name Name used in debug output.
+         * \param[in] presented True if the resource leaves the frame, e.g. the window surface.
+         * \return The resource handle, or -1 if the graph is full.
+         */
+        int addResource(const char* name, bool presented);
+
+        /**
+         * \brief Declare a pass. Passes are kept in declaration order unless their dependencies require otherwise.
+         * \return The pass handle, or -1 if the graph is full.
+         */
+        int addPass(const char* name, PassFunction function, void* userData);
+
+        /**
+         * \brief Declare that a pass samples or otherwise consumes a resource.
+         * \return false if the pass already has maxPassResources inputs.
+         */
+        bool addRead(int pass, int resource);
+
+        /**
+         * \brief Declare that a pass renders into a resource.
+         * \return false if the pass already has maxPassResources outputs.
+         */
+        bool addWrite(int pass, int resource);
+
+        /**
+         * \brief Cull unused passes and compute the execution order.
+         * \return false if the passes form a cycle; nothing is scheduled in that case.
+         */
+        bool compile(void);
+
+        /**
+         * \brief Run the scheduled passes in order. compile() must have succeeded.
+         */
+        void execute(void);
+
+        /**
+         * \brief Print the schedule and the culled passes to stderr.
+         */
+        void printSchedule(void) const;
+
+        int scheduledPassCount(void) const { return scheduleCount; }
+
+    private:
+        struct Resource
+        {
+            const char* name;
+            bool        presented;
+        };
+
+        struct Pass
+        {
+            const char*     name;
+            PassFunction    function;
+            void*           userData;
+            int             reads[maxPassResources];
+            int             readCount;
+            int             writes[maxPassResources];
+            int             writeCount;
+            bool            live;
+        };
+
+        bool writesTo(const Pass& pass, int resource) const;
+        /* Depth first visit of the producers of a pass; returns false on a cycle. */
+        bool schedulePass(int pass, unsigned char* state);
+
+        Resource    resources[maxResources];
+        int         resourceCount;
+        Pass        passes[maxPasses];
+        int         passCount;
+        int         schedule[maxPasses];
+        int         scheduleCount;
+    };
+
+#endif /* RENDERGRAPH_H */
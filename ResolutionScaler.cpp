@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ResolutionScaler.h"
+#include "Matrix.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include "GLTrace.h"
+
+    const float ResolutionScaler::scaleStep = 0.05f;
+    const float ResolutionScaler::headroom  = 0.85f;
+    const float ResolutionScaler::maxGrowth = 1.1f;
+
+    ResolutionScaler::ResolutionScaler(GLStateCache* state)
+        : state(state), frameBudget(0), minScale(1.0f), maxScale(1.0f),
+          windowWidth(0), windowHeight(0), textureWidth(0), textureHeight(0),
+          texture(0), depthBuffer(0), framebuffer(0),
+          scale(1.0f), scaledWidth(0), scaledHeight(0), pendingProbes(0), pendingTime(0)
+    {
+        resetStats();
+    }
+
+    void ResolutionScaler::configure(nsecs_t frameBudget, float minScale, float maxScale)
+    {
+        this->frameBudget = frameBudget;
+        this->minScale    = minScale;
+        this->maxScale    = maxScale;
+    }
+
+    bool ResolutionScaler::setup(int width, int height)
+    {
+        windowWidth   = width;
+        windowHeight  = height;
+        textureWidth  = (int)ceilf(width * maxScale);
+        textureHeight = (int)ceilf(height * maxScale);
+
+        glGenTextures(1, &texture);
+        state->bindTexture(GL_TEXTURE_2D, texture);
+        /* Not a power of two, so it must clamp and must not be mipmapped. */
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, textureWidth, textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        glGenRenderbuffers(1, &depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, textureWidth, textureHeight);
+
+        glGenFramebuffers(1, &framebuffer);
+        state->bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        state->bindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            fprintf(stderr, "Scaled render target incomplete (0x%x).\n", status);
+            return false;
+        }
+
+        setScale(maxScale);
+        fprintf(stderr, "Resolution scaling: %d x %d render target, scale %.2f-%.2f for %.2f ms frames\n",
+                textureWidth, textureHeight, minScale, maxScale, frameBudget / 1e6);
+        return true;
+    }
+
+    void ResolutionScaler::scaleSize(int* width, int* height) const
+    {
+        int scaled = (int)(*width * scale + 0.5f);
+        *width = scaled > 0 ? scaled : 1;
+        scaled = (int)(*height * scale + 0.5f);
+        *height = scaled > 0 ? scaled : 1;
+    }
+
+    void ResolutionScaler::setScale(float newScale)
+    {
+        scale        = newScale;
+        scaledWidth  = windowWidth;
+        scaledHeight = windowHeight;
+        scaleSize(&scaledWidth, &scaledHeight);
+        if (scaledWidth > textureWidth)
+        {
+            scaledWidth = textureWidth;
+        }
+        if (scaledHeight > textureHeight)
+        {
+            scaledHeight = textureHeight;
+        }
+    }
+
+    void ResolutionScaler::addProbe(nsecs_t frameTime)
+    {
+        probes++;
+        totalProbeTime += frameTime;
+        totalScale     += scale;
+        lowestScale     = scale < lowestScale ? scale : lowestScale;
+        highestScale    = scale > highestScale ? scale : highestScale;
+
+        pendingTime += frameTime;
+        if (++pendingProbes < probesPerStep)
+        {
+            return;
+        }
+        float average = (float)pendingTime / pendingProbes;
+        pendingProbes = 0;
+        pendingTime   = 0;
+
+        /* The scale that would have met the budget, pixels going with its square. */
+        float target = scale;
+        if (average > frameBudget)
+        {
+            target = scale * sqrtf(frameBudget / average);
+        }
+        else if (average < frameBudget * headroom)
+        {
+            target = scale * sqrtf(frameBudget * headroom / average);
+            target = target < scale * maxGrowth ? target : scale * maxGrowth;
+        }
+        else
+        {
+            return;
+        }
+
+        /* Whole steps, rounding towards the cheaper scale, and at least one step down when
+         * over the budget. */
+        target = floorf(target / scaleStep + 0.001f) * scaleStep;
+        if (average > frameBudget && target > scale - scaleStep)
+        {
+            target = scale - scaleStep;
+        }
+        target = target < minScale ? minScale : (target > maxScale ? maxScale : target);
+        if (fabsf(target - scale) > 0.001f)
+        {
+            setScale(target);
+            changes++;
+        }
+    }
+
+    void ResolutionScaler::draw(ShaderVariant* variant)
+    {
+        /* The whole window in clip space, sampling the part of the texture drawn to. The far
+         * edges stop half a texel short, so linear filtering never blends in the texels beyond
+         * them, which hold whatever a larger scale drew there, or nothing yet. */
+        GLfloat right = (scaledWidth - 0.5f) / textureWidth;
+        GLfloat top   = (scaledHeight - 0.5f) / textureHeight;
+        const GLfloat positions[] = { -1.0f, -1.0f,   -1.0f, 1.0f,   1.0f, -1.0f,    1.0f, 1.0f };
+        const GLfloat texCoords[] = { 0.0f, 0.0f,     0.0f, top,     right, 0.0f,    right, top };
+
+        state->useProgram(variant->program);
+        state->bindBuffer(GL_ARRAY_BUFFER, 0);
+        state->enableVertexAttribArray(ATTRIB_POSITION);
+        state->vertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, positions);
+        state->disableVertexAttribArray(ATTRIB_FILL_COLOR);
+        state->enableVertexAttribArray(ATTRIB_TEX_COORD);
+        state->vertexAttribPointer(ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+        state->uniformMatrix4fv(variant->mvp, Matrix::identityMatrix.getAsArray());
+        state->activeTexture(GL_TEXTURE0);
+        state->bindTexture(GL_TEXTURE_2D, texture);
+
+        /* Replaces everything under it, alpha included. */
+        state->disable(GL_DEPTH_TEST);
+        state->disable(GL_CULL_FACE);
+        state->disable(GL_BLEND);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        state->enable(GL_BLEND);
+        state->enable(GL_CULL_FACE);
+        state->enable(GL_DEPTH_TEST);
+    }
+
+    void ResolutionScaler::printStats(const char* label) const
+    {
+        if (probes == 0)
+        {
+            return;
+        }
+        fprintf(stderr, "Resolution (%s): scale %.2f, %.2f/%.2f/%.2f min/avg/max, %u changes, "
+                "probed frames %.3f ms for a %.3f ms budget\n",
+                label, scale, lowestScale, totalScale / probes, highestScale, changes,
+                totalProbeTime / 1e6 / probes, frameBudget / 1e6);
+    }
+
+    void ResolutionScaler::resetStats(void)
+    {
+        probes         = 0;
+        totalProbeTime = 0;
+        totalScale     = 0.0f;
+        lowestScale    = 1e9f;
+        highestScale   = 0.0f;
+        changes        = 0;
+    }
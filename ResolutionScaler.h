@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <GLES2/gl2.h>
+#include <utils/Timers.h>
+
+#include "GLStateCache.h"
+#include "ShaderVariants.h"
+
+/**
+ * \file ResolutionScaler.h
+ * \brief Renders the scene at whatever resolution holds a frame time budget.
+ */
+
+    /**
+     * \brief Picks the resolution the scene is rendered at from measured frame times, and
+     * upscales the result to the window.
+     *
+     * The render target is allocated once at the largest scale and only the bottom left part
+     * of it the current scale covers is drawn to and sampled, so changing the resolution costs
+     * nothing. Every probeInterval frames the frame is finished with glFinish before it is
+     * presented, and the time from the start of the frame, CPU and GPU work included, is
+     * handed to addProbe(). Each probesPerStep probes the scale is moved towards the one that
+     * would have met the budget, assuming the frame time follows the number of pixels: down
+     * as far as needed when over the budget, up by at most maxGrowth when comfortably under
+     * it, in steps of scaleStep so that noise does not make it wander.
+     */
+    class ResolutionScaler
+    {
+    public:
+        /**
+         * \param[in] state State cache the scaler binds and draws through.
+         */
+        ResolutionScaler(GLStateCache* state);
+
+        /**
+         * \brief Set the frame time to hold and the bounds of the scale, a fraction of the
+         * window's width and height in (0, 1].
+         */
+        void configure(nsecs_t frameBudget, float minScale, float maxScale);
+
+        /**
+         * \brief Create the render target for a window of width x height at the largest
+         * scale. Needs a current context.
+         * \return false if the render target is not complete.
+         */
+        bool setup(int width, int height);
+
+        /**
+         * \brief The render target, with a color texture and a depth buffer.
+         */
+        GLuint getFramebuffer(void) const { return framebuffer; }
+
+        /**
+         * \brief Size of the part of the render target the current scale covers.
+         */
+        int getWidth(void) const { return scaledWidth; }
+        int getHeight(void) const { return scaledHeight; }
+
+        float getScale(void) const { return scale; }
+
+        /**
+         * \brief Scale another target's size the same way, at least 1 x 1.
+         */
+        void scaleSize(int* width, int* height) const;
+
+        /**
+         * \brief Whether a frame should be finished and timed for addProbe().
+         */
+        bool probeDue(unsigned int frame) const { return frame % probeInterval == 0; }
+
+        /**
+         * \brief Record the time a probed frame took, possibly changing the scale for the
+         * frames that follow.
+         */
+        void addProbe(nsecs_t frameTime);
+
+        /**
+         * \brief Draw the scaled scene over the whole bound framebuffer, filtered.
+         * \param[in] variant A SHADER_TEXTURE | SHADER_MVP variant.
+         */
+        void draw(ShaderVariant* variant);
+
+        /**
+         * \brief Print the scales used and the probed frame times to stderr.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        /* Frames between probes, and probes averaged for each decision. */
+        static const unsigned int probeInterval = 4;
+        static const int          probesPerStep = 4;
+
+        static const float  scaleStep;
+        /* Fraction of the budget a frame must stay under before the scale goes up. */
+        static const float  headroom;
+        static const float  maxGrowth;
+
+        void setScale(float newScale);
+
+        GLStateCache*   state;
+        nsecs_t         frameBudget;
+        float           minScale;
+        float           maxScale;
+
+        int             windowWidth;
+        int             windowHeight;
+        int             textureWidth;
+        int             textureHeight;
+        GLuint          texture;
+        GLuint          depthBuffer;
+        GLuint          framebuffer;
+
+        float           scale;
+        int             scaledWidth;
+        int             scaledHeight;
+
+        /* Probes since the last decision. */
+        int             pendingProbes;
+        nsecs_t         pendingTime;
+
+        unsigned int    probes;
+        nsecs_t         totalProbeTime;
+        float           totalScale;
+        float           lowestScale;
+        float           highestScale;
+        unsigned int    changes;
+    };
+
+#endif /* RESOLUTIONSCALER_H */
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ShaderVariants.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <GLES2/gl2ext.h>
+
+#include "GLTrace.h"
+
+    /* Names bound to the ShaderAttribute locations. */
+    static const char* const attributeNames[ATTRIB_COUNT + 1] =
+    {
+        "a_v4Position",
+        "a_v4FillColor",
+        "a_v2TexCoord",
+        "a_fInstance",
+        NULL
+    };
+
+    static const char variantVertexShader[] =
+        "attribute vec4 a_v4Position;\n"
+        "#ifdef FEATURE_MVP\n"
+        "uniform mat4 u_m4MVP;\n"
+        "#else\n"
+        "uniform mat4 u_m4Projection;\n"
+        "uniform mat4 u_m4Modelview;\n"
+        "#endif\n"
+        "#ifdef FEATURE_VERTEX_COLOR\n"
+        "attribute vec4 a_v4FillColor;\n"
+        "varying vec4 v_v4FillColor;\n"
+        "#endif\n"
+        "#ifdef FEATURE_TEXTURE\n"
+        "attribute vec2 a_v2TexCoord;\n"
+        "varying vec2 v_v2TexCoord;\n"
+        "#endif\n"
+        "#ifdef FEATURE_INSTANCED\n"
+        "attribute float a_fInstance;\n"
+        "#endif\n"
+        "void main()\n"
+        "{\n"
+        "#ifdef FEATURE_VERTEX_COLOR\n"
+        "   v_v4FillColor = a_v4FillColor;\n"
+        "#endif\n"
+        "#ifdef FEATURE_TEXTURE\n"
+        "   v_v2TexCoord = a_v2TexCoord;\n"
+        "#endif\n"
+        "#ifdef FEATURE_INSTANCED\n"
+        "   int iRow = int(a_fInstance) * 3;\n"
+        "   vec4 v4Position = vec4(dot(u_v4Instances[iRow], a_v4Position),\n"
+        "                          dot(u_v4Instances[iRow + 1], a_v4Position),\n"
+        "                          dot(u_v4Instances[iRow + 2], a_v4Position), 1.0);\n"
+        "#else\n"
+        "   vec4 v4Position = a_v4Position;\n"
+        "#endif\n"
+        "#ifdef FEATURE_MVP\n"
+        "   gl_Position = u_m4MVP * v4Position;\n"
+        "#else\n"
+        "   gl_Position = u_m4Projection * u_m4Modelview * v4Position;\n"
+        "#endif\n"
+        "}\n";
+
+    static const char variantFragmentShader[] =
+        "precision mediump float;\n"
+        "#ifdef FEATURE_VERTEX_COLOR\n"
+        "varying vec4 v_v4FillColor;\n"
+        "#endif\n"
+        "#ifdef FEATURE_TEXTURE\n"
+        "#ifdef FEATURE_TEXTURE_EXTERNAL\n"
+        "uniform samplerExternalOES u_s2dTexture;\n"
+        "#else\n"
+        "uniform sampler2D u_s2dTexture;\n"
+        "#endif\n"
+        "varying vec2 v_v2TexCoord;\n"
+        "#endif\n"
+        "#if defined(FEATURE_VERTEX_COLOR) && defined(FEATURE_TEXTURE)\n"
+        "uniform float u_fTex;\n"
+        "#endif\n"
+        "void main()\n"
+        "{\n"
+        "#if defined(FEATURE_VERTEX_COLOR) && defined(FEATURE_TEXTURE)\n"
+        "   vec4 v4Texel = texture2D(u_s2dTexture, v_v2TexCoord);\n"
+        "   gl_FragColor = mix(v_v4FillColor, v4Texel, u_fTex);\n"
+        "#elif defined(FEATURE_TEXTURE)\n"
+        "   gl_FragColor = texture2D(u_s2dTexture, v_v2TexCoord);\n"
+        "#elif defined(FEATURE_VERTEX_COLOR)\n"
+        "   gl_FragColor = v_v4FillColor;\n"
+        "#else\n"
+        "   gl_FragColor = vec4(1.0);\n"
+        "#endif\n"
+        "}\n";
+
+    bool ShaderVariant::usesAttribute(int attribute) const
+    {
+        switch (attribute)
+        {
+            case ATTRIB_POSITION:   return true;
+            case ATTRIB_FILL_COLOR: return (features & SHADER_VERTEX_COLOR) != 0;
+            case ATTRIB_TEX_COORD:  return (features & SHADER_TEXTURE) != 0;
+            case ATTRIB_INSTANCE:   return (features & SHADER_INSTANCED) != 0;
+            default:                return false;
+        }
+    }
+
+    ShaderVariantCache::ShaderVariantCache(ProgramCache* programCache, GLStateCache* state)
+        : programCache(programCache), state(state)
+    {
+        memset(status, 0, sizeof(status));
+    }
+
+    unsigned int ShaderVariantCache::normalize(unsigned int features)
+    {
+        if (features & SHADER_TEXTURE_EXTERNAL)
+        {
+            features |= SHADER_TEXTURE;
+        }
+        return features & ((1 << SHADER_FEATURE_BITS) - 1);
+    }
+
+    int ShaderVariantCache::instanceCapacity(void)
+    {
+        GLint vectors = 0;
+        glGetIntegerv(GL_MAX_VERTEX_UNIFORM_VECTORS, &vectors);
+        int instances = (vectors - reservedVectors) / 3;
+        return instances < maxInstances ? instances : maxInstances;
+    }
+
+    bool ShaderVariantCache::generateSource(unsigned int features, int instances, GLenum shaderType,
+                                            char* buffer, size_t size)
+    {
+        features = normalize(features);
+
+        /* #extension has to precede any non-preprocessor token, so it goes first. The size of
+         * the transform array is spelled out rather than left to a macro. */
+        int length = snprintf(buffer, size, "%s%s%s%s%s",
+                              (shaderType == GL_FRAGMENT_SHADER && (features & SHADER_TEXTURE_EXTERNAL)) ?
+                                  "#extension GL_OES_EGL_image_external : require\n" : "",
+                              (features & SHADER_VERTEX_COLOR)     ? "#define FEATURE_VERTEX_COLOR\n" : "",
+                              (features & SHADER_TEXTURE)          ? "#define FEATURE_TEXTURE\n" : "",
+                              (features & SHADER_TEXTURE_EXTERNAL) ? "#define FEATURE_TEXTURE_EXTERNAL\n" : "",
+                              (features & SHADER_MVP)              ? "#define FEATURE_MVP\n" : "");
+        if (length >= 0 && (size_t)length < size && (features & SHADER_INSTANCED))
+        {
+            if (shaderType == GL_VERTEX_SHADER)
+            {
+                length += snprintf(buffer + length, size - length,
+                                   "#define FEATURE_INSTANCED\nuniform vec4 u_v4Instances[%d];\n", instances * 3);
+            }
+            else
+            {
+                length += snprintf(buffer + length, size - length, "#define FEATURE_INSTANCED\n");
+            }
+        }
+        if (length < 0 || (size_t)length >= size)
+        {
+            return false;
+        }
+
+        const char* body = shaderType == GL_VERTEX_SHADER ? variantVertexShader : variantFragmentShader;
+        size_t bodyLength = strlen(body);
+        if (length + bodyLength >= size)
+        {
+            return false;
+        }
+        memcpy(buffer + length, body, bodyLength + 1);
+        return true;
+    }
+
+    void ShaderVariantCache::describe(unsigned int features, char* buffer, size_t size)
+    {
+        features = normalize(features);
+        snprintf(buffer, size, "%s%s%s%s%s",
+                 (features & SHADER_VERTEX_COLOR) ? "color " : "",
+                 (features & SHADER_TEXTURE_EXTERNAL) ? "textureExternal " :
+                 (features & SHADER_TEXTURE) ? "texture " : "",
+                 (features & SHADER_VERTEX_COLOR) && (features & SHADER_TEXTURE) ? "mixed " : "",
+                 (features & SHADER_INSTANCED) ? "instanced " : "",
+                 (features & SHADER_MVP) ? "mvp" : "projection*modelview");
+    }
+
+    ShaderVariant* ShaderVariantCache::get(unsigned int features)
+    {
+        features = normalize(features);
+        if (status[features] == 1)
+        {
+            return &variants[features];
+        }
+        if (status[features] == -1)
+        {
+            return NULL;
+        }
+
+        char vertexSource[2048];
+        char fragmentSource[2048];
+        char name[64];
+        describe(features, name, sizeof(name));
+
+        status[features] = -1;
+        int instances = (features & SHADER_INSTANCED) ? instanceCapacity() : 0;
+        if ((features & SHADER_INSTANCED) && instances < 1)
+        {
+            fprintf(stderr, "Shader variant (%s): too few vertex uniform vectors for instancing\n", name);
+            return NULL;
+        }
+        if (!generateSource(features, instances, GL_VERTEX_SHADER, vertexSource, sizeof(vertexSource)) ||
+            !generateSource(features, instances, GL_FRAGMENT_SHADER, fragmentSource, sizeof(fragmentSource)))
+        {
+            fprintf(stderr, "Shader variant (%s): source too long\n", name);
+            return NULL;
+        }
+
+        GLuint program = programCache->getProgram(vertexSource, fragmentSource, attributeNames);
+        if (program == 0)
+        {
+            fprintf(stderr, "Shader variant (%s): could not build program\n", name);
+            return NULL;
+        }
+
+        ShaderVariant& variant = variants[features];
+        variant.features       = features;
+        variant.program        = program;
+        GLStateCache::bindUniformSlot(variant.projection, program, "u_m4Projection");
+        GLStateCache::bindUniformSlot(variant.modelview,  program, "u_m4Modelview");
+        GLStateCache::bindUniformSlot(variant.mvp,        program, "u_m4MVP");
+        GLStateCache::bindUniformSlot(variant.texture,    program, "u_s2dTexture");
+        GLStateCache::bindUniformSlot(variant.textureMix, program, "u_fTex");
+        GLStateCache::bindUniformSlot(variant.instanceTransforms, program, "u_v4Instances");
+        variant.instances      = instances;
+
+        /* The sampler always reads texture unit 0. */
+        state->uniform1i(variant.texture, 0);
+
+        if (instances > 0)
+        {
+            fprintf(stderr, "Shader variant (%s): program %u, %d instances per draw\n", name, program, instances);
+        }
+        else
+        {
+            fprintf(stderr, "Shader variant (%s): program %u\n", name, program);
+        }
+        status[features] = 1;
+        return &variant;
+    }
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+#include <stddef.h>
+
+#include <GLES2/gl2.h>
+
+#include "GLStateCache.h"
+#include "ProgramCache.h"
+
+/**
+ * \file ShaderVariants.h
+ * \brief Cube programs specialized at build time from feature defines.
+ */
+
+    /**
+     * \brief Features a shader variant can be built with. Each one adds a FEATURE_* define
+     * in front of the shared shader source.
+     */
+    enum ShaderFeature
+    {
+        /** Per-vertex color from a_v4FillColor. */
+        SHADER_VERTEX_COLOR         = 1 << 0,
+        /** Texture sampled at a_v2TexCoord; mixed with the vertex color by u_fTex when both are set. */
+        SHADER_TEXTURE              = 1 << 1,
+        /** The texture is a samplerExternalOES (implies SHADER_TEXTURE). */
+        SHADER_TEXTURE_EXTERNAL     = 1 << 2,
+        /** Transform by a single CPU-side combined u_m4MVP instead of u_m4Projection * u_m4Modelview. */
+        SHADER_MVP                  = 1 << 3,
+        /** Several copies of a mesh per draw: each vertex is first transformed by the 4x3 model
+         *  matrix a_fInstance selects from the u_v4Instances array, three rows per copy. */
+        SHADER_INSTANCED            = 1 << 4
+    };
+
+    /**
+     * \brief Number of feature bits, the variant cache has one slot per combination.
+     */
+    #define SHADER_FEATURE_BITS 5
+
+    /**
+     * \brief Attribute locations bound in every variant, so vertex setup is shared.
+     */
+    enum ShaderAttribute
+    {
+        ATTRIB_POSITION,
+        ATTRIB_FILL_COLOR,
+        ATTRIB_TEX_COORD,
+        ATTRIB_INSTANCE,
+        ATTRIB_COUNT
+    };
+
+    /**
+     * \brief A linked variant and a slot per uniform, holding the last uploaded value.
+     * Slots of uniforms the variant lacks have location -1 and ignore uploads.
+     */
+    struct ShaderVariant
+    {
+        unsigned int    features;
+        GLuint          program;
+        UniformSlot     projection;
+        UniformSlot     modelview;
+        UniformSlot     mvp;
+        UniformSlot     texture;
+        UniformSlot     textureMix;
+        UniformSlot     instanceTransforms;
+        /** Copies of a mesh one draw can transform, 0 for variants without SHADER_INSTANCED. */
+        int             instances;
+
+        /**
+         * \brief True if the variant reads the given attribute.
+         */
+        bool usesAttribute(int attribute) const;
+    };
+
+    /**
+     * \brief Builds shader variants on first use and keeps them by feature bits.
+     */
+    class ShaderVariantCache
+    {
+    public:
+        /**
+         * \param[in] programCache Where programs are loaded from or built.
+         * \param[in] state State cache used to set the variants' constant uniforms.
+         */
+        ShaderVariantCache(ProgramCache* programCache, GLStateCache* state);
+
+        /**
+         * \brief Get the variant for a feature combination, building it if needed.
+         * \return The variant, or NULL if it failed to build.
+         */
+        ShaderVariant* get(unsigned int features);
+
+        /**
+         * \brief Generate the source of a variant.
+         * \param[in] instances Size of the transform array of SHADER_INSTANCED variants.
+         * \param[in] shaderType GL_VERTEX_SHADER or GL_FRAGMENT_SHADER.
+         * \return false if the buffer was too small.
+         */
+        static bool generateSource(unsigned int features, int instances, GLenum shaderType,
+                                   char* buffer, size_t size);
+
+        /**
+         * \brief Describe a feature combination as text, for logging.
+         */
+        static void describe(unsigned int features, char* buffer, size_t size);
+
+    private:
+        /* Vertex uniform vectors kept for the matrices next to the instance transforms. */
+        static const int reservedVectors = 8;
+        /* Instance indices are unsigned bytes. */
+        static const int maxInstances = 256;
+
+        /* Canonical feature bits: external implies textured. */
+        static unsigned int normalize(unsigned int features);
+        /* Transforms an instanced variant can hold, from GL_MAX_VERTEX_UNIFORM_VECTORS. */
+        static int instanceCapacity(void);
+
+        ProgramCache*   programCache;
+        GLStateCache*   state;
+        ShaderVariant   variants[1 << SHADER_FEATURE_BITS];
+        /* 0 not built yet, 1 built, -1 failed to build. */
+        signed char     status[1 << SHADER_FEATURE_BITS];
+    };
+
+#endif /* SHADERVARIANTS_H */
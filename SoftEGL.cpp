@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SoftGL.h"
+#include "HostEGL.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The EGL entry points are in HostEGL.cpp; these are the software backend's hooks. */
+
+const char   hosteglVersion[]    = "1.4 softgl";
+const char   hosteglExtensions[] = "EGL_EXT_buffer_age EGL_KHR_swap_buffers_with_damage";
+const EGLint hosteglConfigCaveat = EGL_SLOW_CONFIG;
+
+/* The buffers of each surface, by surface index. */
+static SoftRenderTarget targets[HOSTEGL_MAX_SURFACES];
+
+static const char* dumpPath;
+static unsigned int dumpInterval = 60;
+static unsigned int statsInterval;
+
+void hosteglCount(HostEGLCall call)
+{
+}
+
+void hosteglInitialize(void)
+{
+  const char* interval;
+  dumpPath = getenv("SOFTGL_DUMP");
+  if ((interval = getenv("SOFTGL_DUMP_INTERVAL")) != NULL && atoi(interval) > 0)
+  {
+    dumpInterval = atoi(interval);
+  }
+  if ((interval = getenv("SOFTGL_STATS")) != NULL)
+  {
+    statsInterval = atoi(interval) > 0 ? atoi(interval) : 0;
+  }
+}
+
+void hosteglTerminate(void)
+{
+}
+
+bool hosteglCreateContext(void)
+{
+  return softglCreateContext();
+}
+
+void hosteglDestroyContext(void)
+{
+  softglDestroyContext();
+}
+
+bool hosteglCreateSurface(int surface, EGLint width, EGLint height)
+{
+  SoftRenderTarget& target = targets[surface];
+  size_t pixels = width * height > 0 ? width * height : 1;
+  target.width  = width;
+  target.height = height;
+  target.color  = (uint32_t*)calloc(pixels, sizeof(uint32_t));
+  target.depth  = (float*)malloc(pixels * sizeof(float));
+  if (target.color == NULL || target.depth == NULL)
+  {
+    hosteglDestroySurface(surface);
+    return false;
+  }
+  for (size_t i = 0; i < pixels; i++)
+  {
+    target.depth[i] = 1.0f;
+  }
+  return true;
+}
+
+void hosteglDestroySurface(int surface)
+{
+  free(targets[surface].color);
+  free(targets[surface].depth);
+  memset(&targets[surface], 0, sizeof(targets[surface]));
+}
+
+void hosteglMakeCurrent(int surface, EGLint width, EGLint height)
+{
+  softglMakeCurrent(surface >= 0 ? &targets[surface] : NULL);
+}
+
+/* Dumps the surface and reports statistics as configured by the environment. */
+void hosteglSwapBuffers(int surface, unsigned int swaps)
+{
+  if (dumpPath != NULL && swaps % dumpInterval == 0)
+  {
+    char path[512];
+    snprintf(path, sizeof(path), dumpPath, swaps);
+    if (!softglWritePPM(targets[surface], path))
+    {
+      fprintf(stderr, "softgl: could not write %s\n", path);
+    }
+  }
+  if (statsInterval != 0 && swaps % statsInterval == 0)
+  {
+    char label[64];
+    snprintf(label, sizeof(label), "swaps %u-%u", swaps - statsInterval + 1, swaps);
+    softglPrintStats(label);
+  }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOFTGL_H
+#define SOFTGL_H
+
+#include "SoftRasterizer.h"
+
+/**
+ * \file SoftGL.h
+ * \brief Software implementation of the EGL and GLES2 entry points gl2-cube uses, so it can
+ * run on hosts without a GPU (the gl2-cube-soft host executable).
+ *
+ * There is one display, one config and one context; surfaces are pbuffers. GLSL is not
+ * compiled: what a linked program does is taken from the FEATURE_* defines at the top of
+ * ShaderVariantCache sources, or for other shaders from the names they use (a_v4FillColor,
+ * a_v2TexCoord, u_m4MVP, samplerExternalOES, u_v4Instances). Programs transform a_v4Position by
+ * u_m4MVP or u_m4Projection * u_m4Modelview, after the rows of u_v4Instances a_fInstance picks
+ * if they have them, and output the vertex color, the texel, both mixed by u_fTex, or white.
+ *
+ * Environment variables:
+ *  - SOFTGL_THREADS:        rasterizer threads, default one per CPU.
+ *  - SOFTGL_DUMP:           write the surface to this PPM file on eglSwapBuffers; a %u in
+ *                           the name is replaced by the swap number.
+ *  - SOFTGL_DUMP_INTERVAL:  swaps between dumps, default 60.
+ *  - SOFTGL_STATS:          swaps between rasterizer statistics reports, default 0 (never).
+ */
+
+    /**
+     * \brief Create the GL context state and start the rasterizer threads.
+     */
+    bool softglCreateContext(void);
+
+    /**
+     * \brief Free all GL objects and stop the rasterizer threads.
+     */
+    void softglDestroyContext(void);
+
+    /**
+     * \brief Make a surface the default framebuffer, NULL to release it.
+     */
+    void softglMakeCurrent(const SoftRenderTarget* surface);
+
+    /**
+     * \brief Print the rasterizer statistics to stderr and reset them.
+     */
+    void softglPrintStats(const char* label);
+
+    /**
+     * \brief Write the color buffer of a target to a binary PPM file, top row first.
+     * \return False if the file could not be written.
+     */
+    bool softglWritePPM(const SoftRenderTarget& target, const char* path);
+
+#endif /* SOFTGL_H */
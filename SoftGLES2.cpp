@@ -0,0 +1,2191 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SoftGL.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#define SOFTGL_MAX_TEXTURES      256
+#define SOFTGL_MAX_BUFFERS       256
+#define SOFTGL_MAX_SHADERS       128
+#define SOFTGL_MAX_PROGRAMS      64
+#define SOFTGL_MAX_FRAMEBUFFERS  32
+#define SOFTGL_MAX_RENDERBUFFERS 32
+#define SOFTGL_MAX_ATTRIBS       8
+#define SOFTGL_MAX_TEXTURE_UNITS 8
+#define SOFTGL_MAX_TEXTURE_SIZE  4096
+#define SOFTGL_MAX_UNIFORM_VECTORS 128
+
+/* What a program does, see SoftGL.h. */
+enum
+{
+  PROGRAM_COLOR    = 1,
+  PROGRAM_TEXTURE  = 2,
+  PROGRAM_EXTERNAL = 4,
+  PROGRAM_MVP      = 8,
+  PROGRAM_INSTANCED = 16
+};
+
+/* The attributes and uniforms programs can use; uniform locations are their index. */
+enum { SEMANTIC_POSITION, SEMANTIC_COLOR, SEMANTIC_TEX_COORD, SEMANTIC_INSTANCE, SEMANTIC_COUNT };
+static const char* const attributeNames[SEMANTIC_COUNT] =
+{
+  "a_v4Position", "a_v4FillColor", "a_v2TexCoord", "a_fInstance"
+};
+
+/* The instance rows are an array, kept apart from the other uniforms' values. */
+enum { UNIFORM_PROJECTION, UNIFORM_MODELVIEW, UNIFORM_MVP, UNIFORM_SAMPLER, UNIFORM_TEXTURE_MIX, UNIFORM_INSTANCES,
+       UNIFORM_COUNT };
+static const char* const uniformNames[UNIFORM_COUNT] =
+{
+  "u_m4Projection", "u_m4Modelview", "u_m4MVP", "u_s2dTexture", "u_fTex", "u_v4Instances"
+};
+
+struct TextureObject
+{
+  bool        used;
+  SoftTexture texture;
+};
+
+struct BufferObject
+{
+  bool            used;
+  GLsizeiptr      size;
+  unsigned char*  data;
+};
+
+struct ShaderObject
+{
+  bool    used;
+  GLenum  type;
+  char*   source;
+  bool    compiled;
+};
+
+struct ProgramObject
+{
+  bool          used;
+  GLuint        shaders[2];
+  bool          linked;
+  unsigned int  features;
+  /* Locations requested with glBindAttribLocation, -1 if none. */
+  GLint         boundLocations[SEMANTIC_COUNT];
+  /* Locations after linking, -1 for attributes the program does not read. */
+  GLint         attribLocations[SEMANTIC_COUNT];
+  bool          activeUniforms[UNIFORM_COUNT];
+  GLfloat       uniforms[UNIFORM_COUNT][16];
+  GLfloat       instanceRows[SOFTGL_MAX_UNIFORM_VECTORS][4];
+  const char*   infoLog;
+};
+
+struct FramebufferObject
+{
+  bool    used;
+  GLuint  colorTexture;
+  GLuint  depthRenderbuffer;
+};
+
+/* Only depth renderbuffers have storage, in the rasterizer's format. */
+struct RenderbufferObject
+{
+  bool    used;
+  GLsizei width;
+  GLsizei height;
+  float*  depth;
+};
+
+struct VertexAttrib
+{
+  bool          enabled;
+  GLint         size;
+  GLenum        type;
+  GLboolean     normalized;
+  GLsizei       stride;
+  const GLvoid* pointer;
+  GLuint        buffer;
+  GLfloat       current[4];
+};
+
+struct ContextState
+{
+  GLenum            error;
+  TextureObject     textures[SOFTGL_MAX_TEXTURES];
+  BufferObject      buffers[SOFTGL_MAX_BUFFERS];
+  ShaderObject      shaders[SOFTGL_MAX_SHADERS];
+  ProgramObject     programs[SOFTGL_MAX_PROGRAMS];
+  FramebufferObject framebuffers[SOFTGL_MAX_FRAMEBUFFERS];
+  RenderbufferObject renderbuffers[SOFTGL_MAX_RENDERBUFFERS];
+  VertexAttrib      attribs[SOFTGL_MAX_ATTRIBS];
+
+  GLuint            program;
+  GLuint            arrayBuffer;
+  GLuint            elementArrayBuffer;
+  GLuint            framebuffer;
+  GLuint            renderbuffer;
+  GLuint            activeTexture;
+  /* Bindings per unit for GL_TEXTURE_2D and GL_TEXTURE_EXTERNAL_OES. */
+  GLuint            boundTextures[SOFTGL_MAX_TEXTURE_UNITS][2];
+  GLint             unpackAlignment;
+  GLint             packAlignment;
+
+  SoftDrawState     draw;
+  GLfloat           clearColor[4];
+  GLfloat           clearDepth;
+  bool              hasSurface;
+  SoftRenderTarget  surface;
+
+  /* Per draw scratch space. */
+  GLuint*           indices;
+  GLsizei           indexCapacity;
+  SoftVertex*       vertices;
+  GLsizei           vertexCapacity;
+  GLuint*           triangles;
+  GLsizei           triangleCapacity;
+};
+
+static ContextState   context;
+static SoftRasterizer rasterizer;
+
+static void setError(GLenum error)
+{
+  if (context.error == GL_NO_ERROR)
+  {
+    context.error = error;
+  }
+}
+
+static void resetContext(void)
+{
+  memset(&context, 0, sizeof(context));
+  for (int i = 0; i < SOFTGL_MAX_ATTRIBS; i++)
+  {
+    context.attribs[i].size = 4;
+    context.attribs[i].type = GL_FLOAT;
+    context.attribs[i].current[3] = 1.0f;
+  }
+  context.activeTexture   = GL_TEXTURE0;
+  context.unpackAlignment = 4;
+  context.packAlignment   = 4;
+  context.clearDepth      = 1.0f;
+  context.draw.cullMode   = GL_BACK;
+  context.draw.frontFace  = GL_CCW;
+  context.draw.depthMask  = true;
+  context.draw.depthFunc  = GL_LESS;
+  context.draw.blendSrc   = GL_ONE;
+  context.draw.blendDst   = GL_ZERO;
+}
+
+bool softglCreateContext(void)
+{
+  resetContext();
+  const char* threads = getenv("SOFTGL_THREADS");
+  rasterizer.start(threads ? atoi(threads) : 0);
+  fprintf(stderr, "softgl: rasterizing %dx%d tiles on %d threads\n",
+          SoftRasterizer::tileSize, SoftRasterizer::tileSize, rasterizer.threadCount());
+  return true;
+}
+
+void softglDestroyContext(void)
+{
+  rasterizer.stop();
+  for (int i = 0; i < SOFTGL_MAX_TEXTURES; i++)
+  {
+    free(context.textures[i].texture.pixels);
+  }
+  for (int i = 0; i < SOFTGL_MAX_BUFFERS; i++)
+  {
+    free(context.buffers[i].data);
+  }
+  for (int i = 0; i < SOFTGL_MAX_SHADERS; i++)
+  {
+    free(context.shaders[i].source);
+  }
+  for (int i = 0; i < SOFTGL_MAX_RENDERBUFFERS; i++)
+  {
+    free(context.renderbuffers[i].depth);
+  }
+  free(context.indices);
+  free(context.vertices);
+  free(context.triangles);
+  resetContext();
+}
+
+void softglMakeCurrent(const SoftRenderTarget* surface)
+{
+  context.hasSurface = surface != NULL;
+  if (surface != NULL)
+  {
+    context.surface = *surface;
+    if (context.draw.viewport[2] == 0 && context.draw.viewport[3] == 0)
+    {
+      /* Like every EGL implementation, size the viewport and scissor to the first surface. */
+      context.draw.viewport[2] = context.draw.scissor[2] = surface->width;
+      context.draw.viewport[3] = context.draw.scissor[3] = surface->height;
+    }
+  }
+}
+
+void softglPrintStats(const char* label)
+{
+  const SoftRasterizer::Stats& stats = rasterizer.stats();
+  fprintf(stderr, "softgl (%s): %u draws, %u triangles, %u culled, %u tile bins, %u fragments\n",
+          label, stats.draws, stats.triangles, stats.culled, stats.binned, stats.fragments);
+  rasterizer.resetStats();
+}
+
+bool softglWritePPM(const SoftRenderTarget& target, const char* path)
+{
+  FILE* file = fopen(path, "wb");
+  if (file == NULL)
+  {
+    return false;
+  }
+
+  unsigned char* row = (unsigned char*)malloc(target.width * 3);
+  bool ok = row != NULL && fprintf(file, "P6\n%d %d\n255\n", target.width, target.height) > 0;
+  for (int y = target.height - 1; ok && y >= 0; y--)
+  {
+    const uint32_t* pixels = target.color + y * target.width;
+    for (int x = 0; x < target.width; x++)
+    {
+      row[3 * x]     = pixels[x] & 0xFF;
+      row[3 * x + 1] = (pixels[x] >> 8) & 0xFF;
+      row[3 * x + 2] = (pixels[x] >> 16) & 0xFF;
+    }
+    ok = fwrite(row, 3, target.width, file) == (size_t)target.width;
+  }
+  free(row);
+  return fclose(file) == 0 && ok;
+}
+
+/* Object names are indices into the object tables, 0 is never handed out. */
+#define OBJECT(table, name) \
+  ((name) > 0 && (name) < sizeof(context.table) / sizeof(context.table[0]) && context.table[name].used ? \
+   &context.table[name] : NULL)
+
+#define GEN_OBJECTS(table, n, names)                                             \
+  do {                                                                           \
+    GLuint next = 1;                                                             \
+    for (GLsizei i = 0; i < (n); i++)                                            \
+    {                                                                            \
+      while (next < sizeof(context.table) / sizeof(context.table[0]) &&          \
+             context.table[next].used)                                           \
+      {                                                                          \
+        next++;                                                                  \
+      }                                                                          \
+      if (next == sizeof(context.table) / sizeof(context.table[0]))              \
+      {                                                                          \
+        setError(GL_OUT_OF_MEMORY);                                              \
+        (names)[i] = 0;                                                          \
+        continue;                                                                \
+      }                                                                          \
+      memset(&context.table[next], 0, sizeof(context.table[next]));              \
+      context.table[next].used = true;                                           \
+      (names)[i] = next;                                                         \
+    }                                                                            \
+  } while (0)
+
+static SoftTexture* textureObject(GLuint name)
+{
+  TextureObject* object = OBJECT(textures, name);
+  return object ? &object->texture : NULL;
+}
+
+static int textureTargetIndex(GLenum target)
+{
+  switch (target)
+  {
+    case GL_TEXTURE_2D:           return 0;
+    case GL_TEXTURE_EXTERNAL_OES: return 1;
+    default:                      return -1;
+  }
+}
+
+/* The texture bound to target on the active unit. */
+static SoftTexture* boundTexture(GLenum target)
+{
+  int index = textureTargetIndex(target);
+  if (index < 0)
+  {
+    setError(GL_INVALID_ENUM);
+    return NULL;
+  }
+  SoftTexture* texture = textureObject(context.boundTextures[context.activeTexture - GL_TEXTURE0][index]);
+  if (texture == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+  }
+  return texture;
+}
+
+/* The target drawn to, NULL if the bound framebuffer is incomplete. */
+static bool currentTarget(SoftRenderTarget& target)
+{
+  if (context.framebuffer == 0)
+  {
+    target = context.surface;
+    return context.hasSurface;
+  }
+
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  SoftTexture* texture = framebuffer ? textureObject(framebuffer->colorTexture) : NULL;
+  if (texture == NULL || texture->pixels == NULL)
+  {
+    return false;
+  }
+  RenderbufferObject* depth = OBJECT(renderbuffers, framebuffer->depthRenderbuffer);
+  if (framebuffer->depthRenderbuffer != 0 &&
+      (depth == NULL || depth->depth == NULL || depth->width != texture->width || depth->height != texture->height))
+  {
+    return false;
+  }
+  target.width  = texture->width;
+  target.height = texture->height;
+  target.color  = texture->pixels;
+  target.depth  = depth != NULL ? depth->depth : NULL;
+  return true;
+}
+
+static float clampUnit(float value)
+{
+  return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static uint32_t packUnitColor(const GLfloat* color)
+{
+  return softPackColor((unsigned int)(clampUnit(color[0]) * 255.0f + 0.5f),
+                       (unsigned int)(clampUnit(color[1]) * 255.0f + 0.5f),
+                       (unsigned int)(clampUnit(color[2]) * 255.0f + 0.5f),
+                       (unsigned int)(clampUnit(color[3]) * 255.0f + 0.5f));
+}
+
+/* Depth bits of the bound framebuffer. */
+static GLint depthBits(void)
+{
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (context.framebuffer == 0)
+  {
+    return 24;
+  }
+  return framebuffer != NULL && OBJECT(renderbuffers, framebuffer->depthRenderbuffer) != NULL ? 16 : 0;
+}
+
+/* State. */
+
+GLenum glGetError(void)
+{
+  GLenum error = context.error;
+  context.error = GL_NO_ERROR;
+  return error;
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+  switch (name)
+  {
+    case GL_VENDOR:                   return (const GLubyte*)"gl2-cube";
+    case GL_RENDERER:                 return (const GLubyte*)"softgl tile rasterizer";
+    case GL_VERSION:                  return (const GLubyte*)"OpenGL ES 2.0 softgl";
+    case GL_SHADING_LANGUAGE_VERSION: return (const GLubyte*)"OpenGL ES GLSL ES 1.00";
+    case GL_EXTENSIONS:               return (const GLubyte*)"GL_OES_vertex_half_float GL_OES_EGL_image_external";
+    default:
+      setError(GL_INVALID_ENUM);
+      return NULL;
+  }
+}
+
+void glGetIntegerv(GLenum name, GLint* params)
+{
+  switch (name)
+  {
+    case GL_MAX_VERTEX_ATTRIBS:                 *params = SOFTGL_MAX_ATTRIBS; break;
+    case GL_MAX_TEXTURE_SIZE:                   *params = SOFTGL_MAX_TEXTURE_SIZE; break;
+    case GL_MAX_TEXTURE_IMAGE_UNITS:
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:   *params = SOFTGL_MAX_TEXTURE_UNITS; break;
+    case GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS:     *params = 0; break;
+    case GL_MAX_VERTEX_UNIFORM_VECTORS:         *params = SOFTGL_MAX_UNIFORM_VECTORS; break;
+    case GL_MAX_FRAGMENT_UNIFORM_VECTORS:       *params = 16; break;
+    case GL_MAX_VARYING_VECTORS:                *params = 8; break;
+    case GL_MAX_RENDERBUFFER_SIZE:              *params = SOFTGL_MAX_TEXTURE_SIZE; break;
+    case GL_MAX_VIEWPORT_DIMS:                  params[0] = params[1] = SOFTGL_MAX_TEXTURE_SIZE; break;
+    case GL_NUM_COMPRESSED_TEXTURE_FORMATS:
+    case GL_NUM_SHADER_BINARY_FORMATS:
+    case GL_NUM_PROGRAM_BINARY_FORMATS_OES:     *params = 0; break;
+    case GL_RED_BITS:
+    case GL_GREEN_BITS:
+    case GL_BLUE_BITS:
+    case GL_ALPHA_BITS:                         *params = 8; break;
+    case GL_DEPTH_BITS:                         *params = depthBits(); break;
+    case GL_STENCIL_BITS:                       *params = 0; break;
+    case GL_VIEWPORT:                           memcpy(params, context.draw.viewport, 4 * sizeof(GLint)); break;
+    case GL_SCISSOR_BOX:                        memcpy(params, context.draw.scissor, 4 * sizeof(GLint)); break;
+    case GL_CURRENT_PROGRAM:                    *params = context.program; break;
+    case GL_ARRAY_BUFFER_BINDING:               *params = context.arrayBuffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER_BINDING:       *params = context.elementArrayBuffer; break;
+    case GL_FRAMEBUFFER_BINDING:                *params = context.framebuffer; break;
+    case GL_ACTIVE_TEXTURE:                     *params = context.activeTexture; break;
+    case GL_TEXTURE_BINDING_2D:
+      *params = context.boundTextures[context.activeTexture - GL_TEXTURE0][0];
+      break;
+    case GL_UNPACK_ALIGNMENT:                   *params = context.unpackAlignment; break;
+    case GL_PACK_ALIGNMENT:                     *params = context.packAlignment; break;
+    default:
+      setError(GL_INVALID_ENUM);
+      break;
+  }
+}
+
+static bool* capability(GLenum cap)
+{
+  switch (cap)
+  {
+    case GL_BLEND:        return &context.draw.blend;
+    case GL_CULL_FACE:    return &context.draw.cullFace;
+    case GL_DEPTH_TEST:   return &context.draw.depthTest;
+    case GL_SCISSOR_TEST: return &context.draw.scissorTest;
+    default:              return NULL;
+  }
+}
+
+void glEnable(GLenum cap)
+{
+  bool* value = capability(cap);
+  if (value != NULL)
+  {
+    *value = true;
+  }
+  else if (cap != GL_DITHER)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+void glDisable(GLenum cap)
+{
+  bool* value = capability(cap);
+  if (value != NULL)
+  {
+    *value = false;
+  }
+  else if (cap != GL_DITHER)
+  {
+    setError(GL_INVALID_ENUM);
+  }
+}
+
+GLboolean glIsEnabled(GLenum cap)
+{
+  bool* value = capability(cap);
+  if (value == NULL)
+  {
+    setError(GL_INVALID_ENUM);
+    return GL_FALSE;
+  }
+  return *value ? GL_TRUE : GL_FALSE;
+}
+
+void glCullFace(GLenum mode)
+{
+  if (mode != GL_FRONT && mode != GL_BACK && mode != GL_FRONT_AND_BACK)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  context.draw.cullMode = mode;
+}
+
+void glFrontFace(GLenum mode)
+{
+  if (mode != GL_CW && mode != GL_CCW)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  context.draw.frontFace = mode;
+}
+
+void glDepthFunc(GLenum func)
+{
+  if (func < GL_NEVER || func > GL_ALWAYS)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  context.draw.depthFunc = func;
+}
+
+void glDepthMask(GLboolean flag)
+{
+  context.draw.depthMask = flag != GL_FALSE;
+}
+
+void glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+  context.draw.blendSrc = sfactor;
+  context.draw.blendDst = dfactor;
+}
+
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.draw.viewport[0] = x;
+  context.draw.viewport[1] = y;
+  context.draw.viewport[2] = width < SOFTGL_MAX_TEXTURE_SIZE ? width : SOFTGL_MAX_TEXTURE_SIZE;
+  context.draw.viewport[3] = height < SOFTGL_MAX_TEXTURE_SIZE ? height : SOFTGL_MAX_TEXTURE_SIZE;
+}
+
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.draw.scissor[0] = x;
+  context.draw.scissor[1] = y;
+  context.draw.scissor[2] = width;
+  context.draw.scissor[3] = height;
+}
+
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha)
+{
+  context.clearColor[0] = red;
+  context.clearColor[1] = green;
+  context.clearColor[2] = blue;
+  context.clearColor[3] = alpha;
+}
+
+void glClearDepthf(GLclampf depth)
+{
+  context.clearDepth = clampUnit(depth);
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+  if (param != 1 && param != 2 && param != 4 && param != 8)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  switch (pname)
+  {
+    case GL_UNPACK_ALIGNMENT: context.unpackAlignment = param; break;
+    case GL_PACK_ALIGNMENT:   context.packAlignment = param; break;
+    default:                  setError(GL_INVALID_ENUM); break;
+  }
+}
+
+void glFlush(void)
+{
+}
+
+/* Draws complete before they return, so there is nothing to wait for. */
+void glFinish(void)
+{
+}
+
+void glClear(GLbitfield mask)
+{
+  if (mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT))
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  SoftRenderTarget target;
+  if (!currentTarget(target))
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+    return;
+  }
+
+  GLint rect[4] = { 0, 0, target.width, target.height };
+  if (context.draw.scissorTest)
+  {
+    GLint x1 = context.draw.scissor[0] + context.draw.scissor[2];
+    GLint y1 = context.draw.scissor[1] + context.draw.scissor[3];
+    rect[0] = context.draw.scissor[0] > 0 ? context.draw.scissor[0] : 0;
+    rect[1] = context.draw.scissor[1] > 0 ? context.draw.scissor[1] : 0;
+    rect[2] = (x1 < target.width ? x1 : target.width) - rect[0];
+    rect[3] = (y1 < target.height ? y1 : target.height) - rect[1];
+    if (rect[2] <= 0 || rect[3] <= 0)
+    {
+      return;
+    }
+  }
+  SoftRasterizer::clear(target, rect,
+                        (mask & GL_COLOR_BUFFER_BIT) != 0, packUnitColor(context.clearColor),
+                        (mask & GL_DEPTH_BUFFER_BIT) != 0 && context.draw.depthMask, context.clearDepth);
+}
+
+void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid* pixels)
+{
+  if (format != GL_RGBA || type != GL_UNSIGNED_BYTE)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (width < 0 || height < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  SoftRenderTarget target;
+  if (!currentTarget(target))
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+    return;
+  }
+
+  GLsizei rowLength = (width * 4 + context.packAlignment - 1) & ~(context.packAlignment - 1);
+  for (GLsizei row = 0; row < height; row++)
+  {
+    unsigned char* out = (unsigned char*)pixels + row * rowLength;
+    for (GLsizei column = 0; column < width; column++)
+    {
+      /* Pixels outside the target are undefined, leave them alone. */
+      GLint px = x + column;
+      GLint py = y + row;
+      if (px >= 0 && py >= 0 && px < target.width && py < target.height)
+      {
+        uint32_t pixel = target.color[py * target.width + px];
+        out[4 * column]     = pixel & 0xFF;
+        out[4 * column + 1] = (pixel >> 8) & 0xFF;
+        out[4 * column + 2] = (pixel >> 16) & 0xFF;
+        out[4 * column + 3] = pixel >> 24;
+      }
+    }
+  }
+}
+
+/* Buffers. */
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+  GEN_OBJECTS(buffers, n, buffers);
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+  for (GLsizei i = 0; i < n; i++)
+  {
+    BufferObject* buffer = OBJECT(buffers, buffers[i]);
+    if (buffer == NULL)
+    {
+      continue;
+    }
+    free(buffer->data);
+    memset(buffer, 0, sizeof(*buffer));
+    if (context.arrayBuffer == buffers[i])
+    {
+      context.arrayBuffer = 0;
+    }
+    if (context.elementArrayBuffer == buffers[i])
+    {
+      context.elementArrayBuffer = 0;
+    }
+    for (int j = 0; j < SOFTGL_MAX_ATTRIBS; j++)
+    {
+      if (context.attribs[j].buffer == buffers[i])
+      {
+        context.attribs[j].buffer = 0;
+      }
+    }
+  }
+}
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+  if (buffer != 0 && OBJECT(buffers, buffer) == NULL)
+  {
+    /* Names not from glGenBuffers are valid in ES 2.0; create the object on first bind. */
+    if (buffer >= SOFTGL_MAX_BUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    context.buffers[buffer].used = true;
+  }
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:         context.arrayBuffer = buffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER: context.elementArrayBuffer = buffer; break;
+    default:                      setError(GL_INVALID_ENUM); break;
+  }
+}
+
+static BufferObject* boundBuffer(GLenum target)
+{
+  GLuint name;
+  switch (target)
+  {
+    case GL_ARRAY_BUFFER:         name = context.arrayBuffer; break;
+    case GL_ELEMENT_ARRAY_BUFFER: name = context.elementArrayBuffer; break;
+    default:
+      setError(GL_INVALID_ENUM);
+      return NULL;
+  }
+  BufferObject* buffer = OBJECT(buffers, name);
+  if (buffer == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+  }
+  return buffer;
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
+{
+  if (size < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (usage != GL_STREAM_DRAW && usage != GL_STATIC_DRAW && usage != GL_DYNAMIC_DRAW)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  BufferObject* buffer = boundBuffer(target);
+  if (buffer == NULL)
+  {
+    return;
+  }
+
+  unsigned char* storage = (unsigned char*)realloc(buffer->data, size ? size : 1);
+  if (storage == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  buffer->data = storage;
+  buffer->size = size;
+  if (data != NULL)
+  {
+    memcpy(buffer->data, data, size);
+  }
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data)
+{
+  BufferObject* buffer = boundBuffer(target);
+  if (buffer == NULL)
+  {
+    return;
+  }
+  if (offset < 0 || size < 0 || offset + size > buffer->size)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  memcpy(buffer->data + offset, data, size);
+}
+
+/* Textures. */
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+  GEN_OBJECTS(textures, n, textures);
+  for (GLsizei i = 0; i < n; i++)
+  {
+    SoftTexture* texture = textureObject(textures[i]);
+    if (texture != NULL)
+    {
+      texture->minFilter = GL_NEAREST_MIPMAP_LINEAR;
+      texture->magFilter = GL_LINEAR;
+      texture->wrapS     = GL_REPEAT;
+      texture->wrapT     = GL_REPEAT;
+    }
+  }
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+  for (GLsizei i = 0; i < n; i++)
+  {
+    TextureObject* texture = OBJECT(textures, textures[i]);
+    if (texture == NULL)
+    {
+      continue;
+    }
+    free(texture->texture.pixels);
+    memset(texture, 0, sizeof(*texture));
+    for (int unit = 0; unit < SOFTGL_MAX_TEXTURE_UNITS; unit++)
+    {
+      for (int j = 0; j < 2; j++)
+      {
+        if (context.boundTextures[unit][j] == textures[i])
+        {
+          context.boundTextures[unit][j] = 0;
+        }
+      }
+    }
+  }
+}
+
+void glActiveTexture(GLenum texture)
+{
+  if (texture < GL_TEXTURE0 || texture >= GL_TEXTURE0 + SOFTGL_MAX_TEXTURE_UNITS)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  context.activeTexture = texture;
+}
+
+void glBindTexture(GLenum target, GLuint texture)
+{
+  int index = textureTargetIndex(target);
+  if (index < 0)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texture != 0 && textureObject(texture) == NULL)
+  {
+    if (texture >= SOFTGL_MAX_TEXTURES)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.textures[texture], 0, sizeof(context.textures[texture]));
+    context.textures[texture].used = true;
+    context.textures[texture].texture.minFilter = GL_NEAREST_MIPMAP_LINEAR;
+    context.textures[texture].texture.magFilter = GL_LINEAR;
+    context.textures[texture].texture.wrapS = GL_REPEAT;
+    context.textures[texture].texture.wrapT = GL_REPEAT;
+  }
+  context.boundTextures[context.activeTexture - GL_TEXTURE0][index] = texture;
+}
+
+void glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+  SoftTexture* texture = boundTexture(target);
+  if (texture == NULL)
+  {
+    return;
+  }
+  switch (pname)
+  {
+    case GL_TEXTURE_MIN_FILTER: texture->minFilter = param; break;
+    case GL_TEXTURE_MAG_FILTER: texture->magFilter = param; break;
+    case GL_TEXTURE_WRAP_S:     texture->wrapS = param; break;
+    case GL_TEXTURE_WRAP_T:     texture->wrapT = param; break;
+    default:                    setError(GL_INVALID_ENUM); break;
+  }
+}
+
+void glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+  glTexParameteri(target, pname, (GLint)param);
+}
+
+/* Bytes per pixel of a client format, 0 if the combination is not valid ES 2.0. */
+static int texelSize(GLenum format, GLenum type)
+{
+  switch (type)
+  {
+    case GL_UNSIGNED_BYTE:
+      switch (format)
+      {
+        case GL_RGBA:            return 4;
+        case GL_RGB:             return 3;
+        case GL_LUMINANCE_ALPHA: return 2;
+        case GL_LUMINANCE:
+        case GL_ALPHA:           return 1;
+        default:                 return 0;
+      }
+    case GL_UNSIGNED_SHORT_5_6_5:   return format == GL_RGB ? 2 : 0;
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1: return format == GL_RGBA ? 2 : 0;
+    default:                        return 0;
+  }
+}
+
+static uint32_t convertTexel(GLenum format, GLenum type, const unsigned char* texel)
+{
+  unsigned int value;
+  switch (type)
+  {
+    case GL_UNSIGNED_SHORT_5_6_5:
+      value = texel[0] | (texel[1] << 8);
+      return softPackColor(((value >> 11) & 0x1F) * 255 / 31, ((value >> 5) & 0x3F) * 255 / 63,
+                           (value & 0x1F) * 255 / 31, 255);
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+      value = texel[0] | (texel[1] << 8);
+      return softPackColor(((value >> 12) & 0xF) * 17, ((value >> 8) & 0xF) * 17,
+                           ((value >> 4) & 0xF) * 17, (value & 0xF) * 17);
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      value = texel[0] | (texel[1] << 8);
+      return softPackColor(((value >> 11) & 0x1F) * 255 / 31, ((value >> 6) & 0x1F) * 255 / 31,
+                           ((value >> 1) & 0x1F) * 255 / 31, (value & 1) * 255);
+    default:
+      break;
+  }
+  switch (format)
+  {
+    case GL_RGBA:            return softPackColor(texel[0], texel[1], texel[2], texel[3]);
+    case GL_RGB:             return softPackColor(texel[0], texel[1], texel[2], 255);
+    case GL_LUMINANCE_ALPHA: return softPackColor(texel[0], texel[0], texel[0], texel[1]);
+    case GL_LUMINANCE:       return softPackColor(texel[0], texel[0], texel[0], 255);
+    default:                 return softPackColor(0, 0, 0, texel[0]);
+  }
+}
+
+static void copyTexels(SoftTexture* texture, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+                       GLenum format, GLenum type, const GLvoid* pixels)
+{
+  int size = texelSize(format, type);
+  GLsizei rowLength = (width * size + context.unpackAlignment - 1) & ~(context.unpackAlignment - 1);
+
+  for (GLsizei y = 0; y < height; y++)
+  {
+    const unsigned char* in = (const unsigned char*)pixels + y * rowLength;
+    uint32_t* out = texture->pixels + (yoffset + y) * texture->width + xoffset;
+    for (GLsizei x = 0; x < width; x++)
+    {
+      out[x] = convertTexel(format, type, in + x * size);
+    }
+  }
+}
+
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                  GLint border, GLenum format, GLenum type, const GLvoid* pixels)
+{
+  if (target != GL_TEXTURE_2D)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (level < 0 || width < 0 || height < 0 || border != 0 ||
+      width > SOFTGL_MAX_TEXTURE_SIZE || height > SOFTGL_MAX_TEXTURE_SIZE)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if ((GLenum)internalformat != format || texelSize(format, type) == 0)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  SoftTexture* texture = boundTexture(target);
+  if (texture == NULL)
+  {
+    return;
+  }
+  /* Only level 0 is stored, so mipmapped filtering leaves the texture incomplete. */
+  if (level > 0)
+  {
+    return;
+  }
+
+  uint32_t* storage = (uint32_t*)realloc(texture->pixels, (width * height > 0 ? width * height : 1) * sizeof(uint32_t));
+  if (storage == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  texture->pixels = storage;
+  texture->width  = width;
+  texture->height = height;
+  if (pixels != NULL)
+  {
+    copyTexels(texture, 0, 0, width, height, format, type, pixels);
+  }
+  else
+  {
+    memset(texture->pixels, 0, width * height * sizeof(uint32_t));
+  }
+}
+
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+                     GLenum format, GLenum type, const GLvoid* pixels)
+{
+  if (target != GL_TEXTURE_2D)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (texelSize(format, type) == 0)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  SoftTexture* texture = boundTexture(target);
+  if (texture == NULL || level > 0)
+  {
+    return;
+  }
+  if (level < 0 || xoffset < 0 || yoffset < 0 || width < 0 || height < 0 ||
+      xoffset + width > texture->width || yoffset + height > texture->height)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (pixels != NULL)
+  {
+    copyTexels(texture, xoffset, yoffset, width, height, format, type, pixels);
+  }
+}
+
+/* Framebuffers. */
+
+void glGenFramebuffers(GLsizei n, GLuint* framebuffers)
+{
+  GEN_OBJECTS(framebuffers, n, framebuffers);
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+{
+  for (GLsizei i = 0; i < n; i++)
+  {
+    FramebufferObject* framebuffer = OBJECT(framebuffers, framebuffers[i]);
+    if (framebuffer != NULL)
+    {
+      framebuffer->used = false;
+      if (context.framebuffer == framebuffers[i])
+      {
+        context.framebuffer = 0;
+      }
+    }
+  }
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+  if (target != GL_FRAMEBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (framebuffer != 0 && OBJECT(framebuffers, framebuffer) == NULL)
+  {
+    if (framebuffer >= SOFTGL_MAX_FRAMEBUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.framebuffers[framebuffer], 0, sizeof(context.framebuffers[framebuffer]));
+    context.framebuffers[framebuffer].used = true;
+  }
+  context.framebuffer = framebuffer;
+}
+
+/* Only color attachments are supported; depth comes from renderbuffers. */
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+{
+  if (target != GL_FRAMEBUFFER || textarget != GL_TEXTURE_2D)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer == NULL || (texture != 0 && textureObject(texture) == NULL))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  if (level != 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (attachment != GL_COLOR_ATTACHMENT0)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  framebuffer->colorTexture = texture;
+}
+
+GLenum glCheckFramebufferStatus(GLenum target)
+{
+  if (target != GL_FRAMEBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return 0;
+  }
+  if (context.framebuffer == 0)
+  {
+    return GL_FRAMEBUFFER_COMPLETE;
+  }
+
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer == NULL || framebuffer->colorTexture == 0)
+  {
+    return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+  }
+  SoftTexture* texture = textureObject(framebuffer->colorTexture);
+  if (texture == NULL || texture->pixels == NULL || texture->width == 0 || texture->height == 0)
+  {
+    return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+  }
+  if (framebuffer->depthRenderbuffer != 0)
+  {
+    RenderbufferObject* depth = OBJECT(renderbuffers, framebuffer->depthRenderbuffer);
+    if (depth == NULL || depth->depth == NULL)
+    {
+      return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+    }
+    if (depth->width != texture->width || depth->height != texture->height)
+    {
+      return GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS;
+    }
+  }
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+/* Renderbuffers, only GL_DEPTH_COMPONENT16 ones for depth attachments. */
+
+void glGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+{
+  if (n < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GEN_OBJECTS(renderbuffers, n, renderbuffers);
+}
+
+void glBindRenderbuffer(GLenum target, GLuint renderbuffer)
+{
+  if (target != GL_RENDERBUFFER)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (renderbuffer != 0 && OBJECT(renderbuffers, renderbuffer) == NULL)
+  {
+    if (renderbuffer >= SOFTGL_MAX_RENDERBUFFERS)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    memset(&context.renderbuffers[renderbuffer], 0, sizeof(context.renderbuffers[renderbuffer]));
+    context.renderbuffers[renderbuffer].used = true;
+  }
+  context.renderbuffer = renderbuffer;
+}
+
+void glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+{
+  if (target != GL_RENDERBUFFER || internalformat != GL_DEPTH_COMPONENT16)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (width < 0 || height < 0 || width > SOFTGL_MAX_TEXTURE_SIZE || height > SOFTGL_MAX_TEXTURE_SIZE)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  RenderbufferObject* renderbuffer = OBJECT(renderbuffers, context.renderbuffer);
+  if (renderbuffer == NULL)
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  float* depth = NULL;
+  if (width > 0 && height > 0)
+  {
+    depth = (float*)malloc(width * height * sizeof(float));
+    if (depth == NULL)
+    {
+      setError(GL_OUT_OF_MEMORY);
+      return;
+    }
+    for (GLsizei i = 0; i < width * height; i++)
+    {
+      depth[i] = 1.0f;
+    }
+  }
+  free(renderbuffer->depth);
+  renderbuffer->width  = width;
+  renderbuffer->height = height;
+  renderbuffer->depth  = depth;
+}
+
+void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+{
+  if (target != GL_FRAMEBUFFER || renderbuffertarget != GL_RENDERBUFFER || attachment != GL_DEPTH_ATTACHMENT)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  FramebufferObject* framebuffer = OBJECT(framebuffers, context.framebuffer);
+  if (framebuffer == NULL || (renderbuffer != 0 && OBJECT(renderbuffers, renderbuffer) == NULL))
+  {
+    setError(GL_INVALID_OPERATION);
+    return;
+  }
+  framebuffer->depthRenderbuffer = renderbuffer;
+}
+
+/* Shaders and programs. */
+
+GLuint glCreateShader(GLenum type)
+{
+  if (type != GL_VERTEX_SHADER && type != GL_FRAGMENT_SHADER)
+  {
+    setError(GL_INVALID_ENUM);
+    return 0;
+  }
+  GLuint name;
+  GEN_OBJECTS(shaders, 1, &name);
+  if (name != 0)
+  {
+    context.shaders[name].type = type;
+  }
+  return name;
+}
+
+void glDeleteShader(GLuint shader)
+{
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object != NULL)
+  {
+    /* Programs only keep what they worked out at link time, so this can free at once. */
+    free(object->source);
+    memset(object, 0, sizeof(*object));
+  }
+}
+
+/* Headers generated from the Khronos XML registry made the strings const. */
+#ifdef GL_GLES_PROTOTYPES
+typedef const GLchar* const* ShaderSourceStrings;
+#else
+typedef const GLchar** ShaderSourceStrings;
+#endif
+
+void glShaderSource(GLuint shader, GLsizei count, ShaderSourceStrings string, const GLint* length)
+{
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  size_t total = 0;
+  for (GLsizei i = 0; i < count; i++)
+  {
+    total += length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+  }
+  char* source = (char*)malloc(total + 1);
+  if (source == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+  size_t offset = 0;
+  for (GLsizei i = 0; i < count; i++)
+  {
+    size_t part = length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+    memcpy(source + offset, string[i], part);
+    offset += part;
+  }
+  source[total] = '\0';
+
+  free(object->source);
+  object->source = source;
+  object->compiled = false;
+}
+
+/* Anything with an entry point compiles, GLSL is never parsed. */
+void glCompileShader(GLuint shader)
+{
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  object->compiled = object->source != NULL && strstr(object->source, "main") != NULL;
+}
+
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params)
+{
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  switch (pname)
+  {
+    case GL_SHADER_TYPE:          *params = object->type; break;
+    case GL_COMPILE_STATUS:       *params = object->compiled; break;
+    case GL_DELETE_STATUS:        *params = GL_FALSE; break;
+    case GL_INFO_LOG_LENGTH:      *params = object->compiled ? 0 : 12; break;
+    case GL_SHADER_SOURCE_LENGTH: *params = object->source ? strlen(object->source) + 1 : 0; break;
+    default:                      setError(GL_INVALID_ENUM); break;
+  }
+}
+
+static void copyInfoLog(const char* log, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  GLsizei written = 0;
+  if (bufsize > 0)
+  {
+    written = (GLsizei)strlen(log) < bufsize - 1 ? (GLsizei)strlen(log) : bufsize - 1;
+    memcpy(infolog, log, written);
+    infolog[written] = '\0';
+  }
+  if (length != NULL)
+  {
+    *length = written;
+  }
+}
+
+void glGetShaderInfoLog(GLuint shader, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  ShaderObject* object = OBJECT(shaders, shader);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  copyInfoLog(object->compiled ? "" : "no main()\n", bufsize, length, infolog);
+}
+
+GLuint glCreateProgram(void)
+{
+  GLuint name;
+  GEN_OBJECTS(programs, 1, &name);
+  if (name != 0)
+  {
+    for (int i = 0; i < SEMANTIC_COUNT; i++)
+    {
+      context.programs[name].boundLocations[i] = -1;
+      context.programs[name].attribLocations[i] = -1;
+    }
+    context.programs[name].infoLog = "";
+  }
+  return name;
+}
+
+void glDeleteProgram(GLuint program)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object != NULL)
+  {
+    memset(object, 0, sizeof(*object));
+    if (context.program == program)
+    {
+      context.program = 0;
+    }
+  }
+}
+
+void glAttachShader(GLuint program, GLuint shader)
+{
+  ProgramObject* programObject = OBJECT(programs, program);
+  ShaderObject* shaderObject = OBJECT(shaders, shader);
+  if (programObject == NULL || shaderObject == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  programObject->shaders[shaderObject->type == GL_VERTEX_SHADER ? 0 : 1] = shader;
+}
+
+void glDetachShader(GLuint program, GLuint shader)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  for (int i = 0; i < 2; i++)
+  {
+    if (object->shaders[i] == shader)
+    {
+      object->shaders[i] = 0;
+    }
+  }
+}
+
+static int attributeSemantic(const char* name)
+{
+  for (int i = 0; i < SEMANTIC_COUNT; i++)
+  {
+    if (strcmp(name, attributeNames[i]) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void glBindAttribLocation(GLuint program, GLuint index, const GLchar* name)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || index >= SOFTGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  int semantic = attributeSemantic(name);
+  if (semantic >= 0)
+  {
+    object->boundLocations[semantic] = index;
+  }
+}
+
+/* Whether source defines name, as ShaderVariantCache does for its features. */
+static bool hasDefine(const char* source, const char* name)
+{
+  size_t length = strlen(name);
+  for (const char* p = strstr(source, "#define "); p != NULL; p = strstr(p + 1, "#define "))
+  {
+    const char* defined = p + 8;
+    if (strncmp(defined, name, length) == 0 &&
+        (defined[length] == '\0' || defined[length] == '\n' || defined[length] == ' '))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+static unsigned int programFeatures(const char* vertexSource, const char* fragmentSource)
+{
+  unsigned int features = 0;
+
+  if (strstr(vertexSource, "#define FEATURE_") != NULL || strstr(fragmentSource, "#define FEATURE_") != NULL)
+  {
+    features |= hasDefine(vertexSource, "FEATURE_VERTEX_COLOR")       ? PROGRAM_COLOR    : 0;
+    features |= hasDefine(vertexSource, "FEATURE_TEXTURE")            ? PROGRAM_TEXTURE  : 0;
+    features |= hasDefine(fragmentSource, "FEATURE_TEXTURE_EXTERNAL") ? PROGRAM_EXTERNAL : 0;
+    features |= hasDefine(vertexSource, "FEATURE_MVP")                ? PROGRAM_MVP      : 0;
+    features |= hasDefine(vertexSource, "FEATURE_INSTANCED")          ? PROGRAM_INSTANCED : 0;
+    return features;
+  }
+
+  features |= strstr(vertexSource, attributeNames[SEMANTIC_COLOR])     ? PROGRAM_COLOR    : 0;
+  features |= strstr(vertexSource, attributeNames[SEMANTIC_TEX_COORD]) ? PROGRAM_TEXTURE  : 0;
+  features |= strstr(fragmentSource, "samplerExternalOES")             ? PROGRAM_EXTERNAL : 0;
+  features |= strstr(vertexSource, uniformNames[UNIFORM_MVP])          ? PROGRAM_MVP      : 0;
+  features |= strstr(vertexSource, uniformNames[UNIFORM_INSTANCES])    ? PROGRAM_INSTANCED : 0;
+  return features;
+}
+
+void glLinkProgram(GLuint program)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  ShaderObject* vertexShader = OBJECT(shaders, object->shaders[0]);
+  ShaderObject* fragmentShader = OBJECT(shaders, object->shaders[1]);
+  object->linked = false;
+  if (vertexShader == NULL || fragmentShader == NULL || !vertexShader->compiled || !fragmentShader->compiled)
+  {
+    object->infoLog = "a compiled vertex and fragment shader must be attached\n";
+    return;
+  }
+
+  unsigned int features = programFeatures(vertexShader->source, fragmentShader->source);
+  object->features = features;
+  object->activeUniforms[UNIFORM_PROJECTION]  = (features & PROGRAM_MVP) == 0;
+  object->activeUniforms[UNIFORM_MODELVIEW]   = (features & PROGRAM_MVP) == 0;
+  object->activeUniforms[UNIFORM_MVP]         = (features & PROGRAM_MVP) != 0;
+  object->activeUniforms[UNIFORM_SAMPLER]     = (features & PROGRAM_TEXTURE) != 0;
+  object->activeUniforms[UNIFORM_TEXTURE_MIX] = (features & PROGRAM_COLOR) && (features & PROGRAM_TEXTURE);
+  object->activeUniforms[UNIFORM_INSTANCES]   = (features & PROGRAM_INSTANCED) != 0;
+  memset(object->uniforms, 0, sizeof(object->uniforms));
+  memset(object->instanceRows, 0, sizeof(object->instanceRows));
+
+  bool active[SEMANTIC_COUNT] =
+  {
+    true, (features & PROGRAM_COLOR) != 0, (features & PROGRAM_TEXTURE) != 0, (features & PROGRAM_INSTANCED) != 0
+  };
+  bool used[SOFTGL_MAX_ATTRIBS] = { false };
+  for (int i = 0; i < SEMANTIC_COUNT; i++)
+  {
+    object->attribLocations[i] = active[i] ? object->boundLocations[i] : -1;
+    if (object->attribLocations[i] >= 0)
+    {
+      used[object->attribLocations[i]] = true;
+    }
+  }
+  for (int i = 0, next = 0; i < SEMANTIC_COUNT; i++)
+  {
+    if (active[i] && object->attribLocations[i] < 0)
+    {
+      while (used[next])
+      {
+        next++;
+      }
+      object->attribLocations[i] = next;
+      used[next] = true;
+    }
+  }
+
+  object->infoLog = "";
+  object->linked = true;
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+
+  GLint count = 0;
+  switch (pname)
+  {
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:            *params = object->linked; break;
+    case GL_DELETE_STATUS:              *params = GL_FALSE; break;
+    case GL_INFO_LOG_LENGTH:            *params = object->infoLog[0] ? strlen(object->infoLog) + 1 : 0; break;
+    case GL_ATTACHED_SHADERS:           *params = (object->shaders[0] != 0) + (object->shaders[1] != 0); break;
+    case GL_ACTIVE_ATTRIBUTES:
+      for (int i = 0; i < SEMANTIC_COUNT; i++)
+      {
+        count += object->attribLocations[i] >= 0;
+      }
+      *params = count;
+      break;
+    case GL_ACTIVE_UNIFORMS:
+      for (int i = 0; i < UNIFORM_COUNT; i++)
+      {
+        count += object->activeUniforms[i];
+      }
+      *params = count;
+      break;
+    case GL_PROGRAM_BINARY_LENGTH_OES:  *params = 0; break;
+    default:                            setError(GL_INVALID_ENUM); break;
+  }
+}
+
+void glGetProgramInfoLog(GLuint program, GLsizei bufsize, GLsizei* length, GLchar* infolog)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  copyInfoLog(object->infoLog, bufsize, length, infolog);
+}
+
+/* No binary formats are reported, so there is nothing to save or load. */
+void glGetProgramBinaryOES(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, GLvoid* binary)
+{
+  if (length != NULL)
+  {
+    *length = 0;
+  }
+  setError(GL_INVALID_OPERATION);
+}
+
+void glProgramBinaryOES(GLuint program, GLenum binaryFormat, const GLvoid* binary, GLint length)
+{
+  setError(GL_INVALID_ENUM);
+}
+
+void glUseProgram(GLuint program)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (program != 0 && (object == NULL || !object->linked))
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return;
+  }
+  context.program = program;
+}
+
+int glGetAttribLocation(GLuint program, const GLchar* name)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || !object->linked)
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return -1;
+  }
+  int semantic = attributeSemantic(name);
+  return semantic >= 0 ? object->attribLocations[semantic] : -1;
+}
+
+int glGetUniformLocation(GLuint program, const GLchar* name)
+{
+  ProgramObject* object = OBJECT(programs, program);
+  if (object == NULL || !object->linked)
+  {
+    setError(object == NULL ? GL_INVALID_VALUE : GL_INVALID_OPERATION);
+    return -1;
+  }
+  for (int i = 0; i < UNIFORM_COUNT; i++)
+  {
+    if (object->activeUniforms[i] && strcmp(name, uniformNames[i]) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* The uniform at location of the current program if it has the given kind, else NULL. */
+static GLfloat* currentUniform(GLint location, bool matrix)
+{
+  if (location == -1)
+  {
+    return NULL;
+  }
+  ProgramObject* object = OBJECT(programs, context.program);
+  if (object == NULL || location < 0 || location >= UNIFORM_COUNT || !object->activeUniforms[location] ||
+      matrix != (location <= UNIFORM_MVP))
+  {
+    setError(GL_INVALID_OPERATION);
+    return NULL;
+  }
+  return object->uniforms[location];
+}
+
+void glUniform1i(GLint location, GLint x)
+{
+  GLfloat* value = currentUniform(location, false);
+  if (value != NULL)
+  {
+    value[0] = (GLfloat)x;
+  }
+}
+
+void glUniform1f(GLint location, GLfloat x)
+{
+  GLfloat* value = currentUniform(location, false);
+  if (value != NULL)
+  {
+    value[0] = x;
+  }
+}
+
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+{
+  if (count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (location == UNIFORM_INSTANCES)
+  {
+    /* Checks the location; the rows themselves live in the program. */
+    if (currentUniform(location, false) != NULL)
+    {
+      ProgramObject* object = OBJECT(programs, context.program);
+      count = count < SOFTGL_MAX_UNIFORM_VECTORS ? count : SOFTGL_MAX_UNIFORM_VECTORS;
+      memcpy(object->instanceRows, value, count * 4 * sizeof(GLfloat));
+    }
+    return;
+  }
+  GLfloat* vector = currentUniform(location, false);
+  if (vector != NULL && count > 0)
+  {
+    memcpy(vector, value, 4 * sizeof(GLfloat));
+  }
+}
+
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+{
+  if (transpose != GL_FALSE || count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GLfloat* matrix = currentUniform(location, true);
+  if (matrix != NULL && count > 0)
+  {
+    memcpy(matrix, value, 16 * sizeof(GLfloat));
+  }
+}
+
+/* Vertex attributes. */
+
+void glEnableVertexAttribArray(GLuint index)
+{
+  if (index >= SOFTGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.attribs[index].enabled = true;
+}
+
+void glDisableVertexAttribArray(GLuint index)
+{
+  if (index >= SOFTGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  context.attribs[index].enabled = false;
+}
+
+static int attribTypeSize(GLenum type)
+{
+  switch (type)
+  {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:   return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT_OES:  return 2;
+    case GL_FIXED:
+    case GL_FLOAT:           return 4;
+    default:                 return 0;
+  }
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const GLvoid* ptr)
+{
+  if (index >= SOFTGL_MAX_ATTRIBS || size < 1 || size > 4 || stride < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (attribTypeSize(type) == 0)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  VertexAttrib& attrib = context.attribs[index];
+  attrib.size       = size;
+  attrib.type       = type;
+  attrib.normalized = normalized;
+  attrib.stride     = stride;
+  attrib.pointer    = ptr;
+  attrib.buffer     = context.arrayBuffer;
+}
+
+void glVertexAttrib4f(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+  if (index >= SOFTGL_MAX_ATTRIBS)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  GLfloat* current = context.attribs[index].current;
+  current[0] = x;
+  current[1] = y;
+  current[2] = z;
+  current[3] = w;
+}
+
+/* Drawing. */
+
+static float halfToFloat(GLushort half)
+{
+  int exponent = (half >> 10) & 0x1F;
+  int mantissa = half & 0x3FF;
+  float value;
+
+  if (exponent == 0)
+  {
+    value = ldexpf((float)mantissa, -24);
+  }
+  else if (exponent == 31)
+  {
+    value = mantissa ? NAN : INFINITY;
+  }
+  else
+  {
+    value = ldexpf((float)(mantissa | 0x400), exponent - 25);
+  }
+  return (half & 0x8000) ? -value : value;
+}
+
+/* One component of an attribute, normalized the ES 2.0 way (signed values map 2c+1). */
+static float convertComponent(GLenum type, GLboolean normalized, const unsigned char* data)
+{
+  switch (type)
+  {
+    case GL_BYTE:
+    {
+      GLbyte value = *(const GLbyte*)data;
+      return normalized ? (2.0f * value + 1.0f) / 255.0f : value;
+    }
+    case GL_UNSIGNED_BYTE:
+      return normalized ? *data / 255.0f : *data;
+    case GL_SHORT:
+    {
+      GLshort value;
+      memcpy(&value, data, sizeof(value));
+      return normalized ? (2.0f * value + 1.0f) / 65535.0f : value;
+    }
+    case GL_UNSIGNED_SHORT:
+    {
+      GLushort value;
+      memcpy(&value, data, sizeof(value));
+      return normalized ? value / 65535.0f : value;
+    }
+    case GL_HALF_FLOAT_OES:
+    {
+      GLushort value;
+      memcpy(&value, data, sizeof(value));
+      return halfToFloat(value);
+    }
+    case GL_FIXED:
+    {
+      GLfixed value;
+      memcpy(&value, data, sizeof(value));
+      return value / 65536.0f;
+    }
+    default:
+    {
+      GLfloat value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+  }
+}
+
+/* Where an attribute's data is for one draw. */
+struct AttribSource
+{
+  const VertexAttrib*   attrib;
+  const unsigned char*  data;
+  /* Bytes readable from data, or 0 for client memory which is not bounds checked. */
+  size_t                limit;
+  GLsizei               stride;
+  int                   elementSize;
+};
+
+static bool resolveAttrib(GLint location, AttribSource& source)
+{
+  source.attrib = location >= 0 ? &context.attribs[location] : NULL;
+  if (source.attrib == NULL || !source.attrib->enabled)
+  {
+    return false;
+  }
+
+  source.elementSize = attribTypeSize(source.attrib->type) * source.attrib->size;
+  source.stride = source.attrib->stride ? source.attrib->stride : source.elementSize;
+  source.limit = 0;
+  if (source.attrib->buffer != 0)
+  {
+    BufferObject* buffer = OBJECT(buffers, source.attrib->buffer);
+    size_t offset = (size_t)source.attrib->pointer;
+    if (buffer == NULL || buffer->data == NULL || offset >= (size_t)buffer->size)
+    {
+      source.data = NULL;
+      return true;
+    }
+    source.data = buffer->data + offset;
+    source.limit = buffer->size - offset;
+  }
+  else
+  {
+    source.data = (const unsigned char*)source.attrib->pointer;
+  }
+  return true;
+}
+
+static void fetchAttrib(const AttribSource& source, bool enabled, GLuint index, float* out)
+{
+  if (source.attrib == NULL)
+  {
+    return;
+  }
+  if (!enabled)
+  {
+    memcpy(out, source.attrib->current, 4 * sizeof(float));
+    return;
+  }
+
+  size_t offset = (size_t)index * source.stride;
+  out[0] = out[1] = out[2] = 0.0f;
+  out[3] = 1.0f;
+  if (source.data == NULL || (source.limit && offset + source.elementSize > source.limit))
+  {
+    return;
+  }
+  int componentSize = attribTypeSize(source.attrib->type);
+  for (int i = 0; i < source.attrib->size; i++)
+  {
+    out[i] = convertComponent(source.attrib->type, source.attrib->normalized,
+                              source.data + offset + i * componentSize);
+  }
+}
+
+static bool reserve(void** array, GLsizei* capacity, GLsizei count, size_t elementSize)
+{
+  if (count <= *capacity)
+  {
+    return true;
+  }
+  GLsizei newCapacity = *capacity ? *capacity : 256;
+  while (newCapacity < count)
+  {
+    newCapacity *= 2;
+  }
+  void* grown = realloc(*array, newCapacity * elementSize);
+  if (grown == NULL)
+  {
+    setError(GL_OUT_OF_MEMORY);
+    return false;
+  }
+  *array = grown;
+  *capacity = newCapacity;
+  return true;
+}
+
+static void multiplyMatrix(const GLfloat* left, const GLfloat* right, GLfloat* out)
+{
+  for (int column = 0; column < 4; column++)
+  {
+    for (int row = 0; row < 4; row++)
+    {
+      float sum = 0.0f;
+      for (int k = 0; k < 4; k++)
+      {
+        sum += left[k * 4 + row] * right[column * 4 + k];
+      }
+      out[column * 4 + row] = sum;
+    }
+  }
+}
+
+/* Run the vertex stage over indices, assemble triangles and rasterize them. */
+static void drawIndexed(GLenum mode, GLsizei count)
+{
+  ProgramObject* program = OBJECT(programs, context.program);
+  if (program == NULL || count < 3)
+  {
+    return;
+  }
+  if (!currentTarget(context.draw.target))
+  {
+    setError(GL_INVALID_FRAMEBUFFER_OPERATION);
+    return;
+  }
+
+  GLuint minIndex = context.indices[0];
+  GLuint maxIndex = context.indices[0];
+  for (GLsizei i = 1; i < count; i++)
+  {
+    minIndex = context.indices[i] < minIndex ? context.indices[i] : minIndex;
+    maxIndex = context.indices[i] > maxIndex ? context.indices[i] : maxIndex;
+  }
+  GLsizei vertexCount = maxIndex - minIndex + 1;
+  GLsizei triangleCount = mode == GL_TRIANGLES ? count / 3 : count - 2;
+  if (!reserve((void**)&context.vertices, &context.vertexCapacity, vertexCount, sizeof(SoftVertex)) ||
+      !reserve((void**)&context.triangles, &context.triangleCapacity, triangleCount * 3, sizeof(GLuint)))
+  {
+    return;
+  }
+
+  /* Vertex stage. */
+  GLfloat transform[16];
+  if (program->features & PROGRAM_MVP)
+  {
+    memcpy(transform, program->uniforms[UNIFORM_MVP], sizeof(transform));
+  }
+  else
+  {
+    multiplyMatrix(program->uniforms[UNIFORM_PROJECTION], program->uniforms[UNIFORM_MODELVIEW], transform);
+  }
+
+  AttribSource sources[SEMANTIC_COUNT];
+  bool enabled[SEMANTIC_COUNT];
+  for (int i = 0; i < SEMANTIC_COUNT; i++)
+  {
+    enabled[i] = resolveAttrib(program->attribLocations[i], sources[i]);
+  }
+  for (GLsizei i = 0; i < vertexCount; i++)
+  {
+    SoftVertex& vertex = context.vertices[i];
+    float position[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    float texCoord[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    vertex.color[0] = vertex.color[1] = vertex.color[2] = vertex.color[3] = 1.0f;
+
+    fetchAttrib(sources[SEMANTIC_POSITION], enabled[SEMANTIC_POSITION], minIndex + i, position);
+    fetchAttrib(sources[SEMANTIC_COLOR], enabled[SEMANTIC_COLOR], minIndex + i, vertex.color);
+    fetchAttrib(sources[SEMANTIC_TEX_COORD], enabled[SEMANTIC_TEX_COORD], minIndex + i, texCoord);
+    if (program->features & PROGRAM_INSTANCED)
+    {
+      float instance[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+      fetchAttrib(sources[SEMANTIC_INSTANCE], enabled[SEMANTIC_INSTANCE], minIndex + i, instance);
+      int first = (int)instance[0] * 3;
+      first = first >= 0 && first + 3 <= SOFTGL_MAX_UNIFORM_VECTORS ? first : 0;
+      float model[4];
+      for (int row = 0; row < 3; row++)
+      {
+        const GLfloat* rows = program->instanceRows[first + row];
+        model[row] = rows[0] * position[0] + rows[1] * position[1] + rows[2] * position[2] + rows[3] * position[3];
+      }
+      model[3] = 1.0f;
+      memcpy(position, model, sizeof(position));
+    }
+    for (int row = 0; row < 4; row++)
+    {
+      vertex.position[row] = transform[row] * position[0] + transform[4 + row] * position[1] +
+                             transform[8 + row] * position[2] + transform[12 + row] * position[3];
+    }
+    vertex.texCoord[0] = texCoord[0];
+    vertex.texCoord[1] = texCoord[1];
+  }
+
+  /* Primitive assembly; strips alternate their winding so every triangle keeps the first one's. */
+  GLuint* triangle = context.triangles;
+  for (GLsizei i = 0; i < triangleCount; i++, triangle += 3)
+  {
+    const GLuint* index = context.indices + (mode == GL_TRIANGLES ? 3 * i : i);
+    if (mode == GL_TRIANGLE_FAN)
+    {
+      triangle[0] = context.indices[0] - minIndex;
+      triangle[1] = index[1] - minIndex;
+      triangle[2] = index[2] - minIndex;
+    }
+    else if (mode == GL_TRIANGLE_STRIP && (i & 1))
+    {
+      triangle[0] = index[1] - minIndex;
+      triangle[1] = index[0] - minIndex;
+      triangle[2] = index[2] - minIndex;
+    }
+    else
+    {
+      triangle[0] = index[0] - minIndex;
+      triangle[1] = index[1] - minIndex;
+      triangle[2] = index[2] - minIndex;
+    }
+  }
+
+  /* Fragment state. */
+  context.draw.shading = ((program->features & PROGRAM_COLOR) ? SOFT_SHADE_COLOR : 0) |
+                         ((program->features & PROGRAM_TEXTURE) ? SOFT_SHADE_TEXTURE : 0);
+  context.draw.texture = NULL;
+  if (program->features & PROGRAM_TEXTURE)
+  {
+    int unit = (int)program->uniforms[UNIFORM_SAMPLER][0];
+    if (unit >= 0 && unit < SOFTGL_MAX_TEXTURE_UNITS)
+    {
+      context.draw.texture = textureObject(context.boundTextures[unit][(program->features & PROGRAM_EXTERNAL) ? 1 : 0]);
+    }
+  }
+  context.draw.textureMix = program->uniforms[UNIFORM_TEXTURE_MIX][0];
+
+  rasterizer.drawTriangles(context.draw, context.vertices, context.triangles, triangleCount);
+}
+
+static bool validDrawMode(GLenum mode)
+{
+  switch (mode)
+  {
+    case GL_TRIANGLES:
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+      return true;
+    case GL_POINTS:
+    case GL_LINES:
+    case GL_LINE_LOOP:
+    case GL_LINE_STRIP:
+      /* Valid, but points and lines are not rasterized. */
+      return false;
+    default:
+      setError(GL_INVALID_ENUM);
+      return false;
+  }
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+  if (first < 0 || count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (!validDrawMode(mode) ||
+      !reserve((void**)&context.indices, &context.indexCapacity, count, sizeof(GLuint)))
+  {
+    return;
+  }
+  for (GLsizei i = 0; i < count; i++)
+  {
+    context.indices[i] = first + i;
+  }
+  drawIndexed(mode, count);
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
+{
+  if (count < 0)
+  {
+    setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT)
+  {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  if (!validDrawMode(mode) ||
+      !reserve((void**)&context.indices, &context.indexCapacity, count, sizeof(GLuint)))
+  {
+    return;
+  }
+
+  const unsigned char* data = (const unsigned char*)indices;
+  size_t size = count * (type == GL_UNSIGNED_BYTE ? 1 : 2);
+  if (context.elementArrayBuffer != 0)
+  {
+    BufferObject* buffer = OBJECT(buffers, context.elementArrayBuffer);
+    size_t offset = (size_t)indices;
+    if (buffer == NULL || buffer->data == NULL || offset + size > (size_t)buffer->size)
+    {
+      setError(GL_INVALID_OPERATION);
+      return;
+    }
+    data = buffer->data + offset;
+  }
+  if (data == NULL)
+  {
+    return;
+  }
+
+  for (GLsizei i = 0; i < count; i++)
+  {
+    if (type == GL_UNSIGNED_BYTE)
+    {
+      context.indices[i] = data[i];
+    }
+    else
+    {
+      GLushort index;
+      memcpy(&index, data + 2 * i, sizeof(index));
+      context.indices[i] = index;
+    }
+  }
+  drawIndexed(mode, count);
+}
@@ -0,0 +1,872 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SoftRasterizer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include <cutils/atomic.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SOFT_RASTERIZER_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SOFT_RASTERIZER_NEON 1
+#endif
+
+    /* Interpolated per pixel: depth, 1/w, then color and texture coordinates divided by w. */
+    enum
+    {
+        interpolantDepth,
+        interpolantInverseW,
+        interpolantColor,
+        interpolantTexCoord = interpolantColor + 4,
+        interpolantCount = interpolantTexCoord + 2
+    };
+
+    struct SoftRasterizer::Triangle
+    {
+        /* Edge function i, a[i] * x + b[i] * y + c[i], is the weight of vertex i times twice
+         * the triangle's area. All three are positive inside the triangle. */
+        float   a[3];
+        float   b[3];
+        float   c[3];
+        /* Whether pixel centers exactly on edge i are covered (the top-left rule). */
+        bool    inclusive[3];
+        float   inverseArea;
+        /* Pixels that may be covered, x0, y0, x1, y1 with x1 and y1 exclusive. */
+        int     bounds[4];
+        /* Interpolants at vertex 0 and their differences to vertices 1 and 2. */
+        float   value[interpolantCount];
+        float   delta1[interpolantCount];
+        float   delta2[interpolantCount];
+    };
+
+    struct SoftRasterizer::Tile
+    {
+        int     rect[4];
+        /* Indices of the triangles overlapping the tile, in submission order. */
+        int*    triangles;
+        int     count;
+        int     capacity;
+    };
+
+    SoftRasterizer::SoftRasterizer(void)
+        : workerCount(0), jobGeneration(0), workersDone(0), quit(false), state(NULL),
+          triangles(NULL), triangleCount(0), triangleCapacity(0), tiles(NULL), tileCapacity(0),
+          tilesX(0), tilesY(0), activeTiles(NULL), activeTileCount(0), nextTile(0), fragmentCount(0),
+          texture(NULL)
+    {
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&startCondition, NULL);
+        pthread_cond_init(&doneCondition, NULL);
+        resetStats();
+    }
+
+    SoftRasterizer::~SoftRasterizer(void)
+    {
+        stop();
+        for (int i = 0; i < tileCapacity; i++)
+        {
+            free(tiles[i].triangles);
+        }
+        free(tiles);
+        free(activeTiles);
+        free(triangles);
+        pthread_cond_destroy(&doneCondition);
+        pthread_cond_destroy(&startCondition);
+        pthread_mutex_destroy(&lock);
+    }
+
+    bool SoftRasterizer::start(int threads)
+    {
+        stop();
+        if (threads <= 0)
+        {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            threads = cpus > 0 ? (int)cpus : 1;
+        }
+        if (threads > maxThreads)
+        {
+            threads = maxThreads;
+        }
+
+        quit = false;
+        jobGeneration = 0;
+        for (workerCount = 0; workerCount < threads - 1; workerCount++)
+        {
+            if (pthread_create(&workers[workerCount], NULL, workerMain, this) != 0)
+            {
+                fprintf(stderr, "SoftRasterizer: could only start %d of %d threads\n", workerCount + 1, threads);
+                return workerCount > 0;
+            }
+        }
+        return true;
+    }
+
+    void SoftRasterizer::stop(void)
+    {
+        pthread_mutex_lock(&lock);
+        quit = true;
+        pthread_cond_broadcast(&startCondition);
+        pthread_mutex_unlock(&lock);
+
+        for (int i = 0; i < workerCount; i++)
+        {
+            pthread_join(workers[i], NULL);
+        }
+        workerCount = 0;
+    }
+
+    void SoftRasterizer::resetStats(void)
+    {
+        memset(&drawStats, 0, sizeof(drawStats));
+    }
+
+    void* SoftRasterizer::workerMain(void* arg)
+    {
+        SoftRasterizer* rasterizer = (SoftRasterizer*)arg;
+        unsigned int generation = 0;
+
+        pthread_mutex_lock(&rasterizer->lock);
+        for (;;)
+        {
+            while (rasterizer->jobGeneration == generation && !rasterizer->quit)
+            {
+                pthread_cond_wait(&rasterizer->startCondition, &rasterizer->lock);
+            }
+            if (rasterizer->quit)
+            {
+                break;
+            }
+            generation = rasterizer->jobGeneration;
+            pthread_mutex_unlock(&rasterizer->lock);
+
+            unsigned int fragments = rasterizer->runTiles();
+
+            pthread_mutex_lock(&rasterizer->lock);
+            rasterizer->fragmentCount += fragments;
+            if (++rasterizer->workersDone == rasterizer->workerCount)
+            {
+                pthread_cond_signal(&rasterizer->doneCondition);
+            }
+        }
+        pthread_mutex_unlock(&rasterizer->lock);
+        return NULL;
+    }
+
+    unsigned int SoftRasterizer::runTiles(void)
+    {
+        unsigned int fragments = 0;
+        for (;;)
+        {
+            int tile = android_atomic_inc(&nextTile);
+            if (tile >= activeTileCount)
+            {
+                return fragments;
+            }
+            rasterizeTile(tiles[activeTiles[tile]], fragments);
+        }
+    }
+
+    bool SoftRasterizer::resizeTiles(int width, int height)
+    {
+        int x = (width + tileSize - 1) / tileSize;
+        int y = (height + tileSize - 1) / tileSize;
+
+        if (x * y > tileCapacity)
+        {
+            Tile* newTiles = (Tile*)realloc(tiles, x * y * sizeof(Tile));
+            if (newTiles == NULL)
+            {
+                return false;
+            }
+            tiles = newTiles;
+            memset(tiles + tileCapacity, 0, (x * y - tileCapacity) * sizeof(Tile));
+            tileCapacity = x * y;
+
+            int* newActiveTiles = (int*)realloc(activeTiles, tileCapacity * sizeof(int));
+            if (newActiveTiles == NULL)
+            {
+                return false;
+            }
+            activeTiles = newActiveTiles;
+        }
+
+        tilesX = x;
+        tilesY = y;
+        for (int ty = 0; ty < tilesY; ty++)
+        {
+            for (int tx = 0; tx < tilesX; tx++)
+            {
+                Tile& tile = tiles[ty * tilesX + tx];
+                tile.rect[0] = tx * tileSize;
+                tile.rect[1] = ty * tileSize;
+                tile.rect[2] = tile.rect[0] + tileSize < width ? tile.rect[0] + tileSize : width;
+                tile.rect[3] = tile.rect[1] + tileSize < height ? tile.rect[1] + tileSize : height;
+                tile.count = 0;
+            }
+        }
+        activeTileCount = 0;
+        return true;
+    }
+
+    /* An ES 2.0 texture without mipmaps is complete only with a non-mipmapped minification
+     * filter, and a non-power-of-two one only if it also clamps to the edge. */
+    static bool textureComplete(const SoftTexture* texture)
+    {
+        if (texture == NULL || texture->pixels == NULL)
+        {
+            return false;
+        }
+        if (texture->minFilter != GL_NEAREST && texture->minFilter != GL_LINEAR &&
+            (texture->width > 1 || texture->height > 1))
+        {
+            return false;
+        }
+        bool powerOfTwo = (texture->width & (texture->width - 1)) == 0 &&
+                          (texture->height & (texture->height - 1)) == 0;
+        return powerOfTwo || (texture->wrapS == GL_CLAMP_TO_EDGE && texture->wrapT == GL_CLAMP_TO_EDGE);
+    }
+
+    void SoftRasterizer::drawTriangles(const SoftDrawState& drawState, const SoftVertex* vertices,
+                                       const GLuint* indices, int count)
+    {
+        const SoftRenderTarget& target = drawState.target;
+
+        drawStats.draws++;
+        drawStats.triangles += count;
+        if (count <= 0 || target.color == NULL || !resizeTiles(target.width, target.height))
+        {
+            return;
+        }
+
+        /* Triangles are not clipped against the side planes; pixels outside the viewport
+         * are never visited instead. */
+        int x0 = drawState.viewport[0] > 0 ? drawState.viewport[0] : 0;
+        int y0 = drawState.viewport[1] > 0 ? drawState.viewport[1] : 0;
+        int x1 = drawState.viewport[0] + drawState.viewport[2];
+        int y1 = drawState.viewport[1] + drawState.viewport[3];
+        x1 = x1 < target.width ? x1 : target.width;
+        y1 = y1 < target.height ? y1 : target.height;
+        if (drawState.scissorTest)
+        {
+            x0 = drawState.scissor[0] > x0 ? drawState.scissor[0] : x0;
+            y0 = drawState.scissor[1] > y0 ? drawState.scissor[1] : y0;
+            x1 = drawState.scissor[0] + drawState.scissor[2] < x1 ? drawState.scissor[0] + drawState.scissor[2] : x1;
+            y1 = drawState.scissor[1] + drawState.scissor[3] < y1 ? drawState.scissor[1] + drawState.scissor[3] : y1;
+        }
+        if (x0 >= x1 || y0 >= y1)
+        {
+            return;
+        }
+        clipRect[0] = x0;
+        clipRect[1] = y0;
+        clipRect[2] = x1;
+        clipRect[3] = y1;
+
+        state = &drawState;
+        texture = (drawState.shading & SOFT_SHADE_TEXTURE) && textureComplete(drawState.texture) ?
+                  drawState.texture : NULL;
+        triangleCount = 0;
+        for (int i = 0; i < count; i++)
+        {
+            clipTriangle(vertices[indices[3 * i]], vertices[indices[3 * i + 1]], vertices[indices[3 * i + 2]]);
+        }
+
+        nextTile = 0;
+        fragmentCount = 0;
+        if (workerCount > 0 && activeTileCount > 1)
+        {
+            pthread_mutex_lock(&lock);
+            workersDone = 0;
+            jobGeneration++;
+            pthread_cond_broadcast(&startCondition);
+            pthread_mutex_unlock(&lock);
+
+            unsigned int fragments = runTiles();
+
+            pthread_mutex_lock(&lock);
+            fragmentCount += fragments;
+            while (workersDone < workerCount)
+            {
+                pthread_cond_wait(&doneCondition, &lock);
+            }
+            pthread_mutex_unlock(&lock);
+        }
+        else
+        {
+            fragmentCount = runTiles();
+        }
+        drawStats.fragments += fragmentCount;
+
+        for (int i = 0; i < activeTileCount; i++)
+        {
+            tiles[activeTiles[i]].count = 0;
+        }
+        activeTileCount = 0;
+        state = NULL;
+    }
+
+    static void interpolateVertex(SoftVertex& out, const SoftVertex& from, const SoftVertex& to, float t)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            out.position[i] = from.position[i] + (to.position[i] - from.position[i]) * t;
+            out.color[i] = from.color[i] + (to.color[i] - from.color[i]) * t;
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            out.texCoord[i] = from.texCoord[i] + (to.texCoord[i] - from.texCoord[i]) * t;
+        }
+    }
+
+    void SoftRasterizer::clipTriangle(const SoftVertex& v0, const SoftVertex& v1, const SoftVertex& v2)
+    {
+        const SoftVertex* in[3] = { &v0, &v1, &v2 };
+        /* Signed distances to the near plane, z = -w. */
+        float distance[3];
+        int inside = 0;
+
+        for (int i = 0; i < 3; i++)
+        {
+            distance[i] = in[i]->position[2] + in[i]->position[3];
+            inside += distance[i] >= 0.0f;
+        }
+        if (inside == 3)
+        {
+            setupTriangle(v0, v1, v2);
+            return;
+        }
+        if (inside == 0)
+        {
+            drawStats.culled++;
+            return;
+        }
+
+        SoftVertex polygon[4];
+        int vertexCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            int next = i == 2 ? 0 : i + 1;
+            if (distance[i] >= 0.0f)
+            {
+                polygon[vertexCount++] = *in[i];
+            }
+            if ((distance[i] >= 0.0f) != (distance[next] >= 0.0f))
+            {
+                interpolateVertex(polygon[vertexCount++], *in[i], *in[next],
+                                  distance[i] / (distance[i] - distance[next]));
+            }
+        }
+        for (int i = 1; i + 1 < vertexCount; i++)
+        {
+            setupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+        }
+    }
+
+    void SoftRasterizer::setupTriangle(const SoftVertex& v0, const SoftVertex& v1, const SoftVertex& v2)
+    {
+        const SoftVertex* vertex[3] = { &v0, &v1, &v2 };
+        const GLint* viewport = state->viewport;
+        float x[3];
+        float y[3];
+        float inverseW[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            float w = vertex[i]->position[3];
+            if (!(w > 1e-6f))
+            {
+                drawStats.culled++;
+                return;
+            }
+            inverseW[i] = 1.0f / w;
+            x[i] = (vertex[i]->position[0] * inverseW[i] * 0.5f + 0.5f) * viewport[2] + viewport[0];
+            y[i] = (vertex[i]->position[1] * inverseW[i] * 0.5f + 0.5f) * viewport[3] + viewport[1];
+        }
+
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+        if (!(fabsf(area) > 0.0f))
+        {
+            drawStats.culled++;
+            return;
+        }
+        bool front = (state->frontFace == GL_CCW) == (area > 0.0f);
+        if (state->cullFace &&
+            (state->cullMode == GL_FRONT_AND_BACK ||
+             (state->cullMode == GL_BACK && !front) ||
+             (state->cullMode == GL_FRONT && front)))
+        {
+            drawStats.culled++;
+            return;
+        }
+
+        /* Make the winding counter-clockwise so the edge functions are positive inside. */
+        int order[3] = { 0, 1, 2 };
+        if (area < 0.0f)
+        {
+            order[1] = 2;
+            order[2] = 1;
+            area = -area;
+        }
+
+        float minX = x[0], maxX = x[0], minY = y[0], maxY = y[0];
+        for (int i = 1; i < 3; i++)
+        {
+            minX = x[i] < minX ? x[i] : minX;
+            maxX = x[i] > maxX ? x[i] : maxX;
+            minY = y[i] < minY ? y[i] : minY;
+            maxY = y[i] > maxY ? y[i] : maxY;
+        }
+        /* Clamp before converting, vertices close to the eye plane project very far away. */
+        minX = minX > clipRect[0] ? minX : clipRect[0];
+        minY = minY > clipRect[1] ? minY : clipRect[1];
+        maxX = maxX < clipRect[2] ? maxX : clipRect[2];
+        maxY = maxY < clipRect[3] ? maxY : clipRect[3];
+        if (minX >= maxX || minY >= maxY)
+        {
+            drawStats.culled++;
+            return;
+        }
+
+        if (triangleCount == triangleCapacity)
+        {
+            int capacity = triangleCapacity ? triangleCapacity * 2 : 256;
+            Triangle* newTriangles = (Triangle*)realloc(triangles, capacity * sizeof(Triangle));
+            if (newTriangles == NULL)
+            {
+                drawStats.culled++;
+                return;
+            }
+            triangles = newTriangles;
+            triangleCapacity = capacity;
+        }
+
+        Triangle& triangle = triangles[triangleCount];
+        triangle.bounds[0] = (int)floorf(minX);
+        triangle.bounds[1] = (int)floorf(minY);
+        triangle.bounds[2] = (int)ceilf(maxX);
+        triangle.bounds[3] = (int)ceilf(maxY);
+        triangle.inverseArea = 1.0f / area;
+
+        for (int i = 0; i < 3; i++)
+        {
+            int from = order[i == 2 ? 0 : i + 1];
+            int to = order[i == 0 ? 2 : i - 1];
+            float dx = x[to] - x[from];
+            float dy = y[to] - y[from];
+
+            triangle.a[i] = -dy;
+            triangle.b[i] = dx;
+            triangle.c[i] = dy * x[from] - dx * y[from];
+            /* Left edges run downwards, top edges run leftwards. */
+            triangle.inclusive[i] = dy < 0.0f || (dy == 0.0f && dx < 0.0f);
+        }
+
+        float values[3][interpolantCount];
+        for (int i = 0; i < 3; i++)
+        {
+            const SoftVertex* v = vertex[order[i]];
+            float w = inverseW[order[i]];
+
+            values[i][interpolantDepth] = v->position[2] * w * 0.5f + 0.5f;
+            values[i][interpolantInverseW] = w;
+            for (int j = 0; j < 4; j++)
+            {
+                values[i][interpolantColor + j] = v->color[j] * w;
+            }
+            for (int j = 0; j < 2; j++)
+            {
+                values[i][interpolantTexCoord + j] = v->texCoord[j] * w;
+            }
+        }
+        for (int j = 0; j < interpolantCount; j++)
+        {
+            triangle.value[j] = values[0][j];
+            triangle.delta1[j] = values[1][j] - values[0][j];
+            triangle.delta2[j] = values[2][j] - values[0][j];
+        }
+
+        binTriangle(triangleCount++);
+    }
+
+    void SoftRasterizer::binTriangle(int index)
+    {
+        const Triangle& triangle = triangles[index];
+        int tx0 = triangle.bounds[0] / tileSize;
+        int ty0 = triangle.bounds[1] / tileSize;
+        int tx1 = (triangle.bounds[2] - 1) / tileSize;
+        int ty1 = (triangle.bounds[3] - 1) / tileSize;
+
+        for (int ty = ty0; ty <= ty1; ty++)
+        {
+            for (int tx = tx0; tx <= tx1; tx++)
+            {
+                Tile& tile = tiles[ty * tilesX + tx];
+
+                /* Skip tiles entirely outside one edge, tested at the pixel center
+                 * of the tile that is furthest inside that edge. */
+                bool outside = false;
+                for (int i = 0; i < 3 && !outside; i++)
+                {
+                    float x = (triangle.a[i] > 0.0f ? tile.rect[2] - 1 : tile.rect[0]) + 0.5f;
+                    float y = (triangle.b[i] > 0.0f ? tile.rect[3] - 1 : tile.rect[1]) + 0.5f;
+                    outside = triangle.a[i] * x + triangle.b[i] * y + triangle.c[i] < 0.0f;
+                }
+                if (outside)
+                {
+                    continue;
+                }
+
+                if (tile.count == tile.capacity)
+                {
+                    int capacity = tile.capacity ? tile.capacity * 2 : 64;
+                    int* newTriangles = (int*)realloc(tile.triangles, capacity * sizeof(int));
+                    if (newTriangles == NULL)
+                    {
+                        continue;
+                    }
+                    tile.triangles = newTriangles;
+                    tile.capacity = capacity;
+                }
+                if (tile.count == 0)
+                {
+                    activeTiles[activeTileCount++] = ty * tilesX + tx;
+                }
+                tile.triangles[tile.count++] = index;
+                drawStats.binned++;
+            }
+        }
+    }
+
+    unsigned int SoftRasterizer::coverQuad(const Triangle& triangle, int x, int y, float* weight1, float* weight2)
+    {
+        float px = x + 0.5f;
+        float py = y + 0.5f;
+
+#if defined(SOFT_RASTERIZER_SSE2)
+        __m128 vx = _mm_add_ps(_mm_set1_ps(px), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+        __m128 vy = _mm_set1_ps(py);
+        __m128 zero = _mm_setzero_ps();
+        __m128 covered = _mm_cmpeq_ps(zero, zero);
+        __m128 weight[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            weight[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.a[i]), vx),
+                                              _mm_mul_ps(_mm_set1_ps(triangle.b[i]), vy)),
+                                   _mm_set1_ps(triangle.c[i]));
+            covered = _mm_and_ps(covered, triangle.inclusive[i] ? _mm_cmpge_ps(weight[i], zero) :
+                                                                  _mm_cmpgt_ps(weight[i], zero));
+        }
+        _mm_storeu_ps(weight1, weight[1]);
+        _mm_storeu_ps(weight2, weight[2]);
+        return _mm_movemask_ps(covered);
+#elif defined(SOFT_RASTERIZER_NEON)
+        static const float laneOffsets[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        static const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+        float32x4_t vx = vaddq_f32(vdupq_n_f32(px), vld1q_f32(laneOffsets));
+        float32x4_t vy = vdupq_n_f32(py);
+        float32x4_t zero = vdupq_n_f32(0.0f);
+        uint32x4_t covered = vdupq_n_u32(0xFFFFFFFF);
+        float32x4_t weight[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            weight[i] = vmlaq_f32(vmlaq_f32(vdupq_n_f32(triangle.c[i]), vdupq_n_f32(triangle.a[i]), vx),
+                                  vdupq_n_f32(triangle.b[i]), vy);
+            covered = vandq_u32(covered, triangle.inclusive[i] ? vcgeq_f32(weight[i], zero) :
+                                                                 vcgtq_f32(weight[i], zero));
+        }
+        vst1q_f32(weight1, weight[1]);
+        vst1q_f32(weight2, weight[2]);
+        uint32x4_t bits = vandq_u32(covered, vld1q_u32(laneBits));
+        return vgetq_lane_u32(bits, 0) | vgetq_lane_u32(bits, 1) | vgetq_lane_u32(bits, 2) | vgetq_lane_u32(bits, 3);
+#else
+        unsigned int mask = 0;
+        for (int lane = 0; lane < 4; lane++)
+        {
+            bool covered = true;
+            float weight[3];
+            for (int i = 0; i < 3; i++)
+            {
+                weight[i] = triangle.a[i] * (px + lane) + triangle.b[i] * py + triangle.c[i];
+                covered = covered && (triangle.inclusive[i] ? weight[i] >= 0.0f : weight[i] > 0.0f);
+            }
+            weight1[lane] = weight[1];
+            weight2[lane] = weight[2];
+            mask |= covered << lane;
+        }
+        return mask;
+#endif
+    }
+
+    static bool depthPasses(GLenum function, float depth, float stored)
+    {
+        switch (function)
+        {
+            case GL_NEVER:      return false;
+            case GL_LESS:       return depth < stored;
+            case GL_EQUAL:      return depth == stored;
+            case GL_LEQUAL:     return depth <= stored;
+            case GL_GREATER:    return depth > stored;
+            case GL_NOTEQUAL:   return depth != stored;
+            case GL_GEQUAL:     return depth >= stored;
+            default:            return true;
+        }
+    }
+
+    static int wrapCoordinate(int i, int size, GLenum mode)
+    {
+        switch (mode)
+        {
+            case GL_REPEAT:
+                i %= size;
+                return i < 0 ? i + size : i;
+            case GL_MIRRORED_REPEAT:
+                i %= 2 * size;
+                i = i < 0 ? i + 2 * size : i;
+                return i < size ? i : 2 * size - 1 - i;
+            default:
+                return i < 0 ? 0 : (i >= size ? size - 1 : i);
+        }
+    }
+
+    static void unpackColor(uint32_t pixel, float* color)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            color[i] = ((pixel >> (8 * i)) & 0xFF) * (1.0f / 255.0f);
+        }
+    }
+
+    /* The level of detail is not computed, so filtering is bilinear whenever either filter
+     * asks for it. Incomplete textures (NULL here) sample as opaque black. */
+    static void sampleTexture(const SoftTexture* texture, float s, float t, float* color)
+    {
+        if (texture == NULL)
+        {
+            color[0] = color[1] = color[2] = 0.0f;
+            color[3] = 1.0f;
+            return;
+        }
+
+        const float limit = 16777216.0f;
+        float u = s * texture->width;
+        float v = t * texture->height;
+        u = u > limit ? limit : (u < -limit ? -limit : u);
+        v = v > limit ? limit : (v < -limit ? -limit : v);
+
+        if (texture->magFilter != GL_LINEAR && texture->minFilter != GL_LINEAR)
+        {
+            int x = wrapCoordinate((int)floorf(u), texture->width, texture->wrapS);
+            int y = wrapCoordinate((int)floorf(v), texture->height, texture->wrapT);
+            unpackColor(texture->pixels[y * texture->width + x], color);
+            return;
+        }
+
+        u -= 0.5f;
+        v -= 0.5f;
+        float fu = floorf(u);
+        float fv = floorf(v);
+        float ax = u - fu;
+        float ay = v - fv;
+        int x0 = wrapCoordinate((int)fu, texture->width, texture->wrapS);
+        int x1 = wrapCoordinate((int)fu + 1, texture->width, texture->wrapS);
+        int y0 = wrapCoordinate((int)fv, texture->height, texture->wrapT) * texture->width;
+        int y1 = wrapCoordinate((int)fv + 1, texture->height, texture->wrapT) * texture->width;
+
+        float texel[4][4];
+        unpackColor(texture->pixels[y0 + x0], texel[0]);
+        unpackColor(texture->pixels[y0 + x1], texel[1]);
+        unpackColor(texture->pixels[y1 + x0], texel[2]);
+        unpackColor(texture->pixels[y1 + x1], texel[3]);
+        for (int i = 0; i < 4; i++)
+        {
+            float bottom = texel[0][i] + (texel[1][i] - texel[0][i]) * ax;
+            float top = texel[2][i] + (texel[3][i] - texel[2][i]) * ax;
+            color[i] = bottom + (top - bottom) * ay;
+        }
+    }
+
+    static float blendFactor(GLenum factor, const float* source, const float* destination, int channel)
+    {
+        switch (factor)
+        {
+            case GL_ZERO:                   return 0.0f;
+            case GL_SRC_COLOR:              return source[channel];
+            case GL_ONE_MINUS_SRC_COLOR:    return 1.0f - source[channel];
+            case GL_DST_COLOR:              return destination[channel];
+            case GL_ONE_MINUS_DST_COLOR:    return 1.0f - destination[channel];
+            case GL_SRC_ALPHA:              return source[3];
+            case GL_ONE_MINUS_SRC_ALPHA:    return 1.0f - source[3];
+            case GL_DST_ALPHA:              return destination[3];
+            case GL_ONE_MINUS_DST_ALPHA:    return 1.0f - destination[3];
+            case GL_SRC_ALPHA_SATURATE:
+                if (channel == 3)
+                {
+                    return 1.0f;
+                }
+                return source[3] < 1.0f - destination[3] ? source[3] : 1.0f - destination[3];
+            default:                        return 1.0f;
+        }
+    }
+
+    static unsigned int toByte(float value)
+    {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (unsigned int)(value * 255.0f + 0.5f);
+    }
+
+    void SoftRasterizer::rasterizeTile(const Tile& tile, unsigned int& fragments)
+    {
+        const SoftRenderTarget& target = state->target;
+        bool useColor = (state->shading & SOFT_SHADE_COLOR) != 0;
+        bool useTexture = (state->shading & SOFT_SHADE_TEXTURE) != 0;
+        bool depthTest = state->depthTest && target.depth != NULL;
+
+        for (int n = 0; n < tile.count; n++)
+        {
+            const Triangle& triangle = triangles[tile.triangles[n]];
+            int x0 = triangle.bounds[0] > tile.rect[0] ? triangle.bounds[0] : tile.rect[0];
+            int y0 = triangle.bounds[1] > tile.rect[1] ? triangle.bounds[1] : tile.rect[1];
+            int x1 = triangle.bounds[2] < tile.rect[2] ? triangle.bounds[2] : tile.rect[2];
+            int y1 = triangle.bounds[3] < tile.rect[3] ? triangle.bounds[3] : tile.rect[3];
+
+            for (int y = y0; y < y1; y++)
+            {
+                for (int x = x0; x < x1; x += 4)
+                {
+                    float weight1[4];
+                    float weight2[4];
+                    unsigned int mask = coverQuad(triangle, x, y, weight1, weight2);
+                    if (x1 - x < 4)
+                    {
+                        mask &= (1 << (x1 - x)) - 1;
+                    }
+
+                    for (int lane = 0; mask != 0; lane++, mask >>= 1)
+                    {
+                        if ((mask & 1) == 0)
+                        {
+                            continue;
+                        }
+
+                        int index = y * target.width + x + lane;
+                        float b1 = weight1[lane] * triangle.inverseArea;
+                        float b2 = weight2[lane] * triangle.inverseArea;
+
+                        /* Near plane clipping leaves depths at most rounding errors below 0;
+                         * fragments beyond the far plane would have been clipped. */
+                        float depth = triangle.value[interpolantDepth] + b1 * triangle.delta1[interpolantDepth] +
+                                      b2 * triangle.delta2[interpolantDepth];
+                        if (depth > 1.0f)
+                        {
+                            continue;
+                        }
+                        depth = depth < 0.0f ? 0.0f : depth;
+                        if (depthTest)
+                        {
+                            if (!depthPasses(state->depthFunc, depth, target.depth[index]))
+                            {
+                                continue;
+                            }
+                            if (state->depthMask)
+                            {
+                                target.depth[index] = depth;
+                            }
+                        }
+
+                        float w = 1.0f / (triangle.value[interpolantInverseW] +
+                                          b1 * triangle.delta1[interpolantInverseW] +
+                                          b2 * triangle.delta2[interpolantInverseW]);
+                        float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+                        if (useColor)
+                        {
+                            for (int i = 0; i < 4; i++)
+                            {
+                                int j = interpolantColor + i;
+                                color[i] = (triangle.value[j] + b1 * triangle.delta1[j] + b2 * triangle.delta2[j]) * w;
+                            }
+                        }
+                        if (useTexture)
+                        {
+                            int s = interpolantTexCoord;
+                            int t = interpolantTexCoord + 1;
+                            float texel[4];
+                            sampleTexture(texture,
+                                          (triangle.value[s] + b1 * triangle.delta1[s] + b2 * triangle.delta2[s]) * w,
+                                          (triangle.value[t] + b1 * triangle.delta1[t] + b2 * triangle.delta2[t]) * w,
+                                          texel);
+                            float mix = useColor ? state->textureMix : 1.0f;
+                            for (int i = 0; i < 4; i++)
+                            {
+                                color[i] += (texel[i] - color[i]) * mix;
+                            }
+                        }
+
+                        if (state->blend)
+                        {
+                            float destination[4];
+                            float source[4];
+                            unpackColor(target.color[index], destination);
+                            for (int i = 0; i < 4; i++)
+                            {
+                                source[i] = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+                            }
+                            for (int i = 0; i < 4; i++)
+                            {
+                                color[i] = source[i] * blendFactor(state->blendSrc, source, destination, i) +
+                                           destination[i] * blendFactor(state->blendDst, source, destination, i);
+                            }
+                        }
+                        target.color[index] = softPackColor(toByte(color[0]), toByte(color[1]),
+                                                            toByte(color[2]), toByte(color[3]));
+                        fragments++;
+                    }
+                }
+            }
+        }
+    }
+
+    void SoftRasterizer::clear(const SoftRenderTarget& target, const GLint* rect,
+                               bool clearColor, uint32_t color, bool clearDepth, float depth)
+    {
+        for (int y = rect[1]; y < rect[1] + rect[3]; y++)
+        {
+            int row = y * target.width + rect[0];
+            if (clearColor && target.color != NULL)
+            {
+                for (int x = 0; x < rect[2]; x++)
+                {
+                    target.color[row + x] = color;
+                }
+            }
+            if (clearDepth && target.depth != NULL)
+            {
+                for (int x = 0; x < rect[2]; x++)
+                {
+                    target.depth[row + x] = depth;
+                }
+            }
+        }
+    }
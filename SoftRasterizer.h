@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SOFTRASTERIZER_H
+#define SOFTRASTERIZER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <GLES2/gl2.h>
+
+/**
+ * \file SoftRasterizer.h
+ * \brief Tile based triangle rasterizer behind the software GLES2 backend (see SoftGL.h).
+ */
+
+    /**
+     * \brief Pack a color into a SoftRenderTarget pixel, red in the lowest byte so the
+     * pixels have the GL_RGBA/GL_UNSIGNED_BYTE layout in memory on little endian hosts.
+     */
+    static inline uint32_t softPackColor(unsigned int r, unsigned int g, unsigned int b, unsigned int a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    /**
+     * \brief Color buffer and optional depth buffer drawn to. Rows are stored bottom-up like
+     * GL window coordinates, one packed pixel (see softPackColor) per element.
+     */
+    struct SoftRenderTarget
+    {
+        int         width;
+        int         height;
+        uint32_t*   color;
+        /** Depth values in [0, 1], NULL if the target has no depth buffer. */
+        float*      depth;
+    };
+
+    /**
+     * \brief A level 0 only RGBA texture and its sampler state.
+     */
+    struct SoftTexture
+    {
+        int         width;
+        int         height;
+        uint32_t*   pixels;
+        GLenum      minFilter;
+        GLenum      magFilter;
+        GLenum      wrapS;
+        GLenum      wrapT;
+    };
+
+    /**
+     * \brief A shaded vertex: clip space position and the varyings the fragment stage reads.
+     */
+    struct SoftVertex
+    {
+        float   position[4];
+        float   color[4];
+        float   texCoord[2];
+    };
+
+    /**
+     * \brief What the fragment stage outputs. With both flags the vertex color and the
+     * texel are mixed by SoftDrawState::textureMix, with neither the fragment is white.
+     */
+    enum SoftShading
+    {
+        SOFT_SHADE_COLOR   = 1,
+        SOFT_SHADE_TEXTURE = 2
+    };
+
+    /**
+     * \brief The fixed function and fragment state of one draw call.
+     */
+    struct SoftDrawState
+    {
+        SoftRenderTarget    target;
+        GLint               viewport[4];
+        bool                scissorTest;
+        GLint               scissor[4];
+        bool                cullFace;
+        GLenum              cullMode;
+        GLenum              frontFace;
+        bool                depthTest;
+        bool                depthMask;
+        GLenum              depthFunc;
+        bool                blend;
+        GLenum              blendSrc;
+        GLenum              blendDst;
+        unsigned int        shading;
+        /** Texture sampled with SOFT_SHADE_TEXTURE, NULL or incomplete samples as black. */
+        const SoftTexture*  texture;
+        float               textureMix;
+    };
+
+    /**
+     * \brief Clips, culls and bins triangles into screen tiles, then rasterizes the tiles on
+     * a pool of worker threads.
+     *
+     * Each tile is owned by one thread for the whole draw and walks its triangles in
+     * submission order, so depth testing and blending need no synchronization and give the
+     * same result as a serial rasterizer. Coverage is computed four pixels at a time from
+     * the triangle's edge functions with SSE2 or NEON when available.
+     */
+    class SoftRasterizer
+    {
+    public:
+        /**
+         * \brief Width and height of a screen tile in pixels.
+         */
+        static const int tileSize = 64;
+
+        /**
+         * \brief Maximum number of threads rasterizing tiles.
+         */
+        static const int maxThreads = 32;
+
+        /**
+         * \brief Triangle and pixel counts, accumulated until resetStats().
+         */
+        struct Stats
+        {
+            unsigned int    draws;
+            unsigned int    triangles;
+            /** Triangles dropped by culling, the near plane or having no area. */
+            unsigned int    culled;
+            /** Triangle/tile pairs rasterized. */
+            unsigned int    binned;
+            unsigned int    fragments;
+        };
+
+        SoftRasterizer(void);
+        ~SoftRasterizer(void);
+
+        /**
+         * \brief Start the worker threads.
+         * \param[in] threadCount Threads rasterizing tiles, including the caller; 0 for one
+         * per online CPU.
+         * \return False if no worker could be started, the caller then rasterizes alone.
+         */
+        bool start(int threadCount);
+
+        /**
+         * \brief Stop and join the worker threads.
+         */
+        void stop(void);
+
+        /**
+         * \brief Number of threads rasterizing tiles, including the caller.
+         */
+        int threadCount(void) const { return workerCount + 1; }
+
+        /**
+         * \brief Draw a triangle list.
+         * \param[in] state The state to draw with.
+         * \param[in] vertices The shaded vertices.
+         * \param[in] indices Three indices into vertices per triangle.
+         * \param[in] triangleCount The number of triangles.
+         *
+         * Returns when the triangles are in the target.
+         */
+        void drawTriangles(const SoftDrawState& state, const SoftVertex* vertices,
+                           const GLuint* indices, int triangleCount);
+
+        /**
+         * \brief Clear part of a target.
+         * \param[in] rect x, y, width and height of the region, already inside the target.
+         */
+        static void clear(const SoftRenderTarget& target, const GLint* rect,
+                          bool clearColor, uint32_t color, bool clearDepth, float depth);
+
+        const Stats& stats(void) const { return drawStats; }
+        void resetStats(void);
+
+    private:
+        struct Triangle;
+        struct Tile;
+
+        static void* workerMain(void* arg);
+        /* Rasterize tiles until none are left, return the fragments shaded. */
+        unsigned int runTiles(void);
+        void rasterizeTile(const Tile& tile, unsigned int& fragments);
+        /* Coverage of the four pixels from (x, y) as a bit mask, lane i for pixel x + i, and
+         * the unnormalized weights of vertices 1 and 2 at those pixels. */
+        static unsigned int coverQuad(const Triangle& triangle, int x, int y, float* weight1, float* weight2);
+        /* Project, cull and set up one clipped triangle, binning it on success. */
+        void setupTriangle(const SoftVertex& v0, const SoftVertex& v1, const SoftVertex& v2);
+        void clipTriangle(const SoftVertex& v0, const SoftVertex& v1, const SoftVertex& v2);
+        void binTriangle(int index);
+        bool resizeTiles(int width, int height);
+
+        pthread_t           workers[maxThreads - 1];
+        int                 workerCount;
+        pthread_mutex_t     lock;
+        pthread_cond_t      startCondition;
+        pthread_cond_t      doneCondition;
+        unsigned int        jobGeneration;
+        int                 workersDone;
+        bool                quit;
+
+        /* The draw being rasterized. */
+        const SoftDrawState* state;
+        /* The region pixels may be written to: viewport, scissor and target intersected. */
+        int                 clipRect[4];
+        Triangle*           triangles;
+        int                 triangleCount;
+        int                 triangleCapacity;
+        Tile*               tiles;
+        int                 tileCapacity;
+        int                 tilesX;
+        int                 tilesY;
+        int*                activeTiles;
+        int                 activeTileCount;
+        volatile int32_t    nextTile;
+        unsigned int        fragmentCount;
+        /* The texture of the draw, NULL if it is incomplete. */
+        const SoftTexture*  texture;
+        Stats               drawStats;
+    };
+
+#endif /* SOFTRASTERIZER_H */
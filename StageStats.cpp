@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StageStats.h"
+
+#include <cstring>
+
+    static const char* const stageNames[STAGE_COUNT] =
+    {
+        "fboPass",
+        "mainPass",
+        "batch",
+        "submit",
+        "eglSwapBuffers",
+        "fbLock",
+        "fbCopy",
+        "fbUnlock",
+    };
+
+    StageStats::StageStats(void)
+        : exportFile(NULL), exportJson(false)
+    {
+        memset(started, 0, sizeof(started));
+        resetStats();
+    }
+
+    StageStats::~StageStats()
+    {
+        if (exportFile != NULL)
+        {
+            fclose(exportFile);
+        }
+    }
+
+    void StageStats::begin(FrameStage stage)
+    {
+        started[stage] = systemTime(SYSTEM_TIME_THREAD);
+    }
+
+    void StageStats::end(FrameStage stage)
+    {
+        add(stage, systemTime(SYSTEM_TIME_THREAD) - started[stage]);
+    }
+
+    void StageStats::add(FrameStage stage, nsecs_t cpuTime)
+    {
+        Histogram& histogram = histograms[stage];
+        if (histogram.count == 0 || cpuTime < histogram.min)
+        {
+            histogram.min = cpuTime;
+        }
+        if (cpuTime > histogram.max)
+        {
+            histogram.max = cpuTime;
+        }
+        histogram.total += cpuTime;
+        histogram.count++;
+        histogram.buckets[bucketOf(cpuTime)]++;
+    }
+
+    /* Values below 8 ns have a bucket each, above that every power of two is split in eight. */
+    int StageStats::bucketOf(nsecs_t value)
+    {
+        if (value < 8)
+        {
+            return value > 0 ? (int)value : 0;
+        }
+        int highBit = 3;
+        while (highBit < 62 && (value >> (highBit + 1)) != 0)
+        {
+            highBit++;
+        }
+        int bucket = (highBit - 2) * 8 + (int)((value >> (highBit - 3)) & 7);
+        return bucket < bucketCount ? bucket : bucketCount - 1;
+    }
+
+    nsecs_t StageStats::bucketValue(int bucket)
+    {
+        if (bucket < 8)
+        {
+            return bucket;
+        }
+        int shift = bucket / 8 - 1;
+        nsecs_t low = (nsecs_t)(8 + bucket % 8) << shift;
+        return low + ((nsecs_t)1 << shift) / 2;
+    }
+
+    nsecs_t StageStats::percentile(const Histogram& histogram, unsigned int percent) const
+    {
+        unsigned int rank = (histogram.count * percent + 99) / 100;
+        unsigned int seen = 0;
+        rank = rank ? rank : 1;
+        for (int bucket = 0; bucket < bucketCount; bucket++)
+        {
+            seen += histogram.buckets[bucket];
+            if (seen >= rank)
+            {
+                /* The bucket midpoint can lie outside what was actually measured. */
+                nsecs_t value = bucketValue(bucket);
+                value = value < histogram.min ? histogram.min : value;
+                return value > histogram.max ? histogram.max : value;
+            }
+        }
+        return histogram.max;
+    }
+
+    StageStats::Summary StageStats::summarize(FrameStage stage) const
+    {
+        const Histogram& histogram = histograms[stage];
+        Summary summary;
+        memset(&summary, 0, sizeof(summary));
+        if (histogram.count == 0)
+        {
+            return summary;
+        }
+        summary.count   = histogram.count;
+        summary.min     = histogram.min;
+        summary.average = histogram.total / histogram.count;
+        summary.p50     = percentile(histogram, 50);
+        summary.p95     = percentile(histogram, 95);
+        summary.p99     = percentile(histogram, 99);
+        summary.max     = histogram.max;
+        return summary;
+    }
+
+    const char* StageStats::stageName(FrameStage stage)
+    {
+        return stageNames[stage];
+    }
+
+    bool StageStats::openExport(const char* path)
+    {
+        if (exportFile != NULL)
+        {
+            fclose(exportFile);
+        }
+        exportFile = fopen(path, "w");
+        if (exportFile == NULL)
+        {
+            fprintf(stderr, "Could not create stage statistics file %s\n", path);
+            return false;
+        }
+        size_t length = strlen(path);
+        exportJson = length >= 5 && strcmp(path + length - 5, ".json") == 0;
+        if (!exportJson)
+        {
+            fprintf(exportFile, "interval,stage,count,min_us,avg_us,p50_us,p95_us,p99_us,max_us\n");
+        }
+        return true;
+    }
+
+    void StageStats::exportStats(const char* label)
+    {
+        if (exportFile == NULL)
+        {
+            return;
+        }
+        bool first = true;
+        if (exportJson)
+        {
+            fprintf(exportFile, "{\"interval\":\"%s\",\"stages\":{", label);
+        }
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            Summary summary = summarize((FrameStage)stage);
+            if (summary.count == 0)
+            {
+                continue;
+            }
+            exportSummary(label, stageNames[stage], summary, first);
+            first = false;
+        }
+        if (exportJson)
+        {
+            fprintf(exportFile, "}}\n");
+        }
+        /* Keep the file complete up to the last interval if the program is killed. */
+        fflush(exportFile);
+    }
+
+    void StageStats::exportTimes(const char* label, const char* const* names, const nsecs_t* times, int count)
+    {
+        if (exportFile == NULL)
+        {
+            return;
+        }
+        if (exportJson)
+        {
+            fprintf(exportFile, "{\"interval\":\"%s\",\"stages\":{", label);
+        }
+        for (int i = 0; i < count; i++)
+        {
+            Summary summary = { 1, times[i], times[i], times[i], times[i], times[i], times[i] };
+            exportSummary(label, names[i], summary, i == 0);
+        }
+        if (exportJson)
+        {
+            fprintf(exportFile, "}}\n");
+        }
+        fflush(exportFile);
+    }
+
+    void StageStats::exportSummary(const char* label, const char* name, const Summary& summary, bool first)
+    {
+        if (exportJson)
+        {
+            fprintf(exportFile, "%s\"%s\":{\"count\":%u,\"min_us\":%.3f,\"avg_us\":%.3f,\"p50_us\":%.3f,"
+                    "\"p95_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+                    first ? "" : ",", name, summary.count,
+                    summary.min / 1e3, summary.average / 1e3, summary.p50 / 1e3,
+                    summary.p95 / 1e3, summary.p99 / 1e3, summary.max / 1e3);
+        }
+        else
+        {
+            fprintf(exportFile, "%s,%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                    label, name, summary.count,
+                    summary.min / 1e3, summary.average / 1e3, summary.p50 / 1e3,
+                    summary.p95 / 1e3, summary.p99 / 1e3, summary.max / 1e3);
+        }
+    }
+
+    void StageStats::printStats(const char* label) const
+    {
+        fprintf(stderr, "Stage CPU time (%s), min/avg/p50/p95/p99/max in ms:\n", label);
+        for (int stage = 0; stage < STAGE_COUNT; stage++)
+        {
+            Summary summary = summarize((FrameStage)stage);
+            if (summary.count == 0)
+            {
+                continue;
+            }
+            fprintf(stderr, "  %-16s %6u  %.3f/%.3f/%.3f/%.3f/%.3f/%.3f\n",
+                    stageNames[stage], summary.count,
+                    summary.min / 1e6, summary.average / 1e6, summary.p50 / 1e6,
+                    summary.p95 / 1e6, summary.p99 / 1e6, summary.max / 1e6);
+        }
+    }
+
+    void StageStats::resetStats(void)
+    {
+        memset(histograms, 0, sizeof(histograms));
+    }
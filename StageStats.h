@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STAGESTATS_H
+#define STAGESTATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <utils/Timers.h>
+
+/**
+ * \file StageStats.h
+ * \brief CPU time of the stages of a frame, kept in fixed-size histograms.
+ */
+
+    /**
+     * \brief The timed stages of a frame, used to index StageStats.
+     */
+    enum FrameStage
+    {
+        STAGE_FBO_PASS,
+        STAGE_MAIN_PASS,
+        /** Transforming the objects drawn with -N and recording their draws. */
+        STAGE_BATCH,
+        /** Sorting and issuing the commands the passes recorded. */
+        STAGE_SUBMIT,
+        STAGE_SWAP,
+        /** fillFbTexture: locking the capture buffer, copying the framebuffer into it, unlocking it.
+         *  Host builds have no buffer to lock and time the texture upload as the copy. */
+        STAGE_FB_LOCK,
+        STAGE_FB_COPY,
+        STAGE_FB_UNLOCK,
+        STAGE_COUNT
+    };
+
+    /**
+     * \brief Per-stage CPU time statistics over an interval, with percentiles.
+     *
+     * Stages are timed with the thread CPU clock, so time a stage spends blocked, such as
+     * eglSwapBuffers waiting for a buffer, does not count. Each stage has a log-linear
+     * histogram of bucketCount buckets, eight per power of two, so percentiles are within
+     * about 6% of the true value and recording a sample never allocates.
+     *
+     * Statistics can be exported to a file as CSV, one row per stage and interval, or as JSON,
+     * one object per interval and line.
+     */
+    class StageStats
+    {
+    public:
+        /**
+         * \brief Histogram buckets per stage; the last one holds everything above about a minute.
+         */
+        static const int bucketCount = 272;
+
+        /**
+         * \brief Statistics of one stage over an interval, in nanoseconds.
+         */
+        struct Summary
+        {
+            unsigned int    count;
+            nsecs_t         min;
+            nsecs_t         average;
+            nsecs_t         p50;
+            nsecs_t         p95;
+            nsecs_t         p99;
+            nsecs_t         max;
+        };
+
+        StageStats(void);
+        ~StageStats();
+
+        /**
+         * \brief Start timing a stage on the calling thread.
+         */
+        void begin(FrameStage stage);
+
+        /**
+         * \brief Stop timing a stage and add the CPU time since begin() to its histogram.
+         */
+        void end(FrameStage stage);
+
+        /**
+         * \brief Add one sample to a stage.
+         */
+        void add(FrameStage stage, nsecs_t cpuTime);
+
+        /**
+         * \brief Summarize a stage over the current interval.
+         */
+        Summary summarize(FrameStage stage) const;
+
+        static const char* stageName(FrameStage stage);
+
+        /**
+         * \brief Export every following exportStats() to a file, as JSON if the name ends in
+         * ".json" and as CSV otherwise.
+         * \return false if the file could not be created.
+         */
+        bool openExport(const char* path);
+
+        /**
+         * \brief Append the statistics of the stages that ran in this interval to the export file, if any.
+         * \param[in] label A label for the interval, such as the frame range it covers.
+         */
+        void exportStats(const char* label);
+
+        /**
+         * \brief Append single measurements, such as the phases of startup, to the export file,
+         * if any, as one record of count stages measured once each.
+         * \param[in] names Their names, in place of the stage names.
+         */
+        void exportTimes(const char* label, const char* const* names, const nsecs_t* times, int count);
+
+        /**
+         * \brief Print the statistics of the stages that ran in this interval to stderr.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        struct Histogram
+        {
+            uint32_t    buckets[bucketCount];
+            unsigned int count;
+            nsecs_t     min;
+            nsecs_t     max;
+            nsecs_t     total;
+        };
+
+        void exportSummary(const char* label, const char* name, const Summary& summary, bool first);
+        static int bucketOf(nsecs_t value);
+        /* Midpoint of a bucket. */
+        static nsecs_t bucketValue(int bucket);
+        nsecs_t percentile(const Histogram& histogram, unsigned int percent) const;
+
+        Histogram   histograms[STAGE_COUNT];
+        nsecs_t     started[STAGE_COUNT];
+        FILE*       exportFile;
+        bool        exportJson;
+    };
+
+#endif /* STAGESTATS_H */
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "StartupProfiler.h"
+#include "TraceEvents.h"
+
+#include <cstdio>
+
+    StartupProfiler::StartupProfiler(void)
+        : phaseCount(0), started(0), cpuStarted(0), phaseStarted(0), phaseCpuStarted(0), ended(0),
+          presented(false)
+    {
+    }
+
+    void StartupProfiler::start(const char* firstPhase)
+    {
+        started      = systemTime(SYSTEM_TIME_MONOTONIC);
+        cpuStarted   = systemTime(SYSTEM_TIME_THREAD);
+        phaseCount   = 0;
+        presented    = false;
+        phaseStarted = started;
+        phaseCpuStarted = cpuStarted;
+        phase(firstPhase);
+    }
+
+    void StartupProfiler::phase(const char* name)
+    {
+        if (presented)
+        {
+            return;
+        }
+        nsecs_t now    = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t cpuNow = systemTime(SYSTEM_TIME_THREAD);
+        endPhase(now, cpuNow);
+        if (phaseCount < STARTUP_MAX_PHASES)
+        {
+            phases[phaseCount].name     = name;
+            phases[phaseCount].wallTime = 0;
+            phases[phaseCount].cpuTime  = 0;
+            phaseCount++;
+        }
+        phaseStarted    = now;
+        phaseCpuStarted = cpuNow;
+    }
+
+    void StartupProfiler::endPhase(nsecs_t now, nsecs_t cpuNow)
+    {
+        if (phaseCount == 0)
+        {
+            return;
+        }
+        Phase& current = phases[phaseCount - 1];
+        current.wallTime += now - phaseStarted;
+        current.cpuTime  += cpuNow - phaseCpuStarted;
+        if (traceEventsEnabled)
+        {
+            recordTraceEvent(current.name, phaseStarted, now);
+        }
+    }
+
+    void StartupProfiler::firstFramePresented(void)
+    {
+        if (presented || phaseCount == 0)
+        {
+            return;
+        }
+        ended = systemTime(SYSTEM_TIME_MONOTONIC);
+        endPhase(ended, systemTime(SYSTEM_TIME_THREAD));
+        presented = true;
+    }
+
+    void StartupProfiler::exportStats(StageStats* stats) const
+    {
+        if (!presented)
+        {
+            return;
+        }
+        const char* names[STARTUP_MAX_PHASES + 1];
+        nsecs_t     times[STARTUP_MAX_PHASES + 1];
+        names[0] = "timeToFirstFrame";
+        times[0] = getTimeToFirstFrame();
+        for (int i = 0; i < phaseCount; i++)
+        {
+            names[i + 1] = phases[i].name;
+            times[i + 1] = phases[i].wallTime;
+        }
+        stats->exportTimes("startup", names, times, phaseCount + 1);
+    }
+
+    void StartupProfiler::printStats(void) const
+    {
+        if (!presented)
+        {
+            return;
+        }
+        nsecs_t cpuTotal = 0;
+        for (int i = 0; i < phaseCount; i++)
+        {
+            cpuTotal += phases[i].cpuTime;
+        }
+        fprintf(stderr, "Startup: first frame presented after %.2f ms, %.2f ms of it on the CPU\n",
+                (ended - started) / 1e6, cpuTotal / 1e6);
+        for (int i = 0; i < phaseCount; i++)
+        {
+            fprintf(stderr, "  %-16s %8.2f ms  %8.2f ms CPU  %5.1f%%\n", phases[i].name,
+                    phases[i].wallTime / 1e6, phases[i].cpuTime / 1e6,
+                    ended > started ? 100.0 * phases[i].wallTime / (ended - started) : 0.0);
+        }
+    }
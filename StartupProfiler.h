@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <utils/Timers.h>
+
+#include "StageStats.h"
+
+/**
+ * \file StartupProfiler.h
+ * \brief Wall and CPU time of the phases of startup, up to the first frame presented.
+ */
+
+/**
+ * \brief Phases kept; later ones are folded into the last.
+ */
+#define STARTUP_MAX_PHASES  16
+
+    /**
+     * \brief Times startup as a sequence of back to back phases.
+     *
+     * start() is called first thing in main(), then phase() as each phase begins, which also
+     * ends the one before, so the phases cover all of startup without gaps. firstFramePresented()
+     * ends the last phase once the first frame has been handed to the display; the time from
+     * start() to then is the time to first frame. Each phase has the monotonic time it took and
+     * the CPU time of the calling thread, the difference being time spent blocked, such as in
+     * the driver waiting for the display. Phases are also recorded as trace events when -T is
+     * recording.
+     */
+    class StartupProfiler
+    {
+    public:
+        StartupProfiler(void);
+
+        /**
+         * \brief Start timing startup with its first phase.
+         */
+        void start(const char* firstPhase);
+
+        /**
+         * \brief End the current phase and begin the next.
+         * \param[in] name A string that outlives the profiler, normally a literal.
+         */
+        void phase(const char* name);
+
+        /**
+         * \brief End the last phase; only the first call counts.
+         */
+        void firstFramePresented(void);
+
+        /**
+         * \brief Time from start() to firstFramePresented(), 0 before the first frame.
+         */
+        nsecs_t getTimeToFirstFrame(void) const { return presented ? ended - started : 0; }
+
+        /**
+         * \brief Print the time to first frame and each phase to stderr.
+         */
+        void printStats(void) const;
+
+        /**
+         * \brief Write the time to first frame and each phase's wall time to the stage
+         * statistics export, as the interval "startup".
+         */
+        void exportStats(StageStats* stats) const;
+
+    private:
+        void endPhase(nsecs_t now, nsecs_t cpuNow);
+
+        struct Phase
+        {
+            const char* name;
+            nsecs_t     wallTime;
+            nsecs_t     cpuTime;
+        };
+
+        Phase       phases[STARTUP_MAX_PHASES];
+        int         phaseCount;
+        nsecs_t     started;
+        nsecs_t     cpuStarted;
+        nsecs_t     phaseStarted;
+        nsecs_t     phaseCpuStarted;
+        nsecs_t     ended;
+        bool        presented;
+    };
+
+#endif /* STARTUPPROFILER_H */
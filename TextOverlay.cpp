@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextOverlay.h"
+#include "Matrix.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "GLTrace.h"
+
+    /* Font pixels per character cell, the glyph plus one column and two rows of spacing. */
+    static const int cellWidth  = 6;
+    static const int cellHeight = 9;
+
+    static const char firstGlyph = ' ';
+    static const char lastGlyph  = '_';
+
+    /* 5x7 glyphs from ' ' to '_', one byte per column from the left, bit 0 the top row. */
+    static const GLubyte font[lastGlyph - firstGlyph + 1][5] =
+    {
+        { 0x00, 0x00, 0x00, 0x00, 0x00 }, /*   */
+        { 0x00, 0x00, 0x5F, 0x00, 0x00 }, /* ! */
+        { 0x00, 0x07, 0x00, 0x07, 0x00 }, /* " */
+        { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, /* # */
+        { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, /* $ */
+        { 0x23, 0x13, 0x08, 0x64, 0x62 }, /* % */
+        { 0x36, 0x49, 0x55, 0x22, 0x50 }, /* & */
+        { 0x00, 0x05, 0x03, 0x00, 0x00 }, /* ' */
+        { 0x00, 0x1C, 0x22, 0x41, 0x00 }, /* ( */
+        { 0x00, 0x41, 0x22, 0x1C, 0x00 }, /* ) */
+        { 0x14, 0x08, 0x3E, 0x08, 0x14 }, /* * */
+        { 0x08, 0x08, 0x3E, 0x08, 0x08 }, /* + */
+        { 0x00, 0x50, 0x30, 0x00, 0x00 }, /* , */
+        { 0x08, 0x08, 0x08, 0x08, 0x08 }, /* - */
+        { 0x00, 0x60, 0x60, 0x00, 0x00 }, /* . */
+        { 0x20, 0x10, 0x08, 0x04, 0x02 }, /* / */
+        { 0x3E, 0x51, 0x49, 0x45, 0x3E }, /* 0 */
+        { 0x00, 0x42, 0x7F, 0x40, 0x00 }, /* 1 */
+        { 0x42, 0x61, 0x51, 0x49, 0x46 }, /* 2 */
+        { 0x21, 0x41, 0x45, 0x4B, 0x31 }, /* 3 */
+        { 0x18, 0x14, 0x12, 0x7F, 0x10 }, /* 4 */
+        { 0x27, 0x45, 0x45, 0x45, 0x39 }, /* 5 */
+        { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, /* 6 */
+        { 0x01, 0x71, 0x09, 0x05, 0x03 }, /* 7 */
+        { 0x36, 0x49, 0x49, 0x49, 0x36 }, /* 8 */
+        { 0x06, 0x49, 0x49, 0x29, 0x1E }, /* 9 */
+        { 0x00, 0x36, 0x36, 0x00, 0x00 }, /* : */
+        { 0x00, 0x56, 0x36, 0x00, 0x00 }, /* ; */
+        { 0x08, 0x14, 0x22, 0x41, 0x00 }, /* < */
+        { 0x14, 0x14, 0x14, 0x14, 0x14 }, /* = */
+        { 0x00, 0x41, 0x22, 0x14, 0x08 }, /* > */
+        { 0x02, 0x01, 0x51, 0x09, 0x06 }, /* ? */
+        { 0x32, 0x49, 0x79, 0x41, 0x3E }, /* @ */
+        { 0x7E, 0x11, 0x11, 0x11, 0x7E }, /* A */
+        { 0x7F, 0x49, 0x49, 0x49, 0x36 }, /* B */
+        { 0x3E, 0x41, 0x41, 0x41, 0x22 }, /* C */
+        { 0x7F, 0x41, 0x41, 0x22, 0x1C }, /* D */
+        { 0x7F, 0x49, 0x49, 0x49, 0x41 }, /* E */
+        { 0x7F, 0x09, 0x09, 0x09, 0x01 }, /* F */
+        { 0x3E, 0x41, 0x49, 0x49, 0x7A }, /* G */
+        { 0x7F, 0x08, 0x08, 0x08, 0x7F }, /* H */
+        { 0x00, 0x41, 0x7F, 0x41, 0x00 }, /* I */
+        { 0x20, 0x40, 0x41, 0x3F, 0x01 }, /* J */
+        { 0x7F, 0x08, 0x14, 0x22, 0x41 }, /* K */
+        { 0x7F, 0x40, 0x40, 0x40, 0x40 }, /* L */
+        { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, /* M */
+        { 0x7F, 0x04, 0x08, 0x10, 0x7F }, /* N */
+        { 0x3E, 0x41, 0x41, 0x41, 0x3E }, /* O */
+        { 0x7F, 0x09, 0x09, 0x09, 0x06 }, /* P */
+        { 0x3E, 0x41, 0x51, 0x21, 0x5E }, /* Q */
+        { 0x7F, 0x09, 0x19, 0x29, 0x46 }, /* R */
+        { 0x46, 0x49, 0x49, 0x49, 0x31 }, /* S */
+        { 0x01, 0x01, 0x7F, 0x01, 0x01 }, /* T */
+        { 0x3F, 0x40, 0x40, 0x40, 0x3F }, /* U */
+        { 0x1F, 0x20, 0x40, 0x20, 0x1F }, /* V */
+        { 0x3F, 0x40, 0x38, 0x40, 0x3F }, /* W */
+        { 0x63, 0x14, 0x08, 0x14, 0x63 }, /* X */
+        { 0x07, 0x08, 0x70, 0x08, 0x07 }, /* Y */
+        { 0x61, 0x51, 0x49, 0x45, 0x43 }, /* Z */
+        { 0x00, 0x7F, 0x41, 0x41, 0x00 }, /* [ */
+        { 0x02, 0x04, 0x08, 0x10, 0x20 }, /* \ */
+        { 0x00, 0x41, 0x41, 0x7F, 0x00 }, /* ] */
+        { 0x04, 0x02, 0x01, 0x02, 0x04 }, /* ^ */
+        { 0x40, 0x40, 0x40, 0x40, 0x40 }, /* _ */
+    };
+
+    /* Text is white, the cells behind it a translucent black. */
+    static const GLubyte textTexel[2]       = { 255, 255 };
+    static const GLubyte backgroundTexel[2] = { 0, 160 };
+
+    TextOverlay::TextOverlay(GLStateCache* state)
+        : state(state), columns(0), rows(0), width(0), height(0), pixels(NULL), texture(0), dirty(false)
+    {
+    }
+
+    TextOverlay::~TextOverlay()
+    {
+        free(pixels);
+    }
+
+    bool TextOverlay::setup(int columns, int rows)
+    {
+        this->columns = columns;
+        this->rows    = rows;
+        width  = columns * cellWidth;
+        height = rows * cellHeight;
+        pixels = (GLubyte*)malloc(width * height * 2);
+        if (pixels == NULL)
+        {
+            return false;
+        }
+
+        glGenTextures(1, &texture);
+        state->bindTexture(GL_TEXTURE_2D, texture);
+        /* Not a power of two, so it must clamp and must not be mipmapped. Drawn at whole
+         * multiples of its size, so nearest sampling keeps the glyphs sharp. */
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, width, height, 0, GL_LUMINANCE_ALPHA,
+                     GL_UNSIGNED_BYTE, NULL);
+
+        setText("");
+        return true;
+    }
+
+    void TextOverlay::setText(const char* text)
+    {
+        if (pixels == NULL)
+        {
+            return;
+        }
+        for (int i = 0; i < width * height; i++)
+        {
+            memcpy(pixels + i * 2, backgroundTexel, 2);
+        }
+
+        int row = 0;
+        int column = 0;
+        for (const char* c = text; *c != '\0' && row < rows; c++)
+        {
+            if (*c == '\n')
+            {
+                row++;
+                column = 0;
+                continue;
+            }
+            if (column >= columns)
+            {
+                continue;
+            }
+            char character = *c >= 'a' && *c <= 'z' ? *c - 'a' + 'A' : *c;
+            if (character < firstGlyph || character > lastGlyph)
+            {
+                character = ' ';
+            }
+            const GLubyte* glyph = font[character - firstGlyph];
+            for (int x = 0; x < 5; x++)
+            {
+                for (int y = 0; y < 7; y++)
+                {
+                    if (glyph[x] & (1 << y))
+                    {
+                        int texel = (row * cellHeight + 1 + y) * width + column * cellWidth + x;
+                        memcpy(pixels + texel * 2, textTexel, 2);
+                    }
+                }
+            }
+            column++;
+        }
+        dirty = true;
+    }
+
+    void TextOverlay::draw(ShaderVariant* variant, int surfaceWidth, int surfaceHeight, int scale)
+    {
+        if (texture == 0)
+        {
+            return;
+        }
+
+        state->activeTexture(GL_TEXTURE0);
+        state->bindTexture(GL_TEXTURE_2D, texture);
+        if (dirty)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, pixels);
+            dirty = false;
+        }
+
+        /* In window pixels, y down from the top left corner. */
+        GLfloat right  = (GLfloat)(width * scale);
+        GLfloat bottom = (GLfloat)(height * scale);
+        const GLfloat positions[] = { 0.0f, 0.0f,   0.0f, bottom,   right, 0.0f,   right, bottom };
+        const GLfloat texCoords[] = { 0.0f, 0.0f,   0.0f, 1.0f,     1.0f, 0.0f,    1.0f, 1.0f };
+        Matrix pixelToClip = Matrix::matrixOrthographic(0.0f, (float)surfaceWidth, (float)surfaceHeight, 0.0f,
+                                                        -1.0f, 1.0f);
+
+        state->useProgram(variant->program);
+        state->bindBuffer(GL_ARRAY_BUFFER, 0);
+        state->enableVertexAttribArray(ATTRIB_POSITION);
+        state->vertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, positions);
+        state->disableVertexAttribArray(ATTRIB_FILL_COLOR);
+        state->enableVertexAttribArray(ATTRIB_TEX_COORD);
+        state->vertexAttribPointer(ATTRIB_TEX_COORD, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+        state->uniformMatrix4fv(variant->mvp, pixelToClip.getAsArray());
+
+        /* Flat on top of everything, whichever way it winds after the flip. */
+        state->disable(GL_DEPTH_TEST);
+        state->disable(GL_CULL_FACE);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        state->enable(GL_CULL_FACE);
+        state->enable(GL_DEPTH_TEST);
+    }
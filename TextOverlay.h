@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEXTOVERLAY_H
+#define TEXTOVERLAY_H
+
+#include <GLES2/gl2.h>
+
+#include "GLStateCache.h"
+#include "ShaderVariants.h"
+
+/**
+ * \file TextOverlay.h
+ * \brief A block of monospaced text drawn over the window, for statistics.
+ */
+
+    /**
+     * \brief Draws a fixed grid of text cells as one textured quad in the top left corner.
+     *
+     * The text is rasterized on the CPU with a built-in 5x7 font into a luminance-alpha
+     * texture, which is uploaded only when the text changes, so a frame that draws the overlay
+     * costs one small draw. Characters from space to '_' are drawn, lower case as upper case,
+     * anything else as a space.
+     */
+    class TextOverlay
+    {
+    public:
+        /**
+         * \param[in] state State cache the overlay binds and draws through.
+         */
+        TextOverlay(GLStateCache* state);
+        ~TextOverlay();
+
+        /**
+         * \brief Create the texture for a grid of columns x rows characters. Needs a current context.
+         * \return false if the texture could not be allocated.
+         */
+        bool setup(int columns, int rows);
+
+        /**
+         * \brief Set the text, lines separated by '\\n'. Text beyond the grid is cut off.
+         */
+        void setText(const char* text);
+
+        /**
+         * \brief Draw the overlay, blending it over the bound framebuffer.
+         * \param[in] variant A SHADER_TEXTURE | SHADER_MVP variant.
+         * \param[in] scale Screen pixels per font pixel.
+         */
+        void draw(ShaderVariant* variant, int surfaceWidth, int surfaceHeight, int scale);
+
+        /**
+         * \brief Whether the text changed since the overlay was last drawn.
+         */
+        bool changed(void) const { return dirty; }
+
+        /**
+         * \brief Size of the overlay in font pixels, to be multiplied by the scale it is drawn at.
+         */
+        int getWidth(void) const { return width; }
+        int getHeight(void) const { return height; }
+
+    private:
+        GLStateCache*   state;
+        int             columns;
+        int             rows;
+        int             width;
+        int             height;
+        /* Luminance and alpha per texel. */
+        GLubyte*        pixels;
+        GLuint          texture;
+        bool            dirty;
+    };
+
+#endif /* TEXTOVERLAY_H */
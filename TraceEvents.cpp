@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TraceEvents.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <cutils/atomic.h>
+
+bool traceEventsEnabled = false;
+
+#if !GL2_CUBE_TRACE_EVENTS
+
+bool startTraceEvents(const char* path)
+{
+  fprintf(stderr, "Trace events: compiled out (GL2_CUBE_TRACE_EVENTS is 0), not writing %s\n", path);
+  return false;
+}
+
+void stopTraceEvents(void)
+{
+}
+
+void pollTraceEvents(void)
+{
+}
+
+void setTraceThreadName(const char* name)
+{
+}
+
+void recordTraceEvent(const char* name, nsecs_t start, nsecs_t end)
+{
+}
+
+#else
+
+struct TraceEvent
+{
+  const char* name;
+  nsecs_t     start;
+  nsecs_t     end;
+};
+
+/*
+ * The ring of one thread. Only the thread writes it; published counts the events written
+ * so far and is stored after each event, so a reader on another thread sees whole events
+ * up to it, and can tell which of the oldest were overwritten while it was reading.
+ */
+struct ThreadEvents
+{
+  ThreadEvents*     next;
+  pid_t             tid;
+  const char*       name;
+  volatile int32_t  published;
+  TraceEvent        events[TRACE_EVENTS_PER_THREAD];
+};
+
+static pthread_once_t         keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t          threadKey;
+/* Guards the list of threads, which only grows. */
+static pthread_mutex_t        threadsLock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadEvents*          threads;
+static const char*            tracePath;
+static nsecs_t                traceStart;
+static volatile sig_atomic_t  writeRequested;
+
+static void createThreadKey(void)
+{
+  pthread_key_create(&threadKey, NULL);
+}
+
+static void requestWrite(int signal)
+{
+  writeRequested = 1;
+}
+
+/* The ring of the calling thread, created on its first event. */
+static ThreadEvents* threadEvents(void)
+{
+  pthread_once(&keyOnce, createThreadKey);
+  ThreadEvents* thread = (ThreadEvents*)pthread_getspecific(threadKey);
+  if (thread != NULL)
+  {
+    return thread;
+  }
+
+  thread = (ThreadEvents*)malloc(sizeof(ThreadEvents));
+  if (thread == NULL)
+  {
+    return NULL;
+  }
+  thread->tid       = (pid_t)syscall(__NR_gettid);
+  thread->name      = NULL;
+  thread->published = 0;
+  pthread_setspecific(threadKey, thread);
+
+  pthread_mutex_lock(&threadsLock);
+  thread->next = threads;
+  threads = thread;
+  pthread_mutex_unlock(&threadsLock);
+  return thread;
+}
+
+void recordTraceEvent(const char* name, nsecs_t start, nsecs_t end)
+{
+  ThreadEvents* thread = threadEvents();
+  if (thread == NULL)
+  {
+    return;
+  }
+  uint32_t count = (uint32_t)thread->published;
+  TraceEvent& event = thread->events[count & (TRACE_EVENTS_PER_THREAD - 1)];
+  event.name  = name;
+  event.start = start;
+  event.end   = end;
+  android_atomic_release_store((int32_t)(count + 1), &thread->published);
+}
+
+void setTraceThreadName(const char* name)
+{
+  ThreadEvents* thread = traceEventsEnabled ? threadEvents() : NULL;
+  if (thread != NULL)
+  {
+    thread->name = name;
+  }
+}
+
+static bool writeTraceEvents(void)
+{
+  FILE* file = fopen(tracePath, "w");
+  if (file == NULL)
+  {
+    fprintf(stderr, "Trace events: could not create %s\n", tracePath);
+    return false;
+  }
+
+  pid_t pid = getpid();
+  unsigned int written = 0;
+  bool first = true;
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  pthread_mutex_lock(&threadsLock);
+  for (ThreadEvents* thread = threads; thread != NULL; thread = thread->next)
+  {
+    if (thread->name != NULL)
+    {
+      fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+              first ? "" : ",", pid, thread->tid, thread->name);
+      first = false;
+    }
+
+    uint32_t end = (uint32_t)android_atomic_acquire_load(&thread->published);
+    uint32_t begin = end > TRACE_EVENTS_PER_THREAD ? end - TRACE_EVENTS_PER_THREAD : 0;
+    for (uint32_t i = begin; i != end; i++)
+    {
+      TraceEvent event = thread->events[i & (TRACE_EVENTS_PER_THREAD - 1)];
+      /* Skip the event if the thread has wrapped around onto it, or is writing it, by now. */
+      if ((uint32_t)android_atomic_acquire_load(&thread->published) - i >= TRACE_EVENTS_PER_THREAD)
+      {
+        continue;
+      }
+      fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"gl2-cube\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+              "\"ts\":%.3f,\"dur\":%.3f}",
+              first ? "" : ",", event.name, pid, thread->tid,
+              (event.start - traceStart) / 1e3, (event.end - event.start) / 1e3);
+      first = false;
+      written++;
+    }
+  }
+  pthread_mutex_unlock(&threadsLock);
+
+  fprintf(file, "\n]}\n");
+  bool failed = ferror(file) != 0;
+  failed |= fclose(file) != 0;
+  if (failed)
+  {
+    fprintf(stderr, "Trace events: writing %s failed\n", tracePath);
+    return false;
+  }
+  fprintf(stderr, "Trace events: wrote %u events to %s\n", written, tracePath);
+  return true;
+}
+
+bool startTraceEvents(const char* path)
+{
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = requestWrite;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &action, NULL);
+
+  tracePath = path;
+  traceStart = systemTime(SYSTEM_TIME_MONOTONIC);
+  traceEventsEnabled = true;
+  fprintf(stderr, "Trace events: recording, written to %s at exit and on SIGUSR1\n", path);
+  return true;
+}
+
+void pollTraceEvents(void)
+{
+  if (writeRequested)
+  {
+    writeRequested = 0;
+    writeTraceEvents();
+  }
+}
+
+void stopTraceEvents(void)
+{
+  if (!traceEventsEnabled)
+  {
+    return;
+  }
+  traceEventsEnabled = false;
+  writeTraceEvents();
+}
+
+#endif /* GL2_CUBE_TRACE_EVENTS */
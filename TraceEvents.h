@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACEEVENTS_H
+#define TRACEEVENTS_H
+
+#include <utils/Timers.h>
+
+/**
+ * \file TraceEvents.h
+ * \brief Scoped timeline markers, written out as Chrome trace-event JSON.
+ *
+ * TRACE_EVENT("name") at the top of a scope records when the scope was entered and left.
+ * Each thread records into its own ring of the most recent events, so recording takes no
+ * lock; the rings are written out as a trace-event JSON file, which chrome://tracing and
+ * Perfetto open, when the program stops recording or gets SIGUSR1.
+ *
+ * While recording is off a marker costs a test of traceEventsEnabled. Markers are compiled
+ * in unless GL2_CUBE_TRACE_EVENTS is defined to 0.
+ */
+
+#ifndef GL2_CUBE_TRACE_EVENTS
+#define GL2_CUBE_TRACE_EVENTS 1
+#endif
+
+/**
+ * \brief Events kept per thread; older ones are overwritten.
+ */
+#define TRACE_EVENTS_PER_THREAD 65536
+
+    /**
+     * \brief Whether markers are being recorded.
+     */
+    extern bool traceEventsEnabled;
+
+    /**
+     * \brief Start recording markers, to be written to path.
+     * \return false if markers are compiled out.
+     */
+    bool startTraceEvents(const char* path);
+
+    /**
+     * \brief Write the recorded markers and stop recording.
+     */
+    void stopTraceEvents(void);
+
+    /**
+     * \brief Write the markers recorded so far if SIGUSR1 asked for it. Call once per frame.
+     */
+    void pollTraceEvents(void);
+
+    /**
+     * \brief Name the calling thread in the trace. Has no effect unless recording.
+     * \param[in] name A string that outlives the trace.
+     */
+    void setTraceThreadName(const char* name);
+
+    /**
+     * \brief Record a completed event on the calling thread.
+     * \param[in] name A string that outlives the trace, normally a literal.
+     */
+    void recordTraceEvent(const char* name, nsecs_t start, nsecs_t end);
+
+    /**
+     * \brief Records the lifetime of a scope, see TRACE_EVENT.
+     */
+    class ScopedTraceEvent
+    {
+    public:
+        ScopedTraceEvent(const char* name)
+            : name(name), start(traceEventsEnabled ? systemTime(SYSTEM_TIME_MONOTONIC) : 0)
+        {
+        }
+
+        ~ScopedTraceEvent()
+        {
+            if (start != 0)
+            {
+                recordTraceEvent(name, start, systemTime(SYSTEM_TIME_MONOTONIC));
+            }
+        }
+
+    private:
+        const char* name;
+        nsecs_t     start;
+    };
+
+#if GL2_CUBE_TRACE_EVENTS
+#define TRACE_EVENT_CONCAT2(a, b) a##b
+#define TRACE_EVENT_CONCAT(a, b) TRACE_EVENT_CONCAT2(a, b)
+#define TRACE_EVENT(name) ScopedTraceEvent TRACE_EVENT_CONCAT(traceEvent, __LINE__)(name)
+#else
+#define TRACE_EVENT(name) do { } while (0)
+#endif
+
+#endif /* TRACEEVENTS_H */
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VertexBatch.h"
+#include "TraceEvents.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <cutils/atomic.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+    /* Vertices 16 bit indices can address, per draw. */
+    static const int maxDrawVertices = 65536;
+
+    /* translation * rotationX * rotationY * rotationZ * scaling, written out rather than
+     * multiplied. */
+    void batchObjectModel(const BatchObject& object, const float angles[3], GLfloat* model)
+    {
+        const float toRadians = M_PI / 180.0f;
+        float sinX = sinf((angles[0] + object.phase) * toRadians), cosX = cosf((angles[0] + object.phase) * toRadians);
+        float sinY = sinf((angles[1] + object.phase) * toRadians), cosY = cosf((angles[1] + object.phase) * toRadians);
+        float sinZ = sinf(angles[2] * toRadians), cosZ = cosf(angles[2] * toRadians);
+        float scale = object.scale;
+
+        model[0]  = cosY * cosZ * scale;
+        model[1]  = (cosX * sinZ + sinX * sinY * cosZ) * scale;
+        model[2]  = (sinX * sinZ - cosX * sinY * cosZ) * scale;
+        model[3]  = 0.0f;
+        model[4]  = -cosY * sinZ * scale;
+        model[5]  = (cosX * cosZ - sinX * sinY * sinZ) * scale;
+        model[6]  = (sinX * cosZ + cosX * sinY * sinZ) * scale;
+        model[7]  = 0.0f;
+        model[8]  = sinY * scale;
+        model[9]  = -sinX * cosY * scale;
+        model[10] = cosX * cosY * scale;
+        model[11] = 0.0f;
+        model[12] = object.position[0];
+        model[13] = object.position[1];
+        model[14] = object.position[2];
+        model[15] = 1.0f;
+    }
+
+    /* One triangle per strip position; odd positions swap their first two vertices. */
+    int stripToTriangles(const GLubyte* strip, int stripLength, GLubyte* triangles)
+    {
+        int count = 0;
+        for (int i = 0; i + 2 < stripLength; i++)
+        {
+            GLubyte a = strip[i + (i & 1)], b = strip[i + 1 - (i & 1)], c = strip[i + 2];
+            if (a != b && b != c && a != c)
+            {
+                triangles[count++] = a;
+                triangles[count++] = b;
+                triangles[count++] = c;
+            }
+        }
+        return count;
+    }
+
+    /* Transform count positions by a column major matrix into the batch's vertices. */
+    static void transformPositions(const float* matrix, const GLfloat* positions, int count, BatchVertex* out)
+    {
+#if defined(__ARM_NEON__)
+        float32x4_t column0 = vld1q_f32(matrix);
+        float32x4_t column1 = vld1q_f32(matrix + 4);
+        float32x4_t column2 = vld1q_f32(matrix + 8);
+        float32x4_t column3 = vld1q_f32(matrix + 12);
+        for (int i = 0; i < count; i++, positions += 3)
+        {
+            float32x4_t result = vmlaq_n_f32(column3, column0, positions[0]);
+            result = vmlaq_n_f32(result, column1, positions[1]);
+            result = vmlaq_n_f32(result, column2, positions[2]);
+            vst1q_f32(out[i].position, result);
+        }
+#elif defined(__SSE__)
+        __m128 column0 = _mm_loadu_ps(matrix);
+        __m128 column1 = _mm_loadu_ps(matrix + 4);
+        __m128 column2 = _mm_loadu_ps(matrix + 8);
+        __m128 column3 = _mm_loadu_ps(matrix + 12);
+        for (int i = 0; i < count; i++, positions += 3)
+        {
+            __m128 result = _mm_add_ps(column3, _mm_mul_ps(column0, _mm_set1_ps(positions[0])));
+            result = _mm_add_ps(result, _mm_mul_ps(column1, _mm_set1_ps(positions[1])));
+            result = _mm_add_ps(result, _mm_mul_ps(column2, _mm_set1_ps(positions[2])));
+            _mm_storeu_ps(out[i].position, result);
+        }
+#else
+        for (int i = 0; i < count; i++, positions += 3)
+        {
+            for (int row = 0; row < 4; row++)
+            {
+                out[i].position[row] = matrix[row] * positions[0] + matrix[4 + row] * positions[1] +
+                                       matrix[8 + row] * positions[2] + matrix[12 + row];
+            }
+        }
+#endif
+    }
+
+    VertexBatch::VertexBatch(void)
+        : meshVertexCount(0), meshPositions(NULL), meshColors(NULL), objects(NULL), objectCount(0),
+          vertices(NULL), indices(NULL), streams(NULL), draws(NULL), drawCount(0), nextBlock(0),
+          workers(NULL), threadCount(0), workersStarted(0), stopping(0)
+    {
+        resetStats();
+    }
+
+    VertexBatch::~VertexBatch()
+    {
+        shutdown();
+        free(meshPositions);
+        free(meshColors);
+        free(vertices);
+        free(indices);
+        free(streams);
+        free(draws);
+    }
+
+    bool VertexBatch::setup(const GLfloat* positions, const GLfloat* colors, int vertexCount,
+                            const GLubyte* strip, int stripLength,
+                            const BatchObject* objects, int objectCount, int threadCount)
+    {
+        if (vertexCount > maxDrawVertices || objectCount <= 0 || threadCount <= 0)
+        {
+            fprintf(stderr, "Cannot batch %d objects of %d vertices on %d threads.\n",
+                    objectCount, vertexCount, threadCount);
+            return false;
+        }
+        meshVertexCount = vertexCount;
+        this->objects     = objects;
+        this->objectCount = objectCount;
+
+        GLubyte* triangles = (GLubyte*)malloc(stripLength * 3);
+        int triangleIndices = triangles != NULL ? stripToTriangles(strip, stripLength, triangles) : 0;
+
+        int objectsPerDraw = maxDrawVertices / vertexCount;
+        drawCount = (objectCount + objectsPerDraw - 1) / objectsPerDraw;
+        objectsPerDraw = objectCount < objectsPerDraw ? objectCount : objectsPerDraw;
+
+        meshPositions = (GLfloat*)malloc(vertexCount * 3 * sizeof(GLfloat));
+        meshColors    = (GLubyte*)malloc(vertexCount * 4);
+        vertices      = (BatchVertex*)malloc((size_t)objectCount * vertexCount * sizeof(BatchVertex));
+        indices       = (GLushort*)malloc((size_t)objectsPerDraw * triangleIndices * sizeof(GLushort));
+        streams       = (VertexStreams*)calloc(drawCount, sizeof(VertexStreams));
+        draws         = (DrawMesh*)calloc(drawCount, sizeof(DrawMesh));
+        if (triangles == NULL || meshPositions == NULL || meshColors == NULL || vertices == NULL ||
+            indices == NULL || streams == NULL || draws == NULL)
+        {
+            fprintf(stderr, "Could not allocate a batch of %d objects.\n", objectCount);
+            free(triangles);
+            return false;
+        }
+
+        memcpy(meshPositions, positions, vertexCount * 3 * sizeof(GLfloat));
+        for (int i = 0; i < vertexCount * 4; i++)
+        {
+            meshColors[i] = VERTEX_UNORM8(colors[i]);
+        }
+        for (int vertex = 0; vertex < objectCount * vertexCount; vertex++)
+        {
+            memcpy(vertices[vertex].color, &meshColors[vertex % vertexCount * 4], 4);
+        }
+
+        /* Every draw but the last covers objectsPerDraw objects, so all share one index list. */
+        for (int object = 0; object < objectsPerDraw; object++)
+        {
+            for (int i = 0; i < triangleIndices; i++)
+            {
+                indices[object * triangleIndices + i] = (GLushort)(object * vertexCount + triangles[i]);
+            }
+        }
+        free(triangles);
+
+        for (int draw = 0; draw < drawCount; draw++)
+        {
+            int firstObject = draw * objectsPerDraw;
+            int drawObjects = objectCount - firstObject < objectsPerDraw ? objectCount - firstObject : objectsPerDraw;
+            const BatchVertex* base = &vertices[firstObject * vertexCount];
+            VertexStreams* drawStreams = &streams[draw];
+            drawStreams->position.size       = 4;
+            drawStreams->position.type       = GL_FLOAT;
+            drawStreams->position.normalized = GL_FALSE;
+            drawStreams->position.stride     = sizeof(BatchVertex);
+            drawStreams->position.pointer    = base->position;
+            drawStreams->color.size          = 4;
+            drawStreams->color.type          = GL_UNSIGNED_BYTE;
+            drawStreams->color.normalized    = GL_TRUE;
+            drawStreams->color.stride        = sizeof(BatchVertex);
+            drawStreams->color.pointer       = base->color;
+            drawStreams->positionScale       = 1.0f;
+            drawStreams->bytesPerVertex      = sizeof(BatchVertex);
+            drawStreams->name                = "batched clip space";
+
+            draws[draw].streams   = drawStreams;
+            draws[draw].mode      = GL_TRIANGLES;
+            draws[draw].count     = drawObjects * triangleIndices;
+            draws[draw].triangles = drawObjects * triangleIndices / 3;
+            draws[draw].indexType = GL_UNSIGNED_SHORT;
+            draws[draw].indices   = indices;
+        }
+
+        this->threadCount = threadCount;
+        workers = (Worker*)calloc(threadCount, sizeof(Worker));
+        if (workers == NULL || sem_init(&start, 0, 0) != 0 || sem_init(&done, 0, 0) != 0)
+        {
+            fprintf(stderr, "Could not set up the batch workers: %s\n", strerror(errno));
+            free(workers);
+            workers = NULL;
+            return false;
+        }
+        /* Worker 0 is the thread calling transform(). */
+        for (int i = 0; i < threadCount; i++)
+        {
+            workers[i].batch = this;
+        }
+        for (workersStarted = 1; workersStarted < threadCount; workersStarted++)
+        {
+            int error = pthread_create(&workers[workersStarted].thread, NULL, workerMain, &workers[workersStarted]);
+            if (error != 0)
+            {
+                fprintf(stderr, "Could not start a batch worker: %s\n", strerror(error));
+                return false;
+            }
+        }
+
+        fprintf(stderr, "Batch: %d objects, %d vertices in %d draws, transformed on %d threads\n",
+                objectCount, objectCount * vertexCount, drawCount, threadCount);
+        return true;
+    }
+
+    void VertexBatch::shutdown(void)
+    {
+        if (workers == NULL)
+        {
+            return;
+        }
+        android_atomic_release_store(1, &stopping);
+        for (int i = 1; i < workersStarted; i++)
+        {
+            sem_post(&start);
+        }
+        for (int i = 1; i < workersStarted; i++)
+        {
+            pthread_join(workers[i].thread, NULL);
+        }
+        sem_destroy(&start);
+        sem_destroy(&done);
+        free(workers);
+        workers = NULL;
+        workersStarted = 0;
+    }
+
+    void* VertexBatch::workerMain(void* arg)
+    {
+        Worker* worker = (Worker*)arg;
+        VertexBatch* batch = worker->batch;
+        setTraceThreadName("batch");
+        for (;;)
+        {
+            while (sem_wait(&batch->start) != 0 && errno == EINTR)
+            {
+            }
+            if (android_atomic_acquire_load(&batch->stopping))
+            {
+                break;
+            }
+            batch->transformBlocks(worker);
+            sem_post(&batch->done);
+        }
+        return NULL;
+    }
+
+    /* Take blocks of objects until none are left. A worker woken twice in one frame finds
+     * nothing left the second time, and the frame still waits for one done per wake. */
+    void VertexBatch::transformBlocks(Worker* worker)
+    {
+        TRACE_EVENT("transformBlocks");
+        nsecs_t begin = systemTime(SYSTEM_TIME_MONOTONIC);
+        int blockCount = (objectCount + blockObjects - 1) / blockObjects;
+        for (int block = android_atomic_inc(&nextBlock); block < blockCount; block = android_atomic_inc(&nextBlock))
+        {
+            int end = (block + 1) * blockObjects < objectCount ? (block + 1) * blockObjects : objectCount;
+            for (int object = block * blockObjects; object < end; object++)
+            {
+                transformObject(object);
+            }
+        }
+        worker->busyTime += systemTime(SYSTEM_TIME_MONOTONIC) - begin;
+    }
+
+    void VertexBatch::transformObject(int object)
+    {
+        Matrix model;
+        batchObjectModel(objects[object], angles, model.getAsArray());
+        Matrix mvp = viewProjection * model;
+        transformPositions(mvp.getAsArray(), meshPositions, meshVertexCount, &vertices[object * meshVertexCount]);
+    }
+
+    void VertexBatch::transform(Matrix& viewProjection, const float angles[3])
+    {
+        TRACE_EVENT("batchTransform");
+        nsecs_t begin = systemTime(SYSTEM_TIME_MONOTONIC);
+        this->viewProjection = viewProjection;
+        memcpy(this->angles, angles, sizeof(this->angles));
+        for (int i = 0; i < threadCount; i++)
+        {
+            workers[i].busyTime = 0;
+        }
+
+        /* The semaphores order the frame's parameters before the workers and their vertices
+         * before the draws. */
+        android_atomic_release_store(0, &nextBlock);
+        for (int i = 1; i < threadCount; i++)
+        {
+            sem_post(&start);
+        }
+        transformBlocks(&workers[0]);
+        for (int i = 1; i < threadCount; i++)
+        {
+            while (sem_wait(&done) != 0 && errno == EINTR)
+            {
+            }
+        }
+
+        frames++;
+        totalTime += systemTime(SYSTEM_TIME_MONOTONIC) - begin;
+        for (int i = 0; i < threadCount; i++)
+        {
+            totalBusyTime += workers[i].busyTime;
+        }
+    }
+
+    void VertexBatch::printStats(const char* label) const
+    {
+        if (frames == 0 || totalTime == 0)
+        {
+            return;
+        }
+        fprintf(stderr, "Batch (%s): %d objects in %d draws, transformed in %.3f ms/frame "
+                "on %d threads, %.2f threads busy\n",
+                label, objectCount, drawCount, totalTime / 1e6 / frames,
+                threadCount, (double)totalBusyTime / totalTime);
+    }
+
+    void VertexBatch::resetStats(void)
+    {
+        frames        = 0;
+        totalTime     = 0;
+        totalBusyTime = 0;
+    }
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VERTEXBATCH_H
+#define VERTEXBATCH_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdint.h>
+
+#include <GLES2/gl2.h>
+#include <utils/Timers.h>
+
+#include "CommandBuffer.h"
+#include "Matrix.h"
+#include "VertexFormats.h"
+
+/**
+ * \file VertexBatch.h
+ * \brief Many copies of a mesh transformed on the CPU into one vertex array.
+ */
+
+    /**
+     * \brief A vertex of the batch, already in clip space.
+     */
+    struct BatchVertex
+    {
+        GLfloat     position[4];
+        GLubyte     color[4];
+    };
+
+    /**
+     * \brief Where one copy of the mesh is: model = translation * rotation * scaling, the
+     * rotation being the frame's angles each offset by phase.
+     */
+    struct BatchObject
+    {
+        GLfloat     position[3];
+        GLfloat     scale;
+        GLfloat     phase;
+    };
+
+    /**
+     * \brief Build an object's column major model matrix for the frame's angles.
+     */
+    void batchObjectModel(const BatchObject& object, const float angles[3], GLfloat* model);
+
+    /**
+     * \brief Turn a triangle strip with degenerate triangles between its strips into a
+     * triangle list of the same winding, without the degenerate triangles.
+     * \param[out] triangles Room for 3 * (stripLength - 2) indices.
+     * \return The number of indices written.
+     */
+    int stripToTriangles(const GLubyte* strip, int stripLength, GLubyte* triangles);
+
+    /**
+     * \brief Draws a mesh many times over in a few draws, without instancing.
+     *
+     * Every frame transform() builds each object's matrix and transforms the mesh's vertices
+     * to clip space with it, into one vertex array; objects are handed out to a pool of worker
+     * threads in blocks, the calling thread taking its share. The mesh's vertices are
+     * transformed four components at a time, with NEON or SSE where the build targets them.
+     * The copies are then drawn as triangle lists with an identity transform, as many copies
+     * per draw as 16 bit indices can address, so the uniform uploads and draws per frame do
+     * not grow with the number of objects.
+     */
+    class VertexBatch
+    {
+    public:
+        VertexBatch(void);
+        ~VertexBatch();
+
+        /**
+         * \brief Allocate the batch and start the worker threads.
+         * \param[in] positions x, y, z of each vertex of the mesh.
+         * \param[in] colors r, g, b, a of each vertex of the mesh, in [0, 1].
+         * \param[in] strip Triangle strip indices of the mesh, with degenerate triangles
+         *                  between its strips.
+         * \param[in] objects The copies to draw; the array must stay valid.
+         * \param[in] threadCount Threads transforming, the caller included.
+         * \return false if memory or a thread could not be had.
+         */
+        bool setup(const GLfloat* positions, const GLfloat* colors, int vertexCount,
+                   const GLubyte* strip, int stripLength,
+                   const BatchObject* objects, int objectCount, int threadCount);
+
+        /**
+         * \brief Stop the worker threads.
+         */
+        void shutdown(void);
+
+        /**
+         * \brief Transform every object for this frame. Returns when all are done.
+         * \param[in] angles Rotation about x, y and z in degrees, before each object's phase.
+         */
+        void transform(Matrix& viewProjection, const float angles[3]);
+
+        /**
+         * \brief Number of draws the batch takes.
+         */
+        int getDrawCount(void) const { return drawCount; }
+
+        /**
+         * \brief One of the batch's draws, over the vertices transformed last.
+         */
+        const DrawMesh* getDraw(int draw) const { return &draws[draw]; }
+
+        int getThreadCount(void) const { return threadCount; }
+
+        /**
+         * \brief Print the time transform() took per frame to stderr, and how many
+         * threads' worth of work it did in that time.
+         * \param[in] label A label for the report, such as the frame range it covers.
+         */
+        void printStats(const char* label) const;
+
+        void resetStats(void);
+
+    private:
+        /* Objects a thread takes at a time. */
+        static const int blockObjects = 64;
+
+        struct Worker
+        {
+            VertexBatch*    batch;
+            pthread_t       thread;
+            /* Time spent transforming, written by the worker while it runs. */
+            nsecs_t         busyTime;
+        };
+
+        static void* workerMain(void* arg);
+        void transformBlocks(Worker* worker);
+        void transformObject(int object);
+
+        int                 meshVertexCount;
+        GLfloat*            meshPositions;
+        GLubyte*            meshColors;
+        const BatchObject*  objects;
+        int                 objectCount;
+
+        BatchVertex*        vertices;
+        GLushort*           indices;
+        VertexStreams*      streams;
+        DrawMesh*           draws;
+        int                 drawCount;
+
+        /* The frame being transformed. */
+        Matrix              viewProjection;
+        float               angles[3];
+        volatile int32_t    nextBlock;
+
+        Worker*             workers;
+        int                 threadCount;
+        int                 workersStarted;
+        sem_t               start;
+        sem_t               done;
+        volatile int32_t    stopping;
+
+        unsigned int        frames;
+        nsecs_t             totalTime;
+        nsecs_t             totalBusyTime;
+    };
+
+#endif /* VERTEXBATCH_H */
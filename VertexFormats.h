@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VERTEXFORMATS_H
+#define VERTEXFORMATS_H
+
+#include <stddef.h>
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+/**
+ * \file VertexFormats.h
+ * \brief Compact vertex formats quantized at compile time from float vertex tables.
+ *
+ * All quantization macros only use arithmetic on their argument, so when they are
+ * expanded over a literal vertex list (see CUBE_VERTEX_LIST in Cube.h) the packed
+ * tables are constant initialized and cost nothing at startup.
+ *
+ * Define VERTEX_UV_HALF_FLOAT to store texture coordinates as GL_HALF_FLOAT_OES
+ * instead of normalized unsigned shorts (requires GL_OES_vertex_half_float).
+ */
+
+/**
+ * \brief Quantize a float in [-1, 1] to a normalized signed short.
+ */
+#define VERTEX_SNORM16(v)   ((GLshort)((v) * 32767.0f + ((v) < 0.0f ? -0.5f : 0.5f)))
+
+/**
+ * \brief Quantize a float in [0, 1] to a normalized unsigned short.
+ */
+#define VERTEX_UNORM16(v)   ((GLushort)((v) * 65535.0f + 0.5f))
+
+/**
+ * \brief Quantize a float in [0, 1] to a normalized unsigned byte.
+ */
+#define VERTEX_UNORM8(v)    ((GLubyte)((v) * 255.0f + 0.5f))
+
+/**
+ * \brief Encode a float in [0, 1] as an IEEE 754 half float.
+ *
+ * Values below the smallest normal half (2^-14) are flushed to zero. The exponent
+ * is found with a chain of comparisons so the result stays a constant expression;
+ * a mantissa that rounds up to 1024 carries into the exponent field.
+ */
+#define VERTEX_HALF_NORMAL(v, e) \
+    ((GLushort)(((15 - (e)) << 10) + (GLushort)(((v) * (float)(1 << (e)) - 1.0f) * 1024.0f + 0.5f)))
+#define VERTEX_HALF_UNIT(v) \
+    ((v) >= 1.0f          ? (GLushort)0x3C00          : \
+     (v) >= 1.0f / 2      ? VERTEX_HALF_NORMAL(v,  1) : \
+     (v) >= 1.0f / 4      ? VERTEX_HALF_NORMAL(v,  2) : \
+     (v) >= 1.0f / 8      ? VERTEX_HALF_NORMAL(v,  3) : \
+     (v) >= 1.0f / 16     ? VERTEX_HALF_NORMAL(v,  4) : \
+     (v) >= 1.0f / 32     ? VERTEX_HALF_NORMAL(v,  5) : \
+     (v) >= 1.0f / 64     ? VERTEX_HALF_NORMAL(v,  6) : \
+     (v) >= 1.0f / 128    ? VERTEX_HALF_NORMAL(v,  7) : \
+     (v) >= 1.0f / 256    ? VERTEX_HALF_NORMAL(v,  8) : \
+     (v) >= 1.0f / 512    ? VERTEX_HALF_NORMAL(v,  9) : \
+     (v) >= 1.0f / 1024   ? VERTEX_HALF_NORMAL(v, 10) : \
+     (v) >= 1.0f / 2048   ? VERTEX_HALF_NORMAL(v, 11) : \
+     (v) >= 1.0f / 4096   ? VERTEX_HALF_NORMAL(v, 12) : \
+     (v) >= 1.0f / 8192   ? VERTEX_HALF_NORMAL(v, 13) : \
+     (v) >= 1.0f / 16384  ? VERTEX_HALF_NORMAL(v, 14) : \
+                            (GLushort)0)
+
+#ifdef VERTEX_UV_HALF_FLOAT
+#define VERTEX_UV(v)            VERTEX_HALF_UNIT(v)
+#define VERTEX_UV_TYPE          GL_HALF_FLOAT_OES
+#define VERTEX_UV_NORMALIZED    GL_FALSE
+#else
+#define VERTEX_UV(v)            VERTEX_UNORM16(v)
+#define VERTEX_UV_TYPE          GL_UNSIGNED_SHORT
+#define VERTEX_UV_NORMALIZED    GL_TRUE
+#endif
+
+/**
+ * \brief An interleaved vertex with quantized attributes, 16 bytes instead of 36.
+ *
+ * Positions are normalized shorts that must be multiplied by the mesh's position
+ * scale (see VertexStreams::positionScale); the fourth short only pads the
+ * position to 8 bytes so the color stays 4-byte aligned.
+ */
+typedef struct
+{
+    GLshort     position[4];
+    GLubyte     color[4];
+    GLushort    texCoord[2];
+} PackedVertex;
+
+/**
+ * \brief Expand one V(x, y, z, r, g, b, a, s, t) vertex list entry into a PackedVertex
+ * initializer. SCALE is the largest absolute coordinate of the mesh.
+ */
+#define PACKED_VERTEX(SCALE, x, y, z, r, g, b, a, s, t) \
+    { { VERTEX_SNORM16((x) / (SCALE)), VERTEX_SNORM16((y) / (SCALE)), VERTEX_SNORM16((z) / (SCALE)), 0 }, \
+      { VERTEX_UNORM8(r), VERTEX_UNORM8(g), VERTEX_UNORM8(b), VERTEX_UNORM8(a) }, \
+      { VERTEX_UV(s), VERTEX_UV(t) } },
+
+/**
+ * \brief Everything glVertexAttribPointer needs to source one attribute.
+ */
+typedef struct
+{
+    GLint           size;
+    GLenum          type;
+    GLboolean       normalized;
+    GLsizei         stride;
+    const GLvoid*   pointer;
+} VertexAttribStream;
+
+/**
+ * \brief The attribute streams of a mesh in one particular vertex format.
+ */
+typedef struct
+{
+    VertexAttribStream  position;
+    VertexAttribStream  color;
+    VertexAttribStream  texCoord;
+    /** Factor the position attribute must be scaled by to get object space coordinates. */
+    float               positionScale;
+    /** Total vertex data per vertex, summed over all streams. */
+    GLsizei             bytesPerVertex;
+    const char*         name;
+    /** Index into the transforms of SHADER_INSTANCED variants; unset for meshes drawn one at a time. */
+    VertexAttribStream  instance;
+    /** Buffer object the pointers are offsets into, 0 for client arrays. */
+    GLuint              buffer;
+} VertexStreams;
+
+#endif /* VERTEXFORMATS_H */
@@ -16,33 +16,88 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <math.h>
 #include <sched.h>
 #include <fcntl.h>  
 #include <unistd.h> 
 #include <errno.h> 
 #include <sys/resource.h>
+#include <pthread.h>
+#include <semaphore.h>
+#ifdef HAVE_ANDROID_OS
 #include <sys/ioctl.h> 
 #include <sys/mman.h>
 #include <linux/fb.h> 
+#endif
 
 #include "Cube.h"
 #include "Matrix.h"
+#include "GLStateCache.h"
+#include "GLError.h"
+#include "RenderGraph.h"
+#include "FrameClock.h"
+#include "ProgramCache.h"
+#include "ShaderVariants.h"
+#include "StageStats.h"
+#include "TextOverlay.h"
+#include "TraceEvents.h"
+#include "DamageTracker.h"
+#include "FrameState.h"
+#include "CommandBuffer.h"
+#include "VertexBatch.h"
+#include "InstanceBatch.h"
+#include "ResolutionScaler.h"
+#include "MeshFile.h"
+#include "MeshGenerator.h"
+#include "StartupProfiler.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
+#include <cutils/atomic.h>
 #include <utils/Timers.h>
+
+/* EGL_EXT_buffer_age and EGL_KHR_swap_buffers_with_damage, which older headers lack. */
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+typedef EGLBoolean (EGLAPIENTRYP SwapBuffersWithDamageProc)(EGLDisplay dpy, EGLSurface surface,
+                                                           const EGLint* rects, EGLint n_rects);
+
+#ifdef HAVE_ANDROID_OS
 #include <ui/FramebufferNativeWindow.h>
 #include <ui/GraphicBuffer.h>
 #include "EGLUtils.h"
 
 using namespace android;
+#endif
+/* Last, so that it wraps every GL and EGL call below. */
+#include "GLTrace.h"
+
+/* Shadow of the GL state, every state change on the context goes through it. */
+static GLStateCache glState;
+
+/* CPU time of the stages of each frame. */
+static StageStats stageStats;
+
+/* Time of each phase of startup, and the time to first frame. */
+static StartupProfiler startupProfiler;
+
+/* Print the EGL configuration, GL extensions and framebuffer layout too, with -v. They wait
+ * for the first frame to be presented, so the console does not hold up startup. */
+static bool verbose = false;
+
+/* How often, in frames, the state cache and frame time statistics are reported. */
+#define STATS_INTERVAL_FRAMES 600
 
+#ifdef HAVE_ANDROID_OS
 static int xioctl( int fd,int request,void * arg ) 
 { 
+  TRACE_EVENT("xioctl");
   int r; 
   do
   {
@@ -50,6 +105,7 @@ static int xioctl( int fd,int request,void * arg )
   }while( -1 == r && EINTR == errno ); 
   return r; 
 }
+#endif
 
 static void printGLString(const char *name, GLenum s) 
 {
@@ -57,33 +113,6 @@ static void printGLString(const char *name, GLenum s)
   fprintf(stderr, "GL %s = %s\n", name, v);
 }
 
-static void checkEglError(const char* op, EGLBoolean returnVal = EGL_TRUE) 
-{
-  if (returnVal != EGL_TRUE) 
-  {
-    fprintf(stderr, "%s() returned %d\n", op, returnVal);
-  }
-
-  for(EGLint error = eglGetError(); 
-      error != EGL_SUCCESS; 
-      error = eglGetError()) 
-  {
-    fprintf(stderr, "after %s() eglError %s (0x%x)\n",op, 
-                                                      EGLUtils::strerror(error),
-                                                      error);
-  }
-}
-
-static void checkGlError(const char* op) 
-{
-  for(GLint error = glGetError(); 
-      error; 
-      error = glGetError()) 
-  {
-    fprintf(stderr, "after %s() glError (0x%x)\n", op, error);
-  }
-}
-
 /*
 static const char gVertexShader[] = "attribute vec4 av4position;\n"
     "attribute vec3 av3colour;\n"
@@ -102,68 +131,7 @@ static const char gFragmentShader[] = "#extension GL_OES_EGL_image_external : re
     "}\n";
 */
 
-static const char gVertexShader[] = 
-    "attribute vec4 a_v4Position;\n"
-    "attribute vec4 a_v4FillColor;\n"
-    "attribute vec2 a_v2TexCoord;\n"
-    "uniform mat4 u_m4Projection;\n"
-    "uniform mat4 u_m4Modelview;\n"
-    "varying vec4 v_v4FillColor;\n"
-    "varying vec2 v_v2TexCoord;\n"
-    "void main()\n"
-    "{\n"
-    "   v_v4FillColor = a_v4FillColor;\n"
-    "   v_v2TexCoord = a_v2TexCoord;\n"
-    "   gl_Position = u_m4Projection * u_m4Modelview * a_v4Position;\n"
-    "}\n";
-
-static const char gFragmentShader[] = 
-    "precision mediump float;\n"
-    "uniform sampler2D u_s2dTexture;\n"
-    "uniform float u_fTex;\n"
-    "varying vec4 v_v4FillColor;\n"
-    "varying vec2 v_v2TexCoord;\n"
-    "void main()\n"
-    "{\n"
-    "   vec4 v4Texel = texture2D(u_s2dTexture, v_v2TexCoord);\n"
-    "   gl_FragColor = mix(v_v4FillColor, v4Texel, u_fTex);\n"
-    "}\n";
-
-GLuint loadShader(GLenum shaderType, const char* pSource) {
-    GLuint shader = glCreateShader(shaderType);
-    if (shader) {
-        glShaderSource(shader, 1, &pSource, NULL);
-        glCompileShader(shader);
-        GLint compiled = 0;
-        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
-        if (!compiled) {
-            GLint infoLen = 0;
-            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &infoLen);
-            if (infoLen) {
-                char* buf = (char*) malloc(infoLen);
-                if (buf) {
-                    glGetShaderInfoLog(shader, infoLen, NULL, buf);
-                    fprintf(stderr, "Could not compile shader %d:\n%s\n",
-                            shaderType, buf);
-                    free(buf);
-                }
-            } else {
-                fprintf(stderr, "Guessing at GL_INFO_LOG_LENGTH size\n");
-                char* buf = (char*) malloc(0x1000);
-                if (buf) {
-                    glGetShaderInfoLog(shader, 0x1000, NULL, buf);
-                    fprintf(stderr, "Could not compile shader %d:\n%s\n",
-                            shaderType, buf);
-                    free(buf);
-                }
-            }
-            glDeleteShader(shader);
-            shader = 0;
-        }
-    }
-    return shader;
-}
-
+#ifdef HAVE_ANDROID_OS
 const int fbTexWidth    = 640;
 const int fbTexHeight   = 240;
 const int fbTexUsage    = GraphicBuffer::USAGE_HW_TEXTURE |
@@ -171,6 +139,9 @@ const int fbTexUsage    = GraphicBuffer::USAGE_HW_TEXTURE |
 const int fbTexFormat   = HAL_PIXEL_FORMAT_RGB_565;
 static sp<GraphicBuffer> fbTexBuffer;
 static GLuint fbTex;
+/* The capture is an EGLImage, sampled through an external texture. */
+static const GLenum       fbTexTarget  = GL_TEXTURE_EXTERNAL_OES;
+static const unsigned int fbTexFeature = SHADER_TEXTURE_EXTERNAL;
 
 int                         fd, 
                             scrSize;
@@ -182,23 +153,33 @@ unsigned char               color;
 
 void fillFbTexture(EGLDisplay dpy, EGLContext context, bool flag )
 {
+  TRACE_EVENT("fillFbTexture");
+  stageStats.begin(STAGE_FB_LOCK);
   status_t err = fbTexBuffer->lock( GRALLOC_USAGE_SW_WRITE_OFTEN, (void**)(&buf) );
+  stageStats.end(STAGE_FB_LOCK);
   if (err != 0) 
   {
     fprintf( stderr, "fbTexBuffer->lock(...) failed: %d\n", err );
     return;
   }
 
+  stageStats.begin(STAGE_FB_COPY);
   // Get variable screen information. 
   if( -1 == xioctl( fd, FBIOGET_VSCREENINFO, &vInfo ) ) 
   { 
     fprintf( stderr, "Error reading variable information.\n" ); 
   }
-  memcpy( buf,
-          pFbBuf + ( vInfo.yoffset * vInfo.xres * vInfo.bits_per_pixel / 8 ),
-          vInfo.xres * vInfo.yres * vInfo.bits_per_pixel / 8);
+  {
+    TRACE_EVENT("memcpy");
+    memcpy( buf,
+            pFbBuf + ( vInfo.yoffset * vInfo.xres * vInfo.bits_per_pixel / 8 ),
+            vInfo.xres * vInfo.yres * vInfo.bits_per_pixel / 8);
+  }
+  stageStats.end(STAGE_FB_COPY);
 
+  stageStats.begin(STAGE_FB_UNLOCK);
   err = fbTexBuffer->unlock();
+  stageStats.end(STAGE_FB_UNLOCK);
   if (err != 0) 
   {
     fprintf( stderr, "fbTexBuffer->unlock() failed: %d\n", err );
@@ -217,14 +198,14 @@ void fillFbTexture(EGLDisplay dpy, EGLContext context, bool flag )
   }
 
   glGenTextures(1, &fbTex);
-  checkGlError("glGenTextures");
-  glBindTexture(GL_TEXTURE_EXTERNAL_OES, fbTex);
-  checkGlError("glBindTexture");
+  GL_CHECK("glGenTextures");
+  glState.bindTexture(GL_TEXTURE_EXTERNAL_OES, fbTex);
+  GL_CHECK("glBindTexture");
   glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, (GLeglImageOES)img);
-  checkGlError("glEGLImageTargetTexture2DOES");
+  GL_CHECK("glEGLImageTargetTexture2DOES");
 
   eglDestroyImageKHR(dpy, img);
-  checkGlError("eglDestroyImageKHR");
+  GL_CHECK("eglDestroyImageKHR");
   }
 }
 
@@ -249,14 +230,6 @@ void openFbDevice(void)
     fprintf( stderr, "Error reading variable information.\n" ); 
   } 
   scrSize = vInfo.xres_virtual * vInfo.yres_virtual * vInfo.bits_per_pixel / 8;
-  fprintf( stderr, "Visible res:    %dx%d\n", vInfo.xres, vInfo.yres );
-  fprintf( stderr, "Virtual res:    %dx%d\n", vInfo.xres_virtual, vInfo.yres_virtual );
-  fprintf( stderr, "Offset  res:    %dx%d\n", vInfo.xoffset, vInfo.yoffset );
-  fprintf( stderr, "Bits per pixel: %d\n", vInfo.bits_per_pixel );
-  fprintf( stderr, "Red:   %d(%d)\n", vInfo.red.offset, vInfo.red.length );
-  fprintf( stderr, "Green: %d(%d)\n", vInfo.green.offset, vInfo.green.length );
-  fprintf( stderr, "Blue:  %d(%d)\n", vInfo.blue.offset, vInfo.blue.length );
-  fprintf( stderr, "Alpha: %d(%d)\n", vInfo.transp.offset, vInfo.transp.length );
 
   // Map frame buffer device to memory.
   pFbBuf = ( unsigned char * )mmap( NULL, scrSize, PROT_READ, MAP_SHARED , fd, 0 ); 
@@ -272,64 +245,684 @@ void closeFbDevice(void)
   close(fd);
 }
 
+static void printFbInfo(void)
+{
+  fprintf( stderr, "Visible res:    %dx%d\n", vInfo.xres, vInfo.yres );
+  fprintf( stderr, "Virtual res:    %dx%d\n", vInfo.xres_virtual, vInfo.yres_virtual );
+  fprintf( stderr, "Offset  res:    %dx%d\n", vInfo.xoffset, vInfo.yoffset );
+  fprintf( stderr, "Bits per pixel: %d\n", vInfo.bits_per_pixel );
+  fprintf( stderr, "Red:   %d(%d)\n", vInfo.red.offset, vInfo.red.length );
+  fprintf( stderr, "Green: %d(%d)\n", vInfo.green.offset, vInfo.green.length );
+  fprintf( stderr, "Blue:  %d(%d)\n", vInfo.blue.offset, vInfo.blue.length );
+  fprintf( stderr, "Alpha: %d(%d)\n", vInfo.transp.offset, vInfo.transp.length );
+}
+
 
 bool setupFbTexSurface(EGLDisplay dpy, EGLContext context) 
 {
+  startupProfiler.phase("captureBuffer");
   fbTexBuffer = new GraphicBuffer( fbTexWidth, 
                                    fbTexHeight, 
                                    fbTexFormat,
                                    fbTexUsage);
+  startupProfiler.phase("fbMap");
   openFbDevice();
+  startupProfiler.phase("firstCapture");
+  fillFbTexture(dpy, context, true);
+
+  return true;
+}
+#else
+/* There is no framebuffer device on the host. A generated RGB565 test pattern of the
+ * same size stands in for the capture and is uploaded to a plain 2D texture every frame,
+ * where the device copies the framebuffer. */
+const int fbTexWidth    = 640;
+const int fbTexHeight   = 240;
+static GLushort* fbCapture;
+static GLuint fbTex;
+static const GLenum       fbTexTarget  = GL_TEXTURE_2D;
+static const unsigned int fbTexFeature = SHADER_TEXTURE;
+
+void fillFbTexture(EGLDisplay dpy, EGLContext context, bool flag )
+{
+  TRACE_EVENT("fillFbTexture");
+  if( flag )
+  {
+    glGenTextures(1, &fbTex);
+    GL_CHECK("glGenTextures");
+    glState.bindTexture(GL_TEXTURE_2D, fbTex);
+    /* Not a power of two, so it must clamp and must not be mipmapped. */
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, fbTexWidth, fbTexHeight, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, fbCapture);
+    GL_CHECK("glTexImage2D");
+    return;
+  }
+
+  stageStats.begin(STAGE_FB_COPY);
+  TRACE_EVENT("glTexSubImage2D");
+  glState.bindTexture(GL_TEXTURE_2D, fbTex);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, fbTexWidth, fbTexHeight, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, fbCapture);
+  GL_CHECK("glTexSubImage2D");
+  stageStats.end(STAGE_FB_COPY);
+}
+
+void closeFbDevice(void)
+{
+  free(fbCapture);
+  fbCapture = NULL;
+}
+
+static void printFbInfo(void)
+{
+}
+
+bool setupFbTexSurface(EGLDisplay dpy, EGLContext context) 
+{
+  /* Eight color bars over a checkerboard. */
+  static const GLushort bars[8] = { 0xFFFF, 0xFFE0, 0x07FF, 0x07E0, 0xF81F, 0xF800, 0x001F, 0x0000 };
+
+  startupProfiler.phase("captureBuffer");
+  fbCapture = (GLushort*)malloc(fbTexWidth * fbTexHeight * sizeof(GLushort));
+  if (fbCapture == NULL)
+  {
+    return false;
+  }
+  for (int y = 0; y < fbTexHeight; y++)
+  {
+    for (int x = 0; x < fbTexWidth; x++)
+    {
+      GLushort color = bars[x * 8 / fbTexWidth];
+      fbCapture[y * fbTexWidth + x] = ((x / 16 + y / 16) & 1) ? color : (color >> 1) & 0x7BEF;
+    }
+  }
+  startupProfiler.phase("firstCapture");
   fillFbTexture(dpy, context, true);
 
   return true;
 }
+#endif
 
 #define FBO_WIDTH    256
 #define FBO_HEIGHT   256
 
+/* Where linked program binaries are kept between runs. */
+#define PROGRAM_CACHE_DIR "/data/local/tmp/gl2-cube"
+
 /* Shader variables. */
-GLuint programID;
-GLint iLocPosition = -1;
-GLint iLocTextureMix = -1;
-GLint iLocTexture = -1;
-GLint iLocFillColor = -1;
-GLint iLocTexCoord = -1;
-GLint iLocProjection = -1;
-GLint iLocModelview = -1;
-
-/* Animation variables. */
-static float angleX = 0;
-static float angleY = 0;
-static float angleZ = 0;
-Matrix rotationX;
-Matrix rotationY;
-Matrix rotationZ;
+static ProgramCache       programCache(PROGRAM_CACHE_DIR);
+static ShaderVariantCache shaderVariants(&programCache, &glState);
+/* The FBO cube is only vertex colored, the main cube only shows the framebuffer capture. */
+static ShaderVariant*       fboVariant;
+static ShaderVariant*       mainVariant;
+/* SHADER_MVP to upload one combined matrix per object, 0 for separate projection and modelview. */
+static unsigned int         transformFeature = SHADER_MVP;
+
+/* Animation variables. The simulation runs at a fixed rate, the angles used for
+ * rendering are interpolated between the last two simulated states. */
+#define SIMULATION_HZ 60
+
+/* Rotation speeds in degrees per second. */
+static const float angularVelocityX = 9.0f;
+static const float angularVelocityY = 6.0f;
+static const float angularVelocityZ = 3.0f;
+
+struct AnimationState
+{
+  float angleX;
+  float angleY;
+  float angleZ;
+};
+static AnimationState previousAnimation;
+static AnimationState currentAnimation;
+/* Times and paces the frames on the render thread. */
+static FrameClock     frameClock(seconds_to_nanoseconds(1) / SIMULATION_HZ);
+/* Steps the simulation, on whichever thread runs it. */
+static FrameClock     simulationClock(seconds_to_nanoseconds(1) / SIMULATION_HZ);
+
+/* How frames are presented, chosen with -p. Without -p the driver's swap interval is kept. */
+struct PresentMode
+{
+  const char* name;
+  EGLint      swapInterval;
+  /* Wait for each frame to finish after handing it over, so that no frame is queued behind
+   * it and the next frame samples its input as late as possible. */
+  bool        finishAfterSwap;
+  const char* description;
+};
+
+static const PresentMode presentModes[] =
+{
+  { "latency",     1, true,  "synchronized to vsync, no frames queued ahead" },
+  { "vsync",       1, false, "synchronized to vsync, queued as deep as the driver allows" },
+  { "unthrottled", 0, false, "not synchronized, frames may tear" },
+};
+static const PresentMode* presentMode = NULL;
+
+static bool parsePresentMode(const char* text)
+{
+  for (unsigned int i = 0; i < sizeof(presentModes) / sizeof(presentModes[0]); i++)
+  {
+    if (strcmp(text, presentModes[i].name) == 0)
+    {
+      presentMode = &presentModes[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Set up before the simulation starts and constant while it runs. */
 Matrix translation;
-Matrix modelView;
+Matrix positionScaling;
 Matrix projection;
 Matrix projectionFBO;
+/* Bumped whenever the projection matrices are rebuilt, so their uploads can be skipped
+ * without comparing them. Every matrix gets a generation from the same counter. */
+static unsigned int matrixGenerations = 0;
+static unsigned int projectionGeneration;
+static unsigned int projectionFBOGeneration;
+
+/* Vertex data in the format the cube is drawn with. Build with GL2_CUBE_FLOAT_VERTICES
+ * to draw from the original float tables instead of the packed ones. */
+#ifdef GL2_CUBE_FLOAT_VERTICES
+static const VertexStreams* cubeStreams = &cubeFloatStreams;
+#else
+static const VertexStreams* cubeStreams = &cubePackedStreams;
+#endif
+
+/* With -M the cube is read from a mesh file made by gl2-cube-meshconv instead, mapped and
+ * uploaded to buffer objects straight from the mapping. */
+static const char* meshPath = NULL;
+static MeshFile    meshFile;
+/* With -G it is a grid, a subdivided cube or a sphere of a given number of triangles, to
+ * measure vertex throughput across mesh sizes. */
+static MeshShape     generatedShape = MESH_SHAPE_COUNT;
+static int           generatedTriangles;
+static bool          generatedOptimized = false;
+static MeshGenerator meshGenerator;
+/* The mesh drawn instead of the cube of Cube.h, if any. */
+static const DrawMesh* replacementMesh = NULL;
+/* Object space bounds of the cube, for the damage it causes. Generated meshes share them. */
+static float       cubeBoundsMin[3] = { -CUBE_POSITION_SCALE, -CUBE_POSITION_SCALE, -CUBE_POSITION_SCALE };
+static float       cubeBoundsMax[3] = {  CUBE_POSITION_SCALE,  CUBE_POSITION_SCALE,  CUBE_POSITION_SCALE };
 
 /* Framebuffer variables. */
 GLuint iFBO = 0;
 /* Application textures. */
 GLuint iFBOTex = 0;
 
+/* Passes making up a frame, and what they draw. */
+struct FrameContext
+{
+  int         width;
+  int         height;
+  FrameState* state;
+};
+static RenderGraph  renderGraph;
+static FrameContext frameContext;
+
+/* Stage statistics drawn over the window with -O, refreshed every OVERLAY_INTERVAL_FRAMES. */
+#define OVERLAY_INTERVAL_FRAMES 30
+#define OVERLAY_COLUMNS         40
+#define OVERLAY_ROWS            (STAGE_COUNT + 2)
+#define OVERLAY_SCALE           2
+static bool           overlayEnabled = false;
+static TextOverlay    overlay(&glState);
+static ShaderVariant* overlayVariant;
+
+/* With -d only what changed since the back buffer was last drawn is redrawn, and only what
+ * changed since the last frame is presented, where EGL supports it. */
+static bool                       damageEnabled = false;
+static DamageTracker              damageTracker;
+static bool                       bufferAgeSupported;
+static SwapBuffersWithDamageProc  swapBuffersWithDamage;
+/* Window area the main cube covered in the last frame. */
+static DamageTracker::Rect        lastCubeBounds;
+
+/* With -r the scene is drawn at a resolution picked to hold a frame time, then upscaled to
+ * the window; the overlay is drawn over it at the window's resolution. */
+static bool             resolutionScaling = false;
+static ResolutionScaler resolutionScaler(&glState);
+static ShaderVariant*   upscaleVariant;
+
+static bool parseResolutionScaling(const char* text)
+{
+  float budget = 0.0f;
+  float minScale = 0.5f;
+  float maxScale = 1.0f;
+  if (sscanf(text, "%f:%f:%f", &budget, &minScale, &maxScale) < 1 ||
+      budget <= 0.0f || minScale <= 0.0f || minScale > maxScale || maxScale > 1.0f)
+  {
+    return false;
+  }
+  resolutionScaler.configure((nsecs_t)(budget * 1e6f), minScale, maxScale);
+  resolutionScaling = true;
+  return true;
+}
+
+/* The passes record into the command buffer, which is sorted and issued after them. */
+#define COMMAND_ARENA_BYTES   (256 * 1024)
+#define COMMANDS_PER_FRAME    1024
+static CommandBuffer  commandBuffer(&glState);
+static DrawMesh       cubeMesh;
+
+/* With -N the window also shows that many small vertex colored cubes. -b picks how they
+ * are drawn: transformed on the CPU by -w threads into one vertex array and drawn in a few
+ * draws (see VertexBatch.h), transformed by the vertex shader from a uniform array of
+ * transforms, as many cubes per draw as it holds (see InstanceBatch.h), or one draw per cube
+ * to compare against. */
+#define STRESS_NEAR       2.0f
+#define STRESS_FAR        20.0f
+#define STRESS_CUBE_SCALE 0.2f
+/* Arena room for a cube drawn on its own: the command and its matrices. */
+#define STRESS_DRAW_BYTES (sizeof(DrawCommand) + 2 * 16 * sizeof(GLfloat))
+enum BatchMode { BATCH_CPU, BATCH_UNIFORM, BATCH_OFF };
+static const char* const batchModeNames[] = { "cpu", "uniform", "off" };
+static BatchMode      batchMode = BATCH_CPU;
+static int            stressObjectCount = 0;
+static int            batchThreads = 0;
+static BatchObject*   stressObjects;
+static VertexBatch    stressBatch;
+static InstanceBatch  instanceBatch;
+static ShaderVariant* stressVariant;
+/* The batch is already in clip space, so it is drawn with identity matrices. */
+static unsigned int   identityGeneration;
+
+static bool parseBatchMode(const char* text)
+{
+  for (unsigned int i = 0; i < sizeof(batchModeNames) / sizeof(batchModeNames[0]); i++)
+  {
+    if (strcmp(text, batchModeNames[i]) == 0)
+    {
+      batchMode = (BatchMode)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* The window with its full viewport, clipped to what needs redrawing with -d. */
+static const RenderTarget* addWindowTarget(const FrameContext* window)
+{
+  GLint scissor[4];
+  if (damageEnabled)
+  {
+    DamageTracker::Rect redraw = damageTracker.redrawRect();
+    scissor[0] = redraw.x;
+    scissor[1] = redraw.y;
+    scissor[2] = redraw.width;
+    scissor[3] = redraw.height;
+  }
+  return commandBuffer.addTarget(0, 0, 0, window->width, window->height, damageEnabled ? scissor : NULL);
+}
+
+/* Where the scene is drawn: the window, or with -r the part of the scaled render target the
+ * current scale covers, clearing only that part. */
+static const RenderTarget* addSceneTarget(const FrameContext* window)
+{
+  if (!resolutionScaling)
+  {
+    return addWindowTarget(window);
+  }
+  GLint used[4] = { 0, 0, resolutionScaler.getWidth(), resolutionScaler.getHeight() };
+  return commandBuffer.addTarget(resolutionScaler.getFramebuffer(), used[0], used[1], used[2], used[3], used);
+}
+
+/* Draw the untextured cube into iFBOTex. */
+static void renderFboPass(void* userData)
+{
+  FrameState* state = ((const FrameContext*)userData)->state;
+
+  TRACE_EVENT("fboPass");
+  stageStats.begin(STAGE_FBO_PASS);
+
+  /* The FrameBuffer Object, with the viewport of its texture, scaled with -r like the scene;
+   * whatever samples iFBOTex must then sample only that part of it. */
+  int fboWidth  = FBO_WIDTH;
+  int fboHeight = FBO_HEIGHT;
+  if (resolutionScaling)
+  {
+    resolutionScaler.scaleSize(&fboWidth, &fboHeight);
+  }
+  const RenderTarget* target = commandBuffer.addTarget(iFBO, 0, 0, fboWidth, fboHeight, NULL);
+  commandBuffer.clear(target, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 0.5f, 0.5f, 0.5f, 1.0f);
+
+  /* The colored cube, with the FBO-specific projection. */
+  commandBuffer.draw(target, fboVariant, &cubeMesh, GL_TEXTURE_2D, 0,
+                     state->fboMvp, state->fboModelView, projectionFBO, projectionFBOGeneration);
+  stageStats.end(STAGE_FBO_PASS);
+}
+
+/* Draw the cube textured with the framebuffer capture to the EGL window surface. */
+static void renderMainPass(void* userData)
+{
+  const FrameContext* window = (const FrameContext*)userData;
+  FrameState* state = window->state;
+
+  TRACE_EVENT("mainPass");
+  stageStats.begin(STAGE_MAIN_PASS);
+
+  /* The EGL window surface, or the scaled render target with -r; with -d what the back
+   * buffer already holds is left alone, the clear included. */
+  const RenderTarget* target = addSceneTarget(window);
+  commandBuffer.clear(target, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  /* The cube, sampling the framebuffer capture on texture unit 0. */
+  commandBuffer.draw(target, mainVariant, &cubeMesh, fbTexTarget, fbTex,
+                     state->mainMvp, state->mainModelView, projection, projectionGeneration);
+  stageStats.end(STAGE_MAIN_PASS);
+}
+
+/* Blend the statistics overlay onto the EGL window surface. */
+static void drawOverlay(void* userData)
+{
+  const FrameContext* window = (const FrameContext*)userData;
+
+  TRACE_EVENT("overlay");
+  overlay.draw(overlayVariant, window->width, window->height, OVERLAY_SCALE);
+  GL_CHECK("overlay");
+}
+
+/* Transform the stress objects for this frame and draw them to the EGL window surface. */
+static void renderStressPass(void* userData)
+{
+  const FrameContext* window = (const FrameContext*)userData;
+
+  TRACE_EVENT("stressPass");
+  stageStats.begin(STAGE_BATCH);
+  const RenderTarget* target = addSceneTarget(window);
+  switch (batchMode)
+  {
+  case BATCH_CPU:
+    stressBatch.transform(projection, window->state->angles);
+    for (int draw = 0; draw < stressBatch.getDrawCount(); draw++)
+    {
+      commandBuffer.draw(target, stressVariant, stressBatch.getDraw(draw), GL_TEXTURE_2D, 0,
+                         Matrix::identityMatrix, Matrix::identityMatrix, Matrix::identityMatrix,
+                         identityGeneration);
+    }
+    break;
+  case BATCH_UNIFORM:
+    instanceBatch.record(&commandBuffer, target, stressVariant, projection, projectionGeneration,
+                         window->state->angles);
+    break;
+  case BATCH_OFF:
+    for (int i = 0; i < stressObjectCount; i++)
+    {
+      Matrix model;
+      batchObjectModel(stressObjects[i], window->state->angles, model.getAsArray());
+      model = model * positionScaling;
+      Matrix mvp = projection * model;
+      commandBuffer.draw(target, stressVariant, &cubeMesh, GL_TEXTURE_2D, 0,
+                         mvp, model, projection, projectionGeneration);
+    }
+    break;
+  }
+  stageStats.end(STAGE_BATCH);
+}
+
+/* Draw the scaled scene over the whole EGL window surface. */
+static void drawUpscale(void* userData)
+{
+  TRACE_EVENT("upscale");
+  resolutionScaler.draw(upscaleVariant);
+  GL_CHECK("upscale");
+}
+
+static void renderUpscalePass(void* userData)
+{
+  TRACE_EVENT("upscalePass");
+  const RenderTarget* target = addWindowTarget((const FrameContext*)userData);
+  /* Everything is drawn over, but the clear tells tiled GPUs not to load the old contents. */
+  commandBuffer.clear(target, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, 0.0f, 0.0f, 0.0f, 1.0f);
+  commandBuffer.drawCallback(target, drawUpscale, userData);
+}
+
+static void renderOverlayPass(void* userData)
+{
+  TRACE_EVENT("overlayPass");
+  commandBuffer.drawCallback(addWindowTarget((const FrameContext*)userData), drawOverlay, userData);
+}
+
+/* Declare the passes of a frame and what they read and write. Nothing samples iFBOTex,
+ * so the FBO pass is culled unless a pass reading "fboTexture" is added. */
+static bool setupRenderGraph(void)
+{
+  int fbCapture  = renderGraph.addResource("fbCapture", false);
+  int fboTexture = renderGraph.addResource("fboTexture", false);
+  int window     = renderGraph.addResource("window", true);
+  /* With -r the scene goes to the scaled render target first. */
+  int scene      = resolutionScaling ? renderGraph.addResource("scene", false) : window;
+
+  int fboPass = renderGraph.addPass("fboCube", renderFboPass, &frameContext);
+  renderGraph.addWrite(fboPass, fboTexture);
+
+  int mainPass = renderGraph.addPass("mainCube", renderMainPass, &frameContext);
+  renderGraph.addRead(mainPass, fbCapture);
+  renderGraph.addWrite(mainPass, scene);
+
+  if (stressObjectCount > 0)
+  {
+    int stressPass = renderGraph.addPass("stressCubes", renderStressPass, &frameContext);
+    renderGraph.addRead(stressPass, scene);
+    renderGraph.addWrite(stressPass, scene);
+  }
+
+  if (resolutionScaling)
+  {
+    int upscalePass = renderGraph.addPass("upscale", renderUpscalePass, &frameContext);
+    renderGraph.addRead(upscalePass, scene);
+    renderGraph.addWrite(upscalePass, window);
+  }
+
+  if (overlayEnabled)
+  {
+    int overlayPass = renderGraph.addPass("overlay", renderOverlayPass, &frameContext);
+    renderGraph.addRead(overlayPass, window);
+    renderGraph.addWrite(overlayPass, window);
+  }
+
+  if (!renderGraph.compile())
+  {
+    fprintf(stderr, "Could not schedule render passes.\n");
+    return false;
+  }
+  renderGraph.printSchedule();
+  return true;
+}
+
+/* Scatter the stress objects through the view between STRESS_NEAR and STRESS_FAR, the same
+ * way every run, and start the threads transforming them. */
+static bool setupStress(int w, int h)
+{
+  stressVariant = shaderVariants.get(SHADER_VERTEX_COLOR | transformFeature |
+                                     (batchMode == BATCH_UNIFORM ? SHADER_INSTANCED : 0));
+  stressObjects = (BatchObject*)malloc(stressObjectCount * sizeof(BatchObject));
+  if (stressVariant == NULL || stressObjects == NULL)
+  {
+    fprintf(stderr, "Could not set up %d stress objects.\n", stressObjectCount);
+    return false;
+  }
+  identityGeneration = ++matrixGenerations;
+
+  /* Half the view's height at unit distance, from the 45 degree field of view. */
+  const float halfHeight = tanf(22.5f * M_PI / 180.0f);
+  const float aspect = w / (float)h;
+  unsigned int random = 1;
+  for (int i = 0; i < stressObjectCount; i++)
+  {
+    float unit[4];
+    for (int j = 0; j < 4; j++)
+    {
+      random = random * 1103515245 + 12345;
+      unit[j] = (random >> 8 & 0xFFFF) / 65535.0f;
+    }
+    float distance = STRESS_NEAR + (STRESS_FAR - STRESS_NEAR) * unit[2];
+    stressObjects[i].position[0] = (unit[0] * 2.0f - 1.0f) * halfHeight * aspect * distance;
+    stressObjects[i].position[1] = (unit[1] * 2.0f - 1.0f) * halfHeight * distance;
+    stressObjects[i].position[2] = -distance;
+    stressObjects[i].scale       = STRESS_CUBE_SCALE;
+    stressObjects[i].phase       = unit[3] * 360.0f;
+  }
+
+  if (batchMode == BATCH_UNIFORM)
+  {
+    return instanceBatch.setup(cubeVertices, cubeColors, sizeof(cubeVertices) / (3 * sizeof(float)),
+                               cubeIndices, sizeof(cubeIndices) / sizeof(GLubyte),
+                               stressObjects, stressObjectCount, stressVariant->instances);
+  }
+  if (batchMode == BATCH_OFF)
+  {
+    fprintf(stderr, "Stress objects: %d, drawn one at a time\n", stressObjectCount);
+    return true;
+  }
+  if (batchThreads <= 0)
+  {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    batchThreads = processors > 0 ? (int)processors : 1;
+  }
+  return stressBatch.setup(cubeVertices, cubeColors, sizeof(cubeVertices) / (3 * sizeof(float)),
+                           cubeIndices, sizeof(cubeIndices) / sizeof(GLubyte),
+                           stressObjects, stressObjectCount, batchThreads);
+}
+
+/* Copy a mesh's vertices and indices into two new buffer objects. */
+static void uploadMesh(const void* vertices, GLsizeiptr vertexBytes, const void* indices, GLsizeiptr indexBytes,
+                       GLuint* buffers)
+{
+  glGenBuffers(2, buffers);
+  glState.bindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices, GL_STATIC_DRAW);
+  glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indices, GL_STATIC_DRAW);
+  GL_CHECK("glBufferData");
+}
+
+static bool loadMesh(const char* path)
+{
+  if (!meshFile.load(path))
+  {
+    return false;
+  }
+  const MeshFileHeader& header = meshFile.getHeader();
+  if (header.streams[1].size == 0 || header.streams[2].size == 0)
+  {
+    fprintf(stderr, "Mesh %s needs colors and texture coordinates.\n", path);
+    return false;
+  }
+
+  /* The only copy made is the driver's. */
+  GLuint buffers[2];
+  uploadMesh(meshFile.getVertices(), header.vertexBytes, meshFile.getIndices(), header.indexBytes, buffers);
+  meshFile.useBuffers(buffers[0], buffers[1]);
+
+  memcpy(cubeBoundsMin, header.boundsMin, sizeof(cubeBoundsMin));
+  memcpy(cubeBoundsMax, header.boundsMax, sizeof(cubeBoundsMax));
+  cubeStreams     = meshFile.getStreams();
+  replacementMesh = meshFile.getMesh();
+  return true;
+}
+
+static bool generateMesh(void)
+{
+  if (!meshGenerator.generate(generatedShape, generatedTriangles, generatedOptimized))
+  {
+    return false;
+  }
+  GLuint buffers[2];
+  uploadMesh(meshGenerator.getVertices(), meshGenerator.getVertexCount() * sizeof(GeneratedVertex),
+             meshGenerator.getIndices(), meshGenerator.getIndexCount() * sizeof(GLushort), buffers);
+  meshGenerator.useBuffers(buffers[0], buffers[1]);
+
+  cubeStreams     = meshGenerator.getStreams();
+  replacementMesh = meshGenerator.getMesh();
+  return true;
+}
+
+static bool parseGeneratedMesh(const char* text)
+{
+  char name[16];
+  char option[16] = "";
+  if (sscanf(text, "%15[a-z]:%d:%15s", name, &generatedTriangles, option) < 2 ||
+      generatedTriangles <= 0 || (option[0] != '\0' && strcmp(option, "optimized") != 0))
+  {
+    return false;
+  }
+  generatedShape     = MeshGenerator::findShape(name);
+  generatedOptimized = option[0] != '\0';
+  return generatedShape != MESH_SHAPE_COUNT;
+}
+
 bool setupGraphics(int w, int h) 
 {
+  startupProfiler.phase("resources");
   projection    = Matrix::matrixPerspective(45.0f, w/(float)h, 0.01f, 100.0f);
   projectionFBO = Matrix::matrixPerspective(45.0f, (FBO_WIDTH / (float)FBO_HEIGHT), 0.01f, 100.0f);
+  projectionGeneration    = ++matrixGenerations;
+  projectionFBOGeneration = ++matrixGenerations;
   translation   = Matrix::createTranslation(0.0f, 0.0f, -2.0f);
 
+#ifdef VERTEX_UV_HALF_FLOAT
+  const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+  if (cubeStreams == &cubePackedStreams &&
+      (extensions == NULL || strstr(extensions, "GL_OES_vertex_half_float") == NULL))
+  {
+    fprintf(stderr, "GL_OES_vertex_half_float not supported, using float vertices.\n");
+    cubeStreams = &cubeFloatStreams;
+  }
+#endif
+  if (meshPath != NULL && !loadMesh(meshPath))
+  {
+    return false;
+  }
+  if (generatedShape != MESH_SHAPE_COUNT && !generateMesh())
+  {
+    return false;
+  }
+
+  /* Packed positions are normalized, so scale them back to object space. */
+  positionScaling = Matrix::createScaling(cubeStreams->positionScale,
+                                          cubeStreams->positionScale,
+                                          cubeStreams->positionScale);
+  fprintf(stderr, "Vertex format: %s, %d bytes per vertex\n",
+          cubeStreams->name, (int)cubeStreams->bytesPerVertex);
+
+  if (replacementMesh != NULL)
+  {
+    cubeMesh = *replacementMesh;
+  }
+  else
+  {
+    cubeMesh.streams   = cubeStreams;
+    cubeMesh.mode      = GL_TRIANGLE_STRIP;
+    cubeMesh.count     = sizeof(cubeIndices) / sizeof(GLubyte);
+    GLubyte cubeTriangles[3 * sizeof(cubeIndices)];
+    cubeMesh.triangles = stripToTriangles(cubeIndices, cubeMesh.count, cubeTriangles) / 3;
+    cubeMesh.indexType = GL_UNSIGNED_BYTE;
+    cubeMesh.indices   = cubeIndices;
+  }
+  /* Cubes drawn on their own take a command each, instanced ones their transforms. */
+  unsigned int stressCommands = batchMode == BATCH_OFF ? stressObjectCount : 0;
+  size_t stressBytes = batchMode == BATCH_OFF     ? stressObjectCount * STRESS_DRAW_BYTES :
+                       batchMode == BATCH_UNIFORM ? stressObjectCount * 12 * sizeof(GLfloat) : 0;
+  if (!commandBuffer.setup(COMMAND_ARENA_BYTES + stressBytes, COMMANDS_PER_FRAME + stressCommands))
+  {
+    fprintf(stderr, "Could not allocate the command buffer.\n");
+    return false;
+  }
+
   /* Initialize OpenGL ES. */
-  glEnable(GL_BLEND);
-  glEnable(GL_CULL_FACE);
+  glState.enable(GL_BLEND);
+  glState.enable(GL_CULL_FACE);
   glCullFace(GL_BACK);
-  glEnable(GL_DEPTH_TEST);
+  glState.enable(GL_DEPTH_TEST);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
   glGenTextures(1, &iFBOTex);
-  glBindTexture(GL_TEXTURE_2D, iFBOTex);
+  glState.bindTexture(GL_TEXTURE_2D, iFBOTex);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, FBO_WIDTH, FBO_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -339,7 +932,7 @@ bool setupGraphics(int w, int h)
 
   /* Render to framebuffer object. */
   /* Bind our framebuffer for rendering. */
-  glBindFramebuffer(GL_FRAMEBUFFER, iFBO);
+  glState.bindFramebuffer(GL_FRAMEBUFFER, iFBO);
 
   /* Attach texture to the framebuffer. */
   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, iFBOTex, 0);
@@ -353,209 +946,343 @@ bool setupGraphics(int w, int h)
   }
 
   /* Unbind framebuffer. */
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
 
-  programID = glCreateProgram();
-  if(programID == 0)
+  startupProfiler.phase("shaders");
+  fboVariant  = shaderVariants.get(SHADER_VERTEX_COLOR | transformFeature);
+  mainVariant = shaderVariants.get(fbTexFeature | transformFeature);
+  if (fboVariant == NULL || mainVariant == NULL)
   {
-    fprintf(stderr, "glCreateProgram error.\n");
+    fprintf(stderr, "Could not create shader variants.\n");
     return false;
   }
-
-  GLuint vertexShaderID = loadShader( GL_VERTEX_SHADER, gVertexShader );
-  if( !vertexShaderID ) 
+  if (overlayEnabled)
   {
-    fprintf(stderr, "vertexShader load error.\n");
-    return false;
+    overlayVariant = shaderVariants.get(SHADER_TEXTURE | SHADER_MVP);
+    if (overlayVariant == NULL || !overlay.setup(OVERLAY_COLUMNS, OVERLAY_ROWS))
+    {
+      fprintf(stderr, "Could not set up the statistics overlay.\n");
+      return false;
+    }
   }
-
-  GLuint pixelShaderID = loadShader( GL_FRAGMENT_SHADER, gFragmentShader );
-  if( !pixelShaderID )
+  if (stressObjectCount > 0 && !setupStress(w, h))
   {
-    fprintf(stderr, "pixelShader load error.\n");
     return false;
   }
-
-  glAttachShader( programID, vertexShaderID );
-  checkGlError("glAttachShader");
-  glAttachShader( programID, pixelShaderID );
-  checkGlError("glAttachShader");
-  glLinkProgram( programID );
-  checkGlError("glLinkProgram");
-  glUseProgram( programID );
-  checkGlError("glUseProgram");
-
-  /* Vertex positions. */
-  iLocPosition = glGetAttribLocation(programID, "a_v4Position");
-  if(iLocPosition == -1)
+  if (resolutionScaling)
   {
-      fprintf(stderr,"Attribute not found at %s:%i\n", __FILE__, __LINE__);
+    upscaleVariant = shaderVariants.get(SHADER_TEXTURE | SHADER_MVP);
+    if (upscaleVariant == NULL || !resolutionScaler.setup(w, h))
+    {
+      fprintf(stderr, "Could not set up resolution scaling.\n");
       return false;
+    }
   }
-  glEnableVertexAttribArray(iLocPosition);
+  programCache.printStats();
 
-  /* Texture mix. */
-  iLocTextureMix = glGetUniformLocation(programID, "u_fTex");
-  if(iLocTextureMix == -1)
+  startupProfiler.phase("renderGraph");
+  return setupRenderGraph();
+}
+
+static float wrapAngle(float angle)
+{
+  return angle >= 360 ? angle - 360 : angle;
+}
+
+/* Advance the cube's rotation by one fixed simulation step. */
+static void updateAnimation(float seconds)
+{
+  previousAnimation = currentAnimation;
+  currentAnimation.angleX = wrapAngle(currentAnimation.angleX + angularVelocityX * seconds);
+  currentAnimation.angleY = wrapAngle(currentAnimation.angleY + angularVelocityY * seconds);
+  currentAnimation.angleZ = wrapAngle(currentAnimation.angleZ + angularVelocityZ * seconds);
+}
+
+static float interpolateAngle(float from, float to, float alpha)
+{
+  /* Angles only increase, so a smaller target has wrapped past 360. */
+  if (to < from)
   {
-    fprintf(stderr,"Warning: Uniform not found at %s:%i\n", __FILE__, __LINE__);
+    to += 360;
   }
-  else 
+  return wrapAngle(from + (to - from) * alpha);
+}
+
+/* The angles to render with, alpha of the way from the previous to the current state. */
+static AnimationState interpolateAnimation(float alpha)
+{
+  AnimationState angles;
+  angles.angleX = interpolateAngle(previousAnimation.angleX, currentAnimation.angleX, alpha);
+  angles.angleY = interpolateAngle(previousAnimation.angleY, currentAnimation.angleY, alpha);
+  angles.angleZ = interpolateAngle(previousAnimation.angleZ, currentAnimation.angleZ, alpha);
+  return angles;
+}
+
+/* Rotate about origin, then translate away from camera. */
+static Matrix cubeModelView(float angleX, float angleY, float angleZ)
+{
+  Matrix modelView = translation * Matrix::createRotationX(angleX);
+  modelView = modelView * Matrix::createRotationY(angleY);
+  modelView = modelView * Matrix::createRotationZ(angleZ);
+  return modelView * positionScaling;
+}
+
+/* Window area covered by the main cube, from its corners, in whole pixels and with a pixel
+ * to spare for rasterization. The whole window if the cube reaches behind the eye. */
+static DamageTracker::Rect cubeWindowBounds(Matrix& mvp, int w, int h)
+{
+  float scale = 1.0f / cubeStreams->positionScale;
+  float minX = (float)w, minY = (float)h, maxX = 0.0f, maxY = 0.0f;
+  DamageTracker::Rect bounds = { 0, 0, w, h };
+
+  for (int corner = 0; corner < 8; corner++)
   {
-    glUniform1f(iLocTextureMix, 0.0);
+    Vec4f vertex;
+    vertex.x = (corner & 1 ? cubeBoundsMax[0] : cubeBoundsMin[0]) * scale;
+    vertex.y = (corner & 2 ? cubeBoundsMax[1] : cubeBoundsMin[1]) * scale;
+    vertex.z = (corner & 4 ? cubeBoundsMax[2] : cubeBoundsMin[2]) * scale;
+    vertex.w = 1.0f;
+    Vec4f clip = Matrix::vertexTransform(&vertex, &mvp);
+    if (clip.w <= 0.0f)
+    {
+      return bounds;
+    }
+    float x = (clip.x / clip.w * 0.5f + 0.5f) * w;
+    float y = (clip.y / clip.w * 0.5f + 0.5f) * h;
+    minX = x < minX ? x : minX;
+    maxX = x > maxX ? x : maxX;
+    minY = y < minY ? y : minY;
+    maxY = y > maxY ? y : maxY;
   }
+  bounds.x      = (int)floorf(minX) - 1;
+  bounds.y      = (int)floorf(minY) - 1;
+  bounds.width  = (int)ceilf(maxX) + 1 - bounds.x;
+  bounds.height = (int)ceilf(maxY) + 1 - bounds.y;
+  return bounds;
+}
 
-  /* Texture. */
-  iLocTexture = glGetUniformLocation(programID, "u_s2dTexture");
-  if(iLocTexture == -1)
+/*
+ * The simulation runs one frame ahead of rendering on a thread of its own, unless -S keeps
+ * it on the render thread: when the render thread takes the state for a frame it asks for
+ * the next one, which is prepared while the frame is submitted. States are handed over
+ * through frameStates, the request is the only thing the threads wait on.
+ */
+static bool             simulationThreaded = true;
+static FrameStateBuffer frameStates;
+static pthread_t        simulationThread;
+static sem_t            simulationRequests;
+static volatile int32_t simulationStopping;
+/* Window size the simulation prepares for. */
+static int              simulationWidth;
+static int              simulationHeight;
+/* Frames that found no new state and were drawn with the previous one again. */
+static unsigned int     staleFrames;
+
+/* Step the animation up to now and build the transforms to draw it with. */
+static void simulate(FrameState* state)
+{
+  TRACE_EVENT("simulate");
+  simulationClock.beginFrame();
+  for (int step = 0; step < simulationClock.stepsToSimulate(); step++)
   {
-    fprintf(stderr,"Warning: Uniform not found at %s:%i\n", __FILE__, __LINE__);
+    updateAnimation(simulationClock.stepSeconds());
   }
-  else 
+  AnimationState angles = interpolateAnimation(simulationClock.alpha());
+  state->sampleTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+  /* The FBO's cube turns the other way round. */
+  state->fboModelView  = cubeModelView(-angles.angleZ, -angles.angleY, -angles.angleX);
+  state->fboMvp        = projectionFBO * state->fboModelView;
+  state->mainModelView = cubeModelView(angles.angleX, angles.angleY, angles.angleZ);
+  state->mainMvp       = projection * state->mainModelView;
+  state->mainBounds    = cubeWindowBounds(state->mainMvp, simulationWidth, simulationHeight);
+  state->angles[0]     = angles.angleX;
+  state->angles[1]     = angles.angleY;
+  state->angles[2]     = angles.angleZ;
+}
+
+static void* simulationMain(void* arg)
+{
+  setTraceThreadName("simulation");
+  for (;;)
   {
-    glUniform1i(iLocTexture, 0);
+    while (sem_wait(&simulationRequests) != 0 && errno == EINTR)
+    {
+    }
+    if (android_atomic_acquire_load(&simulationStopping))
+    {
+      break;
+    }
+    simulate(frameStates.writeSlot());
+    frameStates.publish();
   }
+  return NULL;
+}
 
-  /* Vertex colors. */
-  iLocFillColor = glGetAttribLocation(programID, "a_v4FillColor");
-  if(iLocFillColor == -1)
+static bool startSimulation(int w, int h)
+{
+  simulationWidth  = w;
+  simulationHeight = h;
+  if (!simulationThreaded)
+  {
+    return true;
+  }
+  if (sem_init(&simulationRequests, 0, 0) != 0)
   {
-    fprintf(stderr,"Warning: Attribute not found at %s:%i\n", __FILE__, __LINE__);
+    fprintf(stderr, "Could not create the simulation semaphore: %s\n", strerror(errno));
+    return false;
   }
-  else 
+  int error = pthread_create(&simulationThread, NULL, simulationMain, NULL);
+  if (error != 0)
   {
-    glEnableVertexAttribArray(iLocFillColor);
+    fprintf(stderr, "Could not start the simulation thread: %s\n", strerror(error));
+    return false;
   }
+  /* The first frame's state. */
+  sem_post(&simulationRequests);
+  return true;
+}
 
-  /* Texture coords. */
-  iLocTexCoord = glGetAttribLocation(programID, "a_v2TexCoord");
-  if(iLocTexCoord == -1)
+static void stopSimulation(void)
+{
+  if (!simulationThreaded)
   {
-    fprintf(stderr,"Warning: Attribute not found at %s:%i\n", __FILE__, __LINE__);
+    return;
   }
-  else 
+  android_atomic_release_store(1, &simulationStopping);
+  sem_post(&simulationRequests);
+  pthread_join(simulationThread, NULL);
+  sem_destroy(&simulationRequests);
+}
+
+/* The state to draw this frame with; the simulation starts on the next one. */
+static FrameState* nextFrameState(unsigned int frame)
+{
+  if (!simulationThreaded)
   {
-    glEnableVertexAttribArray(iLocTexCoord);
+    simulate(frameStates.writeSlot());
+    frameStates.publish();
+    frameStates.acquire();
+    return frameStates.readSlot();
   }
 
-  /* Projection matrix. */
-  iLocProjection = glGetUniformLocation(programID, "u_m4Projection");
-  if(iLocProjection == -1)
+  if (frameStates.acquire())
   {
-    fprintf(stderr,"Warning: Uniform not found at %s:%i\n", __FILE__, __LINE__);
+    sem_post(&simulationRequests);
   }
-  else 
+  else if (frame == 1)
   {
-    glUniformMatrix4fv(iLocProjection, 1, GL_FALSE, projection.getAsArray());
+    /* Nothing to draw yet, only ever at the start. */
+    TRACE_EVENT("waitForSimulation");
+    while (!frameStates.acquire())
+    {
+      sched_yield();
+    }
+    sem_post(&simulationRequests);
   }
-
-  /* Modelview matrix. */
-  iLocModelview = glGetUniformLocation(programID, "u_m4Modelview");
-  fprintf(stderr, "glGetUniformLocation(\"u_m4Modelview\") = %d\n", iLocModelview);
-
-  return true;
+  else
+  {
+    /* The simulation is still on the state asked for last frame, which stays asked for. */
+    staleFrames++;
+  }
+  return frameStates.readSlot();
 }
 
-void renderFrame(int w, int h) 
+/* Collect what this frame changes: where the cube is and was, and the overlay when its text
+ * changed. The back buffer's age says how many frames of that it misses. */
+static void beginDamage(EGLDisplay dpy, EGLSurface surface, const FrameState* state, int w, int h)
 {
-  glUseProgram(programID);
-  checkGlError("glUseProgram");
-
-  glEnableVertexAttribArray(iLocPosition);
-  checkGlError("glEnableVertexAttribArray: iLocPosition");
-  glVertexAttribPointer(iLocPosition, 3, GL_FLOAT, GL_FALSE, 0, cubeVertices);
-  checkGlError("glVertexAttribPointer: iLocPosition");
-
-  glEnableVertexAttribArray(iLocFillColor);
-  checkGlError("glEnableVertexAttribArray: iLocFillColor");
-  glVertexAttribPointer(iLocFillColor, 4, GL_FLOAT, GL_FALSE, 0, cubeColors);
-  checkGlError("glVertexAttribPointer: iLocFillColor");
-
-  glEnableVertexAttribArray(iLocTexCoord);
-  checkGlError("glEnableVertexAttribArray: iLocTexCoord");
-  glVertexAttribPointer(iLocTexCoord, 2, GL_FLOAT, GL_FALSE, 0, cubeTextureCoordinates);
-  checkGlError("glVertexAttribPointer: iLocTexCoord");
-
-  /* Bind the FrameBuffer Object. */
-  glBindFramebuffer(GL_FRAMEBUFFER, iFBO);
-
-  /* Set the viewport according to the FBO's texture. */
-  glViewport(0, 0, FBO_WIDTH, FBO_HEIGHT);
-
-  /* Clear screen on FBO. */
-  glClearColor(0.5f, 0.5f, 0.5f, 1.0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  /* Create rotation matrix specific to the FBO's cube. */
-  rotationX = Matrix::createRotationX(-angleZ);
-  rotationY = Matrix::createRotationY(-angleY);
-  rotationZ = Matrix::createRotationZ(-angleX);
-
-  /* Rotate about origin, then translate away from camera. */
-  modelView = translation * rotationX;
-  modelView = modelView * rotationY;
-  modelView = modelView * rotationZ;
-
-  /* Load FBO-specific projection and modelview matrices. */
-  glUniformMatrix4fv(iLocModelview, 1, GL_FALSE, modelView.getAsArray());
-  glUniformMatrix4fv(iLocProjection, 1, GL_FALSE, projectionFBO.getAsArray());
-
-  /* The FBO cube doesn't get textured so zero the texture mix factor. */
-  if(iLocTextureMix != -1)
+  EGLint age = 0;
+  if (bufferAgeSupported && !eglQuerySurface(dpy, surface, EGL_BUFFER_AGE_EXT, &age))
   {
-    glUniform1f(iLocTextureMix, 0.0);
+    age = 0;
   }
+  damageTracker.beginFrame(age);
 
-  /* Now draw the colored cube to the FrameBuffer Object. */
-  glDrawElements(GL_TRIANGLE_STRIP, sizeof(cubeIndices) / sizeof(GLubyte), GL_UNSIGNED_BYTE, cubeIndices);
-  checkGlError("glDrawElements: FBO");
-
-  /* And unbind the FrameBuffer Object so subsequent drawing calls are to the EGL window surface. */
-  glBindFramebuffer(GL_FRAMEBUFFER,0);
-
-  /* Reset viewport to the EGL window surface's dimensions. */
-  glViewport(0, 0, w, h);
-
-  /* Clear the screen on the EGL surface. */
-  glClearColor(0.0f, 0.0f, 1.0f, 1.0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  /* Construct different rotation for main cube. */
-  rotationX = Matrix::createRotationX(angleX);
-  rotationY = Matrix::createRotationY(angleY);
-  rotationZ = Matrix::createRotationZ(angleZ);
+  /* The stress objects move all over the window, and the upscaled scene is redrawn whole. */
+  if (stressObjectCount > 0 || resolutionScaling)
+  {
+    damageTracker.addFullDamage();
+  }
+  damageTracker.addDamage(state->mainBounds);
+  damageTracker.addDamage(lastCubeBounds);
+  lastCubeBounds = state->mainBounds;
 
-  /* Rotate about origin, then translate away from camera. */
-  modelView = translation * rotationX;
-  modelView = modelView * rotationY;
-  modelView = modelView * rotationZ;
+  if (overlayEnabled && overlay.changed())
+  {
+    DamageTracker::Rect overlayBounds = { 0, h - overlay.getHeight() * OVERLAY_SCALE,
+                                          overlay.getWidth() * OVERLAY_SCALE,
+                                          overlay.getHeight() * OVERLAY_SCALE };
+    damageTracker.addDamage(overlayBounds);
+  }
+}
 
-  /* Load EGL window-specific projection and modelview matrices. */
-  glUniformMatrix4fv(iLocModelview, 1, GL_FALSE, modelView.getAsArray());
-  glUniformMatrix4fv(iLocProjection, 1, GL_FALSE, projection.getAsArray());
+/* Swap, telling EGL what changed when it can use that. */
+static EGLBoolean presentFrame(EGLDisplay dpy, EGLSurface surface)
+{
+  if (damageEnabled && swapBuffersWithDamage != NULL)
+  {
+    const DamageTracker::Rect& damage = damageTracker.frameDamage();
+    EGLint rect[4] = { damage.x, damage.y, damage.width, damage.height };
+    /* No rectangles presents the whole surface, which is right for a frame that changed nothing too. */
+    return swapBuffersWithDamage(dpy, surface, rect, damage.width > 0 && damage.height > 0 ? 1 : 0);
+  }
+  return eglSwapBuffers(dpy, surface);
+}
 
-  /* For the main cube, we use texturing so set the texture mix factor to 1. */
-  if(iLocTextureMix != -1)
+static bool hasEglExtension(EGLDisplay dpy, const char* name)
+{
+  const char* extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+  size_t length = strlen(name);
+  for (const char* match = extensions; match != NULL && (match = strstr(match, name)) != NULL; match += length)
   {
-    glUniform1f(iLocTextureMix, 1.0);
+    if ((match == extensions || match[-1] == ' ') && (match[length] == ' ' || match[length] == '\0'))
+    {
+      return true;
+    }
   }
+  return false;
+}
 
-  /* Ensure the correct texture is bound to texture unit 0. */
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, fbTex);
+/* Find out which of buffer age and swap with damage EGL offers. Without buffer age every
+ * frame is redrawn in full, but still presented with its damage if possible. */
+static void setupDamage(EGLDisplay dpy, EGLConfig config, int w, int h)
+{
+  bufferAgeSupported = hasEglExtension(dpy, "EGL_EXT_buffer_age");
+  if (hasEglExtension(dpy, "EGL_KHR_swap_buffers_with_damage"))
+  {
+    swapBuffersWithDamage = (SwapBuffersWithDamageProc)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+  }
+  else if (hasEglExtension(dpy, "EGL_EXT_swap_buffers_with_damage"))
+  {
+    swapBuffersWithDamage = (SwapBuffersWithDamageProc)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+  }
 
-  /* And draw the cube. */
-  glDrawElements(GL_TRIANGLE_STRIP, sizeof(cubeIndices) / sizeof(GLubyte), GL_UNSIGNED_BYTE, cubeIndices);
-  checkGlError("glDrawElements");
+  EGLint colorBits = 0, depthBits = 0;
+  eglGetConfigAttrib(dpy, config, EGL_BUFFER_SIZE, &colorBits);
+  eglGetConfigAttrib(dpy, config, EGL_DEPTH_SIZE, &depthBits);
+  checkEglError("eglGetConfigAttrib");
+  damageTracker.setSurface(w, h, (colorBits + depthBits + 7) / 8);
 
-  /* Update cube's rotation angles for animating. */
-  angleX += 0.15;
-  angleY += 0.1;
-  angleZ += 0.05;
+  fprintf(stderr, "Damage tracking: buffer age %s, swap with damage %s\n",
+          bufferAgeSupported ? "supported" : "not supported, redrawing every frame in full",
+          swapBuffersWithDamage != NULL ? "supported" : "not supported");
+}
 
-  if(angleX >= 360) angleX -= 360;
-  if(angleY >= 360) angleY -= 360;
-  if(angleZ >= 360) angleZ -= 360;
+void renderFrame(FrameState* state, int w, int h) 
+{
+  TRACE_EVENT("renderFrame");
+  frameContext.width  = w;
+  frameContext.height = h;
+  frameContext.state  = state;
+
+  commandBuffer.begin();
+  renderGraph.execute();
+
+  TRACE_EVENT("submit");
+  stageStats.begin(STAGE_SUBMIT);
+  commandBuffer.submit();
+  stageStats.end(STAGE_SUBMIT);
 }
 
 void printEGLConfiguration(EGLDisplay dpy, EGLConfig config) {
@@ -609,12 +1336,144 @@ void printEGLConfiguration(EGLDisplay dpy, EGLConfig config) {
   fprintf(stderr,"\n");
 }
 
+/* What -v prints once the first frame is on screen. */
+static void printDiagnostics(EGLDisplay dpy, EGLConfig config)
+{
+  fprintf(stderr,"Chose this configuration:\n");
+  printEGLConfiguration(dpy, config);
+  printGLString("Extensions", GL_EXTENSIONS);
+  printFbInfo();
+}
+
+/* Print and export the statistics of the frames since the last report, and start a new interval. */
+static void reportStats(unsigned int firstFrame, unsigned int lastFrame)
+{
+  char label[64];
+  snprintf(label, sizeof(label), "frames %u-%u", firstFrame, lastFrame);
+  if (generatedShape != MESH_SHAPE_COUNT)
+  {
+    /* Everything drawn counts, but the generated mesh is nearly all of it. */
+    const FrameClock::Stats& clockStats = frameClock.stats();
+    double seconds = clockStats.totalFrameTime / 1e9;
+    double triangles = commandBuffer.getTrianglesPerFrame() * clockStats.frames;
+    fprintf(stderr, "Geometry (%s): %s of %d triangles and %d vertices, %.2f M triangles/s\n",
+            label, MeshGenerator::getShapeName(generatedShape), meshGenerator.getTriangleCount(),
+            meshGenerator.getVertexCount(), seconds > 0.0 ? triangles / seconds / 1e6 : 0.0);
+  }
+  glState.printStats(label);
+  glState.resetStats();
+  frameClock.printStats(label);
+  frameClock.resetStats();
+  if (staleFrames != 0)
+  {
+    fprintf(stderr, "Simulation (%s): %u frames drawn again with the previous state\n", label, staleFrames);
+    staleFrames = 0;
+  }
+  if (damageEnabled)
+  {
+    damageTracker.printStats(label);
+    damageTracker.resetStats();
+  }
+  commandBuffer.printStats(label);
+  commandBuffer.resetStats();
+  if (stressObjectCount > 0)
+  {
+    stressBatch.printStats(label);
+    stressBatch.resetStats();
+    instanceBatch.printStats(label);
+    instanceBatch.resetStats();
+  }
+  if (resolutionScaling)
+  {
+    resolutionScaler.printStats(label);
+    resolutionScaler.resetStats();
+  }
+  stageStats.printStats(label);
+  stageStats.exportStats(label);
+  stageStats.resetStats();
+}
+
+/* Show the frame rate and the stage times of the current statistics interval. */
+static void updateOverlay(void)
+{
+  char text[OVERLAY_ROWS * (OVERLAY_COLUMNS + 1) + 1];
+  const FrameClock::Stats& frames = frameClock.stats();
+  nsecs_t average = frames.frames ? frames.totalFrameTime / frames.frames : 0;
+  nsecs_t latency = frames.presented ? frames.totalLatency / frames.presented : 0;
+  int length = snprintf(text, sizeof(text), "%.1f FPS  %.2f MS/FRAME  %.2f MS LAT\n%-14s %7s %7s %7s\n",
+                        average ? 1e9 / average : 0.0, average / 1e6, latency / 1e6,
+                        "CPU MS", "AVG", "P95", "MAX");
+  for (int stage = 0; stage < STAGE_COUNT && length < (int)sizeof(text); stage++)
+  {
+    StageStats::Summary summary = stageStats.summarize((FrameStage)stage);
+    if (summary.count > 0)
+    {
+      length += snprintf(text + length, sizeof(text) - length, "%-14s %7.3f %7.3f %7.3f\n",
+                         StageStats::stageName((FrameStage)stage),
+                         summary.average / 1e6, summary.p95 / 1e6, summary.max / 1e6);
+    }
+  }
+  overlay.setText(text);
+}
+
+static void usage(const char* name)
+{
+  fprintf(stderr, "Usage: %s [options]\n", name);
+  fprintf(stderr, "  -e off|frame|sample[:N]|strict   GL/EGL error check policy\n");
+  fprintf(stderr, "  -f <fps>                         target frame rate, 0 for unthrottled (default)\n");
+  fprintf(stderr, "  -p latency|vsync|unthrottled     presentation mode (default: the driver's swap interval)\n");
+  fprintf(stderr, "  -m                               upload projection and modelview separately\n");
+  fprintf(stderr, "                                   instead of a precomputed MVP matrix\n");
+  fprintf(stderr, "  -c <dir>                         program binary cache directory, \"\" to disable\n");
+  fprintf(stderr, "                                   (default %s)\n", PROGRAM_CACHE_DIR);
+  fprintf(stderr, "  -n <frames>                      exit after this many frames, 0 to run forever (default)\n");
+  fprintf(stderr, "  -t <file>                        record the GL and EGL calls to a trace for gl2-cube-replay\n");
+  fprintf(stderr, "  -o <file>                        export stage CPU times every %d frames, and the startup\n",
+          STATS_INTERVAL_FRAMES);
+  fprintf(stderr, "                                   phases once, as JSON lines if the name ends in .json,\n");
+  fprintf(stderr, "                                   as CSV otherwise\n");
+  fprintf(stderr, "  -O                               draw frame rate and stage CPU times over the window\n");
+  fprintf(stderr, "  -S                               simulate on the render thread, not one frame ahead\n");
+  fprintf(stderr, "                                   on a thread of its own\n");
+  fprintf(stderr, "  -d                               redraw only what changed since the back buffer was drawn\n");
+  fprintf(stderr, "                                   (EGL_EXT_buffer_age), present only what changed\n");
+  fprintf(stderr, "  -N <objects>                     also draw this many small cubes\n");
+  fprintf(stderr, "  -b cpu|uniform|off               how the -N cubes are drawn: transformed on the CPU and\n");
+  fprintf(stderr, "                                   batched into a few draws (default), transformed by the\n");
+  fprintf(stderr, "                                   vertex shader from a uniform array, many per draw, or\n");
+  fprintf(stderr, "                                   one draw per cube\n");
+  fprintf(stderr, "  -w <threads>                     threads transforming the -N cubes, the render thread\n");
+  fprintf(stderr, "                                   included (default: one per CPU)\n");
+  fprintf(stderr, "  -r <ms>[:<min>[:<max>]]          render the scene at the resolution that holds this frame\n");
+  fprintf(stderr, "                                   time, between min and max of the window's (default 0.5:1),\n");
+  fprintf(stderr, "                                   and upscale it to the window\n");
+  fprintf(stderr, "  -M <file>                        draw the cube from a mesh file written by gl2-cube-meshconv\n");
+  fprintf(stderr, "  -G grid|cube|sphere:<triangles>[:optimized]\n");
+  fprintf(stderr, "                                   draw a generated mesh of about that many triangles instead\n");
+  fprintf(stderr, "                                   of the cube, reordered for the vertex caches if optimized\n");
+  fprintf(stderr, "  -T <file>                        record trace events, written as Chrome trace JSON at exit\n");
+  fprintf(stderr, "                                   and on SIGUSR1\n");
+  fprintf(stderr, "  -v                               also print the EGL configuration, GL extensions and\n");
+  fprintf(stderr, "                                   framebuffer layout, once the first frame is presented\n");
+#ifndef HAVE_ANDROID_OS
+  fprintf(stderr, "  -s <width>x<height>              size of the offscreen surface (default 800x480)\n");
+#endif
+}
+
 int main(int argc, char** argv) 
 {
   EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+#ifdef HAVE_ANDROID_OS
   EGLint s_configAttribs[] = { EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
                                EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
                                EGL_NONE };
+#else
+  EGLint s_configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                               EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
+                               EGL_NONE };
+  EGLint      surfaceWidth  = 800;
+  EGLint      surfaceHeight = 480;
+#endif
   EGLBoolean  returnValue;
   EGLConfig   myConfig = {0};
   EGLint      majorVersion;
@@ -624,7 +1483,141 @@ int main(int argc, char** argv)
   EGLint      w, 
               h;
   EGLDisplay  dpy;
+  unsigned int frameLimit = 0;
+  const char* tracePath = NULL;
+  const char* traceEventsPath = NULL;
 
+  startupProfiler.start("arguments");
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+    {
+      if (!parseGlErrorCheckPolicy(argv[++i]))
+      {
+        fprintf(stderr, "Unknown error check policy \"%s\".\n", argv[i]);
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-m") == 0)
+    {
+      transformFeature = 0;
+    }
+    else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+    {
+      programCache.setDirectory(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+    {
+      frameClock.setTargetFrameRate(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+    {
+      if (!parsePresentMode(argv[++i]))
+      {
+        fprintf(stderr, "Unknown presentation mode \"%s\".\n", argv[i]);
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+    {
+      frameLimit = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+    {
+      if (!stageStats.openExport(argv[++i]))
+      {
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-O") == 0)
+    {
+      overlayEnabled = true;
+    }
+    else if (strcmp(argv[i], "-S") == 0)
+    {
+      simulationThreaded = false;
+    }
+    else if (strcmp(argv[i], "-d") == 0)
+    {
+      damageEnabled = true;
+    }
+    else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc)
+    {
+      stressObjectCount = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+    {
+      if (!parseBatchMode(argv[++i]))
+      {
+        fprintf(stderr, "Unknown batch mode \"%s\".\n", argv[i]);
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+    {
+      batchThreads = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+    {
+      if (!parseResolutionScaling(argv[++i]))
+      {
+        fprintf(stderr, "Bad resolution scaling \"%s\".\n", argv[i]);
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc)
+    {
+      meshPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-G") == 0 && i + 1 < argc)
+    {
+      if (!parseGeneratedMesh(argv[++i]))
+      {
+        fprintf(stderr, "Bad generated mesh \"%s\".\n", argv[i]);
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc)
+    {
+      traceEventsPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "-v") == 0)
+    {
+      verbose = true;
+    }
+#ifndef HAVE_ANDROID_OS
+    else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc &&
+             sscanf(argv[++i], "%dx%d", &surfaceWidth, &surfaceHeight) == 2)
+    {
+    }
+#endif
+    else
+    {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (tracePath != NULL && !startGlTrace(tracePath))
+  {
+    return 1;
+  }
+  if (traceEventsPath != NULL && !startTraceEvents(traceEventsPath))
+  {
+    return 1;
+  }
+  setTraceThreadName("main");
+
+  startupProfiler.phase("eglInitialize");
   checkEglError("<init>");
   dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
   checkEglError("eglGetDisplay");
@@ -643,6 +1636,8 @@ int main(int argc, char** argv)
     return 0;
   }
 
+  startupProfiler.phase("chooseConfig");
+#ifdef HAVE_ANDROID_OS
   EGLNativeWindowType window = android_createDisplaySurfaceEx("fb4");
   returnValue = EGLUtils::selectConfigForNativeWindow(dpy, s_configAttribs, window, &myConfig);
   if (returnValue) 
@@ -653,9 +1648,7 @@ int main(int argc, char** argv)
 
   checkEglError("EGLUtils::selectConfigForNativeWindow");
 
-  fprintf(stderr,"Chose this configuration:\n");
-  printEGLConfiguration(dpy, myConfig);
-
+  startupProfiler.phase("createSurface");
   surface = eglCreateWindowSurface(dpy, myConfig, window, NULL);
   checkEglError("eglCreateWindowSurface");
   if (surface == EGL_NO_SURFACE) 
@@ -663,7 +1656,29 @@ int main(int argc, char** argv)
     fprintf(stderr,"gelCreateWindowSurface failed.\n");
     return 1;
   }
+#else
+  /* Hosts render offscreen, to a pbuffer the size given with -s. */
+  EGLint numConfigs = 0;
+  returnValue = eglChooseConfig(dpy, s_configAttribs, &myConfig, 1, &numConfigs);
+  checkEglError("eglChooseConfig", returnValue);
+  if (returnValue != EGL_TRUE || numConfigs == 0)
+  {
+    fprintf(stderr,"eglChooseConfig found no configuration.\n");
+    return 1;
+  }
 
+  startupProfiler.phase("createSurface");
+  EGLint pbufferAttribs[] = { EGL_WIDTH, surfaceWidth, EGL_HEIGHT, surfaceHeight, EGL_NONE };
+  surface = eglCreatePbufferSurface(dpy, myConfig, pbufferAttribs);
+  checkEglError("eglCreatePbufferSurface");
+  if (surface == EGL_NO_SURFACE) 
+  {
+    fprintf(stderr,"eglCreatePbufferSurface failed.\n");
+    return 1;
+  }
+#endif
+
+  startupProfiler.phase("createContext");
   context = eglCreateContext(dpy, myConfig, EGL_NO_CONTEXT, context_attribs);
   checkEglError("eglCreateContext");
   if (context == EGL_NO_CONTEXT) 
@@ -678,6 +1693,13 @@ int main(int argc, char** argv)
     return 1;
   }
 
+  if (presentMode != NULL)
+  {
+    returnValue = eglSwapInterval(dpy, presentMode->swapInterval);
+    checkEglError("eglSwapInterval", returnValue);
+    fprintf(stderr, "Presentation mode %s: %s\n", presentMode->name, presentMode->description);
+  }
+
   eglQuerySurface(dpy, surface, EGL_WIDTH, &w);
   checkEglError("eglQuerySurface");
   eglQuerySurface(dpy, surface, EGL_HEIGHT, &h);
@@ -687,7 +1709,6 @@ int main(int argc, char** argv)
   printGLString("Version",    GL_VERSION);
   printGLString("Vendor",     GL_VENDOR);
   printGLString("Renderer",   GL_RENDERER);
-  printGLString("Extensions", GL_EXTENSIONS);
 
   if(!setupFbTexSurface(dpy, context)) 
   {
@@ -701,12 +1722,106 @@ int main(int argc, char** argv)
     return 1;
   }
 
-  for (;;)
+  startupProfiler.phase("simulation");
+  if (damageEnabled)
   {
-    renderFrame(w, h);
-    eglSwapBuffers(dpy, surface);
-    checkEglError("eglSwapBuffers");
+    setupDamage(dpy, myConfig, w, h);
+  }
+
+  if (!startSimulation(w, h))
+  {
+    return 1;
+  }
+  startupProfiler.phase("firstFrame");
+
+  /* Setup is not a frame. */
+  stageStats.resetStats();
+
+  unsigned int frame;
+  unsigned int reportedFrames = 0;
+  for (frame = 1; frameLimit == 0 || frame <= frameLimit; frame++)
+  {
+    frameClock.beginFrame();
+    nsecs_t frameStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    FrameState* state = nextFrameState(frame);
+
+    if (damageEnabled)
+    {
+      beginDamage(dpy, surface, state, w, h);
+    }
+    renderFrame(state, w, h);
+    if (resolutionScaling && resolutionScaler.probeDue(frame))
+    {
+      /* Wait for the GPU so the probe covers its work too, before a swap can block on vsync. */
+      TRACE_EVENT("resolutionProbe");
+      glFinish();
+      resolutionScaler.addProbe(systemTime(SYSTEM_TIME_MONOTONIC) - frameStart);
+    }
+    {
+      TRACE_EVENT("eglSwapBuffers");
+      stageStats.begin(STAGE_SWAP);
+      returnValue = presentFrame(dpy, surface);
+      stageStats.end(STAGE_SWAP);
+    }
+    if (frame == 1)
+    {
+      startupProfiler.firstFramePresented();
+    }
+    if (damageEnabled)
+    {
+      damageTracker.endFrame();
+    }
+    if (returnValue != EGL_TRUE)
+    {
+      checkEglError("eglSwapBuffers", returnValue);
+    }
+    if (presentMode != NULL && presentMode->finishAfterSwap)
+    {
+      TRACE_EVENT("glFinish");
+      glFinish();
+    }
+    frameClock.framePresented(state->sampleTime);
     fillFbTexture(dpy, context, false);
+    checkFrameErrors(frame);
+    glState.endFrame();
+    frameClock.endFrame();
+
+    pollTraceEvents();
+
+    if (frame == 1)
+    {
+      /* Startup ends here; report it, and what -v held back until now. */
+      startupProfiler.printStats();
+      startupProfiler.exportStats(&stageStats);
+      if (verbose)
+      {
+        printDiagnostics(dpy, myConfig);
+      }
+    }
+    if (overlayEnabled && frame % OVERLAY_INTERVAL_FRAMES == 0)
+    {
+      updateOverlay();
+    }
+    if (frame % STATS_INTERVAL_FRAMES == 0)
+    {
+      reportStats(frame - STATS_INTERVAL_FRAMES + 1, frame);
+      reportedFrames = frame;
+    }
+  }
+
+  /* A run of -n frames that is not a whole number of intervals still reports its last frames. */
+  if (frame - 1 > reportedFrames)
+  {
+    reportStats(reportedFrames + 1, frame - 1);
   }
+
+  stopSimulation();
+  stressBatch.shutdown();
+  free(stressObjects);
+  closeFbDevice();
+  eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglTerminate(dpy);
+  stopGlTrace();
+  stopTraceEvents();
   return 0;
 }